@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+/*
+ * Compares the streaming JSON parser with the substring search it
+ * replaced, on responses shaped and sized like the ones of Cloudflare's
+ * API. Both are given the response in chunks of CURL_MAX_WRITE_SIZE
+ * bytes, like curl's write callback does: the substring search needs to
+ * copy them to a buffer first, while the parser consumes them directly.
+ */
+
+#include "json.hpp"
+#include "measure.hpp"
+
+#include <chrono> /* std::chrono::milliseconds */
+#include <cstddef> /* std::size_t */
+#include <cstdio> /* std::printf, std::snprintf */
+#include <optional> /* std::optional */
+#include <string> /* std::string */
+#include <string_view> /* std::string_view */
+#include <tuple> /* std::tuple */
+
+namespace {
+
+constexpr std::size_t chunk_size {16384U};
+
+/*
+ * How the responses used to be parsed. key must include quotes.
+ */
+std::optional<std::string_view> get_json_value(const std::string_view json, const std::string_view key) {
+	const std::size_t key_start {json.find(key)};
+	if (key_start == std::string_view::npos) {
+		return {};
+	}
+	const std::size_t value_start {json.find('"', key_start + key.length() + 1) + 1};
+	if (value_start == std::string_view::npos) {
+		return {};
+	}
+	const std::size_t value_end {json.find('"', value_start + 1)};
+	if (value_end == std::string_view::npos) {
+		return {};
+	}
+	return json.substr(value_start, value_end - value_start);
+}
+
+std::size_t substring_search(const std::string_view response, std::string& buffer) {
+	buffer.clear();
+	for (std::size_t i = 0; i < response.size(); i += chunk_size) {
+		buffer.append(response.substr(i, chunk_size));
+	}
+
+	std::size_t records {0};
+	std::string_view id_sv {buffer};
+	std::string_view type_sv {buffer};
+	std::string_view content_sv {buffer};
+	while (true) {
+		const std::optional id {get_json_value(id_sv, "\"id\"")};
+		const std::optional type {get_json_value(type_sv, "\"type\"")};
+		const std::optional content {get_json_value(content_sv, "\"content\"")};
+		if (!id || !type || !content) {
+			break;
+		}
+		id_sv.remove_prefix(static_cast<std::size_t>(id->data() - id_sv.data()));
+		type_sv.remove_prefix(static_cast<std::size_t>(type->data() - type_sv.data()));
+		content_sv.remove_prefix(static_cast<std::size_t>(content->data() - content_sv.data()));
+		if (*type == "A" || *type == "AAAA") {
+			++records;
+		}
+	}
+	return records;
+}
+
+std::size_t streaming_parser(const std::string_view response) {
+	std::size_t records {0};
+	priv::json::response_parser parser {
+		[](void* const user, const priv::json::record& record) noexcept {
+			if (record.is_address()) {
+				++*static_cast<std::size_t*>(user);
+			}
+		},
+		&records
+	};
+	for (std::size_t i = 0; i < response.size(); i += chunk_size) {
+		const std::string_view chunk {response.substr(i, chunk_size)};
+		parser.feed(chunk.data(), chunk.size());
+	}
+	return parser.success() ? records : 0;
+}
+
+/*
+ * A listing of records_count records, as returned by Cloudflare
+ */
+std::string make_listing(const std::size_t records_count) {
+	std::string response {R"({"result":[)"};
+	for (std::size_t i = 0; i < records_count; ++i) {
+		char record[1024];
+		std::snprintf(record, sizeof record,
+			R"(%s{"id":"%032zx","zone_id":"023e105f4ecef8ad9ca31a8372d0c353","zone_name":"example.com",)"
+			R"("name":"host%zu.example.com","type":"%s","content":"%s%zu","proxiable":true,"proxied":false,)"
+			R"("ttl":1,"settings":{},"meta":{"auto_added":false,"managed_by_apps":false,"managed_by_argo_tunnel":false},)"
+			R"("comment":"Managed by cloudflare-ddns","tags":[],"created_on":"2026-01-01T00:00:00.000000Z",)"
+			R"("modified_on":"2026-01-01T00:00:00.000000Z","comment_modified_on":"2026-01-01T00:00:00.000000Z"})",
+			i == 0 ? "" : ",", i, i, i % 2 == 0 ? "A" : "AAAA", i % 2 == 0 ? "192.0.2." : "2001:db8::", i % 250
+		);
+		response += record;
+	}
+	response += R"(],"success":true,"errors":[],"messages":[],"result_info":{"page":1,"per_page":100,)";
+	response += R"("count":)" + std::to_string(records_count) + R"(,"total_count":)" + std::to_string(records_count) + "}}";
+	return response;
+}
+
+} // namespace
+
+int main() {
+	std::printf("%-8s %-10s %-18s %10s %10s %10s %8s %8s\n", "records", "bytes", "parser", "p50 us", "p99 us", "MiB/s", "allocs", "found");
+
+	std::string buffer;
+	int status {0};
+	for (const std::size_t records_count : {1U, 25U, 100U, 1000U}) {
+		const std::string response {make_listing(records_count)};
+
+		std::size_t old_found {0};
+		std::size_t new_found {0};
+		const bench::summary old_summary {bench::measure([&] { old_found = substring_search(response, buffer); return true; }, std::chrono::milliseconds{200}, 100)};
+		const bench::summary new_summary {bench::measure([&] { new_found = streaming_parser(response); return true; }, std::chrono::milliseconds{200}, 100)};
+
+		for (const auto& [name, summary, found] : {
+			std::tuple{"substring search", old_summary, old_found},
+			std::tuple{"streaming parser", new_summary, new_found}
+		}) {
+			const double mib_per_s {static_cast<double>(response.size()) * summary.runs_per_s / (1024.0 * 1024.0)};
+			std::printf("%-8zu %-10zu %-18s %10.2f %10.2f %10.1f %8.1f %8zu\n", records_count, response.size(), name, summary.p50_us, summary.p99_us, mib_per_s, summary.allocations, found);
+		}
+
+		if (old_found != records_count || new_found != records_count) {
+			status = 1;
+		}
+	}
+
+	return status;
+}
@@ -0,0 +1,77 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "measure.hpp"
+
+#include <cstdlib> /* std::malloc, std::free */
+#include <new> /* std::bad_alloc, std::nothrow_t */
+
+namespace {
+
+thread_local std::size_t allocations_count {0};
+
+void* allocate(const std::size_t size) noexcept {
+	++allocations_count;
+	return std::malloc(size != 0 ? size : 1);
+}
+
+} // namespace
+
+namespace bench {
+
+std::size_t allocations() noexcept {
+	return allocations_count;
+}
+
+void count_allocations(const std::size_t count) noexcept {
+	allocations_count += count;
+}
+
+} // namespace bench
+
+void* operator new(const std::size_t size) {
+	void* const memory {allocate(size)};
+	if (memory == nullptr) {
+		throw std::bad_alloc{};
+	}
+	return memory;
+}
+
+void* operator new[](const std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void operator delete(void* const memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* const memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* const memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* const memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* const memory, const std::nothrow_t&) noexcept {
+	std::free(memory);
+}
+
+void operator delete[](void* const memory, const std::nothrow_t&) noexcept {
+	std::free(memory);
+}
@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+/*
+ * Runs a function many times, timing every run on its own, and reports the
+ * median and 99th percentile latency, the throughput and the allocations
+ * made by each run. Allocations are the calls to operator new made by the
+ * calling thread, counted by measure.cpp, which replaces it: the library
+ * allocates with it, while curl's and OpenSSL's own calls to malloc aren't
+ * counted, and neither are the ones of the threads of the mock server.
+ */
+
+#pragma once
+#include <algorithm> /* std::sort */
+#include <chrono> /* std::chrono::steady_clock, std::chrono::milliseconds, std::chrono::nanoseconds */
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::int64_t */
+#include <vector> /* std::vector */
+
+namespace bench {
+
+/*
+ * The calls to operator new made by this thread so far
+ */
+std::size_t allocations() noexcept;
+
+/*
+ * Counts allocations made elsewhere, like by a child process, as if this
+ * thread made them
+ */
+void count_allocations(std::size_t count) noexcept;
+
+struct summary {
+	std::size_t runs {0};
+	// Runs that returned false
+	std::size_t failures {0};
+	double p50_us {0};
+	double p99_us {0};
+	double runs_per_s {0};
+	double allocations {0};
+};
+
+/*
+ * Runs function, which returns false when it fails, for at least duration
+ * and min_runs times
+ */
+template <typename Function>
+summary measure(Function&& function, const std::chrono::milliseconds duration, const std::size_t min_runs) {
+	using clock = std::chrono::steady_clock;
+
+	std::vector<std::int64_t> samples_ns;
+	samples_ns.reserve(4096);
+	summary result;
+	std::size_t allocated {0};
+	std::int64_t total_ns {0};
+
+	const clock::time_point start {clock::now()};
+	do {
+		const std::size_t allocations_before {allocations()};
+		const clock::time_point run_start {clock::now()};
+		const bool ok {function()};
+		const clock::time_point run_end {clock::now()};
+		allocated += allocations() - allocations_before;
+
+		const std::int64_t ns {std::chrono::duration_cast<std::chrono::nanoseconds>(run_end - run_start).count()};
+		samples_ns.push_back(ns);
+		total_ns += ns;
+		result.failures += ok ? 0 : 1;
+	} while (samples_ns.size() < min_runs || clock::now() - start < duration);
+
+	std::sort(samples_ns.begin(), samples_ns.end());
+	// Nearest rank
+	const auto percentile = [&](const std::size_t p) {
+		const std::size_t rank {(samples_ns.size() * p + 99) / 100};
+		return static_cast<double>(samples_ns[rank - 1]) / 1e3;
+	};
+
+	result.runs = samples_ns.size();
+	result.p50_us = percentile(50);
+	result.p99_us = percentile(99);
+	result.runs_per_s = static_cast<double>(result.runs) * 1e9 / static_cast<double>(total_ns > 0 ? total_ns : 1);
+	result.allocations = static_cast<double>(allocated) / static_cast<double>(result.runs);
+	return result;
+}
+
+} // namespace bench
@@ -0,0 +1,211 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+/*
+ * Measures the whole request pipeline against the mock of Cloudflare's API
+ * used by the tests, served over HTTPS on the loopback interface, so that
+ * the numbers don't depend on the network:
+ *
+ * - cold process: a new process looking up a record, like the oneshot
+ *   service does, from spawning it to its exit
+ * - cold handle: a new client looking up a record, paying for the
+ *   connection and the TLS handshake
+ * - warm handle: a client reused between lookups and updates, like the
+ *   daemon does
+ * - sweeps: many records looked up at once, and a zone listed in pages
+ *
+ * The JSON extraction alone is measured by the json benchmark.
+ */
+
+#include "measure.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+
+#include <curl/curl.h>
+#include <ddns/cloudflare-ddns.h>
+
+#include <array> /* std::array */
+#include <chrono> /* std::chrono::milliseconds */
+#include <cstdio> /* std::printf */
+#include <cstdlib> /* std::strtoul */
+#include <cstring> /* std::strcmp */
+#include <functional> /* std::ref */
+#include <string> /* std::string, std::to_string */
+#include <vector> /* std::vector */
+
+#include <spawn.h> /* posix_spawn, posix_spawn_file_actions_t */
+#include <sys/wait.h> /* waitpid, WIFEXITED, WEXITSTATUS */
+#include <unistd.h> /* pipe, read, close */
+
+extern char** environ;
+
+namespace {
+
+constexpr std::chrono::milliseconds duration {1000};
+
+struct endpoints {
+	const char* base_url;
+	const char* trace_url;
+	const char* ca_file;
+};
+
+bool get_records(ddns_client* const client) {
+	std::array<ddns_record, 2> records;
+	std::size_t records_count {0};
+	return ddns_client_get_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records.size(), records.data(), &records_count) == DDNS_ERROR_OK
+		&& records_count == 2;
+}
+
+/*
+ * A record lookup by a fresh client, with a fresh connection
+ */
+bool cold_handle(const endpoints& endpoints) {
+	ddns_client* const client {make_client(endpoints.base_url, endpoints.trace_url, endpoints.ca_file)};
+	if (client == nullptr) {
+		return false;
+	}
+	const bool ok {get_records(client)};
+	ddns_client_destroy(client);
+	return ok;
+}
+
+/*
+ * What the child process spawned by cold_process() runs: a lookup like the
+ * one of cold_handle(), with curl initialized from scratch. It prints the
+ * allocations it made.
+ */
+int cold_process_child(const endpoints& endpoints) {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	const bool ok {cold_handle(endpoints)};
+	curl_global_cleanup();
+	std::printf("%zu\n", bench::allocations());
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool cold_process(const char* const self, const endpoints& endpoints) {
+	int output[2];
+	if (pipe(output) != 0) {
+		return false;
+	}
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+	posix_spawn_file_actions_addclose(&actions, output[0]);
+
+	char* const argv[] {
+		const_cast<char*>(self), const_cast<char*>("--cold"),
+		const_cast<char*>(endpoints.base_url), const_cast<char*>(endpoints.trace_url), const_cast<char*>(endpoints.ca_file),
+		nullptr
+	};
+	pid_t child {0};
+	const int error {posix_spawn(&child, self, &actions, nullptr, argv, environ)};
+	posix_spawn_file_actions_destroy(&actions);
+	close(output[1]);
+	if (error != 0) {
+		close(output[0]);
+		return false;
+	}
+
+	char allocations[32] {};
+	std::size_t allocations_size {0};
+	for (ssize_t received {1}; received > 0 && allocations_size < sizeof allocations - 1; allocations_size += static_cast<std::size_t>(received)) {
+		received = read(output[0], allocations + allocations_size, sizeof allocations - 1 - allocations_size);
+		if (received < 0) {
+			break;
+		}
+	}
+	close(output[0]);
+	bench::count_allocations(std::strtoul(allocations, nullptr, 10));
+
+	int status {0};
+	return waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+void print(const char* const name, const bench::summary& summary) {
+	std::printf("%-26s %8zu %10.1f %10.1f %10.0f %8.1f\n", name, summary.runs, summary.p50_us, summary.p99_us, summary.runs_per_s, summary.allocations);
+}
+
+} // namespace
+
+int main(const int argc, char* argv[]) {
+	if (argc == 5 && std::strcmp(argv[1], "--cold") == 0) {
+		return cold_process_child({argv[2], argv[3], argv[4]});
+	}
+
+	mock_cloudflare cloudflare;
+	// Raise the rate limit, or the client would pace the benchmark to the
+	// few requests per second allowed by Cloudflare
+	const mock_server server {[&](const mock_request& request) {
+		mock_response response {cloudflare(request)};
+		response.headers += "RateLimit-Policy: \"default\";q=100000000;w=1\r\n";
+		return response;
+	}};
+	const endpoints endpoints {server.base_url().c_str(), server.trace_url().c_str(), server.ca_file().c_str()};
+
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+	ddns_client* const client {make_client(endpoints.base_url, endpoints.trace_url, endpoints.ca_file)};
+	if (client == nullptr) {
+		std::fputs("Unable to create the client\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%-26s %8s %10s %10s %10s %8s\n", "benchmark", "runs", "p50 us", "p99 us", "runs/s", "allocs");
+
+	std::size_t failures {0};
+	const auto run = [&](const char* const name, const std::size_t min_runs, auto&& function) {
+		const bench::summary summary {bench::measure(function, duration, min_runs)};
+		print(name, summary);
+		failures += summary.failures;
+	};
+
+	run("cold process", 20, [&] { return cold_process(argv[0], endpoints); });
+	run("cold handle", 50, [&] { return cold_handle(endpoints); });
+
+	run("warm handle: lookup", 100, [&] { return get_records(client); });
+	run("warm handle: update", 100, [&] {
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> record_ip;
+		return ddns_client_update_record(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::a_record_id, "198.51.100.1", record_ip.size(), record_ip.data()) == DDNS_ERROR_OK;
+	});
+	run("warm handle: local address", 100, [&] {
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ip;
+		return ddns_client_get_local_ip(client, false, local_ip.size(), local_ip.data()) == DDNS_ERROR_OK;
+	});
+
+	// Lookups sent concurrently, like the ones of the names of a few zones.
+	// The names are all different, as equal queries are sent only once
+	constexpr std::size_t sweep_size {16};
+	std::vector<std::string> sweep_names(sweep_size);
+	sweep_names[0] = mock_cloudflare::record_name;
+	for (std::size_t i = 1; i < sweep_size; ++i) {
+		sweep_names[i] = "host" + std::to_string(i) + ".example.com";
+	}
+	std::vector<std::array<ddns_record, 2>> sweep_records(sweep_size);
+	std::vector<ddns_record_query> queries(sweep_size);
+	run("sweep: 16 lookups", 50, [&] {
+		for (std::size_t i = 0; i < sweep_size; ++i) {
+			queries[i] = {mock_cloudflare::api_token, mock_cloudflare::zone_id, sweep_names[i].c_str(), sweep_records[i].size(), sweep_records[i].data(), 0, DDNS_ERROR_OK};
+		}
+		return ddns_client_get_records_multi(client, queries.size(), queries.data()) == DDNS_ERROR_OK;
+	});
+
+	run("sweep: list 152 records", 50, [&] {
+		ddns_zone_index* index {nullptr};
+		if (ddns_client_list_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, &index) != DDNS_ERROR_OK) {
+			return false;
+		}
+		const bool ok {ddns_zone_index_size(index) == mock_cloudflare::pool_size + 2};
+		ddns_zone_index_destroy(index);
+		return ok;
+	});
+
+	ddns_client_destroy(client);
+	curl_global_cleanup();
+
+	if (failures != 0) {
+		std::fprintf(stderr, "%zu runs failed\n", failures);
+		return EXIT_FAILURE;
+	}
+}
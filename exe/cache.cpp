@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "cache.hpp"
+
+#include <algorithm> /* std::lower_bound, std::sort */
+#include <cerrno> /* errno, EINTR */
+#include <cstring> /* std::memcmp, std::memcpy */
+#include <filesystem> /* std::filesystem::rename, std::filesystem::remove */
+#include <fstream> /* std::ifstream, std::ofstream */
+#include <system_error> /* std::error_code */
+#include <type_traits> /* std::is_trivially_copyable_v */
+
+#if __has_include(<sys/mman.h>)
+#	include <fcntl.h> /* open, O_RDONLY, O_WRONLY, O_CREAT, O_TRUNC, O_CLOEXEC */
+#	include <sys/mman.h> /* mmap, munmap */
+#	include <sys/stat.h> /* fstat */
+#	include <unistd.h> /* close, write, fsync */
+#	define DDNS_HAS_MMAP
+#endif
+
+namespace {
+
+constexpr char file_magic[8] {'c', 'f', '-', 'd', 'd', 'n', 's', '\n'};
+constexpr std::uint32_t file_version {2};
+
+struct header {
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t slot_size;
+	std::uint64_t slot_count;
+	// Of the slots
+	std::uint64_t checksum;
+};
+
+static_assert(std::is_trivially_copyable_v<cache::slot>);
+static_assert(sizeof(header) % alignof(cache::slot) == 0);
+
+/*
+ * 64-bit FNV-1a
+ */
+std::uint64_t fnv1a(const void* const data, const std::size_t size) noexcept {
+	const unsigned char* const bytes = static_cast<const unsigned char*>(data);
+	std::uint64_t hash {0xCBF29CE484222325U};
+	for (std::size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001B3U;
+	}
+	return hash;
+}
+
+#ifdef DDNS_HAS_MMAP
+/*
+ * Writes all the size bytes at data to fd, however many calls it takes
+ */
+bool write_all(const int fd, const void* const data, std::size_t size) noexcept {
+	const char* bytes = static_cast<const char*>(data);
+	while (size != 0) {
+		const ssize_t written = ::write(fd, bytes, size);
+		if (written == -1 && errno == EINTR) {
+			continue;
+		}
+		if (written <= 0) {
+			return false;
+		}
+		bytes += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+#endif
+
+/*
+ * Whether slot a comes before the one of b's hashes
+ */
+bool before(const cache::slot& a, const std::uint64_t name_hash, const std::uint64_t name_check) noexcept {
+	return a.name_hash != name_hash ? a.name_hash < name_hash : a.name_check < name_check;
+}
+
+} // namespace
+
+namespace cache {
+
+std::uint64_t hash(const std::string_view name) noexcept {
+	return fnv1a(name.data(), name.size());
+}
+
+std::uint64_t check(const std::string_view name) noexcept {
+	// A multiplicative hash ended by the SplitMix64 finaliser, which has
+	// nothing in common with FNV-1a
+	std::uint64_t hash {name.size()};
+	for (const char c : name) {
+		hash = (hash + static_cast<unsigned char>(c)) * 0x9E3779B97F4A7C15U;
+	}
+	hash = (hash ^ (hash >> 30U)) * 0xBF58476D1CE4E5B9U;
+	hash = (hash ^ (hash >> 27U)) * 0x94D049BB133111EBU;
+	return hash ^ (hash >> 31U);
+}
+
+reader::reader(const std::string& path) noexcept {
+#ifdef DDNS_HAS_MMAP
+	const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		return;
+	}
+	struct stat status {};
+	if (fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(header))) {
+		close(fd);
+		return;
+	}
+	void* const mapping = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the file is closed
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return;
+	}
+	data = mapping;
+	size = static_cast<std::size_t>(status.st_size);
+#else
+	// Without mmap() the file is read in one go instead
+	std::ifstream file {path, std::ios::binary | std::ios::ate};
+	const std::streamoff file_size = file.tellg();
+	if (!file || file_size < static_cast<std::streamoff>(sizeof(header))) {
+		return;
+	}
+	char* const buffer = new char[static_cast<std::size_t>(file_size)];
+	if (!file.seekg(0).read(buffer, file_size)) {
+		delete[] buffer;
+		return;
+	}
+	data = buffer;
+	size = static_cast<std::size_t>(file_size);
+#endif
+
+	header file_header;
+	std::memcpy(&file_header, data, sizeof file_header);
+
+	const std::size_t slots_size = size - sizeof file_header;
+	if (std::memcmp(file_header.magic, file_magic, sizeof file_magic) != 0
+		|| file_header.version != file_version
+		|| file_header.slot_size != sizeof(slot)
+		|| file_header.slot_count != slots_size / sizeof(slot)
+		|| slots_size % sizeof(slot) != 0) {
+		return;
+	}
+
+	const unsigned char* const slots_data = static_cast<const unsigned char*>(data) + sizeof file_header;
+	if (fnv1a(slots_data, slots_size) != file_header.checksum) {
+		return;
+	}
+
+	slots = reinterpret_cast<const slot*>(slots_data);
+	slot_count = static_cast<std::size_t>(file_header.slot_count);
+}
+
+reader::~reader() {
+	if (data == nullptr) {
+		return;
+	}
+#ifdef DDNS_HAS_MMAP
+	munmap(data, size);
+#else
+	delete[] static_cast<char*>(data);
+#endif
+}
+
+const slot* reader::find(const std::string_view name) const noexcept {
+	const std::uint64_t name_hash = hash(name);
+	const std::uint64_t name_check = check(name);
+	const slot* const end = slots + slot_count;
+	const slot* const found = std::lower_bound(slots, end, name_hash, [name_check](const slot& a, const std::uint64_t b) {
+		return before(a, b, name_check);
+	});
+	return found != end && found->name_hash == name_hash && found->name_check == name_check ? found : nullptr;
+}
+
+bool write(const std::string& path, std::vector<slot>& slots) {
+	std::sort(slots.begin(), slots.end(), [](const slot& a, const slot& b) {
+		return before(a, b.name_hash, b.name_check);
+	});
+
+	header file_header {};
+	std::memcpy(file_header.magic, file_magic, sizeof file_magic);
+	file_header.version = file_version;
+	file_header.slot_size = sizeof(slot);
+	file_header.slot_count = slots.size();
+	file_header.checksum = fnv1a(slots.data(), slots.size() * sizeof(slot));
+
+	const std::string temporary_path = path + ".tmp";
+	std::error_code error;
+#ifdef DDNS_HAS_MMAP
+	// Without fsync() the rename could reach the disk before the data,
+	// and a crash would leave an empty or partial file in place of the
+	// old one
+	const int fd = open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1) {
+		return false;
+	}
+	const bool written = write_all(fd, &file_header, sizeof file_header)
+		&& write_all(fd, slots.data(), slots.size() * sizeof(slot))
+		&& fsync(fd) == 0;
+	if (close(fd) != 0 || !written) {
+		std::filesystem::remove(temporary_path, error);
+		return false;
+	}
+#else
+	{
+		std::ofstream file {temporary_path, std::ios::binary | std::ios::trunc};
+		file.write(reinterpret_cast<const char*>(&file_header), sizeof file_header);
+		file.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(slot)));
+		if (!file.flush()) {
+			file.close();
+			std::filesystem::remove(temporary_path, error);
+			return false;
+		}
+	}
+#endif
+
+	// Readers either see the old file or the new one, never half of it
+	std::filesystem::rename(temporary_path, path, error);
+	if (error) {
+		std::filesystem::remove(temporary_path, error);
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace cache
@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+/*
+ * The cache file, holding what's known about every record name: its zone
+ * ID and its A and AAAA records. It is a single binary file made of a
+ * header and an array of fixed-size slots sorted by two hashes of the
+ * name, so that it can be mapped in memory and searched without parsing
+ * it. The second hash, computed differently, makes two names sharing the
+ * first one as unlikely as a collision of a 128-bit hash.
+ *
+ * The file is only meant to be read by the machine that wrote it, so it
+ * uses the native byte order and struct layout; the version and the slot
+ * size in the header make files written by other builds look invalid,
+ * which just makes the cache start empty.
+ */
+
+#pragma once
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::uint8_t, std::uint32_t, std::uint64_t, std::int64_t */
+#include <string> /* std::string */
+#include <string_view> /* std::string_view */
+#include <vector> /* std::vector */
+
+#include <ddns/cloudflare-ddns.h>
+
+namespace cache {
+
+/*
+ * Names pointing to more records than this keep only their zone ID
+ */
+constexpr std::size_t max_records {4};
+
+struct slot {
+	std::uint64_t name_hash;
+	std::uint64_t name_check;
+	// Seconds since the epoch, 0 if the records are unknown
+	std::int64_t verified_at;
+	char zone_id[DDNS_ZONE_ID_LENGTH + 1U];
+	std::uint8_t records_count;
+	ddns_record records[max_records];
+};
+
+std::uint64_t hash(std::string_view name) noexcept;
+
+/*
+ * The second hash of name, unrelated to hash()
+ */
+std::uint64_t check(std::string_view name) noexcept;
+
+/*
+ * A cache file mapped read-only in memory. A missing, corrupted or
+ * incompatible file is treated as an empty one.
+ */
+class reader {
+public:
+	explicit reader(const std::string& path) noexcept;
+	~reader();
+
+	reader(const reader&) = delete;
+	reader& operator=(const reader&) = delete;
+
+	/*
+	 * The slot of name, or nullptr if it isn't cached
+	 */
+	const slot* find(std::string_view name) const noexcept;
+
+	/*
+	 * Whether there were no valid slots to read
+	 */
+	bool empty() const noexcept {
+		return slot_count == 0;
+	}
+
+private:
+	void* data {nullptr};
+	std::size_t size {0};
+	const slot* slots {nullptr};
+	std::size_t slot_count {0};
+};
+
+/*
+ * Replaces the cache file with one holding slots, atomically: it's first
+ * written to a temporary file, which is flushed to the disk and then
+ * renamed, so that a crash leaves either the old file or the new one.
+ * slots is sorted in the process. Returns false on failure.
+ */
+bool write(const std::string& path, std::vector<slot>& slots);
+
+} // namespace cache
@@ -12,49 +12,28 @@ namespace std {
 }
 #endif
 
+#include <algorithm> /* std::copy_n, std::min */
 #include <array> /* std::array */
+#include <chrono> /* std::chrono::seconds */
+#include <climits> /* INT_MAX */
 #include <cstddef> /* std::size_t */
+#include <cstdint> /* std::int64_t */
 #include <cstdio> /* std::printf, std::fprintf, std::puts, std::fputs */
-#include <cstring> /* std::memchr, std::memcpy */
-#include <filesystem> /* std::filesystem::path::preferred_separator */
-#include <fstream> /* std::ifstream, std::ofstream */
-#include <optional> /* std::optional */
+#include <cstring> /* std::memchr, std::memcpy, std::strcmp, std::strlen */
+#include <filesystem> /* std::filesystem::path::preferred_separator, std::filesystem::remove, std::filesystem::remove_all */
 #include <string> /* std::string */
 #include <string_view> /* std::string_view */
+#include <system_error> /* std::error_code */
+#include <utility> /* std::pair */
+#include <vector> /* std::vector */
 
 #include <INIReader.h>
+#include <ini.h>
 #include <ddns/cloudflare-ddns.h>
+#include "cache.hpp"
+#include "metrics.hpp"
 #include "paths.hpp"
-
-struct static_buffer {
-	static constexpr std::size_t capacity {CURL_MAX_WRITE_SIZE / 2}; // typical requests are smaller than 2000 bytes
-	std::size_t size {0};
-	char buffer[capacity];
-};
-
-static std::size_t write_data(
-	char* DDNS_RESTRICT incoming_buffer,
-	const std::size_t /*size*/, // size will always be 1
-	const std::size_t count,
-	static_buffer* DDNS_RESTRICT data
-) DDNS_NOEXCEPT {
-	// Check if the static buffer can handle all the new data
-	if (data->size + count >= static_buffer::capacity) {
-		return 0;
-	}
-	// Append to the buffer
-	std::memcpy(data->buffer + data->size, incoming_buffer, /*size **/ count);
-	// Increase the current size
-	data->size += /*size **/ count;
-	// null-terminate the buffer (so that it can be used as a C string)
-	// data->buffer[data->size] = '\0';
-	return /*size **/ count;
-}
-
-static void curl_cleanup(CURL** curl) {
-	curl_easy_cleanup(*curl);
-	curl_global_cleanup();
-}
+#include "service.hpp"
 
 /*
  * Same as the POSIX strnlen():
@@ -69,228 +48,969 @@ static std::size_t ddns_strnlen(const char* const s, const size_t maxlen) {
 }
 
 /*
- * key must include quotes
+ * A DNS record name to keep up to date, along with the API token used to
+ * manage it and its zone ID, which is empty until the cache or
+ * check_records() fills it
+ */
+struct record_entry {
+	std::string api_token;
+	std::string name;
+	// +1 because of '\0'
+	std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id {};
+	// The A and AAAA records of the name as Cloudflare last reported them,
+	// at verified_at seconds since the epoch, or 0 if they're unknown
+	std::vector<ddns_record> known_records {};
+	std::int64_t verified_at {0};
+	// Whether the above changed since the cache was last written
+	bool cache_changed {false};
+};
+
+/*
+ * Where the local addresses come from: the network interfaces, Cloudflare's
+ * trace endpoint, or the former with the latter as a fallback
+ */
+enum class ip_source {
+	automatic,
+	interface,
+	trace
+};
+
+/*
+ * How check_records() gets the local addresses and how much it trusts the
+ * known records of each name, as set in the configuration file
  */
-static std::optional<std::string_view> get_json_value(const std::string_view json, const std::string_view key) {
-	const size_t key_start = json.find(key);
-	if (key_start == std::string_view::npos) {
-		return {};
+struct check_options {
+	ip_source source {ip_source::automatic};
+	// Seconds for which the known records are used to update them without
+	// looking them up first. 0 disables the record cache.
+	long cache_ttl {86400};
+	// Seconds after which the known records are looked up again even if
+	// the local addresses didn't change, to notice edits made elsewhere
+	long verify_interval {3600};
+	// Seconds a check may take at most, retries included. 0 disables the
+	// limit, leaving only the timeout of each request.
+	long timeout {60};
+};
+
+/*
+ * How the requests made to Cloudflare are reported with --stats
+ */
+enum class stats_format {
+	none,
+	text,
+	json
+};
+
+/*
+ * The metrics of the checks, and where they're exported as set in the
+ * configuration file
+ */
+struct exported_metrics {
+	metrics::registry registry;
+	// Written after every check for the textfile collector, if not empty
+	std::string file;
+	// host:port served while running as a daemon, if not empty
+	std::string listen;
+};
+
+static std::int64_t seconds_since_epoch() {
+	return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Adds a record entry for every name in a list separated by spaces or
+ * commas, returning false if a name is not valid
+ */
+static bool append_records(std::vector<record_entry>& records, const std::string& api_token, const std::string_view names) {
+	constexpr std::string_view separators {" \t,"};
+
+	for (std::size_t begin = names.find_first_not_of(separators); begin != std::string_view::npos; begin = names.find_first_not_of(separators, begin)) {
+		const std::size_t end = std::min(names.find_first_of(separators, begin), names.length());
+		const std::string_view name = names.substr(begin, end - begin);
+		begin = end;
+
+		/* Make sure to avoid path traversal vulnerabilities */
+		if (name.find('/') != std::string_view::npos
+			|| name.find(std::filesystem::path::preferred_separator) != std::string_view::npos) {
+			std::fputs("Record names cannot contain path separators!\n", stderr);
+			return false;
+		}
+
+		records.push_back({api_token, std::string{name}, {}});
 	}
 
-	const size_t key_end = key_start + key.length();
-	if (key_end == std::string_view::npos) {
-		return {};
+	return true;
+}
+
+/*
+ * inih handler collecting the names of the [ddns.*] sections, each of
+ * them holding additional records managed with a different API token
+ */
+extern "C" int collect_ddns_section(void* const user, const char* const section, const char* /*name*/, const char* /*value*/) {
+	auto& sections = *static_cast<std::vector<std::string>*>(user);
+	const std::string_view section_sv {section};
+	if (section_sv.substr(0, 5) == "ddns." && (sections.empty() || sections.back() != section_sv)) {
+		sections.emplace_back(section_sv);
 	}
+	return 1;
+}
 
-	const size_t value_start = json.find('"', key_end + 1) + 1;
-	if (value_start == std::string_view::npos) {
-		return {};
+/*
+ * Searches the zone ID of a record. Returns false if the zone ID could not
+ * be found.
+ */
+static bool search_zone_id(ddns_client* const client, record_entry& record, metrics::registry& metrics) {
+	const ddns_error error = ddns_client_search_zone_id(client, record.api_token.c_str(), record.name.c_str(), record.zone_id.size(), record.zone_id.data());
+	if (error) {
+		metrics.count_error(error);
+		std::fprintf(stderr, "Error getting the Zone ID of %s\n", record.name.c_str());
+		record.zone_id[0] = '\0';
+		return false;
 	}
+	record.cache_changed = true;
+	return true;
+}
+
+static std::string cache_path() {
+	return std::string{cache_dir} + "records.cache";
+}
 
-	const size_t value_end = json.find('"', value_start + 1);
-	if (value_end == std::string_view::npos) {
-		return {};
+static std::string resolve_cache_path() {
+	return std::string{cache_dir} + "resolve.cache";
+}
+
+/*
+ * Removes the files of the cache used before records.cache, which had a
+ * file with the zone ID of each name, and a directory with the known
+ * records of each one. Only files as big as a zone ID are removed, so
+ * that a name like "records.cache" can't take the new cache with it.
+ */
+static void remove_legacy_cache(const std::vector<record_entry>& records) {
+	std::error_code error;
+	for (const record_entry& record : records) {
+		const std::string path {std::string{cache_dir} + record.name};
+		if (std::filesystem::is_regular_file(path, error) && std::filesystem::file_size(path, error) == record.zone_id.size()) {
+			std::filesystem::remove(path, error);
+		}
 	}
+	std::filesystem::remove_all(std::string{cache_dir} + "records", error);
+}
+
+/*
+ * Reads the zone IDs and the known records of every name from the cache.
+ * The cache file is only mapped in memory, so this costs the same no
+ * matter how many names there are, and it also works if the filesystem is
+ * mounted read-only.
+ */
+static void load_cache(std::vector<record_entry>& records) {
+	const cache::reader reader {cache_path()};
+
+	if (reader.empty()) {
+		remove_legacy_cache(records);
+	}
+
+	for (record_entry& record : records) {
+		const cache::slot* const slot = reader.find(record.name);
+		if (slot == nullptr || ddns_strnlen(slot->zone_id, sizeof slot->zone_id) != DDNS_ZONE_ID_LENGTH) {
+			continue;
+		}
+		std::memcpy(record.zone_id.data(), slot->zone_id, record.zone_id.size());
 
-	return std::string_view(json.data() + value_start, value_end - value_start);
+		if (slot->verified_at == 0 || slot->records_count == 0 || slot->records_count > cache::max_records) {
+			continue;
+		}
+		record.known_records.assign(slot->records, slot->records + slot->records_count);
+		record.verified_at = slot->verified_at;
+	}
 }
 
-int main(const int argc, char* argv[]) {
-	std::string api_token;
-	std::string record_name;
+/*
+ * Rewrites the cache if anything changed since it was last read or
+ * written. Errors are ignored, as the cache is only an optimisation.
+ */
+static void save_cache(std::vector<record_entry>& records) {
+	bool changed = false;
+	for (const record_entry& record : records) {
+		changed = changed || record.cache_changed;
+	}
+	if (!changed) {
+		return;
+	}
 
-	if (argc == 1 || argc == 3) {
-		if (argc == 3 && std::strcmp(argv[1], "--config") != 0) {
-			api_token = argv[1];
-			record_name = argv[2];
+	std::vector<cache::slot> slots;
+	slots.reserve(records.size());
+	for (record_entry& record : records) {
+		record.cache_changed = false;
+		if (record.zone_id[0] == '\0') {
+			continue;
 		}
-		else {
-			const std::string config_file {argc == 1 ? config_path : argv[2]};
-			const INIReader reader {config_file};
+		cache::slot& slot = slots.emplace_back();
+		slot.name_hash = cache::hash(record.name);
+		slot.name_check = cache::check(record.name);
+		std::memcpy(slot.zone_id, record.zone_id.data(), sizeof slot.zone_id);
+		if (record.verified_at != 0 && record.known_records.size() <= cache::max_records) {
+			slot.verified_at = record.verified_at;
+			slot.records_count = static_cast<std::uint8_t>(record.known_records.size());
+			std::copy_n(record.known_records.begin(), record.known_records.size(), slot.records);
+		}
+	}
 
-			if (reader.ParseError() == -1) {
-				std::fprintf(stderr, "Unable to open %s\n", config_file.c_str());
-				return EXIT_FAILURE;
+	cache::write(cache_path(), slots);
+}
+
+/*
+ * Calls save_cache() when it goes out of scope
+ */
+struct cache_writer {
+	std::vector<record_entry>& records;
+
+	~cache_writer() {
+		save_cache(records);
+	}
+};
+
+/*
+ * Zones with at least this many records to check are listed all at once,
+ * which takes a request every DDNS_RECORDS_PER_PAGE records of the zone,
+ * instead of being queried once per name
+ */
+constexpr std::size_t zone_listing_threshold {8};
+
+/*
+ * How long to wait for each local address asked to Cloudflare. They're
+ * asked at once, so a network without working IPv6 only delays the check
+ * by this much, instead of stalling it until curl gives up.
+ */
+constexpr long trace_timeout_ms {5000};
+
+/*
+ * Looks up the records of the queries, listing the zones with many
+ * records to check and querying the other records concurrently. Returns
+ * false if a lookup failed.
+ */
+static bool lookup_records(ddns_client* const client, std::vector<ddns_record_query>& queries) {
+	std::vector<ddns_record_query> single_queries;
+	std::vector<std::size_t> single_queries_index;
+	std::vector<bool> done(queries.size(), false);
+
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		if (done[i]) {
+			continue;
+		}
+
+		std::vector<std::size_t> zone_queries {i};
+		for (std::size_t j = i + 1; j < queries.size(); ++j) {
+			if (std::strcmp(queries[i].zone_id, queries[j].zone_id) == 0 && std::strcmp(queries[i].api_token, queries[j].api_token) == 0) {
+				zone_queries.push_back(j);
 			}
-			else if (int error = reader.ParseError(); error > 0) {
-				std::fprintf(stderr, "Error parsing %s on line %d\n", config_file.c_str(), error);
-				return EXIT_FAILURE;
+		}
+
+		ddns_zone_index* index {nullptr};
+		if (zone_queries.size() < zone_listing_threshold
+			|| ddns_client_list_records(client, queries[i].api_token, queries[i].zone_id, &index) != DDNS_ERROR_OK) {
+			// Fall back to querying each name if the listing fails
+			for (const std::size_t j : zone_queries) {
+				single_queries.push_back(queries[j]);
+				single_queries_index.push_back(j);
+				done[j] = true;
 			}
+			continue;
+		}
 
-			api_token   = reader.GetString("ddns", "api_token",   "token");
-			record_name = reader.GetString("ddns", "record_name", "name");
+		for (const std::size_t j : zone_queries) {
+			ddns_record_query& query = queries[j];
+			query.error = ddns_zone_index_find(index, query.record_name, query.records_size, query.records, &query.records_count);
+			done[j] = true;
+		}
 
-			if (api_token == "token" || record_name == "name") {
-				std::fprintf(stderr, "Error parsing %s\n", config_file.c_str());
-				return EXIT_FAILURE;
-			}
+		ddns_zone_index_destroy(index);
+	}
+
+	bool ok = true;
+
+	if (!single_queries.empty()) {
+		ok = ddns_client_get_records_multi(client, single_queries.size(), single_queries.data()) == DDNS_ERROR_OK;
+		for (std::size_t i = 0; i < single_queries.size(); ++i) {
+			queries[single_queries_index[i]] = single_queries[i];
 		}
 	}
-	else {
-		std::fprintf(stderr,
-			"Bad usage! You can run the program without arguments and load the config in %s "
-			"or pass the API token and the DNS record name as arguments\n", config_path.data());
-		return EXIT_FAILURE;
+
+	return ok;
+}
+
+/*
+ * Looks up the queries at indices, see lookup_records()
+ */
+static bool lookup_records(ddns_client* const client, std::vector<ddns_record_query>& queries, const std::vector<std::size_t>& indices) {
+	if (indices.empty()) {
+		return true;
 	}
 
-	/* Make sure to avoid path traversal vulnerabilities */
-	if (record_name.find('/') != std::string::npos
-		|| record_name.find(std::filesystem::path::preferred_separator) != std::string::npos) {
-		std::fputs("Record names cannot contain path separators!\n", stderr);
-		return EXIT_FAILURE;
+	std::vector<ddns_record_query> subset;
+	subset.reserve(indices.size());
+	for (const std::size_t i : indices) {
+		subset.push_back(queries[i]);
 	}
 
-	curl_global_init(CURL_GLOBAL_DEFAULT);
+	const bool ok = lookup_records(client, subset);
 
-	CURL* curl_handle {curl_easy_init()};
-	static_buffer dns_response;
+	for (std::size_t i = 0; i < indices.size(); ++i) {
+		queries[indices[i]] = subset[i];
+	}
 
-	curl_easy_setopt(curl_handle, CURLOPT_NOPROGRESS, 1L);
-	curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1L);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, write_data);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, &dns_response);
-	curl_easy_setopt(curl_handle, CURLOPT_TCP_FASTOPEN, 1L);
-	curl_easy_setopt(curl_handle, CURLOPT_PROTOCOLS, CURLPROTO_HTTPS);
-	curl_easy_setopt(curl_handle, CURLOPT_DEFAULT_PROTOCOL, "https");
+	return ok;
+}
 
-	ddns_error error = DDNS_ERROR_OK;
-	// +1 because of '\0'
-	std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
-
-	const std::string cache_path = std::string{cache_dir} + record_name;
-
-	// Here the cache file is opened twice, the first time read-only and
-	// the second time write-only. This is because if the filesystem is
-	// mounted read-only I'm still able to read the cache, if available.
-	const bool cache_miss = std::ifstream{cache_path, std::ios::binary}
-		.read(zone_id.data(), zone_id.size())
-		.fail();
-
-	if (cache_miss || ddns_strnlen(zone_id.data(), zone_id.size()) != DDNS_ZONE_ID_LENGTH) {
-		error = ddns_search_zone_id(api_token.c_str(), record_name.c_str(), zone_id.size(), zone_id.data());
-		if (error) {
-			std::fputs("Error getting the Zone ID\n", stderr);
-			curl_cleanup(&curl_handle);
-			return EXIT_FAILURE;
+/*
+ * Checks all the records once, updating them if needed. The lookups and
+ * updates run concurrently, or in bulk for records of the same zone. The
+ * zone IDs are searched only if they are empty, so that a daemon can keep
+ * them in memory between checks, and the cache is written once at the end
+ * if anything changed.
+ *
+ * Names whose known records are younger than options.cache_ttl aren't
+ * looked up: if the local addresses match them, and they were verified
+ * less than options.verify_interval seconds ago, nothing is sent to
+ * Cloudflare at all, and if they don't match they're updated right away.
+ *
+ * The local addresses are read from options.source, and traced is set if
+ * any of them had to be asked to Cloudflare. The errors and updates are
+ * counted in metrics. Returns EXIT_SUCCESS or EXIT_FAILURE.
+ */
+static int check_records(ddns_client* const client, std::vector<record_entry>& records, const check_options& options, metrics::registry& metrics, bool& traced) {
+	const cache_writer writer {records};
+	int result = EXIT_SUCCESS;
+	const std::int64_t now = seconds_since_epoch();
+
+	// A flaky network can't hold a check past its time, however many
+	// requests are retried. The value was already validated.
+	(void) ddns_client_set_deadline(client, options.timeout * 1000);
+
+	// Room for a few more records than the two I can handle, so that I can
+	// still find both the A and AAAA records if a name has more of them
+	using dns_records_t = std::array<ddns_record, 8>;
+	std::vector<dns_records_t> dns_records(records.size());
+	std::vector<ddns_record_query> queries;
+	queries.reserve(records.size());
+	// The entry of each query, and whether it was answered by the cache
+	std::vector<std::size_t> query_entries;
+	std::vector<bool> from_cache;
+	std::vector<std::size_t> lookups;
+
+	for (std::size_t i = 0; i < records.size(); ++i) {
+		record_entry& entry = records[i];
+		if (entry.zone_id[0] == '\0' && !search_zone_id(client, entry, metrics)) {
+			result = EXIT_FAILURE;
+			continue;
+		}
+
+		ddns_record_query query {
+			entry.api_token.c_str(),
+			entry.zone_id.data(),
+			entry.name.c_str(),
+			dns_records[i].size(), dns_records[i].data(),
+			0, DDNS_ERROR_OK
+		};
+
+		// A clock going backwards makes the known records expire too
+		const std::int64_t age = now - entry.verified_at;
+		const bool cached = options.cache_ttl > 0 && entry.verified_at != 0 && age >= 0 && age < options.cache_ttl;
+		if (cached) {
+			query.records_count = std::min(entry.known_records.size(), query.records_size);
+			std::copy_n(entry.known_records.begin(), query.records_count, query.records);
 		}
-		// This also writes '\0'
-		std::ofstream{cache_path, std::ios::binary}
-			.write(zone_id.data(), zone_id.size());
+		else {
+			lookups.push_back(queries.size());
+		}
+
+		queries.push_back(query);
+		query_entries.push_back(i);
+		from_cache.push_back(cached);
 	}
 
-	error = ddns_get_record_raw(api_token.c_str(), zone_id.data(), record_name.c_str(), &curl_handle);
-	if (error) {
-		std::fprintf(stderr,
-			"Error getting DNS record info\n"
-			"API response: %.*s\n", static_cast<int>(dns_response.size), dns_response.buffer);
-		curl_cleanup(&curl_handle);
-		return EXIT_FAILURE;
+	if (!lookup_records(client, queries, lookups)) {
+		result = EXIT_FAILURE;
 	}
 
 	// The first element contains the IPv4 address, while the second
 	// contains the IPv6 one.
 	constexpr const char* ipv_c_str[2] = {"IPv4", "IPv6"};
 	constexpr const char* type_c_str[2] = {"A", "AAAA"};
-	std::string_view record_ids[2];
-	std::string_view record_ips[2];
-	std::size_t records_count = 0;
 
-	const char* id_pos = dns_response.buffer;
-	const char* type_pos = dns_response.buffer;
-	const char* dns_ip_pos = dns_response.buffer;
-	while (true) {
-		const std::optional id = get_json_value(std::string_view(id_pos, dns_response.size - (id_pos - dns_response.buffer)), "\"id\"");
-		if (!id.has_value()) {
-			break;
+	// The local addresses are the same for every record, so each one is
+	// only fetched once, the first time it's needed
+	std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ips[2];
+	bool has_local_ip[2] = {false, false};
+	bool fetched_local_ip[2] = {false, false};
+	traced = false;
+
+	const auto fetch_local_ips = [&](const bool (&wanted)[2]) {
+		ddns_local_ip traces[2];
+		std::size_t traces_count = 0;
+		for (unsigned int i = 0; i < 2; i++) {
+			if (!wanted[i] || fetched_local_ip[i]) {
+				continue;
+			}
+			fetched_local_ip[i] = true;
+			// An address of the network interfaces is read without any
+			// request, but behind NAT there's none and it has to be asked
+			// to Cloudflare
+			if (options.source != ip_source::trace && ddns_get_interface_ip(i, local_ips[i].size(), local_ips[i].data()) == DDNS_ERROR_OK) {
+				has_local_ip[i] = true;
+			}
+			else if (options.source == ip_source::interface) {
+				std::fprintf(stderr, "Error getting the local %s address\n", ipv_c_str[i]);
+				metrics.count_error(DDNS_ERROR_GENERIC);
+			}
+			else {
+				traces[traces_count++] = ddns_local_ip {i == 1, trace_timeout_ms, {}, DDNS_ERROR_OK};
+			}
+		}
+
+		// Both families are asked at once, so that this takes as long as
+		// the slowest of them rather than their sum
+		if (traces_count == 0) {
+			return;
+		}
+		(void) ddns_client_get_local_ips(client, traces_count, traces);
+		for (std::size_t i = 0; i < traces_count; i++) {
+			const unsigned int family = traces[i].ipv6;
+			if (traces[i].error) {
+				std::fprintf(stderr, "Error getting the local %s address\n", ipv_c_str[family]);
+				metrics.count_error(traces[i].error);
+				continue;
+			}
+			std::memcpy(local_ips[family].data(), traces[i].ip, local_ips[family].size());
+			has_local_ip[family] = true;
+			traced = true;
+		}
+	};
+
+	// Known records still matching the local addresses are looked up once
+	// in a while anyway, in case they were changed elsewhere
+	std::vector<std::size_t> verifications;
+	const auto verification_due = [&](const std::size_t i) {
+		return from_cache[i] && now - records[query_entries[i]].verified_at >= options.verify_interval;
+	};
+	bool verification_ips[2] = {false, false};
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		for (std::size_t j = 0; verification_due(i) && j < queries[i].records_count; ++j) {
+			verification_ips[queries[i].records[j].aaaa] = true;
 		}
-		id_pos = id->data();
+	}
+	fetch_local_ips(verification_ips);
 
-		const std::optional type = get_json_value(std::string_view(type_pos, dns_response.size - (type_pos - dns_response.buffer)), "\"type\"");
-		if (!type.has_value()) {
-			break;
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		if (!verification_due(i)) {
+			continue;
+		}
+		bool unchanged = true;
+		for (std::size_t j = 0; j < queries[i].records_count; ++j) {
+			const ddns_record& record = queries[i].records[j];
+			unchanged = unchanged && has_local_ip[record.aaaa] && std::strcmp(local_ips[record.aaaa].data(), record.content) == 0;
 		}
-		type_pos = type->data();
+		if (unchanged) {
+			queries[i].records_count = 0;
+			verifications.push_back(i);
+			from_cache[i] = false;
+		}
+	}
 
-		const std::optional dns_ip = get_json_value(std::string_view(dns_ip_pos, dns_response.size - (dns_ip_pos - dns_response.buffer)), "\"content\"");
-		if (!dns_ip.has_value()) {
-			break;
+	if (!lookup_records(client, queries, verifications)) {
+		result = EXIT_FAILURE;
+	}
+
+	// Remember what Cloudflare answered
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		const ddns_record_query& query = queries[i];
+		if (from_cache[i] || query.error) {
+			continue;
 		}
-		dns_ip_pos = dns_ip->data();
+		record_entry& entry = records[query_entries[i]];
+		entry.known_records.assign(query.records, query.records + std::min(query.records_count, query.records_size));
+		entry.verified_at = entry.known_records.empty() ? 0 : now;
+		entry.cache_changed = entry.cache_changed || options.cache_ttl > 0;
+	}
+
+	// The A and AAAA record of each query, if any
+	std::vector<std::array<const ddns_record*, 2>> query_records(queries.size(), {nullptr, nullptr});
+	bool needs_ip[2] = {false, false};
 
-		if (type == "A") {
-			record_ids[0] = *id;
-			record_ips[0] = *dns_ip;
-			records_count++;
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		const ddns_record_query& query = queries[i];
+
+		if (query.error) {
+			std::fprintf(stderr, "Error getting DNS record info of %s\n", query.record_name);
+			metrics.count_error(query.error);
+			continue;
 		}
-		else if (type == "AAAA") {
-			record_ids[1] = *id;
-			record_ips[1] = *dns_ip;
-			records_count++;
+		if (query.records_count == 0) {
+			std::fprintf(stderr, "%s doesn't point to any A or AAAA record\n", query.record_name);
+			result = EXIT_FAILURE;
+			continue;
+		}
+		else if (query.records_count > 2) {
+			std::fprintf(stderr, "%s points to more than two records, things might not work as expected\n", query.record_name);
+		}
+
+		for (std::size_t j = 0; j < query.records_count && j < query.records_size; ++j) {
+			query_records[i][query.records[j].aaaa] = &query.records[j];
+			needs_ip[query.records[j].aaaa] = true;
 		}
 	}
 
-	if (records_count == 0) {
-		std::fprintf(stderr, "%s doesn't point to any A or AAAA record\n", record_name.c_str());
-		curl_cleanup(&curl_handle);
+	fetch_local_ips(needs_ip);
+
+	if ((needs_ip[0] || needs_ip[1]) && !has_local_ip[0] && !has_local_ip[1]) {
 		return EXIT_FAILURE;
 	}
-	else if (records_count > 2) {
-		std::fprintf(stderr, "%s points to more than two records, things might not work as expected\n", record_name.c_str());
+
+	// Only prefix messages with the record name if there's more than one
+	const bool show_names = records.size() > 1;
+
+	std::vector<ddns_record_update> updates;
+	// The query and the family (0 for IPv4, 1 for IPv6) of each update
+	std::vector<std::pair<std::size_t, unsigned int>> updates_source;
+
+	for (std::size_t i = 0; i < queries.size(); ++i) {
+		for (unsigned int j = 0; j < 2; j++) {
+			const ddns_record* const record = query_records[i][j];
+			if (record == nullptr || !has_local_ip[j]) {
+				continue;
+			}
+			if (std::strcmp(local_ips[j].data(), record->content) == 0) {
+				std::printf("%s%sThe %s record is up to date\n", show_names ? queries[i].record_name : "", show_names ? ": " : "", type_c_str[j]);
+				continue;
+			}
+			updates.push_back({
+				queries[i].api_token,
+				queries[i].zone_id,
+				record->id,
+				local_ips[j].data(),
+				{}, DDNS_ERROR_OK
+			});
+			updates_source.emplace_back(i, j);
+		}
 	}
 
-	std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ips[2];
+	if (updates.empty()) {
+		return result;
+	}
 
-	unsigned int local_ips_count = 0;
+	// The records of a zone are updated all at once with a batch request,
+	// while the records alone in their zone are updated concurrently
+	std::vector<ddns_record_update> single_updates;
+	std::vector<std::size_t> single_updates_index;
+	std::vector<bool> batched(updates.size(), false);
 
-	for (unsigned int i = 0; i < 2; i++) {
-		if (record_ips[i].empty()) {
+	for (std::size_t i = 0; i < updates.size(); ++i) {
+		if (batched[i]) {
 			continue;
 		}
-		error = ddns_get_local_ip(i, local_ips[i].size(), local_ips[i].data());
-		if (error) {
-			std::fprintf(stderr, "Error getting the local %s address\n", ipv_c_str[i]);
+
+		std::vector<std::size_t> zone_updates {i};
+		for (std::size_t j = i + 1; j < updates.size(); ++j) {
+			if (std::strcmp(updates[i].zone_id, updates[j].zone_id) == 0 && std::strcmp(updates[i].api_token, updates[j].api_token) == 0) {
+				zone_updates.push_back(j);
+			}
+		}
+
+		if (zone_updates.size() == 1) {
+			single_updates.push_back(updates[i]);
+			single_updates_index.push_back(i);
 			continue;
 		}
-		local_ips_count++;
-
-		if (local_ips[i].data() != record_ips[i]) {
-			// record_ids isn't NULL-terminated since it's just a view of
-			// dns_response, so I need to create a NULL-termiated C string
-			// manually. record_ids.length() and DDNS_RECORD_ID_LENGTH are
-			// the same.
-			char id[DDNS_RECORD_ID_LENGTH + 1];
-			std::memcpy(id, record_ids[i].data(), DDNS_RECORD_ID_LENGTH);
-			id[DDNS_RECORD_ID_LENGTH] = '\0';
-
-			dns_response.size = 0;
-			if (ddns_update_record_raw(
-				api_token.c_str(),
-				zone_id.data(),
-				id,
-				local_ips[i].data(),
-				&curl_handle
-			) != DDNS_ERROR_OK) {
-				std::fprintf(stderr, "Error updating the %s record\n", type_c_str[i]);
-				curl_cleanup(&curl_handle);
-				return EXIT_FAILURE;
+
+		std::vector<ddns_record> batch(zone_updates.size());
+		for (std::size_t j = 0; j < zone_updates.size(); ++j) {
+			const ddns_record_update& update = updates[zone_updates[j]];
+			std::memcpy(batch[j].id, update.record_id, sizeof batch[j].id);
+			std::memcpy(batch[j].content, update.new_ip, std::strlen(update.new_ip) + 1);
+		}
+
+		const ddns_error error = ddns_client_update_records_batch(client, updates[i].api_token, updates[i].zone_id, batch.size(), batch.data());
+
+		for (std::size_t j = 0; j < zone_updates.size(); ++j) {
+			ddns_record_update& update = updates[zone_updates[j]];
+			batched[zone_updates[j]] = true;
+			update.error = error;
+			if (!error) {
+				std::memcpy(update.record_ip, batch[j].content, sizeof update.record_ip);
 			}
+		}
+	}
 
-			const std::optional new_ip = get_json_value(std::string_view(dns_response.buffer, dns_response.size), "\"content\"");
-			if (!new_ip.has_value()) {
-				fputs("Something went very wrong\n", stderr);
-				return 1;
+	if (!single_updates.empty()) {
+		// The outcome of each update is checked below
+		static_cast<void>(ddns_client_update_records_multi(client, single_updates.size(), single_updates.data()));
+		for (std::size_t i = 0; i < single_updates.size(); ++i) {
+			updates[single_updates_index[i]] = single_updates[i];
+		}
+	}
+
+	for (std::size_t i = 0; i < updates.size(); ++i) {
+		const auto [query, ipv] = updates_source[i];
+		const char* const name = show_names ? queries[query].record_name : "";
+		const char* const separator = show_names ? ": " : "";
+		record_entry& entry = records[query_entries[query]];
+
+		if (updates[i].error) {
+			std::fprintf(stderr, "%s%sError updating the %s record\n", name, separator, type_c_str[ipv]);
+			metrics.count_error(updates[i].error);
+			result = EXIT_FAILURE;
+			// The known records might be the reason, for example if the
+			// record was deleted, so the next check looks them up again
+			entry.known_records.clear();
+			entry.verified_at = 0;
+		}
+		else {
+			std::printf("%s%sNew %s: %s\n", name, separator, ipv_c_str[ipv], updates[i].record_ip);
+			metrics.count_update();
+			for (ddns_record& known : entry.known_records) {
+				if (std::strcmp(known.id, updates[i].record_id) == 0) {
+					std::memcpy(known.content, updates[i].record_ip, sizeof known.content);
+				}
 			}
+		}
+		entry.cache_changed = entry.cache_changed || options.cache_ttl > 0;
+	}
+
+	return result;
+}
+
+/*
+ * Where the stats of the requests go: printed as chosen with --stats, and
+ * counted in the metrics if any are exported
+ */
+struct stats_sinks {
+	stats_format format {stats_format::none};
+	metrics::registry* metrics {nullptr};
+};
+
+/*
+ * Stats callback counting every request in the metrics and printing it on
+ * stderr, either as text or as a JSON object per line, as chosen by the
+ * stats_sinks pointed by user
+ */
+extern "C" void report_stats(const ddns_stats* const stats, void* const user) {
+	const stats_sinks& sinks = *static_cast<const stats_sinks*>(user);
+	if (sinks.metrics != nullptr) {
+		sinks.metrics->observe(*stats);
+	}
+	if (sinks.format == stats_format::none) {
+		return;
+	}
+
+	const char* const endpoint = metrics::endpoint_names[stats->endpoint];
+	if (sinks.format == stats_format::json) {
+		std::fprintf(stderr,
+			"{\"endpoint\":\"%s\",\"status\":%ld,\"attempts\":%u,\"reused_connection\":%s,"
+			"\"namelookup_us\":%ld,\"connect_us\":%ld,\"appconnect_us\":%ld,\"starttransfer_us\":%ld,"
+			"\"total_us\":%ld,\"elapsed_us\":%ld,\"bytes_sent\":%zu,\"bytes_received\":%zu}\n",
+			endpoint, stats->status, stats->attempts, stats->reused_connection ? "true" : "false",
+			stats->namelookup_us, stats->connect_us, stats->appconnect_us, stats->starttransfer_us,
+			stats->total_us, stats->elapsed_us, stats->bytes_sent, stats->bytes_received
+		);
+		return;
+	}
+	std::fprintf(stderr,
+		"%s: status %ld, %u attempt%s, %s connection, lookup %.1f ms, connect %.1f ms, TLS %.1f ms, "
+		"first byte %.1f ms, total %.1f ms, elapsed %.1f ms, %zu bytes sent, %zu received\n",
+		endpoint, stats->status, stats->attempts, stats->attempts == 1 ? "" : "s", stats->reused_connection ? "reused" : "new",
+		stats->namelookup_us / 1000.0, stats->connect_us / 1000.0, stats->appconnect_us / 1000.0,
+		stats->starttransfer_us / 1000.0, stats->total_us / 1000.0, stats->elapsed_us / 1000.0,
+		stats->bytes_sent, stats->bytes_received
+	);
+}
+
+/*
+ * Runs check_records() and counts its outcome, writing the metrics file
+ * if there's one
+ */
+static int run_check(ddns_client* const client, std::vector<record_entry>& records, const check_options& options, exported_metrics& metrics, bool& traced) {
+	const int result = check_records(client, records, options, metrics.registry, traced);
+	metrics.registry.count_check(result == EXIT_SUCCESS, seconds_since_epoch());
+	if (!metrics.file.empty() && !metrics::write_textfile(metrics.registry, metrics.file)) {
+		std::fprintf(stderr, "Error writing the metrics to %s\n", metrics.file.c_str());
+	}
+	return result;
+}
+
+/*
+ * The public addresses of the network interfaces, empty if there's none
+ */
+using interface_addresses_t = std::array<std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH>, 2>;
+
+static interface_addresses_t interface_addresses() {
+	interface_addresses_t addresses {};
+	for (unsigned int i = 0; i < 2; i++) {
+		if (ddns_get_interface_ip(i, addresses[i].size(), addresses[i].data()) != DDNS_ERROR_OK) {
+			addresses[i][0] = '\0';
+		}
+	}
+	return addresses;
+}
+
+static void notify_result(const int result) {
+	if (result == EXIT_SUCCESS) {
+		service::notify("STATUS=The records are up to date");
+	}
+	else {
+		service::notify("STATUS=The last check failed, retrying at the next interval");
+	}
+}
+
+/*
+ * Checks the records every time a public address of the network
+ * interfaces changes, staying idle in between. Addresses that had to be
+ * asked to Cloudflare, as happens behind NAT, can change without the
+ * interfaces knowing, so if any was needed the records are also checked
+ * every interval seconds.
+ */
+static void watch_records(ddns_client* const client, std::vector<record_entry>& records, const check_options& options, exported_metrics& metrics, const long interval, ddns_address_watch* const watch) {
+	// Bursts of changes, like the ones caused by the renumbering of a
+	// network, are handled with a single check
+	constexpr int debounce_ms {2000};
+	const int interval_ms = static_cast<int>(std::min(interval, long{INT_MAX / 1000}) * 1000);
+
+	// A stop requested right before a wait still ends it
+	if (ddns_address_watch_set_wake_fd(watch, service::stop_fd()) != DDNS_ERROR_OK) {
+		std::fputs("Unable to wake up the watch on signals\n", stderr);
+	}
+
+	// Read after creating the watch, so that no change can be missed
+	interface_addresses_t addresses {interface_addresses()};
+	bool traced {false};
+	notify_result(run_check(client, records, options, metrics, traced));
+
+	while (!service::stop_requested()) {
+		bool changed {false};
+		if (ddns_address_watch_wait(watch, traced ? interval_ms : -1, debounce_ms, &changed) != DDNS_ERROR_OK) {
+			std::fputs("Error watching the network interfaces, checking every interval instead\n", stderr);
+			while (service::sleep_for(std::chrono::seconds{interval})) {
+				notify_result(run_check(client, records, options, metrics, traced));
+			}
+			return;
+		}
+		if (service::stop_requested()) {
+			return;
+		}
+		if (changed) {
+			const interface_addresses_t new_addresses {interface_addresses()};
+			if (new_addresses == addresses) {
+				continue;
+			}
+			addresses = new_addresses;
+		}
+		else if (!traced) {
+			// Interrupted by a signal, or the stop pipe woke it up
+			continue;
+		}
+		notify_result(run_check(client, records, options, metrics, traced));
+	}
+}
 
-			std::printf("New %s: %.*s\n", ipv_c_str[i], static_cast<int>(new_ip->length()), new_ip->data());
+int main(const int argc, char* argv[]) {
+	std::vector<record_entry> records;
+	long interval {300};
+	check_options options;
+	bool daemon {false};
+	bool watch {false};
+	stats_sinks stats;
+	exported_metrics metrics;
+
+	// --daemon, --watch and --stats can appear anywhere, the remaining
+	// arguments keep their original meaning
+	std::vector<const char*> args;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--daemon") == 0) {
+			daemon = true;
+		}
+		else if (std::strcmp(argv[i], "--watch") == 0) {
+			daemon = true;
+			watch = true;
+		}
+		else if (std::strcmp(argv[i], "--stats") == 0) {
+			stats.format = stats_format::text;
+		}
+		else if (std::strcmp(argv[i], "--stats=json") == 0) {
+			stats.format = stats_format::json;
 		}
 		else {
-			std::printf("The %s record is up to date\n", type_c_str[i]);
+			args.push_back(argv[i]);
+		}
+	}
+
+	if (args.size() >= 2 && std::strcmp(args[0], "--config") != 0) {
+		for (std::size_t i = 1; i < args.size(); ++i) {
+			if (!append_records(records, args[0], args[i])) {
+				return EXIT_FAILURE;
+			}
 		}
 	}
+	else if (args.empty() || args.size() == 2) {
+		const std::string config_file {args.empty() ? config_path : args[1]};
+		const INIReader reader {config_file};
+
+		if (reader.ParseError() == -1) {
+			std::fprintf(stderr, "Unable to open %s\n", config_file.c_str());
+			return EXIT_FAILURE;
+		}
+		else if (int error = reader.ParseError(); error > 0) {
+			std::fprintf(stderr, "Error parsing %s on line %d\n", config_file.c_str(), error);
+			return EXIT_FAILURE;
+		}
+
+		// INIReader can't list sections, so I need to parse the file once
+		// more to find the [ddns.*] ones
+		std::vector<std::string> sections {"ddns"};
+		ini_parse(config_file.c_str(), collect_ddns_section, &sections);
 
-	curl_cleanup(&curl_handle);
+		for (const std::string& section : sections) {
+			const std::string api_token   = reader.GetString(section, "api_token",   "token");
+			const std::string record_name = reader.GetString(section, "record_name", "name");
 
-	if (local_ips_count == 0) {
+			if (api_token == "token" || record_name == "name") {
+				std::fprintf(stderr, "Error parsing %s: missing api_token or record_name in [%s]\n", config_file.c_str(), section.c_str());
+				return EXIT_FAILURE;
+			}
+			if (!append_records(records, api_token, record_name)) {
+				return EXIT_FAILURE;
+			}
+		}
+
+		interval = reader.GetInteger("ddns", "interval", interval);
+		if (interval <= 0) {
+			std::fprintf(stderr, "Error parsing %s\n", config_file.c_str());
+			return EXIT_FAILURE;
+		}
+
+		const std::string source_name = reader.GetString("ddns", "ip_source", "auto");
+		if (source_name == "interface") {
+			options.source = ip_source::interface;
+		}
+		else if (source_name == "trace") {
+			options.source = ip_source::trace;
+		}
+		else if (source_name != "auto") {
+			std::fprintf(stderr, "Error parsing %s: ip_source must be auto, interface or trace\n", config_file.c_str());
+			return EXIT_FAILURE;
+		}
+
+		options.cache_ttl = reader.GetInteger("ddns", "cache_ttl", options.cache_ttl);
+		options.verify_interval = reader.GetInteger("ddns", "verify_interval", options.verify_interval);
+		if (options.cache_ttl < 0 || options.verify_interval < 0) {
+			std::fprintf(stderr, "Error parsing %s: cache_ttl and verify_interval can't be negative\n", config_file.c_str());
+			return EXIT_FAILURE;
+		}
+
+		options.timeout = reader.GetInteger("ddns", "timeout", options.timeout);
+		if (options.timeout < 0 || options.timeout > 86400) {
+			std::fprintf(stderr, "Error parsing %s: timeout must be between 0 and 86400\n", config_file.c_str());
+			return EXIT_FAILURE;
+		}
+
+		metrics.file = reader.GetString("ddns", "metrics_file", "");
+		metrics.listen = reader.GetString("ddns", "metrics_listen", "");
+	}
+	else {
+		std::fprintf(stderr,
+			"Bad usage! You can run the program without arguments and load the config in %s "
+			"or pass the API token and one or more DNS record names as arguments. "
+			"Add --daemon to keep running and check the records periodically, "
+			"or --watch to check them when the addresses of the network interfaces change. "
+			"Add --stats or --stats=json to print how each request to Cloudflare went\n", config_path.data());
+		return EXIT_FAILURE;
+	}
+
+	if (records.empty()) {
+		std::fputs("No DNS record to update\n", stderr);
+		return EXIT_FAILURE;
+	}
+
+	load_cache(records);
+
+	// Each oneshot run starts from scratch, so the last successful check
+	// would be missing from the file as soon as one fails
+	if (!metrics.file.empty()) {
+		metrics.registry.restore_last_success(metrics::read_last_success(metrics.file));
+	}
+
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	ddns_client* client {nullptr};
+	if (ddns_client_create(&client) != DDNS_ERROR_OK) {
+		std::fputs("Unable to create the client\n", stderr);
+		curl_global_cleanup();
+		return EXIT_FAILURE;
+	}
+
+	// Remember the addresses of Cloudflare's servers between runs too, so
+	// that they aren't looked up with DoH every time
+	if (ddns_client_set_resolve_cache(client, resolve_cache_path().c_str()) != DDNS_ERROR_OK) {
+		std::fputs("Unable to use the resolve cache, looking up the servers every time\n", stderr);
+	}
+
+	// The requests are only timed if their stats go somewhere
+	const bool exporting = !metrics.file.empty() || (daemon && !metrics.listen.empty());
+	if (exporting) {
+		stats.metrics = &metrics.registry;
+	}
+	if (stats.format != stats_format::none || exporting) {
+		ddns_client_set_stats_callback(client, report_stats, &stats);
+	}
+
+	if (watch && options.source == ip_source::trace) {
+		std::fputs("--watch needs the addresses of the network interfaces, but ip_source is trace\n", stderr);
+		ddns_client_destroy(client);
+		curl_global_cleanup();
+		return EXIT_FAILURE;
+	}
+
+	ddns_address_watch* address_watch {nullptr};
+	if (watch && ddns_address_watch_create(&address_watch) != DDNS_ERROR_OK) {
+		std::fputs("Unable to watch the network interfaces\n", stderr);
+		ddns_client_destroy(client);
+		curl_global_cleanup();
 		return EXIT_FAILURE;
 	}
+
+	if (!daemon) {
+		bool traced {false};
+		const int result = run_check(client, records, options, metrics, traced);
+		ddns_client_destroy(client);
+		curl_global_cleanup();
+		return result;
+	}
+
+	// stdout is usually a pipe to the journal here, and block buffering
+	// would hold back messages until the buffer fills up
+	std::setvbuf(stdout, nullptr, _IOLBF, 0);
+
+	// Scraped from a background thread, which stops when main returns
+	metrics::server metrics_server {metrics.registry};
+	if (!metrics.listen.empty() && !metrics_server.listen(metrics.listen)) {
+		std::fprintf(stderr, "Unable to serve the metrics on %s\n", metrics.listen.c_str());
+	}
+
+	service::install_signal_handlers();
+	service::notify("READY=1");
+
+	// The client keeps its connections, TLS sessions and DNS cache between
+	// checks, so that a tick costs a few requests over warm connections
+	if (watch) {
+		watch_records(client, records, options, metrics, interval, address_watch);
+	}
+	else {
+		bool traced {false};
+		do {
+			notify_result(run_check(client, records, options, metrics, traced));
+		} while (service::sleep_for(std::chrono::seconds{interval}));
+	}
+
+	service::notify("STOPPING=1");
+
+	ddns_address_watch_destroy(address_watch);
+	ddns_client_destroy(client);
+	curl_global_cleanup();
 }
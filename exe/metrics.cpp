@@ -0,0 +1,400 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "metrics.hpp"
+
+#include <chrono> /* std::chrono::system_clock, std::chrono::seconds */
+#include <cstdio> /* std::fopen, std::fgets, std::fwrite, std::fclose, std::snprintf */
+#include <cstdlib> /* std::strtoll */
+#include <cstring> /* std::memcpy */
+#include <filesystem> /* std::filesystem::rename, std::filesystem::remove */
+#include <string_view> /* std::string_view */
+#include <system_error> /* std::error_code */
+
+#if __has_include(<sys/socket.h>) && __has_include(<poll.h>)
+#	include <netdb.h> /* getaddrinfo, freeaddrinfo, addrinfo, AI_PASSIVE */
+#	include <poll.h> /* poll, pollfd, POLLIN */
+#	include <sys/socket.h> /* socket, setsockopt, bind, listen, accept, recv, send */
+#	include <sys/time.h> /* timeval */
+#	include <unistd.h> /* close */
+#	define DDNS_HAS_SOCKETS
+#endif
+
+namespace {
+
+constexpr const char* error_names[] {"ok", "generic", "usage"};
+static_assert(sizeof error_names / sizeof error_names[0] == metrics::errors_count);
+
+constexpr std::memory_order relaxed {std::memory_order_relaxed};
+
+/*
+ * Text written to a fixed buffer, which stops growing once it's full
+ */
+class text {
+public:
+	text(char* const data, const std::size_t capacity) noexcept
+		: data_ {data}, capacity_ {capacity} {}
+
+	void add(const std::string_view literal) noexcept {
+		if (full_ || literal.size() >= capacity_ - size_) {
+			full_ = true;
+			return;
+		}
+		std::memcpy(data_ + size_, literal.data(), literal.size());
+		size_ += literal.size();
+	}
+
+	template <typename... Args>
+	void print(const char* const format, const Args... args) noexcept {
+		if (full_) {
+			return;
+		}
+		const int written {std::snprintf(data_ + size_, capacity_ - size_, format, args...)};
+		if (written < 0 || static_cast<std::size_t>(written) >= capacity_ - size_) {
+			full_ = true;
+			return;
+		}
+		size_ += static_cast<std::size_t>(written);
+	}
+
+	// 0 if the text didn't fit
+	std::size_t size() const noexcept {
+		return full_ ? 0 : size_;
+	}
+
+private:
+	char* data_;
+	std::size_t capacity_;
+	std::size_t size_ {0};
+	bool full_ {false};
+};
+
+} // namespace
+
+namespace metrics {
+
+void registry::observe(const ddns_stats& stats) noexcept {
+	const std::size_t endpoint {static_cast<std::size_t>(stats.endpoint)};
+	if (endpoint >= endpoints_count) {
+		return;
+	}
+
+	std::size_t bucket {0};
+	while (bucket < latency_buckets_count && stats.elapsed_us > latency_buckets_us[bucket]) {
+		++bucket;
+	}
+	latency_[endpoint].buckets[bucket].fetch_add(1, relaxed);
+	latency_[endpoint].sum_us.fetch_add(static_cast<std::uint64_t>(stats.elapsed_us > 0 ? stats.elapsed_us : 0), relaxed);
+
+	if (stats.status == 0 || stats.status >= 400) {
+		failures_[endpoint].fetch_add(1, relaxed);
+	}
+	if (stats.attempts > 1) {
+		retries_[endpoint].fetch_add(stats.attempts - 1, relaxed);
+	}
+}
+
+void registry::count_error(const ddns_error error) noexcept {
+	const std::size_t index {static_cast<std::size_t>(error)};
+	if (index < errors_count) {
+		errors_[index].fetch_add(1, relaxed);
+	}
+}
+
+void registry::count_update() noexcept {
+	updates_.fetch_add(1, relaxed);
+}
+
+void registry::count_check(const bool success, const std::int64_t now) noexcept {
+	checks_[success ? 0 : 1].fetch_add(1, relaxed);
+	if (success) {
+		last_success_.store(now, relaxed);
+	}
+}
+
+void registry::restore_last_success(const std::int64_t timestamp) noexcept {
+	std::int64_t last_success {last_success_.load(relaxed)};
+	while (timestamp > last_success && !last_success_.compare_exchange_weak(last_success, timestamp, relaxed)) {
+	}
+}
+
+std::size_t registry::render(char* const data, const std::size_t capacity) const noexcept {
+	return render(data, capacity, false, 0);
+}
+
+std::size_t registry::render(const std::int64_t now, char* const data, const std::size_t capacity) const noexcept {
+	return render(data, capacity, true, now);
+}
+
+std::size_t registry::render(char* const data, const std::size_t capacity, const bool served, const std::int64_t now) const noexcept {
+	text out {data, capacity};
+
+	out.add(
+		"# HELP cloudflare_ddns_request_duration_seconds Time taken by the requests, retries and waits for the rate limit included.\n"
+		"# TYPE cloudflare_ddns_request_duration_seconds histogram\n"
+	);
+	for (std::size_t endpoint = 0; endpoint < endpoints_count; ++endpoint) {
+		const histogram& latency {latency_[endpoint]};
+		const char* const name {endpoint_names[endpoint]};
+		unsigned long long cumulative {0};
+		for (std::size_t bucket = 0; bucket <= latency_buckets_count; ++bucket) {
+			cumulative += latency.buckets[bucket].load(relaxed);
+			char le[16] {"+Inf"};
+			if (bucket < latency_buckets_count) {
+				std::snprintf(le, sizeof le, "%g", static_cast<double>(latency_buckets_us[bucket]) / 1e6);
+			}
+			out.print("cloudflare_ddns_request_duration_seconds_bucket{endpoint=\"%s\",le=\"%s\"} %llu\n", name, le, cumulative);
+		}
+		out.print("cloudflare_ddns_request_duration_seconds_sum{endpoint=\"%s\"} %.6f\n", name, static_cast<double>(latency.sum_us.load(relaxed)) / 1e6);
+		out.print("cloudflare_ddns_request_duration_seconds_count{endpoint=\"%s\"} %llu\n", name, cumulative);
+	}
+
+	out.add(
+		"# HELP cloudflare_ddns_request_failures_total Requests that got no response, or an error status.\n"
+		"# TYPE cloudflare_ddns_request_failures_total counter\n"
+	);
+	for (std::size_t endpoint = 0; endpoint < endpoints_count; ++endpoint) {
+		out.print("cloudflare_ddns_request_failures_total{endpoint=\"%s\"} %llu\n", endpoint_names[endpoint], static_cast<unsigned long long>(failures_[endpoint].load(relaxed)));
+	}
+
+	out.add(
+		"# HELP cloudflare_ddns_request_retries_total Requests sent again after a temporary failure.\n"
+		"# TYPE cloudflare_ddns_request_retries_total counter\n"
+	);
+	for (std::size_t endpoint = 0; endpoint < endpoints_count; ++endpoint) {
+		out.print("cloudflare_ddns_request_retries_total{endpoint=\"%s\"} %llu\n", endpoint_names[endpoint], static_cast<unsigned long long>(retries_[endpoint].load(relaxed)));
+	}
+
+	out.add(
+		"# HELP cloudflare_ddns_errors_total Failed lookups, updates and searches, and local addresses that couldn't be found.\n"
+		"# TYPE cloudflare_ddns_errors_total counter\n"
+	);
+	for (std::size_t error = DDNS_ERROR_GENERIC; error < errors_count; ++error) {
+		out.print("cloudflare_ddns_errors_total{error=\"%s\"} %llu\n", error_names[error], static_cast<unsigned long long>(errors_[error].load(relaxed)));
+	}
+
+	out.add(
+		"# HELP cloudflare_ddns_record_updates_total Records changed to a new address.\n"
+		"# TYPE cloudflare_ddns_record_updates_total counter\n"
+	);
+	out.print("cloudflare_ddns_record_updates_total %llu\n", static_cast<unsigned long long>(updates_.load(relaxed)));
+
+	out.add(
+		"# HELP cloudflare_ddns_checks_total Checks of all the records.\n"
+		"# TYPE cloudflare_ddns_checks_total counter\n"
+	);
+	out.print("cloudflare_ddns_checks_total{result=\"success\"} %llu\n", static_cast<unsigned long long>(checks_[0].load(relaxed)));
+	out.print("cloudflare_ddns_checks_total{result=\"failure\"} %llu\n", static_cast<unsigned long long>(checks_[1].load(relaxed)));
+
+	// Always there, so that a check failing in a new process can be told
+	// apart from no check at all
+	const std::int64_t last_success {last_success_.load(relaxed)};
+	out.add(
+		"# HELP cloudflare_ddns_last_success_timestamp_seconds When the last successful check ended, 0 if none did.\n"
+		"# TYPE cloudflare_ddns_last_success_timestamp_seconds gauge\n"
+	);
+	out.print("cloudflare_ddns_last_success_timestamp_seconds %llu\n", static_cast<unsigned long long>(last_success));
+
+	// A file would freeze it at the time it's written
+	if (served && last_success != 0) {
+		out.add(
+			"# HELP cloudflare_ddns_seconds_since_last_success Time elapsed since the last successful check ended.\n"
+			"# TYPE cloudflare_ddns_seconds_since_last_success gauge\n"
+		);
+		out.print("cloudflare_ddns_seconds_since_last_success %llu\n", static_cast<unsigned long long>(now > last_success ? now - last_success : 0));
+	}
+
+	return out.size();
+}
+
+bool write_textfile(const registry& registry, const std::string& path) {
+	std::string rendered(registry::max_text_size, '\0');
+	rendered.resize(registry.render(rendered.data(), rendered.size()));
+	if (rendered.empty()) {
+		return false;
+	}
+	const std::string temporary_path {path + ".tmp"};
+
+	std::FILE* const file {std::fopen(temporary_path.c_str(), "w")};
+	if (file == nullptr) {
+		return false;
+	}
+	bool ok {std::fwrite(rendered.data(), 1, rendered.size(), file) == rendered.size()};
+	ok = std::fclose(file) == 0 && ok;
+
+	std::error_code error;
+	if (ok) {
+		std::filesystem::rename(temporary_path, path, error);
+	}
+	if (!ok || error) {
+		std::filesystem::remove(temporary_path, error);
+		return false;
+	}
+	return true;
+}
+
+std::int64_t read_last_success(const std::string& path) {
+	std::FILE* const file {std::fopen(path.c_str(), "r")};
+	if (file == nullptr) {
+		return 0;
+	}
+
+	constexpr std::string_view name {"cloudflare_ddns_last_success_timestamp_seconds "};
+	std::int64_t last_success {0};
+	char line[256];
+	while (std::fgets(line, sizeof line, file) != nullptr) {
+		if (std::string_view{line}.substr(0, name.size()) == name) {
+			last_success = std::strtoll(line + name.size(), nullptr, 10);
+			break;
+		}
+	}
+	std::fclose(file);
+	return last_success > 0 ? last_success : 0;
+}
+
+server::~server() {
+	stopping_ = true;
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+#ifdef DDNS_HAS_SOCKETS
+	if (listener_ != -1) {
+		close(listener_);
+	}
+#endif
+}
+
+bool server::listen([[maybe_unused]] const std::string& address) {
+#ifdef DDNS_HAS_SOCKETS
+	std::string host;
+	std::string port;
+	if (!address.empty() && address.front() == '[') {
+		const std::size_t end {address.find("]:")};
+		if (end == std::string::npos) {
+			return false;
+		}
+		host = address.substr(1, end - 1);
+		port = address.substr(end + 2);
+	}
+	else {
+		const std::size_t colon {address.rfind(':')};
+		if (colon == std::string::npos) {
+			return false;
+		}
+		host = address.substr(0, colon);
+		port = address.substr(colon + 1);
+	}
+
+	addrinfo hints {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	addrinfo* addresses {nullptr};
+	if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+		return false;
+	}
+
+	for (const addrinfo* candidate = addresses; candidate != nullptr && listener_ == -1; candidate = candidate->ai_next) {
+		listener_ = socket(candidate->ai_family, candidate->ai_socktype | SOCK_CLOEXEC, candidate->ai_protocol);
+		if (listener_ == -1) {
+			continue;
+		}
+		const int reuse {1};
+		setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+		if (bind(listener_, candidate->ai_addr, candidate->ai_addrlen) != 0 || ::listen(listener_, 8) != 0) {
+			close(listener_);
+			listener_ = -1;
+		}
+	}
+	freeaddrinfo(addresses);
+
+	if (listener_ == -1) {
+		return false;
+	}
+	thread_ = std::thread{&server::serve, this};
+	return true;
+#else
+	return false;
+#endif
+}
+
+void server::serve() noexcept {
+#ifdef DDNS_HAS_SOCKETS
+	// How often to check whether the server should stop
+	constexpr int poll_timeout_ms {250};
+
+	while (!stopping_) {
+		pollfd listener {listener_, POLLIN, 0};
+		if (poll(&listener, 1, poll_timeout_ms) <= 0) {
+			continue;
+		}
+		const int connection {accept(listener_, nullptr, nullptr)};
+		if (connection == -1) {
+			continue;
+		}
+
+		// A slow or stuck scraper can't hold the server for long
+		const timeval timeout {1, 0};
+		setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+		setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof timeout);
+
+		char request[2048];
+		std::size_t request_size {0};
+		while (request_size < sizeof request) {
+			const ssize_t received {recv(connection, request + request_size, sizeof request - request_size, 0)};
+			if (received <= 0) {
+				break;
+			}
+			request_size += static_cast<std::size_t>(received);
+			if (std::string_view{request, request_size}.find("\r\n\r\n") != std::string_view::npos) {
+				break;
+			}
+		}
+
+		const std::string_view request_line {request, request_size};
+		const bool found {request_line.substr(0, 13) == "GET /metrics " || request_line.substr(0, 13) == "GET /metrics?"};
+
+		// The headers go in front of the body once its size is known
+		char* const body {response_ + headers_capacity};
+		std::size_t body_size;
+		if (found) {
+			const std::int64_t now {std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()};
+			body_size = registry_.render(now, body, registry::max_text_size);
+		}
+		else {
+			constexpr std::string_view not_found {"Not found, try /metrics\n"};
+			std::memcpy(body, not_found.data(), not_found.size());
+			body_size = not_found.size();
+		}
+
+		char headers[headers_capacity];
+		const int headers_size {std::snprintf(
+			headers, sizeof headers,
+			"HTTP/1.1 %s\r\n"
+			"Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+			"Content-Length: %zu\r\n"
+			"Connection: close\r\n\r\n",
+			!found ? "404 Not Found" : body_size != 0 ? "200 OK" : "500 Internal Server Error",
+			body_size
+		)};
+		if (headers_size > 0 && static_cast<std::size_t>(headers_size) < sizeof headers) {
+			char* const response {body - headers_size};
+			std::memcpy(response, headers, static_cast<std::size_t>(headers_size));
+			const std::size_t response_size {static_cast<std::size_t>(headers_size) + body_size};
+			for (std::size_t sent = 0; sent < response_size;) {
+				const ssize_t written {send(connection, response + sent, response_size - sent, MSG_NOSIGNAL)};
+				if (written <= 0) {
+					break;
+				}
+				sent += static_cast<std::size_t>(written);
+			}
+		}
+		close(connection);
+	}
+#endif
+}
+
+} // namespace metrics
@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+/*
+ * Metrics of the checks and of the requests they make, in the text format
+ * read by Prometheus. They can be written to a file after every check, for
+ * the textfile collector of node_exporter, which suits the oneshot
+ * service, and served over HTTP while running as a daemon.
+ *
+ * The values are atomics updated with relaxed ordering: they're written
+ * by the thread checking the records and read by the one serving them,
+ * and they don't need to be consistent with each other, so counting costs
+ * no more than an increment.
+ */
+
+#pragma once
+#include <atomic> /* std::atomic */
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::int64_t, std::uint64_t */
+#include <string> /* std::string */
+#include <thread> /* std::thread */
+
+#include <ddns/cloudflare-ddns.h>
+
+namespace metrics {
+
+/*
+ * Upper bounds of the buckets of the request latency histograms, in
+ * microseconds
+ */
+constexpr std::int64_t latency_buckets_us[] {5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000};
+constexpr std::size_t latency_buckets_count {sizeof latency_buckets_us / sizeof latency_buckets_us[0]};
+
+// DDNS_ENDPOINT_DOH is the last one
+constexpr std::size_t endpoints_count {DDNS_ENDPOINT_DOH + 1};
+
+/*
+ * The names of the ddns_endpoint values, used as labels
+ */
+constexpr const char* endpoint_names[endpoints_count] {"trace", "zones", "dns_records", "update", "batch", "doh"};
+// DDNS_ERROR_USAGE is the last one
+constexpr std::size_t errors_count {DDNS_ERROR_USAGE + 1};
+
+class registry {
+public:
+	/*
+	 * Counts a request made by the client, as reported by its stats
+	 * callback
+	 */
+	void observe(const ddns_stats& stats) noexcept;
+
+	/*
+	 * Counts a failed lookup, update or search, or a local address that
+	 * couldn't be found
+	 */
+	void count_error(ddns_error error) noexcept;
+
+	/*
+	 * Counts a record that was changed to a new address
+	 */
+	void count_update() noexcept;
+
+	/*
+	 * Counts a whole check, finished at now seconds since the epoch
+	 */
+	void count_check(bool success, std::int64_t now) noexcept;
+
+	/*
+	 * Takes timestamp, in seconds since the epoch, as the end of the last
+	 * successful check if no later one was counted, like the one of a
+	 * previous run read by read_last_success()
+	 */
+	void restore_last_success(std::int64_t timestamp) noexcept;
+
+	/*
+	 * The most that render() can write
+	 */
+	static constexpr std::size_t max_text_size {32768};
+
+	/*
+	 * Writes all the metrics in the Prometheus text format, as written to
+	 * a file, to the capacity bytes at data. Returns how many were
+	 * written, or 0 if they didn't fit.
+	 */
+	std::size_t render(char* data, std::size_t capacity) const noexcept;
+
+	/*
+	 * Same as the other render(), but as served, with the time elapsed
+	 * since the last successful check computed at now seconds since the
+	 * epoch
+	 */
+	std::size_t render(std::int64_t now, char* data, std::size_t capacity) const noexcept;
+
+private:
+	struct histogram {
+		// Not cumulative, render() adds them up
+		std::atomic<std::uint64_t> buckets[latency_buckets_count + 1] {};
+		std::atomic<std::uint64_t> sum_us {0};
+	};
+
+	std::size_t render(char* data, std::size_t capacity, bool served, std::int64_t now) const noexcept;
+
+	histogram latency_[endpoints_count];
+	std::atomic<std::uint64_t> failures_[endpoints_count] {};
+	std::atomic<std::uint64_t> retries_[endpoints_count] {};
+	std::atomic<std::uint64_t> errors_[errors_count] {};
+	std::atomic<std::uint64_t> updates_ {0};
+	std::atomic<std::uint64_t> checks_[2] {};
+	// 0 until a check succeeds, in this run or in a restored one
+	std::atomic<std::int64_t> last_success_ {0};
+};
+
+/*
+ * Replaces the file at path with the metrics of registry, through a
+ * temporary file, so that the collector never reads half of it. Returns
+ * false if the file couldn't be written.
+ */
+bool write_textfile(const registry& registry, const std::string& path);
+
+/*
+ * The end of the last successful check written by write_textfile() to the
+ * file at path, so that a new process doesn't lose it, or 0 if there's
+ * none
+ */
+std::int64_t read_last_success(const std::string& path);
+
+/*
+ * Serves the metrics of registry at /metrics from a background thread,
+ * for as long as it lives. Only available where there are POSIX sockets.
+ */
+class server {
+public:
+	explicit server(const registry& registry) noexcept
+		: registry_ {registry} {}
+	~server();
+
+	server(const server&) = delete;
+	server& operator=(const server&) = delete;
+
+	/*
+	 * Starts listening on address, a host and a port separated by a
+	 * colon, with IPv6 hosts between square brackets. Returns false if it
+	 * can't.
+	 */
+	bool listen(const std::string& address);
+
+private:
+	void serve() noexcept;
+
+	// Room in front of the body of a response for its headers
+	static constexpr std::size_t headers_capacity {256};
+
+	const registry& registry_;
+	int listener_ {-1};
+	std::atomic<bool> stopping_ {false};
+	std::thread thread_;
+	// Where the responses are written, so that serving allocates nothing
+	char response_[headers_capacity + registry::max_text_size];
+};
+
+} // namespace metrics
@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "service.hpp"
+
+#include <csignal> /* std::signal, std::sig_atomic_t, SIGINT, SIGTERM */
+#include <cstddef> /* offsetof, std::size_t */
+#include <cstdlib> /* std::getenv */
+#include <cstring> /* std::memcpy, std::strlen */
+#include <thread> /* std::this_thread::sleep_for */
+
+#if __has_include(<unistd.h>) && __has_include(<poll.h>)
+#	include <cerrno> /* errno, EINTR */
+#	include <climits> /* INT_MAX */
+#	include <fcntl.h> /* fcntl, FD_CLOEXEC, O_NONBLOCK */
+#	include <poll.h> /* poll, pollfd, POLLIN */
+#	include <unistd.h> /* close, pipe, write */
+#	define DDNS_HAS_POSIX
+#endif
+
+#ifdef __linux__
+#	include <sys/socket.h> /* socket, sendto, AF_UNIX, SOCK_DGRAM */
+#	include <sys/un.h> /* sockaddr_un */
+#endif
+
+namespace {
+
+volatile std::sig_atomic_t stop_signal_received {0};
+
+#ifdef DDNS_HAS_POSIX
+/*
+ * A pipe written to by the signal handler and never read, so that its
+ * read end stays readable once a stop is requested. Waiting on it can't
+ * miss a signal coming right before the wait, unlike checking the flag
+ * and then sleeping.
+ */
+int stop_pipe[2] {-1, -1};
+#endif
+
+extern "C" void handle_stop_signal(int /*signal*/) {
+	stop_signal_received = 1;
+#ifdef DDNS_HAS_POSIX
+	const int saved_errno {errno};
+	const char byte {1};
+	[[maybe_unused]] const ssize_t written {write(stop_pipe[1], &byte, 1)};
+	errno = saved_errno;
+#endif
+}
+
+} // namespace
+
+namespace service {
+
+void install_signal_handlers() noexcept {
+#ifdef DDNS_HAS_POSIX
+	// pipe2() isn't available everywhere
+	if (stop_pipe[0] == -1 && pipe(stop_pipe) == 0) {
+		for (const int fd : stop_pipe) {
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+			fcntl(fd, F_SETFL, O_NONBLOCK);
+		}
+	}
+#endif
+	std::signal(SIGINT, handle_stop_signal);
+	std::signal(SIGTERM, handle_stop_signal);
+}
+
+bool stop_requested() noexcept {
+	return stop_signal_received != 0;
+}
+
+int stop_fd() noexcept {
+#ifdef DDNS_HAS_POSIX
+	return stop_pipe[0];
+#else
+	return -1;
+#endif
+}
+
+bool sleep_for(const std::chrono::seconds duration) noexcept {
+	using clock = std::chrono::steady_clock;
+	const clock::time_point deadline {clock::now() + duration};
+
+#ifdef DDNS_HAS_POSIX
+	// Waiting on the pipe instead of sleeping, a signal coming after the
+	// check of stop_requested() still ends the wait
+	bool polling {stop_pipe[0] != -1};
+	for (clock::duration left {duration}; polling && !stop_requested() && left > clock::duration::zero(); left = deadline - clock::now()) {
+		const auto left_ms {std::chrono::duration_cast<std::chrono::milliseconds>(left).count() + 1};
+		pollfd stop {stop_pipe[0], POLLIN, 0};
+		polling = poll(&stop, 1, left_ms < INT_MAX ? static_cast<int>(left_ms) : INT_MAX) != -1 || errno == EINTR;
+	}
+#endif
+	// Short ticks, so that a stop isn't delayed for long
+	while (!stop_requested() && clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds{250});
+	}
+	return !stop_requested();
+}
+
+void notify([[maybe_unused]] const char* const state) noexcept {
+#ifdef __linux__
+	const char* const socket_path = std::getenv("NOTIFY_SOCKET");
+	if (socket_path == nullptr) {
+		return;
+	}
+
+	sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+
+	const std::size_t socket_path_length = std::strlen(socket_path);
+	if (socket_path_length < 2U || socket_path_length >= sizeof address.sun_path) {
+		return;
+	}
+	// Only absolute paths and abstract sockets are valid
+	if (socket_path[0] != '/' && socket_path[0] != '@') {
+		return;
+	}
+	std::memcpy(address.sun_path, socket_path, socket_path_length);
+	socklen_t address_length = offsetof(sockaddr_un, sun_path) + socket_path_length;
+	if (address.sun_path[0] == '@') {
+		// Abstract namespace sockets start with a NUL byte and are not
+		// NUL-terminated
+		address.sun_path[0] = '\0';
+	}
+	else {
+		++address_length;
+	}
+
+	const int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd == -1) {
+		return;
+	}
+
+	sendto(fd, state, std::strlen(state), MSG_NOSIGNAL, reinterpret_cast<const sockaddr*>(&address), address_length);
+
+	close(fd);
+#endif
+}
+
+} // namespace service
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+/*
+ * Helpers used when running as a long-lived service, i.e. with --daemon.
+ * Everything here is a no-op (or a plain sleep) on platforms where the
+ * underlying facility is not available.
+ */
+
+#pragma once
+#include <chrono>
+
+namespace service {
+
+/*
+ * Installs handlers for SIGINT and SIGTERM, which make stop_requested()
+ * return true and interrupt any pending sleep_for().
+ */
+void install_signal_handlers() noexcept;
+
+bool stop_requested() noexcept;
+
+/*
+ * A file descriptor that becomes readable, and stays so, once a
+ * termination signal is received, to be polled along with others so that
+ * a signal can't be missed between stop_requested() and the wait. -1 if
+ * the handlers aren't installed or the platform lacks pipes.
+ */
+int stop_fd() noexcept;
+
+/*
+ * Sleeps for the given duration, returning early if a termination signal
+ * is received. Returns false if the service should stop.
+ */
+bool sleep_for(std::chrono::seconds duration) noexcept;
+
+/*
+ * Sends a state string to the service manager, following the protocol
+ * described in sd_notify(3). Does nothing if $NOTIFY_SOCKET is not set.
+ */
+void notify(const char* state) noexcept;
+
+} // namespace service
@@ -5,10 +5,11 @@
  */
 
 /**
- * There are two kinds of functions; the one that is self contained, thread
- * safe, that creates and uses its own cURL handle, and the other one that
+ * There are three kinds of functions; the one that is self contained,
+ * thread safe, that creates and uses its own cURL handle, the one that
  * borrows mutably a cURL handle, a more efficient approach but that is not
- * thread safe.
+ * thread safe, and the one that takes a ddns_client, which is just as
+ * efficient but manages its cURL handle by itself.
  *
  * The user of the library is responsable for calling curl_global_init.
  *
@@ -27,6 +28,10 @@ extern "C" {
 #define DDNS_RECORD_NAME_MAX_LENGTH 255U
 #define DDNS_IP_ADDRESS_MAX_LENGTH  46U
 #define DDNS_API_TOKEN_LENGTH       40U
+#define DDNS_BASE_URL_MAX_LENGTH    128U
+#define DDNS_TRACE_URL_MAX_LENGTH   128U
+#define DDNS_BATCH_MAX_RECORDS      100U
+#define DDNS_RECORDS_PER_PAGE       100U
 
 #include <stdbool.h> /* bool */
 #include <stddef.h> /* size_t */
@@ -118,6 +123,264 @@ typedef enum ddns_error {
 	DDNS_ERROR_USAGE
 } ddns_error;
 
+/**
+ * An A or AAAA DNS record, as returned by Cloudflare's API
+ *
+ * id and content are NUL-terminated, and aaaa tells whether content is
+ * an IPv6 address (AAAA record) or an IPv4 one (A record).
+ */
+typedef struct ddns_record {
+	char id[DDNS_RECORD_ID_LENGTH + 1U];
+	char content[DDNS_IP_ADDRESS_MAX_LENGTH];
+	bool aaaa;
+} ddns_record;
+
+/**
+ * Opaque handle that keeps connections to Cloudflare alive across calls
+ *
+ * A client owns a cURL handle, along with a cURL share object holding its
+ * DNS cache, TLS sessions and connection cache, so that every call made
+ * with the same client can reuse the connection, TLS session tickets and
+ * resolved addresses of the previous ones. This makes it the fastest way
+ * to make more than one request, without having to deal with libcurl
+ * like the _raw functions require.
+ *
+ * A client also paces the requests it sends with each API token, so that
+ * they stay under Cloudflare's rate limit, following the RateLimit headers
+ * of the responses, and remembers for a few minutes which names it found
+ * to be zones, or not, so that names of the same zone don't search it
+ * again.
+ *
+ * A client must not be used by more than one thread at a time.
+ */
+typedef struct ddns_client ddns_client;
+
+/**
+ * A DNS cache, TLS sessions and connections shared by several clients
+ *
+ * Every client has its own by default, so two clients each resolve
+ * Cloudflare's addresses and do a full TLS handshake. Clients attached to
+ * the same share with ddns_client_set_share() reuse each other's instead.
+ * They can be used by different threads, but not at the same time, as
+ * libcurl doesn't support sharing connections between concurrent
+ * transfers of different clients. A share must be destroyed with
+ * ddns_share_destroy(), after the clients using it.
+ *
+ * Only clients use a share. The functions not taking a client, like
+ * ddns_get_record(), ddns_update_record(), ddns_get_local_ip(),
+ * ddns_list_records() and ddns_update_records_batch(), still set up a
+ * connection of their own on every call.
+ */
+typedef struct ddns_share ddns_share;
+
+/**
+ * All the A and AAAA records of a zone, indexed by name
+ *
+ * An index is created by ddns_list_records() or ddns_client_list_records()
+ * with a few requests, instead of the one request per name needed by
+ * ddns_get_record(), and then answers any number of lookups with
+ * ddns_zone_index_find() without talking to Cloudflare. It must be
+ * destroyed with ddns_zone_index_destroy().
+ */
+typedef struct ddns_zone_index ddns_zone_index;
+
+/**
+ * A subscription to the changes of the addresses of the network interfaces
+ *
+ * A watch lets a long-running program know when to check its records,
+ * instead of checking them periodically: ddns_address_watch_wait() blocks
+ * until a public address is added or removed, without sending any request.
+ * It must be destroyed with ddns_address_watch_destroy().
+ */
+typedef struct ddns_address_watch ddns_address_watch;
+
+/**
+ * Runs the requests of a client without blocking
+ *
+ * The functions of a client block until their requests are done, which
+ * suits a program doing nothing else. An async instead starts the requests
+ * and returns right away, calling a completion callback once each
+ * operation is done, so that many of them can run in the thread of an
+ * event loop along with the rest of its work. It uses the connections,
+ * options, rate limits and zone answers of its client.
+ *
+ * The event loop tells the async when its sockets are ready and when its
+ * timer expires, like with curl_multi_socket_action(): see
+ * ddns_async_set_callbacks() and ddns_async_socket_action(). Programs
+ * without an event loop of their own can call ddns_async_poll() instead.
+ *
+ * The addresses of the servers known by the client are used, but unlike
+ * the functions of the client the async never blocks to look up the
+ * others with DNS over HTTPS, leaving it to curl.
+ *
+ * An async must be destroyed with ddns_async_destroy(), before its
+ * client, and must be used by the thread using its client.
+ */
+typedef struct ddns_async ddns_async;
+
+/**
+ * One of the record names looked up by ddns_client_get_records_multi()
+ *
+ * api_token, zone_id, record_name, records_size and records are inputs,
+ * and have the same meaning of the ddns_client_get_records() parameters
+ * with the same name; records_count and error are set once the lookup is
+ * done.
+ */
+typedef struct ddns_record_query {
+	const char* api_token;
+	const char* zone_id;
+	const char* record_name;
+	size_t records_size;
+	ddns_record* records;
+	size_t records_count;
+	ddns_error error;
+} ddns_record_query;
+
+/**
+ * One of the records updated by ddns_client_update_records_multi()
+ *
+ * api_token, zone_id, record_id and new_ip are inputs, and have the same
+ * meaning of the ddns_update_record() parameters with the same name;
+ * record_ip and error are set once the update is done.
+ */
+typedef struct ddns_record_update {
+	const char* api_token;
+	const char* zone_id;
+	const char* record_id;
+	const char* new_ip;
+	char record_ip[DDNS_IP_ADDRESS_MAX_LENGTH];
+	ddns_error error;
+} ddns_record_update;
+
+/**
+ * One of the public IP addresses asked by ddns_client_get_local_ips()
+ *
+ * ipv6 and timeout_ms are inputs: the first one has the same meaning of
+ * the ddns_get_local_ip() parameter with the same name, and the second one
+ * is how long to wait for the address, in milliseconds, 0 meaning the
+ * timeout of the client. ip and error are set once the request is done.
+ */
+typedef struct ddns_local_ip {
+	bool ipv6;
+	long timeout_ms;
+	char ip[DDNS_IP_ADDRESS_MAX_LENGTH];
+	ddns_error error;
+} ddns_local_ip;
+
+/**
+ * The search of the zone of a record started by ddns_async_search_zone_id()
+ *
+ * api_token and record_name are inputs, and have the same meaning of the
+ * ddns_search_zone_id() parameters with the same name; zone_id and error
+ * are set once the search is done.
+ */
+typedef struct ddns_zone_search {
+	const char* api_token;
+	const char* record_name;
+	char zone_id[DDNS_ZONE_ID_LENGTH + 1U];
+	ddns_error error;
+} ddns_zone_search;
+
+/**
+ * A socket, as handed to the event loop by a ddns_async
+ */
+#ifdef _WIN32
+#	include <stdint.h> /* uintptr_t */
+typedef uintptr_t ddns_socket;
+#else
+typedef int ddns_socket;
+#endif
+
+/**
+ * Passed to ddns_async_socket_action() when the timer expires
+ */
+#define DDNS_SOCKET_TIMEOUT ((ddns_socket) -1)
+
+/**
+ * What a socket of a ddns_async is waiting for, or is ready for
+ */
+#define DDNS_POLL_IN    1
+#define DDNS_POLL_OUT   2
+/* Only passed to ddns_async_socket_action() */
+#define DDNS_POLL_ERROR 4
+
+/**
+ * Called when an operation of a ddns_async is done, with error being the
+ * one also written in the error member of its entry, and user the pointer
+ * passed along with the callback
+ */
+typedef void (*ddns_async_callback)(ddns_error error, void* user);
+
+/**
+ * Called by a ddns_async when the event loop must watch socket for events,
+ * a combination of DDNS_POLL_IN and DDNS_POLL_OUT, or stop watching it if
+ * events is 0
+ */
+typedef void (*ddns_socket_callback)(ddns_socket socket, int events, void* user);
+
+/**
+ * Called by a ddns_async when its timer must expire in timeout_ms
+ * milliseconds, replacing the previous one, or be stopped if timeout_ms is
+ * -1. When it expires, the event loop calls ddns_async_socket_action()
+ * with DDNS_SOCKET_TIMEOUT.
+ */
+typedef void (*ddns_timer_callback)(long timeout_ms, void* user);
+
+/**
+ * What a request made by a client was for
+ */
+typedef enum ddns_endpoint {
+	/* The trace page, to find a local address */
+	DDNS_ENDPOINT_TRACE,
+	/* GET zones, to search a zone ID */
+	DDNS_ENDPOINT_ZONES,
+	/* GET dns_records, to get or list records */
+	DDNS_ENDPOINT_DNS_RECORDS,
+	/* PATCH dns_records, to update a record */
+	DDNS_ENDPOINT_UPDATE,
+	/* POST dns_records/batch, to update many records */
+	DDNS_ENDPOINT_BATCH,
+	/* DNS over HTTPS, to find the addresses of the servers */
+	DDNS_ENDPOINT_DOH
+} ddns_endpoint;
+
+/**
+ * How a request made by a client went, passed to the callback set with
+ * ddns_client_set_stats_callback()
+ *
+ * status is the HTTP status of the last response, or 0 if none was
+ * received, and attempts is how many times the request was sent, which is
+ * more than 1 if it was retried. The timings are the ones of the last
+ * attempt, in microseconds from its start to the end of each phase, like
+ * the ones of curl: the name lookup, the TCP connection, the TLS
+ * handshake, the first byte of the response and the whole transfer.
+ * Phases skipped thanks to a reused connection take no time, and
+ * reused_connection tells whether that was the case. elapsed_us is instead
+ * the whole time taken by the request, retries and waits for the rate
+ * limit included, while the bytes are the ones of all the attempts,
+ * headers included.
+ */
+typedef struct ddns_stats {
+	ddns_endpoint endpoint;
+	long status;
+	unsigned attempts;
+	bool reused_connection;
+	long namelookup_us;
+	long connect_us;
+	long appconnect_us;
+	long starttransfer_us;
+	long total_us;
+	long elapsed_us;
+	size_t bytes_sent;
+	size_t bytes_received;
+} ddns_stats;
+
+/**
+ * Called once for every request a client makes, with user being the
+ * pointer passed to ddns_client_set_stats_callback()
+ */
+typedef void (*ddns_stats_callback)(const ddns_stats* stats, void* user);
+
 /**
  * Get the public IP address of the machine
  *
@@ -139,6 +402,88 @@ DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_local_ip(
 	size_t ip_size, char* DDNS_RESTRICT ip
 ) DDNS_NOEXCEPT;
 
+/**
+ * Get the public IP address assigned to a network interface
+ *
+ * Unlike ddns_get_local_ip(), this function doesn't make any request: it
+ * reads the addresses of the network interfaces of the machine, and
+ * writes the first public one in ip. Only addresses with global scope
+ * that aren't temporary (privacy extensions), deprecated or tentative are
+ * considered, and private, shared (CGNAT), documentation and other
+ * reserved ranges are skipped, as they can't be reached from the
+ * Internet.
+ *
+ * Machines behind NAT usually have no public IPv4 address on their
+ * interfaces, in which case the function returns DDNS_ERROR_GENERIC and
+ * ddns_get_local_ip() should be used instead. The function also returns
+ * DDNS_ERROR_GENERIC if the addresses can't be read, which is always the
+ * case on systems other than Linux, where they're read over rtnetlink.
+ * If ip_size is too small, it returns DDNS_ERROR_USAGE.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_interface_ip(
+	bool ipv6,
+	size_t ip_size, char* DDNS_RESTRICT ip
+) DDNS_NOEXCEPT;
+
+/**
+ * Start watching the addresses of the network interfaces
+ *
+ * Changes are only recorded from now on, so the addresses should be read
+ * after creating the watch, not before, to avoid missing any. Watching is
+ * only supported on Linux, where the changes are received over rtnetlink;
+ * elsewhere, and if the subscription fails, the function returns
+ * DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_address_watch_create(
+	ddns_address_watch** DDNS_RESTRICT watch
+) DDNS_NOEXCEPT;
+
+/**
+ * Wait for a public address to be added to or removed from the network
+ * interfaces
+ *
+ * The function blocks until one of the addresses that
+ * ddns_get_interface_ip() could return changes, or until timeout_ms
+ * milliseconds have passed, forever if timeout_ms is negative. Changes
+ * usually come in bursts, for example when a network is renumbered, so
+ * after the first one the function keeps waiting until debounce_ms
+ * milliseconds pass without further changes, and reports all of them at
+ * once. Other changes, like the ones of private or temporary addresses,
+ * are ignored.
+ *
+ * changed is set to true if an address changed, and to false if the time
+ * ran out, a signal interrupted the wait or the file descriptor set with
+ * ddns_address_watch_set_wake_fd() became readable, in which case the
+ * function still returns DDNS_ERROR_OK. Since the kernel doesn't say what changed
+ * if it has to drop some notifications, changed can be true even if the
+ * addresses turn out to be the same.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_address_watch_wait(
+	ddns_address_watch* DDNS_RESTRICT watch,
+	int timeout_ms, int debounce_ms,
+	bool* DDNS_RESTRICT changed
+) DDNS_NOEXCEPT;
+
+/**
+ * Make ddns_address_watch_wait() return as soon as fd is readable
+ *
+ * A signal coming right before ddns_address_watch_wait() doesn't interrupt
+ * it, so a program checking a flag set by its signal handlers and then
+ * waiting could wait forever. Instead, the handlers can write to a pipe
+ * whose read end is passed here: the wait ends whenever it's readable,
+ * even if the signal came before it started. fd is only polled, never
+ * read or closed, and a negative one stops using it.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_address_watch_set_wake_fd(
+	ddns_address_watch* DDNS_RESTRICT watch,
+	int fd
+) DDNS_NOEXCEPT;
+
+/**
+ * Destroy an address watch. watch can be NULL.
+ */
+DDNS_PUB void ddns_address_watch_destroy(ddns_address_watch* watch) DDNS_NOEXCEPT;
+
 /**
  * Get the Zone ID of a DNS record
  *
@@ -153,10 +498,21 @@ DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_local_ip(
  * "pappacoda.it". The full domain name is tried as well as it is
  * completely legal to use the root domain name as an A or AAAA record,
  * while the "it" TLD is not tried as Cloudflare does not allow zones to be
- * top level domains.
+ * top level domains. Other names listed in the Public Suffix List, like
+ * "co.uk", are not tried either, if the library was built with it.
+ *
+ * The queries are sent concurrently, so the lookup takes about as long as
+ * a single one. When more than one of them matches, as when a subdomain is
+ * delegated to another zone of the same account, the longest zone name
+ * wins. It is still recommended to cache the returned ID, as zone IDs are
+ * unlikely to change often.
  *
- * Due to the slow nature of this lookup, it is recommended to cache the
- * returned ID, as zone IDs are unlikely to change often.
+ * To send the queries concurrently, each call creates and destroys a
+ * whole ddns_client, with its own connections and TLS handshakes, and
+ * remembers nothing of the zones it finds. Programs searching more than
+ * one zone, or searching it more than once, should rather use
+ * ddns_client_search_zone_id(), which reuses the connections of the client
+ * and the zones it already found.
  *
  * If you already know the zone name and simply want to figure out its id,
  * simply pass it as the "record_name" parameter; the function will query
@@ -240,6 +596,71 @@ DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_record_raw(
 	void**      DDNS_RESTRICT curl
 ) DDNS_NOEXCEPT;
 
+/**
+ * List all the A and AAAA DNS records of a zone
+ *
+ * This function fetches every A and AAAA record of the zone identified by
+ * zone_id, DDNS_RECORDS_PER_PAGE records per request, and writes them in a
+ * new index, which must be destroyed with ddns_zone_index_destroy(). This
+ * is much faster than looking up each name when many records of the same
+ * zone are needed.
+ *
+ * If the length of the API token or of the zone id is wrong, the function
+ * returns DDNS_ERROR_USAGE; if a request fails, or if the index can't be
+ * allocated, it returns DDNS_ERROR_GENERIC. Like ddns_get_record(), it
+ * creates and destroys its own cURL handle.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_list_records(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	ddns_zone_index** DDNS_RESTRICT index
+) DDNS_NOEXCEPT;
+
+/**
+ * Query the API for a page of the A and AAAA DNS records of a zone
+ *
+ * This function fetches the page-th page, starting from 1, of the listing
+ * made by ddns_list_records(), writing the raw JSON response in the cURL
+ * response buffer. A page holds up to DDNS_RECORDS_PER_PAGE records; one
+ * with fewer records is the last one. If the length of the API token or
+ * of the zone id is wrong, or if page is 0, the function returns
+ * DDNS_ERROR_USAGE; if something goes wrong with the HTTP request, it
+ * returns DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_list_records_raw(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	size_t page,
+	void**      DDNS_RESTRICT curl
+) DDNS_NOEXCEPT;
+
+/**
+ * Get all the records of an index with a given name
+ *
+ * Works like ddns_client_get_records(): every A and AAAA record named
+ * record_name is written in records, up to records_size, and the number
+ * of records found is written in records_count, which is 0 if the zone
+ * has no such record. The function always returns DDNS_ERROR_OK.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_zone_index_find(
+	const ddns_zone_index* DDNS_RESTRICT index,
+	const char* DDNS_RESTRICT record_name,
+	size_t records_size, ddns_record* DDNS_RESTRICT records,
+	size_t* DDNS_RESTRICT records_count
+) DDNS_NOEXCEPT;
+
+/**
+ * Get the number of records in an index
+ */
+DDNS_NODISCARD DDNS_PUB size_t ddns_zone_index_size(
+	const ddns_zone_index* DDNS_RESTRICT index
+) DDNS_NOEXCEPT;
+
+/**
+ * Destroy an index. Passing NULL is allowed.
+ */
+DDNS_PUB void ddns_zone_index_destroy(ddns_zone_index* index) DDNS_NOEXCEPT;
+
 /**
  * Update the IP address of a given A/AAAA DNS record
  *
@@ -286,6 +707,502 @@ DDNS_NODISCARD DDNS_PUB ddns_error ddns_update_record_raw(
 	void**      DDNS_RESTRICT curl
 ) DDNS_NOEXCEPT;
 
+/**
+ * Update the IP address of many A/AAAA DNS records of the same zone
+ *
+ * This function sets the content of each record, identified by its id
+ * member, to the IP address held in its content member, sending all the
+ * changes at once to the dns_records/batch endpoint of Cloudflare's API
+ * instead of sending one PATCH request per record. Once done, the content
+ * member of each record holds the IP that Cloudflare set, and aaaa tells
+ * whether it is an AAAA record.
+ *
+ * Cloudflare applies the changes of a batch request atomically, so either
+ * all the records get updated or none does. Up to DDNS_BATCH_MAX_RECORDS
+ * records are sent in each request, and if records_size is greater than
+ * that the records are updated with more than one request; in that case,
+ * if a request fails the following ones are not sent.
+ *
+ * If the length of the API token or of the zone id is wrong, or if a
+ * record has an invalid id or content, the function returns
+ * DDNS_ERROR_USAGE without sending any request; on any other error, it
+ * returns DDNS_ERROR_GENERIC. Like ddns_update_record(), it creates and
+ * destroys its own cURL handle.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_update_records_batch(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	size_t records_size, ddns_record* DDNS_RESTRICT records
+) DDNS_NOEXCEPT;
+
+/**
+ * Update the IP address of many A/AAAA DNS records of the same zone
+ *
+ * This function sends a single batch request, built like the ones sent by
+ * ddns_update_records_batch(), using your own cURL handle; the response
+ * is written in the cURL response buffer, and you'll have to parse it
+ * yourself. If records_size is 0 or greater than DDNS_BATCH_MAX_RECORDS,
+ * or if one of the parameters is invalid as described in
+ * ddns_update_records_batch(), the function returns DDNS_ERROR_USAGE; if
+ * something goes wrong with the HTTP request, it returns
+ * DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_update_records_batch_raw(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	size_t records_size, const ddns_record* DDNS_RESTRICT records,
+	void**      DDNS_RESTRICT curl
+) DDNS_NOEXCEPT;
+
+/**
+ * Create a new client
+ *
+ * The new client is written in the client out parameter, and must be
+ * destroyed with ddns_client_destroy(). If the client can't be allocated,
+ * the function returns DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_create(
+	ddns_client** DDNS_RESTRICT client
+) DDNS_NOEXCEPT;
+
+/**
+ * Destroy a client, closing its connections. Passing NULL is allowed.
+ */
+DDNS_PUB void ddns_client_destroy(ddns_client* client) DDNS_NOEXCEPT;
+
+/**
+ * Make the client talk to a different API server
+ *
+ * By default a client sends its requests to Cloudflare's API, at
+ * https://api.cloudflare.com/client/v4; this function makes it use
+ * base_url instead, which is mostly useful to test your application
+ * against a local server. Only HTTPS URLs are supported. Passing NULL
+ * restores the default. If base_url is longer than
+ * DDNS_BASE_URL_MAX_LENGTH, the function returns DDNS_ERROR_USAGE.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_base_url(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT base_url
+) DDNS_NOEXCEPT;
+
+/**
+ * Make the client find its public address with a different server
+ *
+ * ddns_client_get_local_ip() and ddns_client_get_local_ips() send a GET
+ * request to https://one.one.one.one/cdn-cgi/trace by default, and read
+ * the "ip=" line of the response; this function makes them use trace_url
+ * instead, which has to answer in the same way. Like
+ * ddns_client_set_base_url(), it's mostly useful for tests. Passing NULL
+ * restores the default. If trace_url is longer than
+ * DDNS_TRACE_URL_MAX_LENGTH, the function returns DDNS_ERROR_USAGE.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_trace_url(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT trace_url
+) DDNS_NOEXCEPT;
+
+/**
+ * Make the client verify servers using the CA certificates in ca_file
+ *
+ * ca_file is the path of a PEM file, used instead of the system's CA
+ * bundle. It gets copied, so it doesn't need to outlive the call. If
+ * the TLS backend of libcurl doesn't support it, the function returns
+ * DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_ca_file(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT ca_file
+) DDNS_NOEXCEPT;
+
+/**
+ * Keep the addresses of the servers the client talks to in a file
+ *
+ * A client looks up the addresses of the servers it talks to with DNS
+ * over HTTPS, and remembers them for as long as the TTL of the answers
+ * allows, so that the requests made in the meantime skip the lookup. The
+ * addresses still valid are read from path right away, and path is
+ * rewritten after every lookup, so that they're remembered between runs
+ * too. A missing or malformed file is treated as an empty one, and errors
+ * writing it are ignored. If path is NULL, the addresses are only kept in
+ * memory, like clients do by default.
+ *
+ * If path can't be copied, the function returns DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_resolve_cache(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT path
+) DDNS_NOEXCEPT;
+
+/**
+ * Set how long each request of the client may take
+ *
+ * connect_timeout_ms bounds the time it takes to connect to the server,
+ * and timeout_ms the whole request, both in milliseconds. They're 10 and
+ * 30 seconds by default; 0 means curl's default connection timeout and no
+ * limit on the request, respectively.
+ *
+ * Requests answered with 429, 500, 502, 503 or 504 are sent again up to
+ * three times, after an exponential backoff with random jitter, or after
+ * the delay asked by the server with the Retry-After header if it's
+ * longer. Every attempt has its own timeout.
+ *
+ * If either timeout is negative, the function returns DDNS_ERROR_USAGE.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_timeouts(
+	ddns_client* DDNS_RESTRICT client,
+	long connect_timeout_ms,
+	long timeout_ms
+) DDNS_NOEXCEPT;
+
+/**
+ * Make the following requests of the client end within budget_ms
+ * milliseconds from now
+ *
+ * Once the deadline is reached no request is sent or retried, and the
+ * ones in flight are cut short, all of them failing with
+ * DDNS_ERROR_GENERIC. This bounds the time taken by a group of requests,
+ * like the ones of a single check of a daemon, however many retries they
+ * need. If budget_ms is 0 the deadline is removed, which is the default.
+ *
+ * If budget_ms is negative, the function returns DDNS_ERROR_USAGE.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_deadline(
+	ddns_client* DDNS_RESTRICT client,
+	long budget_ms
+) DDNS_NOEXCEPT;
+
+/**
+ * Make the client report how each of its requests went
+ *
+ * callback is called with the ddns_stats of every request the client
+ * makes, DNS over HTTPS lookups included, as soon as it's done, from the
+ * thread calling the function that made it. It must not use the client.
+ * This makes it possible to tell where the time of a slow call went
+ * without a debugger. Passing NULL stops the reports, which is the
+ * default.
+ */
+DDNS_PUB void ddns_client_set_stats_callback(
+	ddns_client* DDNS_RESTRICT client,
+	ddns_stats_callback callback,
+	void* user
+) DDNS_NOEXCEPT;
+
+/**
+ * Create a new share
+ *
+ * The new share is written in the share out parameter, and must be
+ * destroyed with ddns_share_destroy(). If the share can't be allocated,
+ * the function returns DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_share_create(
+	ddns_share** DDNS_RESTRICT share
+) DDNS_NOEXCEPT;
+
+/**
+ * Destroy a share, closing its connections. Every client attached to it
+ * must have been destroyed or attached to another share first. Passing
+ * NULL is allowed.
+ */
+DDNS_PUB void ddns_share_destroy(ddns_share* share) DDNS_NOEXCEPT;
+
+/**
+ * Make the client use the DNS cache, TLS sessions and connections of share
+ *
+ * The client stops using its own ones, and goes back to them if share is
+ * NULL. It must not be called while another function is using the client.
+ */
+DDNS_PUB void ddns_client_set_share(
+	ddns_client* DDNS_RESTRICT client,
+	ddns_share* DDNS_RESTRICT share
+) DDNS_NOEXCEPT;
+
+/**
+ * Get the raw response of the last request made by the client
+ *
+ * This is mostly useful to show the error returned by Cloudflare's API
+ * when a call fails. The returned buffer is not NUL-terminated, its size
+ * is written in response_size, and it is valid until the next call made
+ * with the same client.
+ */
+DDNS_NODISCARD DDNS_PUB const char* ddns_client_response(
+	const ddns_client* DDNS_RESTRICT client,
+	size_t* DDNS_RESTRICT response_size
+) DDNS_NOEXCEPT;
+
+/**
+ * Same as ddns_get_local_ip(), but using the client's connections
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_local_ip(
+	ddns_client* DDNS_RESTRICT client,
+	bool ipv6,
+	size_t ip_size, char* DDNS_RESTRICT ip
+) DDNS_NOEXCEPT;
+
+/**
+ * Get the public IPv4 and IPv6 addresses of the machine at once
+ *
+ * This function works like ddns_client_get_local_ip(), but makes all the
+ * requests concurrently, each of them with its own timeout, so that
+ * getting both addresses takes as long as the slowest of them, and a
+ * broken IPv6 connectivity can't delay the IPv4 address. local_ips
+ * usually holds an IPv4 and an IPv6 request.
+ *
+ * The outcome of each request is written in the error member of the
+ * corresponding element, which is DDNS_ERROR_USAGE if its timeout_ms is
+ * negative. The function returns DDNS_ERROR_OK if all the requests
+ * succeeded, and DDNS_ERROR_GENERIC otherwise.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_local_ips(
+	ddns_client* DDNS_RESTRICT client,
+	size_t local_ips_size, ddns_local_ip* DDNS_RESTRICT local_ips
+) DDNS_NOEXCEPT;
+
+/**
+ * Same as ddns_search_zone_id(), but using the client's connections
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_search_zone_id(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT record_name,
+	size_t zone_id_size, char* DDNS_RESTRICT zone_id
+) DDNS_NOEXCEPT;
+
+/**
+ * Same as ddns_get_record(), but using the client's connections
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_record(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	size_t record_ip_size, char* DDNS_RESTRICT record_ip,
+	size_t record_id_size, char* DDNS_RESTRICT record_id,
+	bool* DDNS_RESTRICT aaaa
+) DDNS_NOEXCEPT;
+
+/**
+ * Get all the A and AAAA DNS records with a given name
+ *
+ * Unlike ddns_client_get_record(), which only returns the first record,
+ * this function writes every A and AAAA record named record_name in the
+ * records array, up to records_size records. The number of records found
+ * is written in records_count, and can be greater than records_size, in
+ * which case only the first records_size ones are written. The function
+ * returns DDNS_ERROR_USAGE if one of the parameters is invalid, as
+ * described in ddns_get_record_raw(), and DDNS_ERROR_GENERIC on any other
+ * error.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_records(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	size_t records_size, ddns_record* DDNS_RESTRICT records,
+	size_t* DDNS_RESTRICT records_count
+) DDNS_NOEXCEPT;
+
+/**
+ * Same as ddns_list_records(), but using the client's connections
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_list_records(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	ddns_zone_index** DDNS_RESTRICT index
+) DDNS_NOEXCEPT;
+
+/**
+ * Same as ddns_update_record(), but using the client's connections
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_update_record(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_id,
+	const char* DDNS_RESTRICT new_ip,
+	size_t record_ip_size, char* DDNS_RESTRICT record_ip
+) DDNS_NOEXCEPT;
+
+/**
+ * Same as ddns_update_records_batch(), but using the client's connections
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_update_records_batch(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	size_t records_size, ddns_record* DDNS_RESTRICT records
+) DDNS_NOEXCEPT;
+
+/**
+ * Look up many record names at once
+ *
+ * This function works like ddns_client_get_records(), but performs all
+ * the lookups concurrently, multiplexing them on a single HTTP/2
+ * connection to Cloudflare's API when possible, so that looking up many
+ * records takes about as long as looking up a single one. The records
+ * may belong to different zones, and may need different API tokens.
+ *
+ * The outcome of each lookup is written in the error member of the
+ * corresponding query. The function returns DDNS_ERROR_OK if all the
+ * lookups succeeded, and DDNS_ERROR_GENERIC otherwise.
+ *
+ * Queries with the same API token, zone ID and record name are sent once,
+ * and the records found are copied to each of them, as many as fit. Only
+ * the queries of a single call are merged, not the ones of other calls or
+ * of a ddns_async.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_records_multi(
+	ddns_client* DDNS_RESTRICT client,
+	size_t queries_size, ddns_record_query* DDNS_RESTRICT queries
+) DDNS_NOEXCEPT;
+
+/**
+ * Update many records at once
+ *
+ * This function works like ddns_client_update_record(), but sends all the
+ * PATCH requests concurrently, like ddns_client_get_records_multi() does.
+ *
+ * The outcome of each update is written in the error member of the
+ * corresponding update. The function returns DDNS_ERROR_OK if all the
+ * updates succeeded, and DDNS_ERROR_GENERIC otherwise.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_update_records_multi(
+	ddns_client* DDNS_RESTRICT client,
+	size_t updates_size, ddns_record_update* DDNS_RESTRICT updates
+) DDNS_NOEXCEPT;
+
+/**
+ * Create a new async running the requests of client
+ *
+ * The new async is written in the async out parameter, and must be
+ * destroyed with ddns_async_destroy(). If the async can't be allocated,
+ * the function returns DDNS_ERROR_GENERIC.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_create(
+	ddns_client* DDNS_RESTRICT client,
+	ddns_async** DDNS_RESTRICT async
+) DDNS_NOEXCEPT;
+
+/**
+ * Destroy an async. The operations still running are abandoned, without
+ * calling their callbacks. Passing NULL is allowed.
+ */
+DDNS_PUB void ddns_async_destroy(ddns_async* async) DDNS_NOEXCEPT;
+
+/**
+ * Make the async tell an event loop what to wait for
+ *
+ * socket_callback and timer_callback are called with user while the async
+ * runs, from the functions of the async, and the event loop must then call
+ * ddns_async_socket_action() when a socket is ready or the timer expires.
+ * Both must be set, and they must be set before starting any operation,
+ * otherwise the function returns DDNS_ERROR_USAGE. ddns_async_poll() can't
+ * be used afterwards.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_set_callbacks(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_socket_callback socket_callback,
+	ddns_timer_callback timer_callback,
+	void* user
+) DDNS_NOEXCEPT;
+
+/**
+ * Make progress after socket got ready for events, a combination of
+ * DDNS_POLL_IN, DDNS_POLL_OUT and DDNS_POLL_ERROR, or after the timer
+ * expired if socket is DDNS_SOCKET_TIMEOUT
+ *
+ * The callbacks of the operations done in the meantime are called before
+ * returning. The function returns DDNS_ERROR_GENERIC if curl failed, and
+ * DDNS_ERROR_USAGE if the async has no callbacks set.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_socket_action(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_socket socket,
+	int events
+) DDNS_NOEXCEPT;
+
+/**
+ * Wait up to timeout_ms milliseconds for the requests of the async to make
+ * progress, without an event loop
+ *
+ * The callbacks of the operations done in the meantime are called before
+ * returning, and the function returns right away if no operation is
+ * running. It returns DDNS_ERROR_GENERIC if curl failed, and
+ * DDNS_ERROR_USAGE if the async has callbacks set or timeout_ms is
+ * negative.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_poll(
+	ddns_async* DDNS_RESTRICT async,
+	int timeout_ms
+) DDNS_NOEXCEPT;
+
+/**
+ * Get the number of operations of the async whose callback wasn't called
+ * yet
+ */
+DDNS_NODISCARD DDNS_PUB size_t ddns_async_pending(
+	const ddns_async* DDNS_RESTRICT async
+) DDNS_NOEXCEPT;
+
+/**
+ * Start getting a public IP address of the machine
+ *
+ * This works like ddns_client_get_local_ips() with a single element, but
+ * returns right away: local_ip must stay valid until callback is called
+ * with user, once the request is done, from ddns_async_socket_action() or
+ * ddns_async_poll(). The callback can start other operations, but must not
+ * call any other function of the async.
+ *
+ * The function returns DDNS_ERROR_GENERIC if the operation couldn't be
+ * started, in which case callback isn't called. Every other outcome,
+ * invalid parameters included, is passed to callback.
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_get_local_ip(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_local_ip* DDNS_RESTRICT local_ip,
+	ddns_async_callback callback,
+	void* user
+) DDNS_NOEXCEPT;
+
+/**
+ * Start looking up the records of a name
+ *
+ * Like ddns_async_get_local_ip(), but for a single query of
+ * ddns_client_get_records_multi()
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_get_records(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_record_query* DDNS_RESTRICT query,
+	ddns_async_callback callback,
+	void* user
+) DDNS_NOEXCEPT;
+
+/**
+ * Start searching the zone of a record
+ *
+ * Like ddns_async_get_local_ip(), but searching the zone like
+ * ddns_client_search_zone_id() does
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_search_zone_id(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_zone_search* DDNS_RESTRICT search,
+	ddns_async_callback callback,
+	void* user
+) DDNS_NOEXCEPT;
+
+/**
+ * Start updating a record
+ *
+ * Like ddns_async_get_local_ip(), but for a single update of
+ * ddns_client_update_records_multi()
+ */
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_update_record(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_record_update* DDNS_RESTRICT update,
+	ddns_async_callback callback,
+	void* user
+) DDNS_NOEXCEPT;
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,621 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/**
+ * C++20 coroutines running the requests of a ddns_client without blocking
+ *
+ * Tasks are coroutines that co_await the requests made through an
+ * executor, which drives them with a ddns_async. Awaiting a task gives a
+ * ddns::result, holding either its value or the error that stopped it, as
+ * nothing here throws:
+ *
+ *     ddns::task<void> refresh(ddns::executor& executor, const char* api_token, const char* name) {
+ *         const ddns::result<ddns::zone_id> zone {co_await ddns::search_zone_id(executor, api_token, name)};
+ *         if (!zone) {
+ *             co_return zone.error();
+ *         }
+ *         const ddns::result<ddns_record> record {co_await ddns::get_record(executor, api_token, zone->data(), name, false)};
+ *         ...
+ *     }
+ *
+ *     ddns::executor executor {client};
+ *     const ddns::result<void> done {executor.run(refresh(executor, api_token, name))};
+ *
+ * Tasks start when they're awaited, or when executor::run() is called,
+ * and when_all() runs many of them concurrently. Their frames come from a
+ * pool kept by each thread, so that once a flow ran a first time running
+ * it again allocates nothing. A task whose frame can't be allocated
+ * finishes right away with DDNS_ERROR_GENERIC.
+ *
+ * Like the async they're built on, an executor and its tasks must be used
+ * by a single thread, and the executor must be destroyed before its
+ * client.
+ */
+
+#ifndef DDNS_TASK_HPP
+#define DDNS_TASK_HPP
+
+#include <ddns/cloudflare-ddns.h>
+
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#	error "ddns/task.hpp needs C++20 coroutines"
+#endif
+
+#include <array> /* std::array */
+#include <coroutine> /* std::coroutine_handle, std::noop_coroutine, std::suspend_always */
+#include <cstddef> /* std::size_t */
+#include <cstring> /* std::memcpy */
+#include <exception> /* std::terminate */
+#include <new> /* std::nothrow, operator new, operator delete */
+#include <utility> /* std::exchange, std::move */
+
+namespace ddns {
+
+/**
+ * The value of a task, or the error that stopped it
+ */
+template <typename T>
+class result {
+public:
+	result(T value) DDNS_NOEXCEPT : value_{std::move(value)}, error_{DDNS_ERROR_OK} {}
+	result(const ddns_error error) DDNS_NOEXCEPT : value_{}, error_{error} {}
+
+	DDNS_NODISCARD ddns_error error() const DDNS_NOEXCEPT {
+		return error_;
+	}
+
+	explicit operator bool() const DDNS_NOEXCEPT {
+		return error_ == DDNS_ERROR_OK;
+	}
+
+	/**
+	 * The value, which is only meaningful if there's no error
+	 */
+	T& operator*() DDNS_NOEXCEPT {
+		return value_;
+	}
+
+	const T& operator*() const DDNS_NOEXCEPT {
+		return value_;
+	}
+
+	T* operator->() DDNS_NOEXCEPT {
+		return &value_;
+	}
+
+	const T* operator->() const DDNS_NOEXCEPT {
+		return &value_;
+	}
+
+private:
+	T value_;
+	ddns_error error_;
+};
+
+template <>
+class result<void> {
+public:
+	result(const ddns_error error = DDNS_ERROR_OK) DDNS_NOEXCEPT : error_{error} {}
+
+	DDNS_NODISCARD ddns_error error() const DDNS_NOEXCEPT {
+		return error_;
+	}
+
+	explicit operator bool() const DDNS_NOEXCEPT {
+		return error_ == DDNS_ERROR_OK;
+	}
+
+private:
+	ddns_error error_;
+};
+
+using ip_address = std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH>;
+using zone_id = std::array<char, DDNS_ZONE_ID_LENGTH + 1U>;
+
+template <typename T = void>
+class task;
+
+namespace detail {
+
+/*
+ * Keeps the frames of the finished coroutines of a thread, by size, to
+ * give them to the next ones. Frames larger than the largest size are
+ * allocated and freed every time.
+ */
+class frame_pool {
+public:
+	frame_pool() = default;
+	frame_pool(const frame_pool&) = delete;
+	frame_pool& operator=(const frame_pool&) = delete;
+
+	~frame_pool() {
+		for (node*& head : free_) {
+			while (node* const frame = head) {
+				head = frame->next;
+				::operator delete(frame);
+			}
+		}
+	}
+
+	DDNS_NODISCARD void* allocate(const std::size_t size) DDNS_NOEXCEPT {
+		const std::size_t size_class {(size + granularity - 1U) / granularity};
+		if (size_class >= size_classes) {
+			return ::operator new(size, std::nothrow);
+		}
+		if (node* const frame = free_[size_class]) {
+			free_[size_class] = frame->next;
+			return frame;
+		}
+		return ::operator new(size_class * granularity, std::nothrow);
+	}
+
+	void deallocate(void* const memory, const std::size_t size) DDNS_NOEXCEPT {
+		const std::size_t size_class {(size + granularity - 1U) / granularity};
+		if (size_class >= size_classes) {
+			::operator delete(memory);
+			return;
+		}
+		node* const frame {static_cast<node*>(memory)};
+		frame->next = free_[size_class];
+		free_[size_class] = frame;
+	}
+
+	static frame_pool& local() DDNS_NOEXCEPT {
+		thread_local frame_pool pool;
+		return pool;
+	}
+
+private:
+	struct node {
+		node* next;
+	};
+
+	static constexpr std::size_t granularity {64U};
+	// Up to 8 KiB, enough for the frames of the flows of this header
+	static constexpr std::size_t size_classes {129U};
+
+	node* free_[size_classes] {};
+};
+
+/*
+ * What a finished task resumes: the coroutine awaiting it, or, when run by
+ * when_all(), the coroutine awaiting all the tasks once the last is done
+ */
+struct task_links {
+	std::coroutine_handle<> continuation {};
+	std::size_t* remaining {nullptr};
+};
+
+struct final_awaiter {
+	bool await_ready() const DDNS_NOEXCEPT {
+		return false;
+	}
+
+	template <typename Promise>
+	std::coroutine_handle<> await_suspend(const std::coroutine_handle<Promise> handle) DDNS_NOEXCEPT {
+		task_links& links {handle.promise()};
+		if (links.remaining != nullptr && --*links.remaining != 0) {
+			return std::noop_coroutine();
+		}
+		return links.continuation ? links.continuation : std::noop_coroutine();
+	}
+
+	void await_resume() const DDNS_NOEXCEPT {}
+};
+
+template <typename T>
+struct promise_base : task_links {
+	static void* operator new(const std::size_t size) DDNS_NOEXCEPT {
+		return frame_pool::local().allocate(size);
+	}
+
+	static void operator delete(void* const memory, const std::size_t size) DDNS_NOEXCEPT {
+		frame_pool::local().deallocate(memory, size);
+	}
+
+	std::suspend_always initial_suspend() const DDNS_NOEXCEPT {
+		return {};
+	}
+
+	final_awaiter final_suspend() const DDNS_NOEXCEPT {
+		return {};
+	}
+
+	// Only reachable if a coroutine is built with exceptions and throws
+	void unhandled_exception() const DDNS_NOEXCEPT {
+		std::terminate();
+	}
+
+	result<T> value {DDNS_ERROR_GENERIC};
+};
+
+/*
+ * A task started by a join, and where it links back to it
+ */
+struct join_child {
+	std::coroutine_handle<> handle;
+	task_links* links;
+};
+
+/*
+ * Awaits size tasks, started one after the other, until they're all done.
+ * child() gives the task at an index of tasks.
+ */
+class join {
+public:
+	using child_function = join_child (*)(void* tasks, std::size_t index);
+
+	join(void* const tasks, const std::size_t size, const child_function child) DDNS_NOEXCEPT
+		: tasks_{tasks}, size_{size}, child_{child} {}
+
+	join(const join&) = delete;
+	join& operator=(const join&) = delete;
+
+	bool await_ready() const DDNS_NOEXCEPT {
+		return false;
+	}
+
+	bool await_suspend(const std::coroutine_handle<> handle) DDNS_NOEXCEPT {
+		// One more than the tasks, so that those finishing while the
+		// others are being started don't resume the awaiting coroutine
+		remaining_ = size_ + 1U;
+		for (std::size_t i = 0; i < size_; ++i) {
+			const join_child child {child_(tasks_, i)};
+			if (!child.handle || child.handle.done()) {
+				--remaining_;
+				continue;
+			}
+			child.links->continuation = handle;
+			child.links->remaining = &remaining_;
+			child.handle.resume();
+		}
+		return --remaining_ != 0;
+	}
+
+	void await_resume() const DDNS_NOEXCEPT {}
+
+private:
+	void* tasks_;
+	std::size_t size_;
+	child_function child_;
+	std::size_t remaining_ {0};
+};
+
+/*
+ * The children of a fixed_join, as a base class so that they're built
+ * before the join pointing to them
+ */
+template <std::size_t N>
+struct join_children {
+	std::array<join_child, N> children;
+};
+
+template <std::size_t N>
+class fixed_join : private join_children<N>, public join {
+public:
+	explicit fixed_join(const std::array<join_child, N>& children) DDNS_NOEXCEPT
+		: join_children<N>{children}, join{this->children.data(), N, child_at} {}
+
+private:
+	static join_child child_at(void* const children, const std::size_t index) DDNS_NOEXCEPT {
+		return static_cast<join_child*>(children)[index];
+	}
+};
+
+} // namespace detail
+
+/**
+ * A coroutine returning a T, or only an error if T is void
+ *
+ * Tasks finish with co_return and either a T or an error, which is
+ * DDNS_ERROR_OK for the successful tasks returning void.
+ * A task is started by awaiting it, which gives its result, by
+ * executor::run() or by when_all(), and must outlive its execution.
+ */
+template <typename T>
+class [[nodiscard]] task {
+public:
+	struct promise_type : detail::promise_base<T> {
+		static task get_return_object_on_allocation_failure() DDNS_NOEXCEPT {
+			return task{};
+		}
+
+		task get_return_object() DDNS_NOEXCEPT {
+			return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+		}
+
+		void return_value(result<T> value) DDNS_NOEXCEPT {
+			this->value = std::move(value);
+		}
+	};
+
+	task() DDNS_NOEXCEPT = default;
+
+	task(task&& other) DDNS_NOEXCEPT : handle_{std::exchange(other.handle_, {})} {}
+
+	task& operator=(task&& other) DDNS_NOEXCEPT {
+		if (this != &other) {
+			destroy();
+			handle_ = std::exchange(other.handle_, {});
+		}
+		return *this;
+	}
+
+	~task() {
+		destroy();
+	}
+
+	/**
+	 * Whether the task finished, which it did if its frame couldn't be
+	 * allocated
+	 */
+	DDNS_NODISCARD bool done() const DDNS_NOEXCEPT {
+		return !handle_ || handle_.done();
+	}
+
+	/*
+	 * How when_all() starts the task
+	 */
+	DDNS_NODISCARD detail::join_child child() DDNS_NOEXCEPT {
+		return {handle_, handle_ ? &handle_.promise() : nullptr};
+	}
+
+	/**
+	 * The result of the finished task
+	 */
+	DDNS_NODISCARD result<T>& get() DDNS_NOEXCEPT {
+		return handle_ ? handle_.promise().value : failed_;
+	}
+
+	bool await_ready() const DDNS_NOEXCEPT {
+		return done();
+	}
+
+	std::coroutine_handle<> await_suspend(const std::coroutine_handle<> awaiting) DDNS_NOEXCEPT {
+		handle_.promise().continuation = awaiting;
+		return handle_;
+	}
+
+	result<T> await_resume() DDNS_NOEXCEPT {
+		return std::move(get());
+	}
+
+private:
+	friend class executor;
+
+	explicit task(const std::coroutine_handle<promise_type> handle) DDNS_NOEXCEPT : handle_{handle} {}
+
+	void destroy() DDNS_NOEXCEPT {
+		if (handle_) {
+			handle_.destroy();
+			handle_ = {};
+		}
+	}
+
+	std::coroutine_handle<promise_type> handle_ {};
+	result<T> failed_ {DDNS_ERROR_GENERIC};
+};
+
+/**
+ * Awaits all the tasks, running them concurrently. Their results are then
+ * read with task::get().
+ */
+template <typename... T>
+DDNS_NODISCARD detail::fixed_join<sizeof...(T)> when_all(task<T>&... tasks) DDNS_NOEXCEPT {
+	return detail::fixed_join<sizeof...(T)>{std::array<detail::join_child, sizeof...(T)>{tasks.child()...}};
+}
+
+/**
+ * Awaits the first size tasks of tasks, like the other when_all()
+ */
+template <typename T>
+DDNS_NODISCARD detail::join when_all(task<T>* const tasks, const std::size_t size) DDNS_NOEXCEPT {
+	return detail::join{tasks, size, [](void* const all, const std::size_t index) DDNS_NOEXCEPT {
+		return static_cast<task<T>*>(all)[index].child();
+	}};
+}
+
+/**
+ * Runs the requests of the tasks made with it on a ddns_async of client
+ */
+class executor {
+public:
+	explicit executor(ddns_client* const client) DDNS_NOEXCEPT : client_{client} {
+		error_ = ddns_async_create(client_, &async_);
+	}
+
+	executor(const executor&) = delete;
+	executor& operator=(const executor&) = delete;
+
+	~executor() {
+		ddns_async_destroy(async_);
+	}
+
+	/**
+	 * DDNS_ERROR_GENERIC if the async couldn't be created, in which case
+	 * every request fails
+	 */
+	DDNS_NODISCARD ddns_error error() const DDNS_NOEXCEPT {
+		return error_;
+	}
+
+	DDNS_NODISCARD ddns_async* async() const DDNS_NOEXCEPT {
+		return async_;
+	}
+
+	/**
+	 * Runs task until it's done, driving the requests of all the tasks of
+	 * the executor, and returns its result
+	 *
+	 * If curl fails, the requests still running are abandoned and the
+	 * result is DDNS_ERROR_GENERIC.
+	 */
+	template <typename T>
+	DDNS_NODISCARD result<T> run(task<T>&& task) DDNS_NOEXCEPT {
+		if (error_) {
+			return DDNS_ERROR_GENERIC;
+		}
+		if (task.done()) {
+			return std::move(task.get());
+		}
+
+		task.handle_.resume();
+		while (!task.done()) {
+			if (ddns_async_poll(async_, poll_timeout_ms) != DDNS_ERROR_OK) {
+				// The tasks waiting for the abandoned requests can't be
+				// resumed, so they're destroyed along with task
+				ddns_async_destroy(async_);
+				async_ = nullptr;
+				error_ = ddns_async_create(client_, &async_);
+				return DDNS_ERROR_GENERIC;
+			}
+		}
+		return std::move(task.get());
+	}
+
+private:
+	// ddns_async_poll() returns as soon as a request makes progress
+	static constexpr int poll_timeout_ms {1000};
+
+	ddns_client* client_;
+	ddns_async* async_ {nullptr};
+	ddns_error error_ {DDNS_ERROR_GENERIC};
+};
+
+namespace detail {
+
+/*
+ * Awaits an operation of a ddns_async, whose entry is kept in the frame of
+ * the awaiting coroutine while it runs
+ */
+template <typename Entry, ddns_error (*Start)(ddns_async*, Entry*, ddns_async_callback, void*)>
+class operation {
+public:
+	operation(executor& executor, const Entry& entry) DDNS_NOEXCEPT : async_{executor.async()}, entry_{entry} {}
+
+	operation(const operation&) = delete;
+	operation& operator=(const operation&) = delete;
+
+	bool await_ready() const DDNS_NOEXCEPT {
+		return false;
+	}
+
+	bool await_suspend(const std::coroutine_handle<> handle) DDNS_NOEXCEPT {
+		handle_ = handle;
+		// Not suspended if the operation can't be started, as its callback
+		// isn't called
+		if (async_ == nullptr || Start(async_, &entry_, resume, this) != DDNS_ERROR_OK) {
+			entry_.error = DDNS_ERROR_GENERIC;
+			return false;
+		}
+		return true;
+	}
+
+	Entry& await_resume() DDNS_NOEXCEPT {
+		return entry_;
+	}
+
+private:
+	static void resume(ddns_error, void* const user) DDNS_NOEXCEPT {
+		static_cast<operation*>(user)->handle_.resume();
+	}
+
+	ddns_async* async_;
+	Entry entry_;
+	std::coroutine_handle<> handle_ {};
+};
+
+} // namespace detail
+
+/**
+ * Get a public IP address of the machine, like ddns_client_get_local_ips()
+ * does for a single element
+ */
+inline task<ip_address> get_local_ip(executor& executor, const bool ipv6, const long timeout_ms = 0) {
+	const ddns_local_ip local_ip {co_await detail::operation<ddns_local_ip, ddns_async_get_local_ip>{executor, {ipv6, timeout_ms, {}, DDNS_ERROR_GENERIC}}};
+	if (local_ip.error) {
+		co_return local_ip.error;
+	}
+	ip_address ip;
+	std::memcpy(ip.data(), local_ip.ip, ip.size());
+	co_return ip;
+}
+
+/**
+ * Search the zone of a record, like ddns_client_search_zone_id() does
+ */
+inline task<zone_id> search_zone_id(executor& executor, const char* const api_token, const char* const record_name) {
+	const ddns_zone_search search {co_await detail::operation<ddns_zone_search, ddns_async_search_zone_id>{executor, {api_token, record_name, {}, DDNS_ERROR_GENERIC}}};
+	if (search.error) {
+		co_return search.error;
+	}
+	zone_id id;
+	std::memcpy(id.data(), search.zone_id, id.size());
+	co_return id;
+}
+
+/**
+ * Look up the records of a name, like ddns_client_get_records_multi() does
+ * for a single query, returning how many were written to records
+ */
+inline task<std::size_t> get_records(
+	executor& executor,
+	const char* const api_token,
+	const char* const zone_id,
+	const char* const record_name,
+	const std::size_t records_size, ddns_record* const records
+) {
+	const ddns_record_query query {co_await detail::operation<ddns_record_query, ddns_async_get_records>{executor, {api_token, zone_id, record_name, records_size, records, 0, DDNS_ERROR_GENERIC}}};
+	if (query.error) {
+		co_return query.error;
+	}
+	co_return query.records_count;
+}
+
+/**
+ * Get the A record of a name, or the AAAA one if aaaa is true, among its
+ * first four records. The result is DDNS_ERROR_GENERIC if there's none.
+ */
+inline task<ddns_record> get_record(
+	executor& executor,
+	const char* const api_token,
+	const char* const zone_id,
+	const char* const record_name,
+	const bool aaaa
+) {
+	std::array<ddns_record, 4> records;
+	const result<std::size_t> found {co_await get_records(executor, api_token, zone_id, record_name, records.size(), records.data())};
+	if (!found) {
+		co_return found.error();
+	}
+	// The records that didn't fit are counted too
+	const std::size_t written {*found < records.size() ? *found : records.size()};
+	for (std::size_t i = 0; i < written; ++i) {
+		if (records[i].aaaa == aaaa) {
+			co_return records[i];
+		}
+	}
+	co_return DDNS_ERROR_GENERIC;
+}
+
+/**
+ * Update the IP address of a record, like ddns_client_update_records_multi()
+ * does for a single update
+ */
+inline task<void> update_record(
+	executor& executor,
+	const char* const api_token,
+	const char* const zone_id,
+	const char* const record_id,
+	const char* const new_ip
+) {
+	const ddns_record_update update {co_await detail::operation<ddns_record_update, ddns_async_update_record>{executor, {api_token, zone_id, record_id, new_ip, {}, DDNS_ERROR_GENERIC}}};
+	co_return update.error;
+}
+
+} // namespace ddns
+
+#endif /* DDNS_TASK_HPP */
@@ -13,6 +13,13 @@
 #endif
 
 #include <ddns/cloudflare-ddns.h>
+#include "json.hpp"
+#include "netlink.hpp"
+#include "psl.hpp"
+#include "ratelimit.hpp"
+#include "request.hpp"
+#include "resolve.hpp"
+#include "retry.hpp"
 
 #include <curl/curl.h>
 // curl.h redefines fopen on Windows, causing issues.
@@ -22,9 +29,16 @@ namespace std {
 }
 #endif
 
-#include <cstring> /* std::memcpy, std::size_t, std::strlen */
-#include <optional> /* std::optional */
+#include <algorithm> /* std::sort, std::equal_range */
+#include <chrono> /* std::chrono::steady_clock, std::chrono::milliseconds, std::chrono::microseconds */
+#include <cstdint> /* std::int64_t, std::uint32_t */
+#include <cstring> /* std::memchr, std::memcmp, std::memcpy, std::size_t, std::strlen */
+#include <ctime> /* std::time */
+#include <iterator> /* std::size */
+#include <new> /* std::nothrow */
 #include <string_view> /* std::string_view */
+#include <thread> /* std::this_thread::sleep_for */
+#include <type_traits> /* std::is_same_v, std::decay_t */
 
 /*
  * By reading Cloudflare's docs, I can see what is the maximum allowed
@@ -34,69 +48,180 @@ namespace std {
  */
 
 namespace priv {
+
 /*
- * key must include quotes
+ * Grows buffer, holding size elements, so that it can hold at least
+ * required ones, doubling its capacity every time
  */
-static std::optional<std::string_view> get_json_value(const std::string_view json, const std::string_view key) {
-	const size_t key_start = json.find(key);
-	if (key_start == std::string_view::npos) {
-		return {};
+template <typename T>
+DDNS_NODISCARD static bool reserve(T*& buffer, const std::size_t size, std::size_t& capacity, const std::size_t required) DDNS_NOEXCEPT {
+	if (required <= capacity) {
+		return true;
 	}
 
-	const size_t key_end = key_start + key.length();
-	if (key_end == std::string_view::npos) {
-		return {};
+	std::size_t new_capacity {capacity == 0 ? 64U : capacity};
+	while (new_capacity < required) {
+		new_capacity *= 2U;
 	}
 
-	const size_t value_start = json.find('"', key_end + 1) + 1;
-	if (value_start == std::string_view::npos) {
-		return {};
+	T* const new_buffer {new (std::nothrow) T[new_capacity]};
+	if (new_buffer == nullptr) {
+		return false;
 	}
-
-	const size_t value_end = json.find('"', value_start + 1);
-	if (value_end == std::string_view::npos) {
-		return {};
+	if (size != 0) {
+		std::memcpy(new_buffer, buffer, size * sizeof(T));
 	}
-
-	return std::string_view(json.data() + value_start, value_end - value_start);
+	delete[] buffer;
+	buffer = new_buffer;
+	capacity = new_capacity;
+	return true;
 }
 
 } // namespace priv
 
 extern "C" {
 
-static constexpr std::string_view base_url {"https://api.cloudflare.com/client/v4/zones/"};
+static constexpr std::string_view default_zones_url {"https://api.cloudflare.com/client/v4/zones/"};
 
 namespace priv {
 
-struct static_buffer {
-	static constexpr std::size_t capacity {CURL_MAX_WRITE_SIZE};
-	std::size_t size {0};
-	char buffer[capacity];
+/*
+ * Where responses are written. Most of them hold a single record and fit
+ * in the inline buffer, so they need no allocation; longer ones, like
+ * pages of a zone listing or verbose errors, spill into a heap buffer,
+ * which is kept around to be reused by the following responses.
+ */
+class response_sink {
+public:
+	static constexpr std::size_t inline_capacity {4096U};
+	// A misbehaving server must not be able to exhaust memory
+	static constexpr std::size_t max_size {16U * 1024U * 1024U};
+
+	response_sink() DDNS_NOEXCEPT = default;
+
+	~response_sink() {
+		delete[] spill_;
+	}
+
+	response_sink(const response_sink&) = delete;
+	response_sink& operator=(const response_sink&) = delete;
+
+	/*
+	 * Discards the current response, keeping the spill buffer
+	 */
+	void clear() DDNS_NOEXCEPT {
+		size_ = 0;
+		spilled_ = false;
+	}
+
+	/*
+	 * Whether the body of the response being received is dropped, because
+	 * the request is going to be sent again
+	 */
+	bool skipping() const DDNS_NOEXCEPT {
+		return skipping_;
+	}
+
+	void skip(const bool skipping) DDNS_NOEXCEPT {
+		skipping_ = skipping;
+	}
+
+	DDNS_NODISCARD bool append(const char* DDNS_RESTRICT data, const std::size_t count) DDNS_NOEXCEPT {
+		const std::size_t required {size_ + count};
+		if (required > max_size) {
+			return false;
+		}
+
+		if (!spilled_ && required > inline_capacity) {
+			// The spill buffer holds nothing worth copying yet
+			if (!reserve(spill_, 0, spill_capacity_, required)) {
+				return false;
+			}
+			std::memcpy(spill_, inline_, size_);
+			spilled_ = true;
+		}
+		else if (spilled_ && !reserve(spill_, size_, spill_capacity_, required)) {
+			return false;
+		}
+
+		std::memcpy(spilled_ ? spill_ + size_ : inline_ + size_, data, count);
+		size_ = required;
+		return true;
+	}
+
+	const char* data() const DDNS_NOEXCEPT {
+		return spilled_ ? spill_ : inline_;
+	}
+
+	std::size_t size() const DDNS_NOEXCEPT {
+		return size_;
+	}
+
+	std::string_view view() const DDNS_NOEXCEPT {
+		return {data(), size_};
+	}
+
+	// When set, the response is also parsed while it's being received
+	json::response_parser* parser {nullptr};
+
+private:
+	std::size_t size_ {0};
+	bool spilled_ {false};
+	bool skipping_ {false};
+	char* spill_ {nullptr};
+	std::size_t spill_capacity_ {0};
+	char inline_[inline_capacity];
 };
 
 static std::size_t write_data(
 	char* DDNS_RESTRICT incoming_buffer,
 	const std::size_t /*size*/, // size will always be 1
 	const std::size_t count,
-	static_buffer* DDNS_RESTRICT data
+	response_sink* DDNS_RESTRICT data
 ) DDNS_NOEXCEPT {
-	// Check if the static buffer can handle all the new data
-	if (data->size + count >= static_buffer::capacity) {
+	if (data->skipping()) {
+		return /*size **/ count;
+	}
+	// Returning less than count makes curl abort the transfer
+	if (!data->append(incoming_buffer, /*size **/ count)) {
 		return 0;
 	}
-	// Append to the buffer
-	std::memcpy(data->buffer + data->size, incoming_buffer, /*size **/ count);
-	// Increase the current size
-	data->size += /*size **/ count;
-	// null-terminate the buffer (so that it can be used as a C string)
-	// data->buffer[data->size] = '\0';
+	if (data->parser != nullptr) {
+		// Malformed responses are reported by the parser once done
+		data->parser->feed(incoming_buffer, count);
+	}
 	return /*size **/ count;
 }
 
+/*
+ * Looks for the status line of every response, so that the bodies of the
+ * ones that are going to be retried aren't mixed with the final one
+ */
+static std::size_t read_header(
+	char* DDNS_RESTRICT header,
+	const std::size_t /*size*/, // size will always be 1
+	const std::size_t count,
+	response_sink* DDNS_RESTRICT data
+) DDNS_NOEXCEPT {
+	constexpr std::string_view status_prefix {"HTTP/"};
+	const std::string_view line {header, count};
+	if (line.substr(0, status_prefix.length()) != status_prefix) {
+		return count;
+	}
+
+	// "HTTP/2 429 \r\n" or "HTTP/1.1 429 Too Many Requests\r\n"
+	const std::size_t space {line.find(' ')};
+	long status {0};
+	for (std::size_t i = space + 1U; space != std::string_view::npos && i < line.length() && line[i] >= '0' && line[i] <= '9'; ++i) {
+		status = status * 10 + (line[i] - '0');
+	}
+	data->skip(retry::retryable(status));
+	return count;
+}
+
 static void curl_handle_setup(
 	CURL** DDNS_RESTRICT curl,
-	const static_buffer& response_buffer
+	const response_sink& response_buffer
 ) DDNS_NOEXCEPT {
 	// General curl options
 	curl_easy_setopt(*curl, CURLOPT_NOPROGRESS, 1L);
@@ -107,15 +232,283 @@ static void curl_handle_setup(
 	curl_easy_setopt(*curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1_2);
 	curl_easy_setopt(*curl, CURLOPT_WRITEFUNCTION, write_data);
 	curl_easy_setopt(*curl, CURLOPT_WRITEDATA, &response_buffer);
+	curl_easy_setopt(*curl, CURLOPT_HEADERFUNCTION, read_header);
+	curl_easy_setopt(*curl, CURLOPT_HEADERDATA, &response_buffer);
+	// A hung server mustn't hold the caller forever
+	curl_easy_setopt(*curl, CURLOPT_CONNECTTIMEOUT_MS, retry::default_connect_timeout_ms);
+	curl_easy_setopt(*curl, CURLOPT_TIMEOUT_MS, retry::default_timeout_ms);
+}
+
+static std::int64_t steady_ms() DDNS_NOEXCEPT {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::int64_t steady_us() DDNS_NOEXCEPT {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The DoH resolver can't look up its own address
+static constexpr const char* doh_resolver_address {"cloudflare-dns.com:443:104.16.248.249,104.16.249.249,2606:4700::6810:f8f9,2606:4700::6810:f9f9"};
+
+/*
+ * The addresses of the hosts a client talks to
+ */
+struct resolver {
+	resolve::cache cache;
+	// Where the cache is kept between runs, or nullptr
+	char* path {nullptr};
+	char* temporary_path {nullptr};
+	// Used for the lookups, keeping its connection to the DoH resolver
+	CURL* curl {nullptr};
+	// The one of the client, so that the connection and TLS session to
+	// the DoH resolver are shared with its other handles
+	CURLSH* share {nullptr};
+
+	resolver() DDNS_NOEXCEPT = default;
+
+	~resolver() {
+		curl_easy_cleanup(curl);
+		delete[] path;
+	}
+
+	resolver(const resolver&) = delete;
+	resolver& operator=(const resolver&) = delete;
+};
+
+/*
+ * What the handles of a client need to know about it, set as their
+ * private data so that curl_doh_setup() and perform() can find it
+ */
+struct client_context {
+	priv::resolver resolver;
+	// Of every attempt of a request, 0 meaning none
+	long timeout_ms {retry::default_timeout_ms};
+	// When the requests must be done by, in steady_ms(), or 0
+	std::int64_t deadline_ms {0};
+	// Spreads the retries of different clients
+	std::uint32_t random {1U};
+	ratelimit::limiter limiter;
+	// Told how every request went, if set
+	ddns_stats_callback stats_callback {nullptr};
+	void* stats_user {nullptr};
+};
+
+/*
+ * Adds what curl knows about the attempt it just made to stats
+ */
+static void count_attempt(ddns_stats& stats, CURL* const curl) DDNS_NOEXCEPT {
+	++stats.attempts;
+	stats.status = 0;
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &stats.status);
+
+	// A request that failed before connecting made no connection either
+	long connects {0};
+	curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+	stats.reused_connection = connects == 0 && stats.status != 0;
+
+	long* const timings[] {&stats.namelookup_us, &stats.connect_us, &stats.appconnect_us, &stats.starttransfer_us, &stats.total_us};
+#if LIBCURL_VERSION_NUM >= 0x073d00
+	constexpr CURLINFO timings_info[] {CURLINFO_NAMELOOKUP_TIME_T, CURLINFO_CONNECT_TIME_T, CURLINFO_APPCONNECT_TIME_T, CURLINFO_STARTTRANSFER_TIME_T, CURLINFO_TOTAL_TIME_T};
+	for (std::size_t i = 0; i < std::size(timings); ++i) {
+		curl_off_t us {0};
+		curl_easy_getinfo(curl, timings_info[i], &us);
+		*timings[i] = static_cast<long>(us);
+	}
+#else
+	constexpr CURLINFO timings_info[] {CURLINFO_NAMELOOKUP_TIME, CURLINFO_CONNECT_TIME, CURLINFO_APPCONNECT_TIME, CURLINFO_STARTTRANSFER_TIME, CURLINFO_TOTAL_TIME};
+	for (std::size_t i = 0; i < std::size(timings); ++i) {
+		double seconds {0};
+		curl_easy_getinfo(curl, timings_info[i], &seconds);
+		*timings[i] = static_cast<long>(seconds * 1e6);
+	}
+#endif
+
+	long request_size {0};
+	long header_size {0};
+	curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &request_size);
+	curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &header_size);
+#if LIBCURL_VERSION_NUM >= 0x073700
+	curl_off_t body_size {0};
+	curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &body_size);
+#else
+	double body_size {0};
+	curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD, &body_size);
+#endif
+	stats.bytes_sent += static_cast<std::size_t>(request_size);
+	stats.bytes_received += static_cast<std::size_t>(header_size) + static_cast<std::size_t>(body_size);
+}
+
+/*
+ * What a request to url is for, api telling whether it's made to the API
+ */
+static ddns_endpoint endpoint_of(const std::string_view url, const bool api) DDNS_NOEXCEPT {
+	if (!api) {
+		return DDNS_ENDPOINT_TRACE;
+	}
+	const std::string_view path {url.substr(0, url.find('?'))};
+	const auto ends_with = [path](const std::string_view suffix) {
+		return path.length() >= suffix.length() && path.substr(path.length() - suffix.length()) == suffix;
+	};
+	if (ends_with(request::zones_path)) {
+		return DDNS_ENDPOINT_ZONES;
+	}
+	if (ends_with(request::dns_records_batch_path)) {
+		return DDNS_ENDPOINT_BATCH;
+	}
+	if (path.find(request::dns_records_path) != std::string_view::npos) {
+		return DDNS_ENDPOINT_UPDATE;
+	}
+	return DDNS_ENDPOINT_DNS_RECORDS;
+}
+
+/*
+ * Passes the stats of a request started at started_us, in steady_us(), to
+ * the callback of the client
+ */
+static void report_stats(const client_context& context, ddns_stats& stats, const ddns_endpoint endpoint, const std::int64_t started_us) DDNS_NOEXCEPT {
+	stats.endpoint = endpoint;
+	stats.elapsed_us = static_cast<long>(steady_us() - started_us);
+	context.stats_callback(&stats, context.stats_user);
+}
+
+/*
+ * Looks up the A and AAAA records of the host of entry, replacing its
+ * addresses. If the lookup fails, entry isn't looked up again for a while.
+ */
+DDNS_NODISCARD static bool lookup(client_context& context, resolve::entry& entry, const std::int64_t now) DDNS_NOEXCEPT {
+	// The lookups count towards the deadline of the client too
+	const long timeout_ms {retry::request_timeout_ms(context.timeout_ms, context.deadline_ms, steady_ms())};
+	if (timeout_ms < 0) {
+		return false;
+	}
+
+	resolver& resolver {context.resolver};
+	entry.retry_at = now + resolve::retry_delay;
+
+	if (resolver.curl == nullptr) {
+		resolver.curl = curl_easy_init();
+		if (resolver.curl == nullptr) {
+			return false;
+		}
+		curl_easy_setopt(resolver.curl, CURLOPT_SHARE, resolver.share);
+	}
+
+	response_sink response;
+	curl_handle_setup(&resolver.curl, response);
+	curl_easy_setopt(resolver.curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+	curl_slist* const resolver_address {curl_slist_append(nullptr, doh_resolver_address)};
+	curl_slist* const headers {curl_slist_append(nullptr, "Accept: application/dns-json")};
+	curl_easy_setopt(resolver.curl, CURLOPT_RESOLVE, resolver_address);
+	curl_easy_setopt(resolver.curl, CURLOPT_HTTPHEADER, headers);
+
+	resolve::entry found {entry};
+	found.addresses_count = 0;
+	std::int64_t ttl {resolve::max_ttl};
+
+	bool ok {true};
+	constexpr std::string_view types[] {"A", "AAAA"};
+	for (const std::string_view type : types) {
+		char url[request::doh_query_url::size];
+		if (request::doh_query_url::make(url, entry.host_sv(), type) != DDNS_ERROR_OK) {
+			ok = false;
+			break;
+		}
+
+		response.clear();
+		curl_easy_setopt(resolver.curl, CURLOPT_URL, url);
+		const std::int64_t started_us {steady_us()};
+		const CURLcode result {curl_easy_perform(resolver.curl)};
+		if (context.stats_callback != nullptr) {
+			ddns_stats stats {};
+			count_attempt(stats, resolver.curl);
+			report_stats(context, stats, DDNS_ENDPOINT_DOH, started_us);
+		}
+		long status {0};
+		if (result != CURLE_OK
+			|| curl_easy_getinfo(resolver.curl, CURLINFO_RESPONSE_CODE, &status) != CURLE_OK
+			|| status != 200) {
+			ok = false;
+			break;
+		}
+
+		resolve::answer_parser parser {found};
+		if (!parser.feed(response.data(), response.size()) || !parser.finish() || !parser.success()) {
+			ok = false;
+			break;
+		}
+		if (parser.ttl() >= 0 && parser.ttl() < ttl) {
+			ttl = parser.ttl();
+		}
+	}
+
+	// response and the lists are about to go away
+	curl_easy_setopt(resolver.curl, CURLOPT_WRITEDATA, nullptr);
+	curl_easy_setopt(resolver.curl, CURLOPT_HEADERDATA, nullptr);
+	curl_easy_setopt(resolver.curl, CURLOPT_RESOLVE, nullptr);
+	curl_easy_setopt(resolver.curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_slist_free_all(resolver_address);
+	curl_slist_free_all(headers);
+
+	if (!ok || found.addresses_count == 0) {
+		return false;
+	}
+
+	found.expires_at = now + ttl;
+	found.retry_at = 0;
+	entry = found;
+	return true;
+}
+
+/*
+ * Appends the addresses of the host of url to list, looking them up first
+ * if they're not known or expired and may_block is true. The list is left
+ * as it is if they can't be found, letting curl do the lookup itself.
+ */
+DDNS_NODISCARD static curl_slist* append_known_host(client_context& context, const std::string_view url, const bool may_block, curl_slist* const list) DDNS_NOEXCEPT {
+	const resolve::endpoint endpoint {resolve::url_endpoint(url)};
+	if (endpoint.host.empty()) {
+		return list;
+	}
+
+	resolver& resolver {context.resolver};
+	const std::int64_t now {static_cast<std::int64_t>(std::time(nullptr))};
+	resolve::entry& entry {resolver.cache.get(endpoint)};
+	if (may_block && !entry.fresh(now) && now >= entry.retry_at && lookup(context, entry, now) && resolver.path != nullptr) {
+		// Errors are ignored, as the file is only an optimisation
+		resolver.cache.save(resolver.path, resolver.temporary_path, now);
+	}
+	if (!entry.fresh(now)) {
+		return list;
+	}
+
+	char line[resolve::resolve_entry_size];
+	// Transient entries leave the DNS cache, so that stale addresses
+	// can't outlive the client's own cache
+	resolve::write_resolve_entry(entry, LIBCURL_VERSION_NUM >= 0x074b00, line);
+	curl_slist* const appended {curl_slist_append(list, line)};
+	return appended != nullptr ? appended : list;
 }
 
 /*
+ * Sets up DoH for a request to url. If the handle belongs to a client,
+ * the addresses it knows are handed to curl as well, so that no DoH query
+ * is made while they're valid. Unless may_block is true, the addresses
+ * that aren't known are left for curl to find, instead of looking them up
+ * first.
+ *
  * Returns the curl_slist that must be freed with curl_slist_free_all()
  */
-DDNS_NODISCARD static curl_slist* curl_doh_setup([[maybe_unused]] CURL** DDNS_RESTRICT curl) DDNS_NOEXCEPT {
+DDNS_NODISCARD static curl_slist* curl_doh_setup([[maybe_unused]] CURL** DDNS_RESTRICT curl, [[maybe_unused]] const std::string_view url, [[maybe_unused]] const bool may_block) DDNS_NOEXCEPT {
 #if LIBCURL_VERSION_NUM >= 0x073e00
 	struct curl_slist* manual_doh_address {nullptr};
-	manual_doh_address = curl_slist_append(manual_doh_address, "cloudflare-dns.com:443:104.16.248.249,104.16.249.249,2606:4700::6810:f8f9,2606:4700::6810:f9f9");
+	manual_doh_address = curl_slist_append(manual_doh_address, doh_resolver_address);
+
+	char* private_data {nullptr};
+	curl_easy_getinfo(*curl, CURLINFO_PRIVATE, &private_data);
+	if (private_data != nullptr && manual_doh_address != nullptr) {
+		manual_doh_address = append_known_host(*reinterpret_cast<client_context*>(private_data), url, may_block, manual_doh_address);
+	}
+
 	curl_easy_setopt(*curl, CURLOPT_RESOLVE, manual_doh_address);
 	curl_easy_setopt(*curl, CURLOPT_DOH_URL, "https://cloudflare-dns.com/dns-query");
 	return manual_doh_address;
@@ -124,6 +517,123 @@ DDNS_NODISCARD static curl_slist* curl_doh_setup([[maybe_unused]] CURL** DDNS_RE
 #endif
 }
 
+/*
+ * How long to wait before sending again the request just made by curl
+ * for the attempt-th time, or -1 if it shouldn't be retried, either
+ * because it doesn't need to or because the deadline would be missed
+ */
+DDNS_NODISCARD static long retry_delay_ms(client_context& context, CURL* const curl, const unsigned attempt) DDNS_NOEXCEPT {
+	long status {0};
+	if (curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status) != CURLE_OK || !retry::retryable(status)) {
+		return -1;
+	}
+
+	long retry_after_s {0};
+#if LIBCURL_VERSION_NUM >= 0x074200
+	curl_off_t retry_after {0};
+	if (curl_easy_getinfo(curl, CURLINFO_RETRY_AFTER, &retry_after) == CURLE_OK && retry_after > 0) {
+		retry_after_s = retry_after > retry::max_retry_after_s ? retry::max_retry_after_s + 1 : static_cast<long>(retry_after);
+	}
+#endif
+
+	const long delay_ms {retry::delay_ms(attempt, retry_after_s, retry::next_random(context.random))};
+	if (delay_ms < 0 || (context.deadline_ms != 0 && steady_ms() + delay_ms >= context.deadline_ms)) {
+		return -1;
+	}
+	return delay_ms;
+}
+
+/*
+ * Tells the limiter what the response just received by curl said about
+ * the rate limit of api_token
+ */
+static void observe_limits(client_context& context, CURL* const curl, const char* const api_token) DDNS_NOEXCEPT {
+	ratelimit::limits limits;
+
+	long status {0};
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+	limits.throttled = status == 429;
+
+#if LIBCURL_VERSION_NUM >= 0x075300
+	curl_header* header {nullptr};
+	if (curl_easy_header(curl, "RateLimit", 0, CURLH_HEADER, -1, &header) == CURLHE_OK) {
+		limits.remaining = ratelimit::parameter(header->value, 'r');
+		limits.reset_s = ratelimit::parameter(header->value, 't');
+	}
+	if (curl_easy_header(curl, "RateLimit-Policy", 0, CURLH_HEADER, -1, &header) == CURLHE_OK) {
+		limits.quota = ratelimit::parameter(header->value, 'q');
+		limits.window_s = ratelimit::parameter(header->value, 'w');
+	}
+#endif
+
+	context.limiter.observe(api_token, steady_ms(), limits);
+}
+
+/*
+ * Sends the request set up on curl for a client until it doesn't need to
+ * be retried, see perform()
+ */
+DDNS_NODISCARD static CURLcode perform_attempts(client_context& context, CURL* const curl, const char* const api_token, ddns_stats& stats) DDNS_NOEXCEPT {
+	for (unsigned attempt = 0;; ++attempt) {
+		// Wait for the rate limit of the token to allow one more request
+		while (api_token != nullptr) {
+			const long wait_ms {context.limiter.acquire(api_token, steady_ms())};
+			if (wait_ms == 0) {
+				break;
+			}
+			if (context.deadline_ms != 0 && steady_ms() + wait_ms >= context.deadline_ms) {
+				return CURLE_OPERATION_TIMEDOUT;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(wait_ms));
+		}
+
+		const long timeout_ms {retry::request_timeout_ms(context.timeout_ms, context.deadline_ms, steady_ms())};
+		if (timeout_ms < 0) {
+			return CURLE_OPERATION_TIMEDOUT;
+		}
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+
+		const CURLcode result {curl_easy_perform(curl)};
+		if (context.stats_callback != nullptr) {
+			count_attempt(stats, curl);
+		}
+		if (result == CURLE_OK && api_token != nullptr) {
+			observe_limits(context, curl, api_token);
+		}
+		const long delay_ms {result == CURLE_OK ? retry_delay_ms(context, curl, attempt) : -1};
+		if (delay_ms < 0) {
+			return result;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+	}
+}
+
+/*
+ * Performs the request set up on curl. The requests of a client are
+ * bounded by its timeout and deadline, paced by the rate limit of
+ * api_token, if they're made to the API, retried when the server asks
+ * for it, and reported to its stats callback.
+ */
+DDNS_NODISCARD static CURLcode perform(CURL* const curl, const char* const api_token) DDNS_NOEXCEPT {
+	char* private_data {nullptr};
+	curl_easy_getinfo(curl, CURLINFO_PRIVATE, &private_data);
+	if (private_data == nullptr) {
+		return curl_easy_perform(curl);
+	}
+	client_context& context {*reinterpret_cast<client_context*>(private_data)};
+
+	ddns_stats stats {};
+	const std::int64_t started_us {steady_us()};
+	const CURLcode result {perform_attempts(context, curl, api_token, stats)};
+	// Requests that were never sent have nothing to report
+	if (stats.attempts != 0) {
+		char* url {nullptr};
+		curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &url);
+		report_stats(context, stats, endpoint_of(url != nullptr ? url : "", api_token != nullptr), started_us);
+	}
+	return result;
+}
+
 DDNS_NODISCARD static curl_slist* curl_auth_setup(CURL** DDNS_RESTRICT curl, const char* DDNS_RESTRICT const api_token) DDNS_NOEXCEPT {
 	curl_easy_setopt(*curl, CURLOPT_HTTPAUTH, CURLAUTH_BEARER);
 	//curl_easy_setopt(*curl, CURLOPT_XOAUTH2_BEARER, api_token); leaks, see https://github.com/curl/curl/issues/8841
@@ -142,407 +652,2896 @@ DDNS_NODISCARD static curl_slist* curl_auth_setup(CURL** DDNS_RESTRICT curl, con
 }
 
 static void curl_get_setup(CURL** DDNS_RESTRICT curl, const char* DDNS_RESTRICT const url) DDNS_NOEXCEPT {
+	// The handle could have been used for a PATCH request before
+	curl_easy_setopt(*curl, CURLOPT_CUSTOMREQUEST, nullptr);
 	curl_easy_setopt(*curl, CURLOPT_HTTPGET, 1L);
 	curl_easy_setopt(*curl, CURLOPT_URL, url);
 }
 
+static void curl_post_setup(CURL** DDNS_RESTRICT curl, const char* DDNS_RESTRICT const url, const char* DDNS_RESTRICT const body) DDNS_NOEXCEPT {
+	// The handle could have been used for a PATCH request before
+	curl_easy_setopt(*curl, CURLOPT_CUSTOMREQUEST, nullptr);
+	curl_easy_setopt(*curl, CURLOPT_URL, url);
+	curl_easy_setopt(*curl, CURLOPT_POSTFIELDS, body);
+}
+
 static void curl_patch_setup(CURL** DDNS_RESTRICT curl, const char* DDNS_RESTRICT const url, const char* DDNS_RESTRICT const body) DDNS_NOEXCEPT {
 	curl_easy_setopt(*curl, CURLOPT_CUSTOMREQUEST, "PATCH");
 	curl_easy_setopt(*curl, CURLOPT_URL, url);
 	curl_easy_setopt(*curl, CURLOPT_POSTFIELDS, body);
 }
 
-} // namespace priv
-
-DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_local_ip(
-	const bool ipv6,
-	const size_t ip_size, char* DDNS_RESTRICT ip
+/*
+ * Writes the URL used to get the records named record_name in
+ * request_url, which must have room for request::get_record_url::size
+ * chars
+ */
+DDNS_NODISCARD static ddns_error make_get_record_url(
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	char* DDNS_RESTRICT request_url
 ) DDNS_NOEXCEPT {
-	// Creating the handle and the response buffer
-	CURL* curl {curl_easy_init()};
-	priv::static_buffer response;
+	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH) {
+		return DDNS_ERROR_USAGE;
+	}
 
-	priv::curl_handle_setup(&curl, response);
-	curl_slist* free_me {priv::curl_doh_setup(&curl)};
-	priv::curl_get_setup(&curl, "https://one.one.one.one/cdn-cgi/trace");
+	return request::get_record_url::make(request_url, zones_url, zone_id, record_name);
+}
 
-	if (ipv6) {
-		curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V6);
+/*
+ * Writes the URL used to search the zone named zone_name in request_url,
+ * which must have room for request::zone_url::size chars
+ */
+DDNS_NODISCARD static ddns_error make_zone_url(
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_name,
+	char* DDNS_RESTRICT request_url
+) DDNS_NOEXCEPT {
+	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH) {
+		return DDNS_ERROR_USAGE;
 	}
-	else {
-		curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+
+	return request::zone_url::make(request_url, zones_url, zone_name);
+}
+
+/*
+ * Writes the URL used to get a page of all the A and AAAA records of a
+ * zone in request_url, which must have room for
+ * request::list_records_url::size chars
+ */
+DDNS_NODISCARD static ddns_error make_list_records_url(
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t page,
+	char* DDNS_RESTRICT request_url
+) DDNS_NOEXCEPT {
+	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH || page == 0) {
+		return DDNS_ERROR_USAGE;
 	}
 
-	// Performing the request
-	const int curl_error = curl_easy_perform(curl);
+	return request::list_records_url::make(request_url, zones_url, zone_id, std::size_t{DDNS_RECORDS_PER_PAGE}, page);
+}
 
-	// Cleaning up the headers
-	curl_slist_free_all(free_me);
+/*
+ * Writes the URL and the body of the PATCH request used to update a
+ * record in request_url and request_body, which must have room for
+ * request::update_record_url::size and request::update_record_body::size
+ * chars respectively
+ */
+DDNS_NODISCARD static ddns_error make_update_record_request(
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_id,
+	const char* DDNS_RESTRICT new_ip,
+	char* DDNS_RESTRICT request_url,
+	char* DDNS_RESTRICT request_body
+) DDNS_NOEXCEPT {
+	const std::string_view new_ip_sv {new_ip};
 
-	// Cleaning up the handle as I won't reuse it
-	curl_easy_cleanup(curl);
+	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH || !request::update_record_body::valid(new_ip_sv)) {
+		return DDNS_ERROR_USAGE;
+	}
 
-	if (curl_error) {
-		// I can return as I've cleaned up everything
-		return DDNS_ERROR_GENERIC;
+	const ddns_error error {request::update_record_url::make(request_url, zones_url, zone_id, record_id)};
+	if (error) {
+		return error;
 	}
 
-	const std::string_view response_sv {response.buffer, response.size};
-	// Parsing the response
-	const std::size_t ip_begin {response_sv.find("ip=") + 3U};  // + 3 because "ip=" is 3 chars
-	const std::size_t ip_end {response_sv.find('\n', ip_begin)};
-	const std::size_t ip_length {ip_end - ip_begin};
+	return request::update_record_body::make(request_body, new_ip_sv);
+}
 
-	if (ip_length >= ip_size) {
+/*
+ * Returns the length of the content of a record that can be sent in a
+ * batch request, or 0 if the record is not valid. The arrays of a
+ * ddns_record might not be NUL-terminated.
+ */
+DDNS_NODISCARD static std::size_t batch_record_content_length(const ddns_record& record) DDNS_NOEXCEPT {
+	const void* const id_end {std::memchr(record.id, '\0', sizeof record.id)};
+	const void* const content_end {std::memchr(record.content, '\0', sizeof record.content)};
+	if (id_end != record.id + DDNS_RECORD_ID_LENGTH || content_end == nullptr) {
+		return 0;
+	}
+	return static_cast<std::size_t>(static_cast<const char*>(content_end) - record.content);
+}
+
+/*
+ * Writes the URL and the body of the POST request used to set the content
+ * of every record to the IP address it holds in request_url and
+ * request_body, which must have room for request::batch_update_url::size
+ * and request::batch_update_body_size chars respectively
+ */
+DDNS_NODISCARD static ddns_error make_batch_update_request(
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t records_size, const ddns_record* DDNS_RESTRICT records,
+	char* DDNS_RESTRICT request_url,
+	char* DDNS_RESTRICT request_body
+) DDNS_NOEXCEPT {
+	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH || records_size == 0 || records_size > DDNS_BATCH_MAX_RECORDS) {
 		return DDNS_ERROR_USAGE;
 	}
 
-	// Copying the ip in the caller's buffer
-	// Using memcpy because I don't need to copy the whole response
-	std::memcpy(ip, response.buffer + ip_begin, ip_length);
-	ip[ip_length] = '\0';
+	const ddns_error error {request::batch_update_url::make(request_url, zones_url, zone_id)};
+	if (error) {
+		return error;
+	}
+
+	// Append the patches one after the other
+	char* end {request::copy(request_body, request::batch_body_start)};
+	for (std::size_t i = 0; i < records_size; ++i) {
+		const ddns_record& record {records[i]};
+
+		const std::size_t content_length {batch_record_content_length(record)};
+		if (content_length == 0) {
+			return DDNS_ERROR_USAGE;
+		}
+
+		if (i != 0) {
+			end = request::copy(end, request::batch_patch_separator);
+		}
+		end = request::batch_patch::write(end, std::string_view{record.id, DDNS_RECORD_ID_LENGTH}, std::string_view{record.content, content_length});
+	}
+	end = request::copy(end, request::batch_body_end);
+	*end = '\0';
 
 	return DDNS_ERROR_OK;
 }
 
-DDNS_NODISCARD DDNS_PUB ddns_error ddns_search_zone_id(
+/*
+ * The _raw functions below send the requests to the API server at
+ * zones_url, and are used both by the public _raw functions, which talk
+ * to Cloudflare, and by the ddns_client ones.
+ */
+
+DDNS_NODISCARD static ddns_error get_zone_id_raw(
+	CURL** DDNS_RESTRICT curl,
+	const std::string_view zones_url,
 	const char* const DDNS_RESTRICT api_token,
-	const char* const DDNS_RESTRICT record_name,
-	const size_t zone_id_size, char* DDNS_RESTRICT zone_id
+	const char* const DDNS_RESTRICT zone_name
 ) DDNS_NOEXCEPT {
-	// <= because I also have to write '\0'
-	if (zone_id_size <= DDNS_ZONE_ID_LENGTH) {
-		return DDNS_ERROR_USAGE;
+	char request_url[request::zone_url::size];
+
+	const ddns_error error {make_zone_url(zones_url, api_token, zone_name, request_url)};
+	if (error) {
+		return error;
 	}
 
-	std::string_view record_name_sv = record_name;
+	curl_slist* free_me_doh = curl_doh_setup(curl, request_url, true);
+	curl_slist* free_me_headers = curl_auth_setup(curl, api_token);
+
+	curl_get_setup(curl, request_url);
+
+	const int curl_error = perform(*curl, api_token);
 
-	CURL* curl = curl_easy_init();
-	priv::static_buffer response;
+	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_slist_free_all(free_me_headers);
+
+	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
+	curl_slist_free_all(free_me_doh);
+
+	if (curl_error) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD static ddns_error get_record_raw(
+	CURL** DDNS_RESTRICT curl,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name
+) DDNS_NOEXCEPT {
+	char request_url[request::get_record_url::size];
+
+	const ddns_error error {make_get_record_url(zones_url, api_token, zone_id, record_name, request_url)};
+	if (error) {
+		return error;
+	}
+
+	curl_slist* free_me_doh {curl_doh_setup(curl, request_url, true)};
+	curl_slist* free_me_headers {curl_auth_setup(curl, api_token)};
+
+	curl_get_setup(curl, request_url);
+
+	const int curl_error = perform(*curl, api_token);
+
+	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_slist_free_all(free_me_headers);
+
+	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
+	curl_slist_free_all(free_me_doh);
+
+	if (curl_error) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD static ddns_error list_records_raw(
+	CURL** DDNS_RESTRICT curl,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t page
+) DDNS_NOEXCEPT {
+	char request_url[request::list_records_url::size];
+
+	const ddns_error error {make_list_records_url(zones_url, api_token, zone_id, page, request_url)};
+	if (error) {
+		return error;
+	}
+
+	curl_slist* free_me_doh {curl_doh_setup(curl, request_url, true)};
+	curl_slist* free_me_headers {curl_auth_setup(curl, api_token)};
+
+	curl_get_setup(curl, request_url);
+
+	const int curl_error = perform(*curl, api_token);
+
+	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_slist_free_all(free_me_headers);
+
+	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
+	curl_slist_free_all(free_me_doh);
+
+	if (curl_error) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD static ddns_error update_record_raw(
+	CURL** DDNS_RESTRICT curl,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_id,
+	const char* DDNS_RESTRICT new_ip
+) DDNS_NOEXCEPT {
+	char request_url[request::update_record_url::size];
+	// This request buffer needs to be valid when calling perform()
+	char request_body[request::update_record_body::size];
+
+	const ddns_error error {make_update_record_request(zones_url, api_token, zone_id, record_id, new_ip, request_url, request_body)};
+	if (error) {
+		return error;
+	}
+
+	curl_slist* free_me_doh {curl_doh_setup(curl, request_url, true)};
+	curl_slist* free_me_headers {curl_auth_setup(curl, api_token)};
+
+	curl_patch_setup(
+		curl,
+		request_url,
+		request_body
+	);
+
+	const int curl_error {perform(*curl, api_token)};
+
+	// request_body is about to go out of scope
+	curl_easy_setopt(*curl, CURLOPT_POSTFIELDS, nullptr);
+
+	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_slist_free_all(free_me_headers);
+
+	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
+	curl_slist_free_all(free_me_doh);
+
+	if (curl_error) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD static ddns_error update_records_batch_raw(
+	CURL** DDNS_RESTRICT curl,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t records_size, const ddns_record* DDNS_RESTRICT records
+) DDNS_NOEXCEPT {
+	char request_url[request::batch_update_url::size];
+	// This request buffer needs to be valid when calling perform()
+	char request_body[request::batch_update_body_size];
+
+	const ddns_error error {make_batch_update_request(zones_url, api_token, zone_id, records_size, records, request_url, request_body)};
+	if (error) {
+		return error;
+	}
+
+	curl_slist* free_me_doh {curl_doh_setup(curl, request_url, true)};
+	curl_slist* free_me_headers {curl_auth_setup(curl, api_token)};
+
+	curl_post_setup(curl, request_url, request_body);
+
+	const int curl_error {perform(*curl, api_token)};
+
+	// request_body is about to go out of scope
+	curl_easy_setopt(*curl, CURLOPT_POSTFIELDS, nullptr);
+
+	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_slist_free_all(free_me_headers);
+
+	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
+	curl_slist_free_all(free_me_doh);
+
+	if (curl_error) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+/*
+ * The functions below contain the actual logic of the public functions,
+ * and work on a curl handle already set up to write in response. This
+ * way they can be used both by the self contained functions, which
+ * create a new handle every time, and by the ddns_client ones.
+ */
+
+static constexpr const char* default_trace_url {"https://one.one.one.one/cdn-cgi/trace"};
+
+/*
+ * Writes the address found in a response of a trace URL in ip
+ */
+DDNS_NODISCARD static ddns_error parse_trace(
+	const std::string_view response,
+	const size_t ip_size, char* DDNS_RESTRICT ip
+) DDNS_NOEXCEPT {
+	const std::size_t ip_key {response.find("ip=")};
+	if (ip_key == std::string_view::npos) {
+		return DDNS_ERROR_GENERIC;
+	}
+	const std::size_t ip_begin {ip_key + 3U};  // + 3 because "ip=" is 3 chars
+	const std::size_t ip_end {response.find('\n', ip_begin)};
+	const std::size_t ip_length {ip_end - ip_begin};
+
+	if (ip_length >= ip_size) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	// Copying the ip in the caller's buffer
+	// Using memcpy because I don't need to copy the whole response
+	std::memcpy(ip, response.data() + ip_begin, ip_length);
+	ip[ip_length] = '\0';
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD static ddns_error get_local_ip(
+	CURL** DDNS_RESTRICT curl,
+	response_sink& response,
+	const char* DDNS_RESTRICT trace_url,
+	const bool ipv6,
+	const size_t ip_size, char* DDNS_RESTRICT ip
+) DDNS_NOEXCEPT {
+	curl_slist* free_me {curl_doh_setup(curl, trace_url, true)};
+	curl_get_setup(curl, trace_url);
+
+	if (ipv6) {
+		curl_easy_setopt(*curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V6);
+	}
+	else {
+		curl_easy_setopt(*curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+	}
+
+	// Performing the request
+	const int curl_error = perform(*curl, nullptr);
+
+	// The handle might get reused for API requests
+	curl_easy_setopt(*curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_WHATEVER);
+
+	// Cleaning up the headers
+	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
+	curl_slist_free_all(free_me);
+
+	if (curl_error) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	return parse_trace(response.view(), ip_size, ip);
+}
+
+/*
+ * Feeds the responses written in response to parser for as long as it
+ * lives, starting from an empty response
+ */
+class response_parsing {
+public:
+	response_parsing(response_sink& response, json::response_parser& parser) DDNS_NOEXCEPT
+		: response_ {response} {
+		response_.clear();
+		response_.parser = &parser;
+	}
+
+	~response_parsing() {
+		response_.parser = nullptr;
+	}
+
+	response_parsing(const response_parsing&) = delete;
+	response_parsing& operator=(const response_parsing&) = delete;
+
+private:
+	response_sink& response_;
+};
+
+/*
+ * Where the A and AAAA records found in a response are written, up to
+ * records_size. records_count is set to the number of records found,
+ * which can be greater than records_size.
+ */
+struct records_sink {
+	std::size_t records_size;
+	ddns_record* records;
+	std::size_t* records_count;
+	ddns_error error;
+};
+
+static void collect_record(void* const user, const json::record& record) DDNS_NOEXCEPT {
+	records_sink& sink {*static_cast<records_sink*>(user)};
+
+	if (!record.is_address()) {
+		return;
+	}
+
+	if (!record.has(json::record::id | json::record::content) || record.id_length != DDNS_RECORD_ID_LENGTH) {
+		sink.error = DDNS_ERROR_GENERIC;
+		return;
+	}
+
+	if (*sink.records_count < sink.records_size) {
+		ddns_record& destination {sink.records[*sink.records_count]};
+		std::memcpy(destination.id, record.id_value, record.id_length + 1U);
+		std::memcpy(destination.content, record.content_value, record.content_length + 1U);
+		destination.aaaa = (record.type_sv() == "AAAA");
+	}
+
+	++*sink.records_count;
+}
+
+/*
+ * Keeps the first object found in the result, like the single zone
+ * searched or the record just updated
+ */
+static void keep_first(void* const user, const json::record& record) DDNS_NOEXCEPT {
+	json::record& first {*static_cast<json::record*>(user)};
+	if (first.found == 0) {
+		first = record;
+	}
+}
+
+/*
+ * Outcome of a request whose response was parsed into sink
+ */
+DDNS_NODISCARD static ddns_error parsed_records(
+	const ddns_error request_error,
+	const json::response_parser& parser,
+	const records_sink& sink
+) DDNS_NOEXCEPT {
+	if (request_error) {
+		return request_error;
+	}
+	if (!parser.success()) {
+		return DDNS_ERROR_GENERIC;
+	}
+	return sink.error;
+}
+
+/*
+ * Gets the A and AAAA records named record_name
+ */
+DDNS_NODISCARD static ddns_error get_records(
+	CURL** DDNS_RESTRICT curl,
+	response_sink& response,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	const size_t records_size, ddns_record* DDNS_RESTRICT records,
+	size_t* DDNS_RESTRICT records_count
+) DDNS_NOEXCEPT {
+	*records_count = 0;
+	records_sink sink {records_size, records, records_count, DDNS_ERROR_OK};
+	json::response_parser parser {collect_record, &sink};
+
+	const response_parsing parsing {response, parser};
+	const ddns_error error {get_record_raw(curl, zones_url, api_token, zone_id, record_name)};
+
+	return parsed_records(error, parser, sink);
+}
+
+/*
+ * Gets the first A or AAAA record named record_name
+ */
+DDNS_NODISCARD static ddns_error get_record(
+	CURL** DDNS_RESTRICT curl,
+	response_sink& response,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	const size_t record_ip_size, char* DDNS_RESTRICT record_ip,
+	const size_t record_id_size, char* DDNS_RESTRICT record_id,
+	bool* DDNS_RESTRICT aaaa
+) DDNS_NOEXCEPT {
+	ddns_record record;
+	std::size_t records_count;
+
+	const ddns_error error {get_records(curl, response, zones_url, api_token, zone_id, record_name, 1U, &record, &records_count)};
+	if (error) {
+		return error;
+	}
+	if (records_count == 0) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	const std::size_t record_ip_length {std::strlen(record.content)};
+	if (record_ip_length >= record_ip_size || DDNS_RECORD_ID_LENGTH >= record_id_size) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	std::memcpy(record_ip, record.content, record_ip_length + 1U);
+	std::memcpy(record_id, record.id, DDNS_RECORD_ID_LENGTH + 1U);
+	*aaaa = record.aaaa;
+
+	return DDNS_ERROR_OK;
+}
+
+/*
+ * Copies the content of the updated record, which is the result of the
+ * request, to record_ip
+ */
+DDNS_NODISCARD static ddns_error updated_ip(
+	const ddns_error request_error,
+	const json::response_parser& parser,
+	const json::record& record,
+	const size_t record_ip_size, char* DDNS_RESTRICT record_ip
+) DDNS_NOEXCEPT {
+	if (request_error) {
+		return request_error;
+	}
+	if (!parser.success() || !record.has(json::record::content)) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	if (record.content_length >= record_ip_size) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	std::memcpy(record_ip, record.content_value, record.content_length + 1U);
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD static ddns_error update_record(
+	CURL** DDNS_RESTRICT curl,
+	response_sink& response,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_id,
+	const char* DDNS_RESTRICT new_ip,
+	const size_t record_ip_size, char* DDNS_RESTRICT record_ip
+) DDNS_NOEXCEPT {
+	json::record record;
+	record.clear();
+	json::response_parser parser {keep_first, &record};
+
+	const response_parsing parsing {response, parser};
+	const ddns_error error {update_record_raw(curl, zones_url, api_token, zone_id, record_id, new_ip)};
+
+	return updated_ip(error, parser, record, record_ip_size, record_ip);
+}
+
+/*
+ * Copies the content of the patched records to the records with the same
+ * ID. Batch requests are atomic, so every record must be there.
+ */
+DDNS_NODISCARD static ddns_error apply_patches(
+	const size_t patched_count, const ddns_record* DDNS_RESTRICT patched,
+	const size_t records_size, ddns_record* DDNS_RESTRICT records
+) DDNS_NOEXCEPT {
+	if (patched_count > DDNS_BATCH_MAX_RECORDS) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	for (std::size_t i = 0; i < records_size; ++i) {
+		const ddns_record* match {nullptr};
+		for (std::size_t j = 0; j < patched_count && match == nullptr; ++j) {
+			if (std::memcmp(patched[j].id, records[i].id, DDNS_RECORD_ID_LENGTH) == 0) {
+				match = &patched[j];
+			}
+		}
+		if (match == nullptr) {
+			return DDNS_ERROR_GENERIC;
+		}
+		std::memcpy(records[i].content, match->content, sizeof records[i].content);
+		records[i].aaaa = match->aaaa;
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+/*
+ * Updates the records DDNS_BATCH_MAX_RECORDS at a time, stopping at the
+ * first request that fails. The records are all checked beforehand, so
+ * that a usage error doesn't leave only some of them updated.
+ */
+DDNS_NODISCARD static ddns_error update_records_batch(
+	CURL** DDNS_RESTRICT curl,
+	response_sink& response,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t records_size, ddns_record* DDNS_RESTRICT records
+) DDNS_NOEXCEPT {
+	for (std::size_t i = 0; i < records_size; ++i) {
+		if (batch_record_content_length(records[i]) == 0) {
+			return DDNS_ERROR_USAGE;
+		}
+	}
+
+	for (std::size_t done = 0; done < records_size; done += DDNS_BATCH_MAX_RECORDS) {
+		const std::size_t chunk_size {
+			records_size - done < DDNS_BATCH_MAX_RECORDS ? records_size - done : DDNS_BATCH_MAX_RECORDS
+		};
+
+		// The patched records are in the patches array of the result
+		ddns_record patched[DDNS_BATCH_MAX_RECORDS];
+		std::size_t patched_count {0};
+		records_sink sink {DDNS_BATCH_MAX_RECORDS, patched, &patched_count, DDNS_ERROR_OK};
+		json::response_parser parser {collect_record, &sink};
+
+		ddns_error error;
+		{
+			const response_parsing parsing {response, parser};
+			error = parsed_records(update_records_batch_raw(curl, zones_url, api_token, zone_id, chunk_size, records + done), parser, sink);
+		}
+		if (error) {
+			return error;
+		}
+
+		error = apply_patches(patched_count, patched, chunk_size, records + done);
+		if (error) {
+			return error;
+		}
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+} // namespace priv
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_local_ip(
+	const bool ipv6,
+	const size_t ip_size, char* DDNS_RESTRICT ip
+) DDNS_NOEXCEPT {
+	// Creating the handle and the response buffer
+	CURL* curl {curl_easy_init()};
+	priv::response_sink response;
+
+	priv::curl_handle_setup(&curl, response);
+
+	const ddns_error error = priv::get_local_ip(&curl, response, priv::default_trace_url, ipv6, ip_size, ip);
+
+	// Cleaning up the handle as I won't reuse it
+	curl_easy_cleanup(curl);
+
+	return error;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_interface_ip(
+	[[maybe_unused]] const bool ipv6,
+	[[maybe_unused]] const size_t ip_size, [[maybe_unused]] char* DDNS_RESTRICT ip
+) DDNS_NOEXCEPT {
+#ifdef __linux__
+	return priv::netlink::get_public_address(ipv6 ? AF_INET6 : AF_INET, ip_size, ip);
+#else
+	return DDNS_ERROR_GENERIC;
+#endif
+}
+
+struct ddns_address_watch {
+	int fd;
+	int wake_fd;
+};
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_address_watch_create(ddns_address_watch** const DDNS_RESTRICT watch) DDNS_NOEXCEPT {
+#ifdef __linux__
+	const int fd {priv::netlink::open_socket(RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR)};
+	if (fd == -1) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	ddns_address_watch* const new_watch {new (std::nothrow) ddns_address_watch{fd, -1}};
+	if (new_watch == nullptr) {
+		close(fd);
+		return DDNS_ERROR_GENERIC;
+	}
+
+	*watch = new_watch;
+
+	return DDNS_ERROR_OK;
+#else
+	*watch = nullptr;
+	return DDNS_ERROR_GENERIC;
+#endif
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_address_watch_wait(
+	[[maybe_unused]] ddns_address_watch* const DDNS_RESTRICT watch,
+	[[maybe_unused]] const int timeout_ms, [[maybe_unused]] const int debounce_ms,
+	bool* const DDNS_RESTRICT changed
+) DDNS_NOEXCEPT {
+#ifdef __linux__
+	return priv::netlink::wait_for_change(watch->fd, watch->wake_fd, timeout_ms, debounce_ms, *changed);
+#else
+	*changed = false;
+	return DDNS_ERROR_GENERIC;
+#endif
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_address_watch_set_wake_fd(ddns_address_watch* const DDNS_RESTRICT watch, const int fd) DDNS_NOEXCEPT {
+	if (watch == nullptr) {
+		return DDNS_ERROR_USAGE;
+	}
+	watch->wake_fd = fd < 0 ? -1 : fd;
+	return DDNS_ERROR_OK;
+}
+
+DDNS_PUB void ddns_address_watch_destroy(ddns_address_watch* const watch) DDNS_NOEXCEPT {
+	if (watch == nullptr) {
+		return;
+	}
+#ifdef __linux__
+	close(watch->fd);
+#endif
+	delete watch;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_search_zone_id(
+	const char* const DDNS_RESTRICT api_token,
+	const char* const DDNS_RESTRICT record_name,
+	const size_t zone_id_size, char* DDNS_RESTRICT zone_id
+) DDNS_NOEXCEPT {
+	// A temporary client, to search all the suffixes at once. Its setup
+	// costs more than a single request, which is why the documentation
+	// points to ddns_client_search_zone_id()
+	ddns_client* client;
+	if (ddns_client_create(&client) != DDNS_ERROR_OK) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	const ddns_error error = ddns_client_search_zone_id(client, api_token, record_name, zone_id_size, zone_id);
+
+	ddns_client_destroy(client);
+
+	return error;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_zone_id_raw(
+	const char* const DDNS_RESTRICT api_token,
+	const char* const DDNS_RESTRICT zone_name,
+	void**            DDNS_RESTRICT curl
+) DDNS_NOEXCEPT {
+	return priv::get_zone_id_raw(curl, default_zones_url, api_token, zone_name);
+}
+
+DDNS_NODISCARD ddns_error ddns_get_record(
+	const char* const DDNS_RESTRICT api_token,
+	const char* const DDNS_RESTRICT zone_id,
+	const char* const DDNS_RESTRICT record_name,
+	const size_t record_ip_size, char* DDNS_RESTRICT record_ip,
+	const size_t record_id_size, char* DDNS_RESTRICT record_id,
+	bool* aaaa
+) DDNS_NOEXCEPT {
+	CURL* curl {curl_easy_init()};
+	priv::response_sink response;
+
+	priv::curl_handle_setup(&curl, response);
+
+	const ddns_error error = priv::get_record(
+		&curl, response, default_zones_url,
+		api_token, zone_id, record_name,
+		record_ip_size, record_ip,
+		record_id_size, record_id,
+		aaaa
+	);
+
+	curl_easy_cleanup(curl);
+
+	return error;
+}
+
+DDNS_NODISCARD ddns_error ddns_get_record_raw(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	void**      DDNS_RESTRICT curl
+) DDNS_NOEXCEPT {
+	return priv::get_record_raw(curl, default_zones_url, api_token, zone_id, record_name);
+}
+
+DDNS_NODISCARD ddns_error ddns_update_record(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_id,
+	const char* DDNS_RESTRICT new_ip,
+	const size_t record_ip_size, char* DDNS_RESTRICT record_ip
+) DDNS_NOEXCEPT {
+	CURL* curl {curl_easy_init()};
+	priv::response_sink response;
+
+	priv::curl_handle_setup(&curl, response);
+
+	const ddns_error error = priv::update_record(&curl, response, default_zones_url, api_token, zone_id, record_id, new_ip, record_ip_size, record_ip);
+
+	curl_easy_cleanup(curl);
+
+	return error;
+}
+
+DDNS_NODISCARD ddns_error ddns_update_record_raw(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_id,
+	const char* DDNS_RESTRICT new_ip,
+	void**      DDNS_RESTRICT curl
+) DDNS_NOEXCEPT {
+	return priv::update_record_raw(curl, default_zones_url, api_token, zone_id, record_id, new_ip);
+}
+
+DDNS_NODISCARD ddns_error ddns_list_records_raw(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t page,
+	void**      DDNS_RESTRICT curl
+) DDNS_NOEXCEPT {
+	return priv::list_records_raw(curl, default_zones_url, api_token, zone_id, page);
+}
+
+DDNS_NODISCARD ddns_error ddns_update_records_batch(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t records_size, ddns_record* DDNS_RESTRICT records
+) DDNS_NOEXCEPT {
+	CURL* curl {curl_easy_init()};
+	priv::response_sink response;
+
+	priv::curl_handle_setup(&curl, response);
+
+	const ddns_error error = priv::update_records_batch(&curl, response, default_zones_url, api_token, zone_id, records_size, records);
+
+	curl_easy_cleanup(curl);
+
+	return error;
+}
+
+DDNS_NODISCARD ddns_error ddns_update_records_batch_raw(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t records_size, const ddns_record* DDNS_RESTRICT records,
+	void**      DDNS_RESTRICT curl
+) DDNS_NOEXCEPT {
+	return priv::update_records_batch_raw(curl, default_zones_url, api_token, zone_id, records_size, records);
+}
+
+namespace priv {
+
+/*
+ * A record of a ddns_zone_index, whose name is stored in the names buffer
+ * of the index
+ */
+struct index_entry {
+	std::size_t name_offset;
+	std::size_t name_length;
+	ddns_record record;
+};
+
+struct batch;
+
+/*
+ * A request run concurrently with others by an engine. Its buffers must
+ * outlive the request, so they're part of the transfer.
+ */
+struct transfer {
+	static constexpr std::size_t url_size {
+		request::get_record_url::size > request::update_record_url::size ? request::get_record_url::size : request::update_record_url::size
+	};
+	static_assert(request::zone_url::size <= url_size);
+	static_assert(DDNS_TRACE_URL_MAX_LENGTH < url_size);
+	static constexpr std::size_t body_size {request::update_record_body::size};
+	static constexpr std::size_t idle {static_cast<std::size_t>(-1)};
+
+	CURL* curl {nullptr};
+	curl_slist* headers {nullptr};
+	curl_slist* doh {nullptr};
+	// The batch of the entry the transfer is working on, and its index, or
+	// idle
+	batch* owner {nullptr};
+	std::size_t index {idle};
+	// Set by prepare() to override the timeout of the client, if not 0
+	long timeout_ms {0};
+	// Set by prepare() for the requests made to the API, to pace them
+	const char* api_token {nullptr};
+	// How many times the request was sent, and when it's going to be sent
+	// again, in steady_ms(), or 0 if it's not waiting to be retried
+	unsigned attempt {0};
+	std::int64_t retry_at {0};
+	// Filled only if the client has a stats callback, from started_us, in
+	// steady_us()
+	ddns_stats stats {};
+	std::int64_t started_us {0};
+	response_sink response;
+	// The response is parsed into sink as it's received
+	json::response_parser parser;
+	records_sink sink;
+	// Written by requests returning a single record
+	json::record record;
+	char url[url_size];
+	char body[body_size];
+};
+
+/*
+ * Maximum number of requests in flight at the same time. With HTTP/2
+ * they're all multiplexed on a single connection.
+ */
+constexpr std::size_t max_transfers {32U};
+
+/*
+ * Callbacks used by an engine to deal with the entries of the caller,
+ * which are passed around as a void pointer.
+ */
+struct transfer_callbacks {
+	/*
+	 * Sets up the transfer for the entry at index, returning an error if
+	 * the entry is invalid
+	 */
+	ddns_error (*prepare)(const ddns_client& client, void* entries, std::size_t index, transfer& transfer);
+	/*
+	 * Called once the request of the entry at index is done, or as soon as
+	 * prepare() fails, with the outcome of the request
+	 */
+	void (*finish)(void* entries, std::size_t index, const transfer& transfer, ddns_error error);
+};
+
+/*
+ * Entries whose requests are run by an engine, in order, sharing its
+ * transfers with the other batches queued
+ */
+struct batch {
+	transfer_callbacks callbacks {};
+	void* entries {nullptr};
+	std::size_t entries_size {0};
+	// The first entry not started yet, and the requests in flight
+	std::size_t next_entry {0};
+	std::size_t in_flight {0};
+	// Called by the owner of the engine once the batch is finished, or
+	// nullptr if the owner waits for it instead
+	void (*complete)(batch& batch) {nullptr};
+	// In the queue or in the completed list of the engine
+	batch* next {nullptr};
+
+	DDNS_NODISCARD bool finished() const DDNS_NOEXCEPT {
+		return next_entry == entries_size && in_flight == 0;
+	}
+};
+
+/*
+ * Runs the requests of batches on a pool of transfers, added to a multi
+ * handle driven by the owner of the engine
+ */
+struct engine {
+	CURLM* multi {nullptr};
+	transfer* transfers {nullptr};
+	// Whether the owner blocks while the requests run, so that the
+	// addresses of the servers can be looked up before sending them
+	bool blocking {true};
+	// Batches with entries not started yet
+	batch* queue {nullptr};
+	batch* queue_tail {nullptr};
+	// Finished batches waiting for their complete() call
+	batch* completed {nullptr};
+	batch* completed_tail {nullptr};
+};
+
+/*
+ * The answer to the search of a zone name, remembered for a while so that
+ * the suffixes shared by the names of several records, like the zone they
+ * all belong to, are only asked once
+ */
+struct zone_answer {
+	// ratelimit::key() of the API token the name was searched with
+	std::uint64_t api_token {0};
+	char name[request::zone_name_max_length + 1U];
+	// Empty if the name isn't a zone
+	char zone_id[DDNS_ZONE_ID_LENGTH + 1U];
+	std::int64_t expires_at {0};
+};
+
+constexpr std::size_t max_zone_answers {16U};
+// Zones are rarely added, and their IDs never change
+constexpr std::int64_t zone_answer_ttl {300};
+
+/*
+ * Makes share hold DNS cache, TLS sessions and, when supported, the
+ * connections of the handles attached to it
+ */
+static void share_setup(CURLSH* const share) DDNS_NOEXCEPT {
+	curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+	curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+
+/*
+ * Options shared by all the handles owned by a client
+ */
+static void client_handle_setup(
+	CURL** DDNS_RESTRICT curl,
+	const response_sink& response_buffer,
+	CURLSH* DDNS_RESTRICT share
+) DDNS_NOEXCEPT {
+	curl_handle_setup(curl, response_buffer);
+	curl_easy_setopt(*curl, CURLOPT_SHARE, share);
+
+	// A client is meant to be long lived, so keep idle connections and
+	// resolved addresses around for longer than libcurl's defaults (118
+	// and 60 seconds). libcurl still makes sure that a connection is
+	// alive before reusing it.
+	curl_easy_setopt(*curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(*curl, CURLOPT_MAXAGE_CONN, 3600L);
+	curl_easy_setopt(*curl, CURLOPT_DNS_CACHE_TIMEOUT, 600L);
+}
+
+} // namespace priv
+
+struct ddns_share {
+	CURLSH* curl;
+};
+
+struct ddns_client {
+	// Used unless the client is attached to a ddns_share
+	CURLSH* share;
+	// The one the handles are attached to, either share or the one of a
+	// ddns_share
+	CURLSH* active_share;
+	CURL* curl;
+	// Set up the first time concurrent requests are made
+	priv::engine engine;
+	// Created by ddns_async_create(), using the options of the client
+	ddns_async* asyncs;
+	// Either default_zones_url or zones_url_buffer
+	std::string_view zones_url;
+	char zones_url_buffer[priv::request::zones_url_max_length + 1U];
+	// Either default_trace_url or trace_url_buffer
+	const char* trace_url;
+	char trace_url_buffer[DDNS_TRACE_URL_MAX_LENGTH + 1U];
+	priv::response_sink response;
+	priv::client_context context;
+	// The latest ones, replaced in a circle
+	priv::zone_answer zone_answers[priv::max_zone_answers];
+	std::size_t next_zone_answer;
+};
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_create(ddns_client** DDNS_RESTRICT client) DDNS_NOEXCEPT {
+	ddns_client* const new_client {new (std::nothrow) ddns_client};
+	if (new_client == nullptr) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	new_client->share = curl_share_init();
+	new_client->active_share = new_client->share;
+	new_client->curl = curl_easy_init();
+	new_client->asyncs = nullptr;
+	new_client->zones_url = default_zones_url;
+	new_client->trace_url = priv::default_trace_url;
+	new_client->next_zone_answer = 0;
+	if (new_client->share == nullptr || new_client->curl == nullptr) {
+		ddns_client_destroy(new_client);
+		return DDNS_ERROR_GENERIC;
+	}
+
+	priv::share_setup(new_client->share);
+	priv::client_handle_setup(&new_client->curl, new_client->response, new_client->share);
+	new_client->context.resolver.share = new_client->share;
+	// Copied to the transfers as well
+	curl_easy_setopt(new_client->curl, CURLOPT_PRIVATE, &new_client->context);
+	// Any non-zero seed will do, as long as clients started together
+	// don't get the same one
+	const auto seed {static_cast<std::uint32_t>(priv::steady_ms()) ^ static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(new_client))};
+	new_client->context.random = seed != 0 ? seed : 1U;
+
+	*client = new_client;
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_PUB void ddns_client_destroy(ddns_client* const client) DDNS_NOEXCEPT {
+	if (client == nullptr) {
+		return;
+	}
+	// Handles must be cleaned up before the share they're attached to. The
+	// requests of the client are never left in flight.
+	if (client->engine.transfers != nullptr) {
+		for (std::size_t i = 0; i < priv::max_transfers; ++i) {
+			curl_easy_cleanup(client->engine.transfers[i].curl);
+		}
+		delete[] client->engine.transfers;
+	}
+	curl_multi_cleanup(client->engine.multi);
+	curl_easy_cleanup(client->curl);
+	curl_easy_cleanup(client->context.resolver.curl);
+	client->context.resolver.curl = nullptr;
+	curl_share_cleanup(client->share);
+	delete client;
+}
+
+namespace priv {
+
+/*
+ * Creates the transfers of engine and its multi handle, unless they're
+ * there already
+ */
+DDNS_NODISCARD static bool engine_setup(ddns_client* DDNS_RESTRICT client, engine& engine) DDNS_NOEXCEPT {
+	if (engine.multi != nullptr) {
+		return true;
+	}
+
+	engine.transfers = new (std::nothrow) transfer[max_transfers];
+	if (engine.transfers == nullptr) {
+		return false;
+	}
+
+	bool ok {true};
+	for (std::size_t i = 0; i < max_transfers; ++i) {
+		transfer& transfer {engine.transfers[i]};
+		// Start from a copy of the main handle, so that the transfers
+		// inherit the options set on the client, like the CA bundle
+		transfer.curl = curl_easy_duphandle(client->curl);
+		if (transfer.curl == nullptr) {
+			ok = false;
+			continue;
+		}
+		curl_easy_setopt(transfer.curl, CURLOPT_WRITEDATA, &transfer.response);
+		curl_easy_setopt(transfer.curl, CURLOPT_HEADERDATA, &transfer.response);
+		// Copies don't keep the share, see curl_easy_duphandle(3)
+		curl_easy_setopt(transfer.curl, CURLOPT_SHARE, client->active_share);
+		transfer.response.parser = &transfer.parser;
+		// Wait for the first connection to be established and then
+		// multiplex all the requests on it, instead of opening a new
+		// connection for every request
+		curl_easy_setopt(transfer.curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+		curl_easy_setopt(transfer.curl, CURLOPT_PIPEWAIT, 1L);
+	}
+
+	engine.multi = ok ? curl_multi_init() : nullptr;
+	if (engine.multi == nullptr) {
+		for (std::size_t i = 0; i < max_transfers; ++i) {
+			curl_easy_cleanup(engine.transfers[i].curl);
+		}
+		delete[] engine.transfers;
+		engine.transfers = nullptr;
+		return false;
+	}
+
+	curl_multi_setopt(engine.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+	return true;
+}
+
+static void transfer_cleanup(transfer& transfer) DDNS_NOEXCEPT {
+	if (transfer.stats.attempts != 0) {
+		char* private_data {nullptr};
+		curl_easy_getinfo(transfer.curl, CURLINFO_PRIVATE, &private_data);
+		report_stats(*reinterpret_cast<client_context*>(private_data), transfer.stats, endpoint_of(transfer.url, transfer.api_token != nullptr), transfer.started_us);
+		transfer.stats = {};
+	}
+
+	curl_easy_setopt(transfer.curl, CURLOPT_POSTFIELDS, nullptr);
+	// Set by the requests of the local addresses
+	curl_easy_setopt(transfer.curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_WHATEVER);
+	transfer.timeout_ms = 0;
+	transfer.api_token = nullptr;
+	transfer.attempt = 0;
+	transfer.retry_at = 0;
+
+	curl_easy_setopt(transfer.curl, CURLOPT_HTTPHEADER, nullptr);
+	curl_slist_free_all(transfer.headers);
+	transfer.headers = nullptr;
+
+	curl_easy_setopt(transfer.curl, CURLOPT_RESOLVE, nullptr);
+	curl_slist_free_all(transfer.doh);
+	transfer.doh = nullptr;
+
+	transfer.owner = nullptr;
+	transfer.index = transfer::idle;
+}
+
+/*
+ * Stops the requests in flight, abandoning their entries, and frees the
+ * transfers and the multi handle of engine
+ */
+static void engine_cleanup(engine& engine) DDNS_NOEXCEPT {
+	if (engine.transfers != nullptr) {
+		for (std::size_t i = 0; i < max_transfers; ++i) {
+			transfer& transfer {engine.transfers[i]};
+			if (transfer.index != transfer::idle) {
+				curl_multi_remove_handle(engine.multi, transfer.curl);
+				transfer_cleanup(transfer);
+			}
+			curl_easy_cleanup(transfer.curl);
+		}
+		delete[] engine.transfers;
+		engine.transfers = nullptr;
+	}
+	curl_multi_cleanup(engine.multi);
+	engine.multi = nullptr;
+}
+
+/*
+ * Adds the request of transfer to multi, or makes it wait for the rate
+ * limit of its API token by setting retry_at. Returns false if the
+ * deadline of the client doesn't leave time for it.
+ */
+DDNS_NODISCARD static bool transfer_send(client_context& context, CURLM* const multi, transfer& transfer) DDNS_NOEXCEPT {
+	const std::int64_t now {steady_ms()};
+	const long timeout_ms {retry::request_timeout_ms(
+		transfer.timeout_ms != 0 ? transfer.timeout_ms : context.timeout_ms,
+		context.deadline_ms,
+		now
+	)};
+	if (timeout_ms < 0) {
+		return false;
+	}
+
+	const long wait_ms {transfer.api_token != nullptr ? context.limiter.acquire(transfer.api_token, now) : 0};
+	if (wait_ms != 0) {
+		if (context.deadline_ms != 0 && now + wait_ms >= context.deadline_ms) {
+			return false;
+		}
+		transfer.retry_at = now + wait_ms;
+		return true;
+	}
+
+	curl_easy_setopt(transfer.curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+	return curl_multi_add_handle(multi, transfer.curl) == CURLM_OK;
+}
+
+/*
+ * Moves batch to the completed list of engine once it's finished, unless
+ * its owner waits for it instead
+ */
+static void batch_check(engine& engine, batch& batch) DDNS_NOEXCEPT {
+	if (!batch.finished() || batch.complete == nullptr) {
+		return;
+	}
+	batch.next = nullptr;
+	if (engine.completed_tail != nullptr) {
+		engine.completed_tail->next = &batch;
+	}
+	else {
+		engine.completed = &batch;
+	}
+	engine.completed_tail = &batch;
+}
+
+/*
+ * Starts the request of the next valid entry queued on an idle transfer,
+ * returning false if there are no entries left
+ */
+static bool transfer_start(ddns_client* DDNS_RESTRICT client, engine& engine, transfer& transfer) DDNS_NOEXCEPT {
+	while (engine.queue != nullptr) {
+		batch& owner {*engine.queue};
+		const std::size_t index {owner.next_entry++};
+		// Every entry of the batch is started, so it leaves the queue
+		if (owner.next_entry == owner.entries_size) {
+			engine.queue = owner.next;
+			if (engine.queue == nullptr) {
+				engine.queue_tail = nullptr;
+			}
+			owner.next = nullptr;
+		}
+
+		transfer.response.clear();
+
+		ddns_error error {owner.callbacks.prepare(*client, owner.entries, index, transfer)};
+		if (!error) {
+			// The URL is only known once the entry is prepared
+			transfer.doh = curl_doh_setup(&transfer.curl, transfer.url, engine.blocking);
+			transfer.started_us = steady_us();
+			if (!transfer_send(client->context, engine.multi, transfer)) {
+				error = DDNS_ERROR_GENERIC;
+			}
+		}
+		if (error) {
+			owner.callbacks.finish(owner.entries, index, transfer, error);
+			transfer_cleanup(transfer);
+			batch_check(engine, owner);
+			continue;
+		}
+
+		transfer.owner = &owner;
+		transfer.index = index;
+		++owner.in_flight;
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Starts the entries queued on the idle transfers
+ */
+static void engine_start(ddns_client* DDNS_RESTRICT client, engine& engine) DDNS_NOEXCEPT {
+	for (std::size_t i = 0; i < max_transfers; ++i) {
+		if (engine.transfers[i].index == transfer::idle && !transfer_start(client, engine, engine.transfers[i])) {
+			break;
+		}
+	}
+}
+
+/*
+ * Queues the entries of batch, starting as many as the idle transfers
+ * allow
+ */
+static void engine_enqueue(ddns_client* DDNS_RESTRICT client, engine& engine, batch& batch) DDNS_NOEXCEPT {
+	batch.next_entry = 0;
+	batch.in_flight = 0;
+	batch.next = nullptr;
+	if (batch.entries_size == 0) {
+		batch_check(engine, batch);
+		return;
+	}
+
+	if (engine.queue_tail != nullptr) {
+		engine.queue_tail->next = &batch;
+	}
+	else {
+		engine.queue = &batch;
+	}
+	engine.queue_tail = &batch;
+
+	engine_start(client, engine);
+}
+
+/*
+ * Passes the outcome of the request of transfer to its batch, leaving the
+ * transfer idle
+ */
+static void engine_finish(engine& engine, transfer& transfer, const ddns_error error) DDNS_NOEXCEPT {
+	batch& owner {*transfer.owner};
+	owner.callbacks.finish(owner.entries, transfer.index, transfer, error);
+	transfer_cleanup(transfer);
+	--owner.in_flight;
+	batch_check(engine, owner);
+}
+
+/*
+ * Deals with the requests curl is done with, either finishing them or
+ * scheduling them to be retried, and starts the next entries on the
+ * transfers left idle
+ */
+static void engine_collect(ddns_client* DDNS_RESTRICT client, engine& engine) DDNS_NOEXCEPT {
+	int messages_left {0};
+	while (const CURLMsg* message = curl_multi_info_read(engine.multi, &messages_left)) {
+		if (message->msg != CURLMSG_DONE) {
+			continue;
+		}
+
+		// Find the transfer owning the handle, there are just a few
+		transfer* done {engine.transfers};
+		while (done->curl != message->easy_handle) {
+			++done;
+		}
+
+		const CURLcode curl_error {message->data.result};
+		curl_multi_remove_handle(engine.multi, done->curl);
+		if (client->context.stats_callback != nullptr) {
+			count_attempt(done->stats, done->curl);
+		}
+
+		if (!curl_error && done->api_token != nullptr) {
+			observe_limits(client->context, done->curl, done->api_token);
+		}
+		const long delay_ms {curl_error ? -1 : retry_delay_ms(client->context, done->curl, done->attempt)};
+		if (delay_ms >= 0) {
+			// Still in flight, sent again by engine_resend() once the
+			// delay is over
+			++done->attempt;
+			done->retry_at = steady_ms() + delay_ms;
+			continue;
+		}
+
+		engine_finish(engine, *done, curl_error ? DDNS_ERROR_GENERIC : DDNS_ERROR_OK);
+		transfer_start(client, engine, *done);
+	}
+}
+
+/*
+ * Sends again the requests whose delay is over
+ */
+static void engine_resend(ddns_client* DDNS_RESTRICT client, engine& engine) DDNS_NOEXCEPT {
+	const std::int64_t now {steady_ms()};
+	for (std::size_t i = 0; i < max_transfers; ++i) {
+		transfer& waiting {engine.transfers[i]};
+		if (waiting.retry_at == 0 || waiting.retry_at > now) {
+			continue;
+		}
+		waiting.retry_at = 0;
+		waiting.response.clear();
+		// Either just added, or still waiting for the rate limit
+		if (transfer_send(client->context, engine.multi, waiting)) {
+			continue;
+		}
+		engine_finish(engine, waiting, DDNS_ERROR_GENERIC);
+		transfer_start(client, engine, waiting);
+	}
+}
+
+/*
+ * When the first request waiting to be sent again is due, in steady_ms(),
+ * or 0 if none is waiting
+ */
+DDNS_NODISCARD static std::int64_t engine_next_retry(const engine& engine) DDNS_NOEXCEPT {
+	std::int64_t next {0};
+	for (std::size_t i = 0; i < max_transfers; ++i) {
+		const std::int64_t retry_at {engine.transfers[i].retry_at};
+		if (retry_at != 0 && (next == 0 || retry_at < next)) {
+			next = retry_at;
+		}
+	}
+	return next;
+}
+
+/*
+ * Fails the requests in flight and the entries still queued
+ */
+static void engine_abort(engine& engine) DDNS_NOEXCEPT {
+	for (std::size_t i = 0; i < max_transfers; ++i) {
+		transfer& transfer {engine.transfers[i]};
+		if (transfer.index == transfer::idle) {
+			continue;
+		}
+		curl_multi_remove_handle(engine.multi, transfer.curl);
+		engine_finish(engine, transfer, DDNS_ERROR_GENERIC);
+	}
+	while (engine.queue != nullptr) {
+		batch& owner {*engine.queue};
+		engine.queue = owner.next;
+		while (owner.next_entry < owner.entries_size) {
+			owner.callbacks.finish(owner.entries, owner.next_entry++, engine.transfers[0], DDNS_ERROR_GENERIC);
+		}
+		batch_check(engine, owner);
+	}
+	engine.queue_tail = nullptr;
+}
+
+/*
+ * Runs the requests of all the entries concurrently, with up to
+ * max_transfers of them in flight at the same time. Returns
+ * DDNS_ERROR_GENERIC if the concurrent requests could not be set up,
+ * otherwise the outcome of each request is passed to callbacks.finish.
+ */
+DDNS_NODISCARD static ddns_error perform_transfers(
+	ddns_client* DDNS_RESTRICT client,
+	const std::size_t entries_size, void* entries,
+	const transfer_callbacks& callbacks
+) DDNS_NOEXCEPT {
+	engine& engine {client->engine};
+	if (!engine_setup(client, engine)) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	batch batch;
+	batch.callbacks = callbacks;
+	batch.entries = entries;
+	batch.entries_size = entries_size;
+	engine_enqueue(client, engine, batch);
+
+	while (!batch.finished()) {
+		int still_running {0};
+		if (curl_multi_perform(engine.multi, &still_running) != CURLM_OK) {
+			break;
+		}
+
+		engine_collect(client, engine);
+		engine_resend(client, engine);
+		if (batch.finished()) {
+			break;
+		}
+
+		// Wake up in time for the next request waiting to be sent again
+		int wait_ms {1000};
+		const std::int64_t retry_at {engine_next_retry(engine)};
+		if (retry_at != 0) {
+			wait_ms = static_cast<int>(std::clamp<std::int64_t>(retry_at - steady_ms(), 0, wait_ms));
+		}
+#if LIBCURL_VERSION_NUM >= 0x074200
+		curl_multi_poll(engine.multi, nullptr, 0, wait_ms, nullptr);
+#else
+		curl_multi_wait(engine.multi, nullptr, 0, wait_ms, nullptr);
+#endif
+	}
+
+	// Only does something if curl_multi_perform() failed
+	engine_abort(engine);
+
+	return DDNS_ERROR_OK;
+}
+
+struct zone_search;
+
+/*
+ * An operation of a ddns_async, run as a batch of its engine. Operations
+ * are recycled, so that none is allocated once there are enough of them.
+ */
+struct operation : batch {
+	ddns_async* async {nullptr};
+	ddns_async_callback callback {nullptr};
+	void* user {nullptr};
+	// Where the outcome is written in the entry
+	ddns_error* error {nullptr};
+	// Set for the searches of zones, whose entries are the candidates of
+	// search_state
+	ddns_zone_search* search {nullptr};
+	zone_search* search_state {nullptr};
+	// Set if the search failed before sending any request
+	ddns_error search_error {DDNS_ERROR_OK};
+	// In the list of all the operations of the async, and of the unused
+	// ones
+	operation* next_allocated {nullptr};
+	operation* next_free {nullptr};
+};
+
+} // namespace priv
+
+struct ddns_async {
+	ddns_client* client;
+	priv::engine engine;
+	// Set when an event loop drives the async
+	ddns_socket_callback socket_callback;
+	ddns_timer_callback timer_callback;
+	void* user;
+	// When curl wants to be called again, in steady_ms(), or -1
+	std::int64_t curl_timer_at;
+	// When the timer of the event loop expires, -1 if it's stopped, or -2
+	// if it must be set again
+	std::int64_t timer_at;
+	priv::operation* operations;
+	priv::operation* free_operations;
+	// Operations whose callback wasn't called yet
+	std::size_t pending;
+	// In the list of the client
+	ddns_async* next;
+};
+
+namespace priv {
+
+/*
+ * Calls set with value on the handles of the transfers of client and of
+ * its asyncs, to change one of their options. Transfers created later
+ * copy the options of the main handle instead.
+ */
+static void transfers_setopt(
+	ddns_client* DDNS_RESTRICT client,
+	const void* const value,
+	void (*const set)(CURL* curl, const void* value)
+) DDNS_NOEXCEPT {
+	const auto set_all = [&](const engine& engine) {
+		if (engine.transfers == nullptr) {
+			return;
+		}
+		for (std::size_t i = 0; i < max_transfers; ++i) {
+			if (engine.transfers[i].curl != nullptr) {
+				set(engine.transfers[i].curl, value);
+			}
+		}
+	};
+	set_all(client->engine);
+	for (const ddns_async* async = client->asyncs; async != nullptr; async = async->next) {
+		set_all(async->engine);
+	}
+}
+
+} // namespace priv
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_base_url(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT base_url
+) DDNS_NOEXCEPT {
+	// The zones of another server might be different
+	for (priv::zone_answer& answer : client->zone_answers) {
+		answer.expires_at = 0;
+	}
+
+	if (base_url == nullptr) {
+		client->zones_url = default_zones_url;
+		return DDNS_ERROR_OK;
+	}
+
+	std::size_t base_url_length {std::strlen(base_url)};
+	// zones_path already starts with a slash
+	if (base_url_length != 0 && base_url[base_url_length - 1U] == '/') {
+		--base_url_length;
+	}
+	if (base_url_length == 0 || base_url_length > DDNS_BASE_URL_MAX_LENGTH) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	std::memcpy(client->zones_url_buffer, base_url, base_url_length);
+	std::memcpy(client->zones_url_buffer + base_url_length, priv::request::zones_path.data(), priv::request::zones_path.length());
+	client->zones_url_buffer[base_url_length + priv::request::zones_path.length()] = '\0';
+	client->zones_url = std::string_view(client->zones_url_buffer, base_url_length + priv::request::zones_path.length());
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_trace_url(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT trace_url
+) DDNS_NOEXCEPT {
+	if (trace_url == nullptr) {
+		client->trace_url = priv::default_trace_url;
+		return DDNS_ERROR_OK;
+	}
+
+	const std::size_t trace_url_length {std::strlen(trace_url)};
+	if (trace_url_length == 0 || trace_url_length > DDNS_TRACE_URL_MAX_LENGTH) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	std::memcpy(client->trace_url_buffer, trace_url, trace_url_length + 1U);
+	client->trace_url = client->trace_url_buffer;
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_ca_file(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT ca_file
+) DDNS_NOEXCEPT {
+	if (curl_easy_setopt(client->curl, CURLOPT_CAINFO, ca_file) != CURLE_OK) {
+		return DDNS_ERROR_GENERIC;
+	}
+	priv::transfers_setopt(client, ca_file, [](CURL* const curl, const void* const value) {
+		curl_easy_setopt(curl, CURLOPT_CAINFO, static_cast<const char*>(value));
+	});
+	return DDNS_ERROR_OK;
+}
+
+DDNS_PUB void ddns_client_set_stats_callback(
+	ddns_client* DDNS_RESTRICT client,
+	const ddns_stats_callback callback,
+	void* const user
+) DDNS_NOEXCEPT {
+	client->context.stats_callback = callback;
+	client->context.stats_user = user;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_resolve_cache(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT path
+) DDNS_NOEXCEPT {
+	priv::resolver& resolver {client->context.resolver};
+	delete[] resolver.path;
+	resolver.path = nullptr;
+	resolver.temporary_path = nullptr;
+
+	if (path == nullptr) {
+		return DDNS_ERROR_OK;
+	}
+
+	// Both paths are kept in the same buffer
+	constexpr std::string_view temporary_suffix {".tmp"};
+	const std::size_t path_length {std::strlen(path)};
+	char* const paths {new (std::nothrow) char[2U * (path_length + 1U) + temporary_suffix.length()]};
+	if (paths == nullptr) {
+		return DDNS_ERROR_GENERIC;
+	}
+	std::memcpy(paths, path, path_length + 1U);
+	char* const temporary_path {paths + path_length + 1U};
+	std::memcpy(temporary_path, path, path_length);
+	std::memcpy(temporary_path + path_length, temporary_suffix.data(), temporary_suffix.length());
+	temporary_path[path_length + temporary_suffix.length()] = '\0';
+
+	resolver.path = paths;
+	resolver.temporary_path = temporary_path;
+	resolver.cache.load(resolver.path, static_cast<std::int64_t>(std::time(nullptr)));
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_timeouts(
+	ddns_client* DDNS_RESTRICT client,
+	const long connect_timeout_ms,
+	const long timeout_ms
+) DDNS_NOEXCEPT {
+	if (connect_timeout_ms < 0 || timeout_ms < 0) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	curl_easy_setopt(client->curl, CURLOPT_CONNECTTIMEOUT_MS, connect_timeout_ms);
+	priv::transfers_setopt(client, &connect_timeout_ms, [](CURL* const curl, const void* const value) {
+		curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, *static_cast<const long*>(value));
+	});
+	// Set on every request, as it depends on the deadline too
+	client->context.timeout_ms = timeout_ms;
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_set_deadline(
+	ddns_client* DDNS_RESTRICT client,
+	const long budget_ms
+) DDNS_NOEXCEPT {
+	if (budget_ms < 0) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	client->context.deadline_ms = budget_ms != 0 ? priv::steady_ms() + budget_ms : 0;
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_share_create(ddns_share** DDNS_RESTRICT share) DDNS_NOEXCEPT {
+	ddns_share* const new_share {new (std::nothrow) ddns_share};
+	if (new_share == nullptr) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	new_share->curl = curl_share_init();
+	if (new_share->curl == nullptr) {
+		delete new_share;
+		return DDNS_ERROR_GENERIC;
+	}
+
+	priv::share_setup(new_share->curl);
+
+	*share = new_share;
+
+	return DDNS_ERROR_OK;
+}
+
+DDNS_PUB void ddns_share_destroy(ddns_share* const share) DDNS_NOEXCEPT {
+	if (share == nullptr) {
+		return;
+	}
+	curl_share_cleanup(share->curl);
+	delete share;
+}
+
+DDNS_PUB void ddns_client_set_share(
+	ddns_client* DDNS_RESTRICT client,
+	ddns_share* DDNS_RESTRICT share
+) DDNS_NOEXCEPT {
+	client->active_share = share != nullptr ? share->curl : client->share;
+	curl_easy_setopt(client->curl, CURLOPT_SHARE, client->active_share);
+	client->context.resolver.share = client->active_share;
+	if (client->context.resolver.curl != nullptr) {
+		curl_easy_setopt(client->context.resolver.curl, CURLOPT_SHARE, client->active_share);
+	}
+	priv::transfers_setopt(client, client->active_share, [](CURL* const curl, const void* const value) {
+		curl_easy_setopt(curl, CURLOPT_SHARE, static_cast<CURLSH*>(const_cast<void*>(value)));
+	});
+}
+
+DDNS_NODISCARD DDNS_PUB const char* ddns_client_response(
+	const ddns_client* DDNS_RESTRICT client,
+	size_t* DDNS_RESTRICT response_size
+) DDNS_NOEXCEPT {
+	*response_size = client->response.size();
+	return client->response.data();
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_local_ip(
+	ddns_client* DDNS_RESTRICT client,
+	const bool ipv6,
+	const size_t ip_size, char* DDNS_RESTRICT ip
+) DDNS_NOEXCEPT {
+	client->response.clear();
+	return priv::get_local_ip(&client->curl, client->response, client->trace_url, ipv6, ip_size, ip);
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_record(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	const size_t record_ip_size, char* DDNS_RESTRICT record_ip,
+	const size_t record_id_size, char* DDNS_RESTRICT record_id,
+	bool* DDNS_RESTRICT aaaa
+) DDNS_NOEXCEPT {
+	return priv::get_record(
+		&client->curl, client->response, client->zones_url,
+		api_token, zone_id, record_name,
+		record_ip_size, record_ip,
+		record_id_size, record_id,
+		aaaa
+	);
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_records(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_name,
+	const size_t records_size, ddns_record* DDNS_RESTRICT records,
+	size_t* DDNS_RESTRICT records_count
+) DDNS_NOEXCEPT {
+	return priv::get_records(
+		&client->curl, client->response, client->zones_url,
+		api_token, zone_id, record_name,
+		records_size, records,
+		records_count
+	);
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_update_record(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const char* DDNS_RESTRICT record_id,
+	const char* DDNS_RESTRICT new_ip,
+	const size_t record_ip_size, char* DDNS_RESTRICT record_ip
+) DDNS_NOEXCEPT {
+	return priv::update_record(&client->curl, client->response, client->zones_url, api_token, zone_id, record_id, new_ip, record_ip_size, record_ip);
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_update_records_batch(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	const size_t records_size, ddns_record* DDNS_RESTRICT records
+) DDNS_NOEXCEPT {
+	return priv::update_records_batch(&client->curl, client->response, client->zones_url, api_token, zone_id, records_size, records);
+}
+
+namespace priv {
+
+static ddns_error get_records_prepare(const ddns_client& client, void* const entries, const std::size_t index, transfer& transfer) DDNS_NOEXCEPT {
+	ddns_record_query& query {static_cast<ddns_record_query*>(entries)[index]};
+
+	const ddns_error error {make_get_record_url(client.zones_url, query.api_token, query.zone_id, query.record_name, transfer.url)};
+	if (error) {
+		return error;
+	}
+
+	query.records_count = 0;
+	transfer.sink = {query.records_size, query.records, &query.records_count, DDNS_ERROR_OK};
+	transfer.parser.reset(collect_record, &transfer.sink);
+
+	transfer.headers = curl_auth_setup(&transfer.curl, query.api_token);
+	transfer.api_token = query.api_token;
+	curl_get_setup(&transfer.curl, transfer.url);
+
+	return DDNS_ERROR_OK;
+}
+
+static void get_records_finish(void* const entries, const std::size_t index, const transfer& transfer, const ddns_error error) DDNS_NOEXCEPT {
+	ddns_record_query& query {static_cast<ddns_record_query*>(entries)[index]};
+
+	query.error = parsed_records(error, transfer.parser, transfer.sink);
+	if (query.error) {
+		query.records_count = 0;
+	}
+}
+
+static ddns_error update_records_prepare(const ddns_client& client, void* const entries, const std::size_t index, transfer& transfer) DDNS_NOEXCEPT {
+	const ddns_record_update& update {static_cast<ddns_record_update*>(entries)[index]};
+
+	const ddns_error error {make_update_record_request(client.zones_url, update.api_token, update.zone_id, update.record_id, update.new_ip, transfer.url, transfer.body)};
+	if (error) {
+		return error;
+	}
+
+	transfer.record.clear();
+	transfer.parser.reset(keep_first, &transfer.record);
+
+	transfer.headers = curl_auth_setup(&transfer.curl, update.api_token);
+	transfer.api_token = update.api_token;
+	curl_patch_setup(&transfer.curl, transfer.url, transfer.body);
+
+	return DDNS_ERROR_OK;
+}
+
+static void update_records_finish(void* const entries, const std::size_t index, const transfer& transfer, const ddns_error error) DDNS_NOEXCEPT {
+	ddns_record_update& update {static_cast<ddns_record_update*>(entries)[index]};
+
+	update.record_ip[0] = '\0';
+	update.error = updated_ip(error, transfer.parser, transfer.record, sizeof update.record_ip, update.record_ip);
+}
+
+static ddns_error local_ips_prepare(const ddns_client& client, void* const entries, const std::size_t index, transfer& transfer) DDNS_NOEXCEPT {
+	const ddns_local_ip& local_ip {static_cast<ddns_local_ip*>(entries)[index]};
+
+	if (local_ip.timeout_ms < 0) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	// The response isn't JSON
+	transfer.parser.reset(nullptr, nullptr);
+
+	std::memcpy(transfer.url, client.trace_url, std::strlen(client.trace_url) + 1U);
+	curl_get_setup(&transfer.curl, transfer.url);
+	curl_easy_setopt(transfer.curl, CURLOPT_IPRESOLVE, local_ip.ipv6 ? CURL_IPRESOLVE_V6 : CURL_IPRESOLVE_V4);
+	transfer.timeout_ms = local_ip.timeout_ms;
+
+	return DDNS_ERROR_OK;
+}
+
+static void local_ips_finish(void* const entries, const std::size_t index, const transfer& transfer, const ddns_error error) DDNS_NOEXCEPT {
+	ddns_local_ip& local_ip {static_cast<ddns_local_ip*>(entries)[index]};
+
+	local_ip.error = error ? error : parse_trace(transfer.response.view(), sizeof local_ip.ip, local_ip.ip);
+	if (local_ip.error) {
+		local_ip.ip[0] = '\0';
+	}
+}
+
+/*
+ * One of the names a record could belong to, i.e. the record name itself
+ * or one of its suffixes, searched among the zones of api_token. If the
+ * search succeeds but no zone has that name zone_id is left empty.
+ */
+struct zone_candidate {
+	const char* api_token;
+	const char* name;
+	ddns_error error;
+	char zone_id[DDNS_ZONE_ID_LENGTH + 1U];
+};
+
+/*
+ * Every name of a zone candidate is a suffix following a dot, so there
+ * can't be more than this
+ */
+constexpr std::size_t max_zone_candidates {DDNS_RECORD_NAME_MAX_LENGTH / 2U + 1U};
+
+static ddns_error search_zone_prepare(const ddns_client& client, void* const entries, const std::size_t index, transfer& transfer) DDNS_NOEXCEPT {
+	const zone_candidate& candidate {static_cast<zone_candidate*>(entries)[index]};
+
+	const ddns_error error {make_zone_url(client.zones_url, candidate.api_token, candidate.name, transfer.url)};
+	if (error) {
+		return error;
+	}
+
+	transfer.record.clear();
+	transfer.parser.reset(keep_first, &transfer.record);
+
+	transfer.headers = curl_auth_setup(&transfer.curl, candidate.api_token);
+	transfer.api_token = candidate.api_token;
+	curl_get_setup(&transfer.curl, transfer.url);
+
+	return DDNS_ERROR_OK;
+}
+
+static void search_zone_finish(void* const entries, const std::size_t index, const transfer& transfer, const ddns_error error) DDNS_NOEXCEPT {
+	zone_candidate& candidate {static_cast<zone_candidate*>(entries)[index]};
+
+	if (error || !transfer.parser.success()) {
+		candidate.error = error ? error : DDNS_ERROR_GENERIC;
+		return;
+	}
+
+	candidate.error = DDNS_ERROR_OK;
+
+	const json::record& zone {transfer.record};
+	if (zone.has(json::record::id) && zone.id_length == DDNS_ZONE_ID_LENGTH) {
+		std::memcpy(candidate.zone_id, zone.id_value, zone.id_length + 1U);
+	}
+}
+
+} // namespace priv
+
+namespace priv {
+
+/*
+ * The answer still valid to the search of name with api_token, if any
+ */
+DDNS_NODISCARD static const zone_answer* find_zone_answer(
+	const ddns_client* DDNS_RESTRICT client,
+	const std::uint64_t api_token,
+	const std::string_view name,
+	const std::int64_t now
+) DDNS_NOEXCEPT {
+	for (const zone_answer& answer : client->zone_answers) {
+		if (answer.expires_at > now && answer.api_token == api_token && name == answer.name) {
+			return &answer;
+		}
+	}
+	return nullptr;
+}
+
+static void remember_zone_answer(ddns_client* DDNS_RESTRICT client, const std::uint64_t api_token, const zone_candidate& candidate, const std::int64_t now) DDNS_NOEXCEPT {
+	const std::size_t name_length {std::strlen(candidate.name)};
+	if (name_length > request::zone_name_max_length) {
+		return;
+	}
+
+	zone_answer& answer {client->zone_answers[client->next_zone_answer]};
+	client->next_zone_answer = (client->next_zone_answer + 1U) % max_zone_answers;
+
+	answer.api_token = api_token;
+	std::memcpy(answer.name, candidate.name, name_length + 1U);
+	std::memcpy(answer.zone_id, candidate.zone_id, sizeof answer.zone_id);
+	answer.expires_at = now + zone_answer_ttl;
+}
+
+/*
+ * The search of the zone of a record, made of the names it could belong
+ * to. Only the pending ones are sent, the others are answered by the zone
+ * answers of the client.
+ */
+struct zone_search {
+	zone_candidate candidates[max_zone_candidates];
+	std::size_t candidates_size;
+	zone_candidate pending[max_zone_candidates];
+	// Where each pending candidate goes among the candidates
+	std::size_t pending_index[max_zone_candidates];
+	std::size_t pending_size;
+	// ratelimit::key() of the API token
+	std::uint64_t api_token;
+	std::int64_t now;
+};
+
+/*
+ * Finds the candidates of the zone of record_name, and which of them must
+ * be sent. Returns DDNS_ERROR_USAGE if the name has too many labels.
+ */
+DDNS_NODISCARD static ddns_error zone_search_begin(
+	const ddns_client* DDNS_RESTRICT client,
+	zone_search& search,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT record_name
+) DDNS_NOEXCEPT {
+	// All the suffixes of the record name are searched at once, instead of
+	// one after the other, so that a lookup takes a single round trip no
+	// matter how deep the name is. Public suffixes, like "co.uk" or the top
+	// level domains, are skipped, as nobody can have them as a zone.
+	search.candidates_size = 0;
+	const char* name {record_name};
+	while (name != nullptr && *name != '\0' && !psl::is_public_suffix(name)) {
+		if (search.candidates_size == max_zone_candidates) {
+			return DDNS_ERROR_USAGE;
+		}
+		search.candidates[search.candidates_size++] = {api_token, name, DDNS_ERROR_GENERIC, {}};
+		name = std::strchr(name, '.');
+		if (name != nullptr) {
+			++name;
+		}
+	}
+
+	// Suffixes searched recently, like the zone of another record, are
+	// answered right away, and only the others are sent
+	search.api_token = ratelimit::key(api_token);
+	search.now = static_cast<std::int64_t>(std::time(nullptr));
+	search.pending_size = 0;
+	for (std::size_t i = 0; i < search.candidates_size; ++i) {
+		zone_candidate& candidate {search.candidates[i]};
+		if (const zone_answer* const answer = find_zone_answer(client, search.api_token, candidate.name, search.now)) {
+			candidate.error = DDNS_ERROR_OK;
+			std::memcpy(candidate.zone_id, answer->zone_id, sizeof candidate.zone_id);
+			continue;
+		}
+		search.pending[search.pending_size] = candidate;
+		search.pending_index[search.pending_size++] = i;
+	}
+
+	return DDNS_ERROR_OK;
+}
+
+/*
+ * Remembers the answers of the pending candidates once they're searched,
+ * and writes the zone of the record in zone_id, which must have room for
+ * DDNS_ZONE_ID_LENGTH + 1 characters
+ */
+DDNS_NODISCARD static ddns_error zone_search_end(ddns_client* DDNS_RESTRICT client, zone_search& search, char* DDNS_RESTRICT zone_id) DDNS_NOEXCEPT {
+	for (std::size_t i = 0; i < search.pending_size; ++i) {
+		search.candidates[search.pending_index[i]] = search.pending[i];
+		if (search.pending[i].error == DDNS_ERROR_OK) {
+			remember_zone_answer(client, search.api_token, search.pending[i], search.now);
+		}
+	}
+
+	// The candidates go from the longest name to the shortest, and the
+	// record belongs to the longest zone, which might be a subdomain
+	// delegated to another zone of the same account. If the search of a
+	// longer name failed a shorter zone can't be trusted to be the right
+	// one.
+	for (std::size_t i = 0; i < search.candidates_size; ++i) {
+		if (search.candidates[i].error == DDNS_ERROR_USAGE) {
+			return DDNS_ERROR_USAGE;
+		}
+	}
+	for (std::size_t i = 0; i < search.candidates_size; ++i) {
+		if (search.candidates[i].error) {
+			return search.candidates[i].error;
+		}
+		if (search.candidates[i].zone_id[0] != '\0') {
+			std::memcpy(zone_id, search.candidates[i].zone_id, DDNS_ZONE_ID_LENGTH + 1U);
+			return DDNS_ERROR_OK;
+		}
+	}
+
+	return DDNS_ERROR_GENERIC;
+}
+
+} // namespace priv
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_search_zone_id(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT record_name,
+	const size_t zone_id_size, char* DDNS_RESTRICT zone_id
+) DDNS_NOEXCEPT {
+	// <= because I also have to write '\0'
+	if (zone_id_size <= DDNS_ZONE_ID_LENGTH) {
+		return DDNS_ERROR_USAGE;
+	}
 
-	priv::curl_handle_setup(&curl, response);
+	priv::zone_search search;
+	const ddns_error usage {priv::zone_search_begin(client, search, api_token, record_name)};
+	if (usage) {
+		return usage;
+	}
 
-	std::optional<std::string_view> zone_id_sv;
+	const ddns_error error {priv::perform_transfers(
+		client,
+		search.pending_size, search.pending,
+		{priv::search_zone_prepare, priv::search_zone_finish}
+	)};
+	if (error) {
+		return error;
+	}
 
-	bool found = false;
+	return priv::zone_search_end(client, search, zone_id);
+}
 
-	for (auto pos = record_name_sv.find_first_of('.'); !found && pos != std::string_view::npos; pos = record_name_sv.find_first_of('.')) {
-		// before making a new request I have to reset the current buffer size
-		response.size = 0;
+namespace priv {
 
-		const ddns_error error = ddns_get_zone_id_raw(api_token, record_name_sv.data(), &curl);
+/*
+ * Whether two queries look up the same records, so that a single request
+ * can answer both
+ */
+static bool same_query(const ddns_record_query& a, const ddns_record_query& b) DDNS_NOEXCEPT {
+	return a.api_token != nullptr && a.zone_id != nullptr && a.record_name != nullptr
+		&& b.api_token != nullptr && b.zone_id != nullptr && b.record_name != nullptr
+		&& std::strcmp(a.record_name, b.record_name) == 0
+		&& std::strcmp(a.zone_id, b.zone_id) == 0
+		&& std::strcmp(a.api_token, b.api_token) == 0;
+}
 
-		// +1 because I also need to remove the leading dot
-		record_name_sv.remove_prefix(pos + 1);
+/*
+ * Looks up the records of queries with one request for each different
+ * query, copying the records found to the ones asking for the same
+ */
+DDNS_NODISCARD static ddns_error get_records_coalesced(ddns_client* DDNS_RESTRICT client, const std::size_t queries_size, ddns_record_query* DDNS_RESTRICT queries) DDNS_NOEXCEPT {
+	// The index in unique of the query answering each of queries
+	std::size_t* const answered_by {new (std::nothrow) std::size_t[queries_size]};
+	ddns_record_query* const unique {new (std::nothrow) ddns_record_query[queries_size]};
+	if (answered_by == nullptr || unique == nullptr) {
+		delete[] answered_by;
+		delete[] unique;
+		return DDNS_ERROR_GENERIC;
+	}
 
-		if (error == DDNS_ERROR_USAGE) {
-			// a usage error will make the request fail over and over again
-			curl_easy_cleanup(curl);
-			return error;
+	// Each different query is sent by the one with the most room for
+	// records, the first one if they have the same
+	std::size_t unique_size {0};
+	for (std::size_t i = 0; i < queries_size; ++i) {
+		std::size_t first {0};
+		while (first < i && !same_query(queries[first], queries[i])) {
+			++first;
 		}
-		else if (error) {
-			// here continue acts as "retry"
+		if (first == i) {
+			unique[unique_size] = queries[i];
+			answered_by[i] = unique_size++;
 			continue;
 		}
-
-		zone_id_sv = priv::get_json_value(std::string_view(response.buffer, response.size), "\"id\"");
-		if (!zone_id_sv.has_value()) {
-			continue;
+		answered_by[i] = answered_by[first];
+		if (queries[i].records_size > unique[answered_by[i]].records_size) {
+			unique[answered_by[i]] = queries[i];
 		}
+	}
 
-		if (zone_id_sv->length() != DDNS_ZONE_ID_LENGTH) {
-			continue;
+	const ddns_error error {perform_transfers(client, unique_size, unique, {get_records_prepare, get_records_finish})};
+	if (!error) {
+		for (std::size_t i = 0; i < queries_size; ++i) {
+			const ddns_record_query& answer {unique[answered_by[i]]};
+			ddns_record_query& query {queries[i]};
+			if (query.records != answer.records) {
+				const std::size_t found {std::min(answer.records_count, answer.records_size)};
+				const std::size_t copied {std::min(found, query.records_size)};
+				if (copied != 0) {
+					std::memcpy(query.records, answer.records, copied * sizeof *query.records);
+				}
+			}
+			query.records_count = answer.records_count;
+			query.error = answer.error;
 		}
-
-		found = true;
 	}
 
-	curl_easy_cleanup(curl);
+	delete[] answered_by;
+	delete[] unique;
+	return error;
+}
 
-	if (!found) {
-		return DDNS_ERROR_GENERIC;
+} // namespace priv
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_records_multi(
+	ddns_client* DDNS_RESTRICT client,
+	const size_t queries_size, ddns_record_query* DDNS_RESTRICT queries
+) DDNS_NOEXCEPT {
+	// Looking for duplicates first, so that a batch without any needs no
+	// allocation
+	bool duplicates {false};
+	for (std::size_t i = 0; i < queries_size && !duplicates; ++i) {
+		for (std::size_t j = i + 1U; j < queries_size && !duplicates; ++j) {
+			duplicates = priv::same_query(queries[i], queries[j]);
+		}
 	}
 
-	std::memcpy(zone_id, zone_id_sv->data(), zone_id_sv->length());
-	zone_id[zone_id_sv->length()] = '\0';
+	const ddns_error error {duplicates
+		? priv::get_records_coalesced(client, queries_size, queries)
+		: priv::perform_transfers(client, queries_size, queries, {priv::get_records_prepare, priv::get_records_finish})
+	};
+	if (error) {
+		return error;
+	}
 
+	for (std::size_t i = 0; i < queries_size; ++i) {
+		if (queries[i].error) {
+			return DDNS_ERROR_GENERIC;
+		}
+	}
 	return DDNS_ERROR_OK;
 }
 
-DDNS_NODISCARD DDNS_PUB ddns_error ddns_get_zone_id_raw(
-	const char* const DDNS_RESTRICT api_token,
-	const char* const DDNS_RESTRICT zone_name,
-	void**            DDNS_RESTRICT curl
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_get_local_ips(
+	ddns_client* DDNS_RESTRICT client,
+	const size_t local_ips_size, ddns_local_ip* DDNS_RESTRICT local_ips
 ) DDNS_NOEXCEPT {
-	const std::size_t zone_name_length = std::strlen(zone_name);
+	const ddns_error error {priv::perform_transfers(
+		client,
+		local_ips_size, local_ips,
+		{priv::local_ips_prepare, priv::local_ips_finish}
+	)};
+	if (error) {
+		return error;
+	}
 
-	// -2 because this endpoint has a maximum record name length of 253
-	constexpr std::size_t zone_name_max_length = DDNS_RECORD_NAME_MAX_LENGTH - 2U;
+	for (std::size_t i = 0; i < local_ips_size; ++i) {
+		if (local_ips[i].error) {
+			return DDNS_ERROR_GENERIC;
+		}
+	}
+	return DDNS_ERROR_OK;
+}
 
-	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH || zone_name_length > zone_name_max_length) {
-		return DDNS_ERROR_USAGE;
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_update_records_multi(
+	ddns_client* DDNS_RESTRICT client,
+	const size_t updates_size, ddns_record_update* DDNS_RESTRICT updates
+) DDNS_NOEXCEPT {
+	const ddns_error error {priv::perform_transfers(
+		client,
+		updates_size, updates,
+		{priv::update_records_prepare, priv::update_records_finish}
+	)};
+	if (error) {
+		return error;
 	}
 
-	constexpr std::string_view zones_url = "?per_page=1&name=";
+	for (std::size_t i = 0; i < updates_size; ++i) {
+		if (updates[i].error) {
+			return DDNS_ERROR_GENERIC;
+		}
+	}
+	return DDNS_ERROR_OK;
+}
 
-	constexpr std::size_t request_url_capacity =
-		base_url.length() +
-		zones_url.length() +
-		zone_name_max_length
-	;
+/*
+ * The records of a zone, sorted by name. The names are stored one after
+ * the other in a single buffer, and each entry refers to its name by
+ * offset, so that the whole index takes two allocations.
+ */
+struct ddns_zone_index {
+	char* names;
+	std::size_t names_size;
+	std::size_t names_capacity;
+	priv::index_entry* entries;
+	std::size_t entries_size;
+	std::size_t entries_capacity;
+};
 
-	// +1 because of '\0'
-	char request_url[request_url_capacity + 1];
+namespace priv {
 
-	// create the request url
-	std::memcpy(request_url, base_url.data(), base_url.length());
-	std::memcpy(request_url + base_url.length(), zones_url.data(), zones_url.length());
-	std::memcpy(request_url + base_url.length() + zones_url.length(), zone_name, zone_name_length);
-	request_url[base_url.length() + zones_url.length() + zone_name_length] = '\0';
+static std::string_view entry_name(const ddns_zone_index& index, const index_entry& entry) DDNS_NOEXCEPT {
+	return {index.names + entry.name_offset, entry.name_length};
+}
 
-	curl_slist* free_me_doh = priv::curl_doh_setup(curl);
-	curl_slist* free_me_headers = priv::curl_auth_setup(curl, api_token);
+/*
+ * Adds the records of a page of the listing to index, stopping at the
+ * first error
+ */
+struct index_sink {
+	ddns_zone_index& index;
+	ddns_error error;
+};
 
-	priv::curl_get_setup(curl, request_url);
+static void index_record(void* const user, const json::record& record) DDNS_NOEXCEPT {
+	index_sink& sink {*static_cast<index_sink*>(user)};
+	ddns_zone_index& index {sink.index};
 
-	const int curl_error = curl_easy_perform(*curl);
+	if (sink.error || !record.is_address()) {
+		return;
+	}
 
-	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
-	curl_slist_free_all(free_me_headers);
+	if (!record.has(json::record::id | json::record::name | json::record::content) || record.id_length != DDNS_RECORD_ID_LENGTH) {
+		sink.error = DDNS_ERROR_GENERIC;
+		return;
+	}
 
-	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
-	curl_slist_free_all(free_me_doh);
+	if (!reserve(index.names, index.names_size, index.names_capacity, index.names_size + record.name_length)
+		|| !reserve(index.entries, index.entries_size, index.entries_capacity, index.entries_size + 1U)) {
+		sink.error = DDNS_ERROR_GENERIC;
+		return;
+	}
 
-	if (curl_error) {
+	index_entry& entry {index.entries[index.entries_size++]};
+	entry.name_offset = index.names_size;
+	entry.name_length = record.name_length;
+	std::memcpy(index.names + index.names_size, record.name_value, record.name_length);
+	index.names_size += record.name_length;
+
+	std::memcpy(entry.record.id, record.id_value, record.id_length + 1U);
+	std::memcpy(entry.record.content, record.content_value, record.content_length + 1U);
+	entry.record.aaaa = (record.type_sv() == "AAAA");
+}
+
+/*
+ * Lists all the pages of A and AAAA records of a zone in a new index
+ */
+DDNS_NODISCARD static ddns_error list_records(
+	CURL** DDNS_RESTRICT curl,
+	response_sink& response,
+	const std::string_view zones_url,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	ddns_zone_index** DDNS_RESTRICT index
+) DDNS_NOEXCEPT {
+	ddns_zone_index* const new_index {new (std::nothrow) ddns_zone_index {nullptr, 0, 0, nullptr, 0, 0}};
+	if (new_index == nullptr) {
 		return DDNS_ERROR_GENERIC;
 	}
 
+	// A page with less than DDNS_RECORDS_PER_PAGE records is the last one
+	std::size_t page_count {DDNS_RECORDS_PER_PAGE};
+	for (std::size_t page = 1; page_count == DDNS_RECORDS_PER_PAGE; ++page) {
+		index_sink sink {*new_index, DDNS_ERROR_OK};
+		json::response_parser parser {index_record, &sink};
+
+		ddns_error error;
+		{
+			const response_parsing parsing {response, parser};
+			error = list_records_raw(curl, zones_url, api_token, zone_id, page);
+		}
+		if (!error && !parser.success()) {
+			error = DDNS_ERROR_GENERIC;
+		}
+		if (!error) {
+			error = sink.error;
+		}
+		if (error) {
+			ddns_zone_index_destroy(new_index);
+			return error;
+		}
+
+		// Records of any type count, as they're all part of the page
+		page_count = parser.records();
+	}
+
+	std::sort(new_index->entries, new_index->entries + new_index->entries_size, [new_index](const index_entry& a, const index_entry& b) {
+		return entry_name(*new_index, a) < entry_name(*new_index, b);
+	});
+
+	*index = new_index;
+
 	return DDNS_ERROR_OK;
 }
 
-DDNS_NODISCARD ddns_error ddns_get_record(
-	const char* const DDNS_RESTRICT api_token,
-	const char* const DDNS_RESTRICT zone_id,
-	const char* const DDNS_RESTRICT record_name,
-	const size_t record_ip_size, char* DDNS_RESTRICT record_ip,
-	const size_t record_id_size, char* DDNS_RESTRICT record_id,
-	bool* aaaa
+} // namespace priv
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_list_records(
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	ddns_zone_index** DDNS_RESTRICT index
 ) DDNS_NOEXCEPT {
 	CURL* curl {curl_easy_init()};
-	priv::static_buffer response;
+	priv::response_sink response;
 
 	priv::curl_handle_setup(&curl, response);
 
-	const ddns_error error = ddns_get_record_raw(api_token, zone_id, record_name, &curl);
+	const ddns_error error = priv::list_records(&curl, response, default_zones_url, api_token, zone_id, index);
 
 	curl_easy_cleanup(curl);
 
-	if (error) {
-		return error;
-	}
+	return error;
+}
 
-	const std::string_view response_sv {response.buffer, response.size};
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_client_list_records(
+	ddns_client* DDNS_RESTRICT client,
+	const char* DDNS_RESTRICT api_token,
+	const char* DDNS_RESTRICT zone_id,
+	ddns_zone_index** DDNS_RESTRICT index
+) DDNS_NOEXCEPT {
+	return priv::list_records(&client->curl, client->response, client->zones_url, api_token, zone_id, index);
+}
 
-	const std::optional record_id_sv = priv::get_json_value(response_sv, "\"id\"");
-	if (!record_id_sv.has_value()) {
-		return DDNS_ERROR_GENERIC;
-	}
+DDNS_NODISCARD DDNS_PUB size_t ddns_zone_index_size(const ddns_zone_index* DDNS_RESTRICT index) DDNS_NOEXCEPT {
+	return index->entries_size;
+}
 
-	const std::optional type = priv::get_json_value(response_sv, "\"type\"");
-	if (!type.has_value()) {
-		return DDNS_ERROR_GENERIC;
-	}
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_zone_index_find(
+	const ddns_zone_index* DDNS_RESTRICT index,
+	const char* DDNS_RESTRICT record_name,
+	const size_t records_size, ddns_record* DDNS_RESTRICT records,
+	size_t* DDNS_RESTRICT records_count
+) DDNS_NOEXCEPT {
+	const std::string_view name {record_name};
+	const auto [first, last] = std::equal_range(
+		index->entries, index->entries + index->entries_size, name,
+		[index](const auto& a, const auto& b) {
+			// One of the two is the name searched, the other an entry
+			if constexpr (std::is_same_v<std::decay_t<decltype(a)>, std::string_view>) {
+				return a < priv::entry_name(*index, b);
+			}
+			else {
+				return priv::entry_name(*index, a) < b;
+			}
+		}
+	);
 
-	const std::optional record_ip_sv = priv::get_json_value(response_sv, "\"content\"");
-	if (!record_ip_sv.has_value()) {
-		return DDNS_ERROR_GENERIC;
+	*records_count = static_cast<std::size_t>(last - first);
+	for (std::size_t i = 0; i < *records_count && i < records_size; ++i) {
+		records[i] = first[i].record;
 	}
 
-	if (record_ip_sv->length() >= record_ip_size || record_id_sv->length() >= record_id_size) {
-		return DDNS_ERROR_USAGE;
+	return DDNS_ERROR_OK;
+}
+
+DDNS_PUB void ddns_zone_index_destroy(ddns_zone_index* const index) DDNS_NOEXCEPT {
+	if (index == nullptr) {
+		return;
 	}
+	delete[] index->names;
+	delete[] index->entries;
+	delete index;
+}
 
-	std::memcpy(record_ip, record_ip_sv->data(), record_ip_sv->length());
-	record_ip[record_ip_sv->length()] = '\0';
 
-	std::memcpy(record_id, record_id_sv->data(), record_id_sv->length());
-	record_id[record_id_sv->length()] = '\0';
+namespace priv {
 
-	*aaaa = (type == "AAAA");
+static int async_socket(CURL*, const curl_socket_t socket, const int what, void* const user, void*) DDNS_NOEXCEPT {
+	const ddns_async& async {*static_cast<const ddns_async*>(user)};
+	int events {0};
+	if (what == CURL_POLL_IN || what == CURL_POLL_INOUT) {
+		events |= DDNS_POLL_IN;
+	}
+	if (what == CURL_POLL_OUT || what == CURL_POLL_INOUT) {
+		events |= DDNS_POLL_OUT;
+	}
+	async.socket_callback(static_cast<ddns_socket>(socket), events, async.user);
+	return 0;
+}
 
-	return DDNS_ERROR_OK;
+/*
+ * Only remembers the timer of curl, which is combined with the one of the
+ * engine by async_update_timer() before telling the event loop
+ */
+static int async_timer(CURLM*, const long timeout_ms, void* const user) DDNS_NOEXCEPT {
+	ddns_async& async {*static_cast<ddns_async*>(user)};
+	async.curl_timer_at = timeout_ms < 0 ? -1 : steady_ms() + timeout_ms;
+	return 0;
 }
 
-DDNS_NODISCARD ddns_error ddns_get_record_raw(
-	const char* DDNS_RESTRICT api_token,
-	const char* DDNS_RESTRICT zone_id,
-	const char* DDNS_RESTRICT record_name,
-	void**      DDNS_RESTRICT curl
-) DDNS_NOEXCEPT {
-	const std::size_t record_name_length {std::strlen(record_name)};
+/*
+ * Tells the event loop when the async must be called next: when curl
+ * wants, when a request must be sent again, or right away if operations
+ * are waiting to be completed
+ */
+static void async_update_timer(ddns_async& async) DDNS_NOEXCEPT {
+	if (async.timer_callback == nullptr) {
+		return;
+	}
 
-	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH || std::strlen(zone_id) != DDNS_ZONE_ID_LENGTH || record_name_length > DDNS_RECORD_NAME_MAX_LENGTH) {
-		return DDNS_ERROR_USAGE;
+	const std::int64_t now {steady_ms()};
+	std::int64_t at {async.curl_timer_at};
+	const std::int64_t retry_at {engine_next_retry(async.engine)};
+	if (retry_at != 0 && (at < 0 || retry_at < at)) {
+		at = retry_at;
+	}
+	if (async.engine.completed != nullptr) {
+		at = now;
+	}
+	if (at == async.timer_at) {
+		return;
 	}
 
-	constexpr std::string_view dns_records_url {"/dns_records?type=A,AAAA&name="};
+	async.timer_at = at;
+	async.timer_callback(at < 0 ? -1L : static_cast<long>(std::max<std::int64_t>(at - now, 0)), async.user);
+}
 
-	constexpr std::size_t request_url_capacity {
-		base_url.length() +
-		DDNS_ZONE_ID_LENGTH +
-		dns_records_url.length() +
-		DDNS_RECORD_NAME_MAX_LENGTH
-	};
+/*
+ * Deals with what curl did, sends again the requests whose delay is over
+ * and completes the finished operations
+ */
+static void async_progress(ddns_async& async) DDNS_NOEXCEPT {
+	engine& engine {async.engine};
+	engine_collect(async.client, engine);
+	engine_resend(async.client, engine);
+
+	// The callbacks can start new operations, which are completed here as
+	// well if they fail right away
+	while (batch* const done = engine.completed) {
+		engine.completed = done->next;
+		if (engine.completed == nullptr) {
+			engine.completed_tail = nullptr;
+		}
+		done->next = nullptr;
+		done->complete(*done);
+	}
 
-	const std::size_t request_url_length {
-		base_url.length() +
-		DDNS_ZONE_ID_LENGTH +
-		dns_records_url.length() +
-		record_name_length
-	};
+	async_update_timer(async);
+}
 
-	// +1 because of '\0'
-	char request_url[request_url_capacity + 1U];
+/*
+ * Takes an unused operation of async, or allocates a new one. Returns
+ * nullptr if that fails.
+ */
+DDNS_NODISCARD static operation* async_operation(ddns_async& async) DDNS_NOEXCEPT {
+	operation* op {async.free_operations};
+	if (op != nullptr) {
+		async.free_operations = op->next_free;
+		return op;
+	}
 
-	// Concatenate strings
-	std::memcpy(request_url, base_url.data(), base_url.length());
-	std::memcpy(request_url + base_url.length(), zone_id, DDNS_ZONE_ID_LENGTH);
-	std::memcpy(request_url + base_url.length() + DDNS_ZONE_ID_LENGTH, dns_records_url.data(), dns_records_url.length());
-	std::memcpy(request_url + base_url.length() + DDNS_ZONE_ID_LENGTH + dns_records_url.length(), record_name, record_name_length);
-	request_url[request_url_length] = '\0';
+	op = new (std::nothrow) operation;
+	if (op == nullptr) {
+		return nullptr;
+	}
+	op->async = &async;
+	op->next_allocated = async.operations;
+	async.operations = op;
+	return op;
+}
 
-	curl_slist* free_me_doh {priv::curl_doh_setup(curl)};
-	curl_slist* free_me_headers {priv::curl_auth_setup(curl, api_token)};
+static void complete_operation(batch& batch) DDNS_NOEXCEPT {
+	operation& op {static_cast<operation&>(batch)};
+	ddns_async& async {*op.async};
 
-	priv::curl_get_setup(curl, request_url);
+	ddns_error error {DDNS_ERROR_GENERIC};
+	if (op.search != nullptr) {
+		error = op.search_error ? op.search_error : zone_search_end(async.client, *op.search_state, op.search->zone_id);
+		op.search->error = error;
+		if (error) {
+			op.search->zone_id[0] = '\0';
+		}
+	}
+	else {
+		error = *op.error;
+	}
 
-	const int curl_error = curl_easy_perform(*curl);
+	// Given back before the callback, which may start another operation
+	const ddns_async_callback callback {op.callback};
+	void* const user {op.user};
+	op.next_free = async.free_operations;
+	async.free_operations = &op;
+	--async.pending;
 
-	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
-	curl_slist_free_all(free_me_headers);
+	callback(error, user);
+}
 
-	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
-	curl_slist_free_all(free_me_doh);
+/*
+ * Queues the entries of op, which is completed by async_progress() once
+ * they're done
+ */
+static void async_start(
+	ddns_async& async,
+	operation& op,
+	const transfer_callbacks& callbacks,
+	const std::size_t entries_size, void* entries,
+	const ddns_async_callback callback,
+	void* const user
+) DDNS_NOEXCEPT {
+	op.callbacks = callbacks;
+	op.entries = entries;
+	op.entries_size = entries_size;
+	op.complete = complete_operation;
+	op.callback = callback;
+	op.user = user;
+	++async.pending;
+
+	engine_enqueue(async.client, async.engine, op);
+	async_update_timer(async);
+}
 
-	if (curl_error) {
+} // namespace priv
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_create(
+	ddns_client* DDNS_RESTRICT client,
+	ddns_async** DDNS_RESTRICT async
+) DDNS_NOEXCEPT {
+	ddns_async* const new_async {new (std::nothrow) ddns_async};
+	if (new_async == nullptr) {
 		return DDNS_ERROR_GENERIC;
 	}
 
-	return DDNS_ERROR_OK;
-}
+	new_async->client = client;
+	// Blocking on a DoH lookup would stall the event loop
+	new_async->engine.blocking = false;
+	new_async->socket_callback = nullptr;
+	new_async->timer_callback = nullptr;
+	new_async->user = nullptr;
+	new_async->curl_timer_at = -1;
+	new_async->timer_at = -1;
+	new_async->operations = nullptr;
+	new_async->free_operations = nullptr;
+	new_async->pending = 0;
+	if (!priv::engine_setup(client, new_async->engine)) {
+		delete new_async;
+		return DDNS_ERROR_GENERIC;
+	}
 
-DDNS_NODISCARD ddns_error ddns_update_record(
-	const char* DDNS_RESTRICT api_token,
-	const char* DDNS_RESTRICT zone_id,
-	const char* DDNS_RESTRICT record_id,
-	const char* DDNS_RESTRICT new_ip,
-	const size_t record_ip_size, char* DDNS_RESTRICT record_ip
-) DDNS_NOEXCEPT {
-	CURL* curl {curl_easy_init()};
-	priv::static_buffer response;
+	new_async->next = client->asyncs;
+	client->asyncs = new_async;
 
-	priv::curl_handle_setup(&curl, response);
+	*async = new_async;
 
-	const ddns_error error = ddns_update_record_raw(api_token, zone_id, record_id, new_ip, &curl);
+	return DDNS_ERROR_OK;
+}
 
-	curl_easy_cleanup(curl);
+DDNS_PUB void ddns_async_destroy(ddns_async* const async) DDNS_NOEXCEPT {
+	if (async == nullptr) {
+		return;
+	}
 
-	if (error) {
-		return error;
+	for (ddns_async** link = &async->client->asyncs; *link != nullptr; link = &(*link)->next) {
+		if (*link == async) {
+			*link = async->next;
+			break;
+		}
 	}
 
-	const std::optional record_ip_sv = priv::get_json_value(std::string_view(response.buffer, response.size), "\"content\"");
-	if (!record_ip_sv.has_value()) {
-		return DDNS_ERROR_GENERIC;
+	// The event loop isn't told about the sockets closed here
+	curl_multi_setopt(async->engine.multi, CURLMOPT_SOCKETFUNCTION, nullptr);
+	curl_multi_setopt(async->engine.multi, CURLMOPT_TIMERFUNCTION, nullptr);
+	priv::engine_cleanup(async->engine);
+
+	while (priv::operation* const op = async->operations) {
+		async->operations = op->next_allocated;
+		delete op->search_state;
+		delete op;
 	}
+	delete async;
+}
 
-	if (record_ip_sv->length() >= record_ip_size) {
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_set_callbacks(
+	ddns_async* DDNS_RESTRICT async,
+	const ddns_socket_callback socket_callback,
+	const ddns_timer_callback timer_callback,
+	void* const user
+) DDNS_NOEXCEPT {
+	if (socket_callback == nullptr || timer_callback == nullptr || async->pending != 0) {
 		return DDNS_ERROR_USAGE;
 	}
 
-	std::memcpy(record_ip, record_ip_sv->data(), record_ip_sv->length());
-	record_ip[record_ip_sv->length()] = '\0';
+	async->socket_callback = socket_callback;
+	async->timer_callback = timer_callback;
+	async->user = user;
+
+	CURLM* const multi {async->engine.multi};
+	curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, priv::async_socket);
+	curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, async);
+	curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, priv::async_timer);
+	curl_multi_setopt(multi, CURLMOPT_TIMERDATA, async);
 
 	return DDNS_ERROR_OK;
 }
 
-DDNS_NODISCARD ddns_error ddns_update_record_raw(
-	const char* DDNS_RESTRICT api_token,
-	const char* DDNS_RESTRICT zone_id,
-	const char* DDNS_RESTRICT record_id,
-	const char* DDNS_RESTRICT new_ip,
-	void**      DDNS_RESTRICT curl
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_socket_action(
+	ddns_async* DDNS_RESTRICT async,
+	const ddns_socket socket,
+	const int events
 ) DDNS_NOEXCEPT {
-	const std::size_t new_ip_length {std::strlen(new_ip)};
+	if (async->socket_callback == nullptr) {
+		return DDNS_ERROR_USAGE;
+	}
+
+	int still_running {0};
+	CURLMcode code {CURLM_OK};
+	if (socket == DDNS_SOCKET_TIMEOUT) {
+		// The timer is gone, so it's set again afterwards even if it
+		// doesn't change. If curl's one was due, curl sets a new one.
+		async->timer_at = -2;
+		if (async->curl_timer_at >= 0 && async->curl_timer_at <= priv::steady_ms()) {
+			async->curl_timer_at = -1;
+		}
+		code = curl_multi_socket_action(async->engine.multi, CURL_SOCKET_TIMEOUT, 0, &still_running);
+	}
+	else {
+		int mask {0};
+		if ((events & DDNS_POLL_IN) != 0) {
+			mask |= CURL_CSELECT_IN;
+		}
+		if ((events & DDNS_POLL_OUT) != 0) {
+			mask |= CURL_CSELECT_OUT;
+		}
+		if ((events & DDNS_POLL_ERROR) != 0) {
+			mask |= CURL_CSELECT_ERR;
+		}
+		code = curl_multi_socket_action(async->engine.multi, static_cast<curl_socket_t>(socket), mask, &still_running);
+	}
 
-	if (std::strlen(api_token) != DDNS_API_TOKEN_LENGTH || std::strlen(zone_id) != DDNS_ZONE_ID_LENGTH || std::strlen(record_id) != DDNS_RECORD_ID_LENGTH || new_ip_length > DDNS_IP_ADDRESS_MAX_LENGTH) {
+	priv::async_progress(*async);
+
+	return code == CURLM_OK ? DDNS_ERROR_OK : DDNS_ERROR_GENERIC;
+}
+
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_poll(
+	ddns_async* DDNS_RESTRICT async,
+	const int timeout_ms
+) DDNS_NOEXCEPT {
+	if (async->socket_callback != nullptr || timeout_ms < 0) {
 		return DDNS_ERROR_USAGE;
 	}
+	if (async->pending == 0) {
+		return DDNS_ERROR_OK;
+	}
 
-	curl_slist* free_me_doh {priv::curl_doh_setup(curl)};
-	curl_slist* free_me_headers {priv::curl_auth_setup(curl, api_token)};
+	// Wake up in time for the next request waiting to be sent again, and
+	// don't wait at all for the operations already done
+	int wait_ms {timeout_ms};
+	const std::int64_t retry_at {priv::engine_next_retry(async->engine)};
+	if (retry_at != 0) {
+		wait_ms = static_cast<int>(std::clamp<std::int64_t>(retry_at - priv::steady_ms(), 0, wait_ms));
+	}
+	if (async->engine.completed != nullptr) {
+		wait_ms = 0;
+	}
 
-	constexpr std::string_view dns_records_url {"/dns_records/"};
+#if LIBCURL_VERSION_NUM >= 0x074200
+	CURLMcode code {curl_multi_poll(async->engine.multi, nullptr, 0, wait_ms, nullptr)};
+#else
+	CURLMcode code {curl_multi_wait(async->engine.multi, nullptr, 0, wait_ms, nullptr)};
+#endif
+	int still_running {0};
+	if (code == CURLM_OK) {
+		code = curl_multi_perform(async->engine.multi, &still_running);
+	}
 
-	constexpr std::size_t request_url_length {
-		base_url.length() +
-		DDNS_ZONE_ID_LENGTH +
-		dns_records_url.length() +
-		DDNS_RECORD_ID_LENGTH
-	};
+	priv::async_progress(*async);
 
-	// +1 because of '\0'
-	char request_url[request_url_length + 1U];
+	return code == CURLM_OK ? DDNS_ERROR_OK : DDNS_ERROR_GENERIC;
+}
 
-	// Concatenate the strings to make the request url
-	std::memcpy(request_url, base_url.data(), base_url.length());
-	std::memcpy(request_url + base_url.length(), zone_id, DDNS_ZONE_ID_LENGTH);
-	std::memcpy(request_url + base_url.length() + DDNS_ZONE_ID_LENGTH, dns_records_url.data(), dns_records_url.length());
-	std::memcpy(request_url + base_url.length() + DDNS_ZONE_ID_LENGTH + dns_records_url.length(), record_id, DDNS_RECORD_ID_LENGTH);
-	request_url[request_url_length] = '\0';
+DDNS_NODISCARD DDNS_PUB size_t ddns_async_pending(const ddns_async* DDNS_RESTRICT async) DDNS_NOEXCEPT {
+	return async->pending;
+}
 
-	constexpr std::string_view request_body_start {R"({"content": ")"};
-	constexpr std::string_view request_body_end {"\"}"};
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_get_local_ip(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_local_ip* DDNS_RESTRICT local_ip,
+	const ddns_async_callback callback,
+	void* const user
+) DDNS_NOEXCEPT {
+	priv::operation* const op {priv::async_operation(*async)};
+	if (op == nullptr) {
+		return DDNS_ERROR_GENERIC;
+	}
 
-	constexpr std::size_t request_body_capacity {
-		request_body_start.length() +
-		DDNS_IP_ADDRESS_MAX_LENGTH +
-		request_body_end.length()
-	};
+	op->error = &local_ip->error;
+	op->search = nullptr;
+	priv::async_start(*async, *op, {priv::local_ips_prepare, priv::local_ips_finish}, 1, local_ip, callback, user);
 
-	const std::size_t request_body_length {
-		request_body_start.length() +
-		new_ip_length +
-		request_body_end.length()
-	};
+	return DDNS_ERROR_OK;
+}
 
-	// This request buffer needs to be valid when calling curl_easy_perform()
-	char request_body [request_body_capacity + 1];
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_get_records(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_record_query* DDNS_RESTRICT query,
+	const ddns_async_callback callback,
+	void* const user
+) DDNS_NOEXCEPT {
+	priv::operation* const op {priv::async_operation(*async)};
+	if (op == nullptr) {
+		return DDNS_ERROR_GENERIC;
+	}
 
-	// Concatenate the strings to make the request body
-	std::memcpy(request_body, request_body_start.data(), request_body_start.length());
-	std::memcpy(request_body + request_body_start.length(), new_ip, new_ip_length);
-	std::memcpy(request_body + request_body_start.length() + new_ip_length, request_body_end.data(), request_body_end.length());
-	request_body[request_body_length] = '\0';
+	op->error = &query->error;
+	op->search = nullptr;
+	priv::async_start(*async, *op, {priv::get_records_prepare, priv::get_records_finish}, 1, query, callback, user);
 
-	priv::curl_patch_setup(
-		curl,
-		request_url,
-		request_body
-	);
+	return DDNS_ERROR_OK;
+}
 
-	const int curl_error {curl_easy_perform(*curl)};
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_search_zone_id(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_zone_search* DDNS_RESTRICT search,
+	const ddns_async_callback callback,
+	void* const user
+) DDNS_NOEXCEPT {
+	priv::operation* const op {priv::async_operation(*async)};
+	if (op == nullptr) {
+		return DDNS_ERROR_GENERIC;
+	}
+	// Kept along with the operation, which is recycled
+	if (op->search_state == nullptr) {
+		op->search_state = new (std::nothrow) priv::zone_search;
+		if (op->search_state == nullptr) {
+			op->next_free = async->free_operations;
+			async->free_operations = op;
+			return DDNS_ERROR_GENERIC;
+		}
+	}
 
-	curl_easy_setopt(*curl, CURLOPT_HTTPHEADER, nullptr);
-	curl_slist_free_all(free_me_headers);
+	op->error = &search->error;
+	op->search = search;
+	priv::zone_search& state {*op->search_state};
+	op->search_error = priv::zone_search_begin(async->client, state, search->api_token, search->record_name);
+	if (op->search_error) {
+		state.pending_size = 0;
+	}
+	priv::async_start(*async, *op, {priv::search_zone_prepare, priv::search_zone_finish}, state.pending_size, state.pending, callback, user);
 
-	curl_easy_setopt(*curl, CURLOPT_RESOLVE, nullptr);
-	curl_slist_free_all(free_me_doh);
+	return DDNS_ERROR_OK;
+}
 
-	if (curl_error) {
+DDNS_NODISCARD DDNS_PUB ddns_error ddns_async_update_record(
+	ddns_async* DDNS_RESTRICT async,
+	ddns_record_update* DDNS_RESTRICT update,
+	const ddns_async_callback callback,
+	void* const user
+) DDNS_NOEXCEPT {
+	priv::operation* const op {priv::async_operation(*async)};
+	if (op == nullptr) {
 		return DDNS_ERROR_GENERIC;
 	}
 
+	op->error = &update->error;
+	op->search = nullptr;
+	priv::async_start(*async, *op, {priv::update_records_prepare, priv::update_records_finish}, 1, update, callback, user);
+
 	return DDNS_ERROR_OK;
 }
 
@@ -0,0 +1,896 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * A small incremental JSON parser, used to read the responses of
+ * Cloudflare's API while they're being received. The tokenizer is fed
+ * with chunks of any size, straight from the curl write callback, and
+ * reports what it finds to a handler in a single linear pass, without
+ * ever allocating: nesting is tracked with a bit set, and only the
+ * string or number being read is buffered, in a fixed-size array.
+ */
+
+#pragma once
+
+#include <ddns/cloudflare-ddns.h>
+
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::uint32_t, std::uint64_t */
+#include <cstring> /* std::memcpy */
+#include <limits> /* std::numeric_limits */
+#include <string_view> /* std::string_view */
+
+namespace priv::json {
+
+/*
+ * Reports the tokens of a JSON document to Derived, which must implement
+ * these functions:
+ *
+ *     void on_object_start();
+ *     void on_object_end();
+ *     void on_array_start();
+ *     void on_array_end();
+ *     void on_key(std::string_view key, bool truncated);
+ *     void on_string(std::string_view value, bool truncated);
+ *     void on_number(std::string_view value);
+ *     void on_bool(bool value);
+ *     void on_null();
+ *
+ * While a container starts or ends, depth() is the depth of that
+ * container, starting from 1; for everything else, it is the depth of the
+ * container holding the token. Strings longer than scratch_capacity are
+ * truncated, and are reported as such.
+ */
+template <typename Derived>
+class tokenizer {
+public:
+	static constexpr std::size_t max_depth {64U};
+	static constexpr std::size_t scratch_capacity {512U};
+
+	/*
+	 * Parses the next chunk of the document, returning false as soon as
+	 * the document turns out to be malformed
+	 */
+	bool feed(const char* data, std::size_t size) noexcept;
+
+	/*
+	 * Must be called after the last chunk, and returns whether the
+	 * document was complete and valid
+	 */
+	bool finish() noexcept;
+
+	bool failed() const noexcept {
+		return state_ == state::error;
+	}
+
+	/*
+	 * Whether a whole document has been parsed. Unlike finish(), it
+	 * doesn't know if a number at the top level is over.
+	 */
+	bool complete() const noexcept {
+		return state_ == state::done;
+	}
+
+	std::size_t depth() const noexcept {
+		return depth_;
+	}
+
+	/*
+	 * Whether the container at depth, which must not be 0, is an array
+	 */
+	bool is_array(const std::size_t depth) const noexcept {
+		return ((arrays_ >> (depth - 1U)) & 1U) != 0;
+	}
+
+protected:
+	/*
+	 * Gets the tokenizer ready to parse a new document
+	 */
+	void reset_tokenizer() noexcept {
+		state_ = state::value;
+		depth_ = 0;
+		arrays_ = 0;
+		scratch_size_ = 0;
+	}
+
+private:
+	enum class state : unsigned char {
+		value,          // expecting a value
+		first_value,    // right after '[', expecting a value or ']'
+		first_key,      // right after '{', expecting a key or '}'
+		key,            // right after ',' in an object
+		colon,
+		after_value,    // expecting ',' or the end of the container
+		string,
+		string_escape,
+		string_unicode,
+		number,
+		literal,
+		done,
+		error
+	};
+
+	enum class literal_kind : unsigned char {
+		true_,
+		false_,
+		null
+	};
+
+	Derived& derived() noexcept {
+		return static_cast<Derived&>(*this);
+	}
+
+	static bool is_space(const char c) noexcept {
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	void append(const char* const data, const std::size_t size) noexcept {
+		const std::size_t room {scratch_capacity - scratch_size_};
+		if (size > room) {
+			truncated_ = true;
+		}
+		const std::size_t copied {size < room ? size : room};
+		std::memcpy(scratch_ + scratch_size_, data, copied);
+		scratch_size_ += copied;
+	}
+
+	void append(const char c) noexcept {
+		append(&c, 1U);
+	}
+
+	void append_code_point(const std::uint32_t code_point) noexcept;
+
+	void flush_high_surrogate() noexcept {
+		if (high_surrogate_ != 0) {
+			// A lone surrogate, replaced with U+FFFD
+			append_code_point(0xFFFDU);
+			high_surrogate_ = 0;
+		}
+	}
+
+	std::string_view scratch() const noexcept {
+		return {scratch_, scratch_size_};
+	}
+
+	bool push(const bool array) noexcept {
+		if (depth_ == max_depth) {
+			state_ = state::error;
+			return false;
+		}
+		if (array) {
+			arrays_ |= std::uint64_t{1} << depth_;
+		}
+		else {
+			arrays_ &= ~(std::uint64_t{1} << depth_);
+		}
+		++depth_;
+		return true;
+	}
+
+	void end_value() noexcept {
+		state_ = depth_ == 0 ? state::done : state::after_value;
+	}
+
+	void end_container(const bool array) noexcept {
+		if (array) {
+			derived().on_array_end();
+		}
+		else {
+			derived().on_object_end();
+		}
+		--depth_;
+		end_value();
+	}
+
+	void begin_value(char c) noexcept;
+	void end_number() noexcept;
+
+	state state_ {state::value};
+	bool string_is_key_ {false};
+	bool truncated_ {false};
+	literal_kind literal_kind_ {literal_kind::null};
+	// Remaining chars of the true, false or null literal being read
+	const char* literal_ {nullptr};
+	std::size_t depth_ {0};
+	// Bit i is set if the container at depth i + 1 is an array
+	std::uint64_t arrays_ {0};
+	std::uint32_t code_point_ {0};
+	std::uint32_t high_surrogate_ {0};
+	unsigned char unicode_digits_ {0};
+	std::size_t scratch_size_ {0};
+	char scratch_[scratch_capacity];
+};
+
+template <typename Derived>
+void tokenizer<Derived>::append_code_point(const std::uint32_t code_point) noexcept {
+	char utf8[4];
+	std::size_t length;
+	if (code_point < 0x80U) {
+		utf8[0] = static_cast<char>(code_point);
+		length = 1;
+	}
+	else if (code_point < 0x800U) {
+		utf8[0] = static_cast<char>(0xC0U | (code_point >> 6U));
+		utf8[1] = static_cast<char>(0x80U | (code_point & 0x3FU));
+		length = 2;
+	}
+	else if (code_point < 0x10000U) {
+		utf8[0] = static_cast<char>(0xE0U | (code_point >> 12U));
+		utf8[1] = static_cast<char>(0x80U | ((code_point >> 6U) & 0x3FU));
+		utf8[2] = static_cast<char>(0x80U | (code_point & 0x3FU));
+		length = 3;
+	}
+	else {
+		utf8[0] = static_cast<char>(0xF0U | (code_point >> 18U));
+		utf8[1] = static_cast<char>(0x80U | ((code_point >> 12U) & 0x3FU));
+		utf8[2] = static_cast<char>(0x80U | ((code_point >> 6U) & 0x3FU));
+		utf8[3] = static_cast<char>(0x80U | (code_point & 0x3FU));
+		length = 4;
+	}
+	append(utf8, length);
+}
+
+template <typename Derived>
+void tokenizer<Derived>::begin_value(const char c) noexcept {
+	switch (c) {
+	case '{':
+		if (push(false)) {
+			state_ = state::first_key;
+			derived().on_object_start();
+		}
+		break;
+	case '[':
+		if (push(true)) {
+			state_ = state::first_value;
+			derived().on_array_start();
+		}
+		break;
+	case '"':
+		string_is_key_ = false;
+		truncated_ = false;
+		scratch_size_ = 0;
+		state_ = state::string;
+		break;
+	case 't':
+		literal_ = "rue";
+		literal_kind_ = literal_kind::true_;
+		state_ = state::literal;
+		break;
+	case 'f':
+		literal_ = "alse";
+		literal_kind_ = literal_kind::false_;
+		state_ = state::literal;
+		break;
+	case 'n':
+		literal_ = "ull";
+		literal_kind_ = literal_kind::null;
+		state_ = state::literal;
+		break;
+	default:
+		if (c == '-' || (c >= '0' && c <= '9')) {
+			truncated_ = false;
+			scratch_size_ = 0;
+			append(c);
+			state_ = state::number;
+		}
+		else {
+			state_ = state::error;
+		}
+	}
+}
+
+template <typename Derived>
+void tokenizer<Derived>::end_number() noexcept {
+	// Numbers are never that long, unless the document is malformed
+	if (truncated_) {
+		state_ = state::error;
+		return;
+	}
+	derived().on_number(scratch());
+	end_value();
+}
+
+template <typename Derived>
+bool tokenizer<Derived>::feed(const char* const data, const std::size_t size) noexcept {
+	const char* it {data};
+	const char* const end {data + size};
+
+	while (it != end) {
+		const char c {*it};
+
+		switch (state_) {
+		case state::value:
+			if (!is_space(c)) {
+				begin_value(c);
+			}
+			break;
+
+		case state::first_value:
+			if (c == ']') {
+				end_container(true);
+			}
+			else if (!is_space(c)) {
+				begin_value(c);
+			}
+			break;
+
+		case state::first_key:
+			if (c == '}') {
+				end_container(false);
+				break;
+			}
+			[[fallthrough]];
+		case state::key:
+			if (c == '"') {
+				string_is_key_ = true;
+				truncated_ = false;
+				scratch_size_ = 0;
+				state_ = state::string;
+			}
+			else if (!is_space(c)) {
+				state_ = state::error;
+			}
+			break;
+
+		case state::colon:
+			if (c == ':') {
+				state_ = state::value;
+			}
+			else if (!is_space(c)) {
+				state_ = state::error;
+			}
+			break;
+
+		case state::after_value:
+			if (c == ',') {
+				state_ = is_array(depth_) ? state::value : state::key;
+			}
+			else if (c == ']' || c == '}') {
+				if (is_array(depth_) == (c == ']')) {
+					end_container(c == ']');
+				}
+				else {
+					state_ = state::error;
+				}
+			}
+			else if (!is_space(c)) {
+				state_ = state::error;
+			}
+			break;
+
+		case state::string: {
+			// Copy the whole run of plain chars at once
+			const char* run_end {it};
+			while (run_end != end && *run_end != '"' && *run_end != '\\' && static_cast<unsigned char>(*run_end) >= 0x20U) {
+				++run_end;
+			}
+			if (run_end != it) {
+				flush_high_surrogate();
+				append(it, static_cast<std::size_t>(run_end - it));
+				it = run_end;
+				continue;
+			}
+
+			if (c == '\\') {
+				state_ = state::string_escape;
+			}
+			else if (c == '"') {
+				flush_high_surrogate();
+				if (string_is_key_) {
+					derived().on_key(scratch(), truncated_);
+					state_ = state::colon;
+				}
+				else {
+					derived().on_string(scratch(), truncated_);
+					end_value();
+				}
+			}
+			else {
+				// Control characters must be escaped
+				state_ = state::error;
+			}
+			break;
+		}
+
+		case state::string_escape: {
+			state_ = state::string;
+			char unescaped;
+			switch (c) {
+			case '"': unescaped = '"'; break;
+			case '\\': unescaped = '\\'; break;
+			case '/': unescaped = '/'; break;
+			case 'b': unescaped = '\b'; break;
+			case 'f': unescaped = '\f'; break;
+			case 'n': unescaped = '\n'; break;
+			case 'r': unescaped = '\r'; break;
+			case 't': unescaped = '\t'; break;
+			case 'u':
+				code_point_ = 0;
+				unicode_digits_ = 0;
+				state_ = state::string_unicode;
+				break;
+			default:
+				state_ = state::error;
+			}
+			if (state_ == state::string) {
+				flush_high_surrogate();
+				append(unescaped);
+			}
+			break;
+		}
+
+		case state::string_unicode: {
+			std::uint32_t digit;
+			if (c >= '0' && c <= '9') {
+				digit = static_cast<std::uint32_t>(c - '0');
+			}
+			else if (c >= 'a' && c <= 'f') {
+				digit = static_cast<std::uint32_t>(c - 'a' + 10);
+			}
+			else if (c >= 'A' && c <= 'F') {
+				digit = static_cast<std::uint32_t>(c - 'A' + 10);
+			}
+			else {
+				state_ = state::error;
+				break;
+			}
+			code_point_ = (code_point_ << 4U) | digit;
+			if (++unicode_digits_ != 4U) {
+				break;
+			}
+
+			state_ = state::string;
+			if (code_point_ >= 0xD800U && code_point_ <= 0xDBFFU) {
+				flush_high_surrogate();
+				high_surrogate_ = code_point_;
+			}
+			else if (code_point_ >= 0xDC00U && code_point_ <= 0xDFFFU && high_surrogate_ != 0) {
+				append_code_point(0x10000U + ((high_surrogate_ - 0xD800U) << 10U) + (code_point_ - 0xDC00U));
+				high_surrogate_ = 0;
+			}
+			else {
+				flush_high_surrogate();
+				append_code_point(code_point_ >= 0xDC00U && code_point_ <= 0xDFFFU ? 0xFFFDU : code_point_);
+			}
+			break;
+		}
+
+		case state::number:
+			if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+				append(c);
+				break;
+			}
+			end_number();
+			// The char ending the number belongs to what comes next
+			continue;
+
+		case state::literal:
+			if (c != *literal_) {
+				state_ = state::error;
+				break;
+			}
+			if (*++literal_ == '\0') {
+				if (literal_kind_ == literal_kind::null) {
+					derived().on_null();
+				}
+				else {
+					derived().on_bool(literal_kind_ == literal_kind::true_);
+				}
+				end_value();
+			}
+			break;
+
+		case state::done:
+			if (!is_space(c)) {
+				state_ = state::error;
+			}
+			break;
+
+		case state::error:
+			return false;
+		}
+
+		++it;
+	}
+
+	return state_ != state::error;
+}
+
+template <typename Derived>
+bool tokenizer<Derived>::finish() noexcept {
+	// A number is only over once something else comes
+	if (state_ == state::number && depth_ == 0) {
+		end_number();
+	}
+	return state_ == state::done;
+}
+
+/*
+ * An A or AAAA record, or any other object found in the result of an API
+ * response, like a zone. Fields missing from the object are empty, and so
+ * are the ones too long to fit, which are also marked as overflown.
+ */
+struct record {
+	enum field : unsigned {
+		id = 1U << 0U,
+		name = 1U << 1U,
+		type = 1U << 2U,
+		content = 1U << 3U,
+		ttl = 1U << 4U,
+		proxied = 1U << 5U
+	};
+
+	char id_value[DDNS_RECORD_ID_LENGTH + 1U];
+	std::size_t id_length;
+	char name_value[DDNS_RECORD_NAME_MAX_LENGTH + 1U];
+	std::size_t name_length;
+	// Longer than any record type
+	char type_value[16];
+	std::size_t type_length;
+	char content_value[DDNS_IP_ADDRESS_MAX_LENGTH];
+	std::size_t content_length;
+	long long ttl_value;
+	bool proxied_value;
+	// Bit sets of field
+	unsigned found;
+	unsigned overflown;
+
+	void clear() noexcept {
+		id_length = name_length = type_length = content_length = 0;
+		id_value[0] = name_value[0] = type_value[0] = content_value[0] = '\0';
+		ttl_value = 0;
+		proxied_value = false;
+		found = overflown = 0;
+	}
+
+	bool has(const unsigned fields) const noexcept {
+		return (found & fields) == fields && (overflown & fields) == 0;
+	}
+
+	std::string_view id_sv() const noexcept {
+		return {id_value, id_length};
+	}
+
+	std::string_view name_sv() const noexcept {
+		return {name_value, name_length};
+	}
+
+	std::string_view type_sv() const noexcept {
+		return {type_value, type_length};
+	}
+
+	std::string_view content_sv() const noexcept {
+		return {content_value, content_length};
+	}
+
+	bool is_address() const noexcept {
+		return type_sv() == "A" || type_sv() == "AAAA";
+	}
+};
+
+/*
+ * Reads the envelope of Cloudflare's API responses, that is success,
+ * errors and result, in a single pass. Every object found in result is
+ * passed to the callback as a record once it ends: the elements of result
+ * if it's an array, result itself if it's an object, and the elements of
+ * the arrays of result, like the patches of a batch request. Keys of
+ * nested objects, like meta, never get mixed up with the ones of records.
+ */
+class response_parser : public tokenizer<response_parser> {
+public:
+	using record_callback = void (*)(void* user, const record& record);
+
+	static constexpr std::size_t error_message_capacity {128U};
+
+	response_parser() noexcept {
+		reset(nullptr, nullptr);
+	}
+
+	response_parser(const record_callback callback, void* const user) noexcept {
+		reset(callback, user);
+	}
+
+	/*
+	 * Gets the parser ready to parse a new response
+	 */
+	void reset(const record_callback callback, void* const user) noexcept {
+		reset_tokenizer();
+		callback_ = callback;
+		user_ = user;
+		section_ = section::none;
+		field_ = field::none;
+		record_depth_ = 0;
+		error_depth_ = 0;
+		result_is_object_ = false;
+		success_ = false;
+		records_ = 0;
+		errors_ = 0;
+		error_code_ = 0;
+		error_message_[0] = '\0';
+		record_.clear();
+	}
+
+	/*
+	 * Whether the response was valid and said "success": true. Must be
+	 * called once the whole response has been fed.
+	 */
+	bool success() const noexcept {
+		return complete() && success_;
+	}
+
+	/*
+	 * Number of objects found in result
+	 */
+	std::size_t records() const noexcept {
+		return records_;
+	}
+
+	std::size_t errors() const noexcept {
+		return errors_;
+	}
+
+	/*
+	 * Code and message of the first error, or 0 and "" if there's none
+	 */
+	long long error_code() const noexcept {
+		return error_code_;
+	}
+
+	const char* error_message() const noexcept {
+		return error_message_;
+	}
+
+	void on_object_start() noexcept;
+	void on_object_end() noexcept;
+	void on_array_start() noexcept {
+		field_ = field::none;
+	}
+	void on_array_end() noexcept {}
+	void on_key(std::string_view key, bool truncated) noexcept;
+	void on_string(std::string_view value, bool truncated) noexcept;
+	void on_number(std::string_view value) noexcept;
+	void on_bool(bool value) noexcept;
+	void on_null() noexcept {
+		field_ = field::none;
+	}
+
+private:
+	enum class section : unsigned char {
+		none,
+		success,
+		errors,
+		result
+	};
+
+	enum class field : unsigned char {
+		none,
+		id,
+		name,
+		type,
+		content,
+		ttl,
+		proxied,
+		error_code,
+		error_message
+	};
+
+	static bool copy(const std::string_view value, const bool truncated, char* const destination, const std::size_t capacity, std::size_t& length) noexcept {
+		// Leave room for '\0'
+		if (truncated || value.length() >= capacity) {
+			destination[0] = '\0';
+			length = 0;
+			return false;
+		}
+		std::memcpy(destination, value.data(), value.length());
+		destination[value.length()] = '\0';
+		length = value.length();
+		return true;
+	}
+
+	record_callback callback_;
+	void* user_;
+	section section_;
+	field field_;
+	// Depth of the record or error being read, or 0
+	std::size_t record_depth_;
+	std::size_t error_depth_;
+	bool result_is_object_;
+	bool success_;
+	std::size_t records_;
+	std::size_t errors_;
+	long long error_code_;
+	char error_message_[error_message_capacity];
+	record record_;
+};
+
+inline void response_parser::on_object_start() noexcept {
+	const std::size_t current {depth()};
+	field_ = field::none;
+
+	if (section_ == section::result) {
+		if (current == 2U) {
+			result_is_object_ = true;
+			record_depth_ = 2U;
+			record_.clear();
+		}
+		// Elements of result, or of the arrays of result
+		else if ((current == 3U && is_array(2U)) || (current == 4U && result_is_object_ && is_array(3U))) {
+			record_depth_ = current;
+			record_.clear();
+		}
+	}
+	else if (section_ == section::errors && current == 3U && is_array(2U)) {
+		error_depth_ = current;
+		++errors_;
+	}
+}
+
+inline void response_parser::on_object_end() noexcept {
+	const std::size_t current {depth()};
+
+	if (record_depth_ == current && record_depth_ != 0) {
+		++records_;
+		if (callback_ != nullptr) {
+			callback_(user_, record_);
+		}
+		record_.clear();
+		// Back to the result object holding the array, if any
+		record_depth_ = result_is_object_ && current != 2U ? 2U : 0U;
+	}
+	else if (error_depth_ == current && error_depth_ != 0) {
+		error_depth_ = 0;
+	}
+	field_ = field::none;
+}
+
+inline void response_parser::on_key(const std::string_view key, const bool /*truncated*/) noexcept {
+	const std::size_t current {depth()};
+	field_ = field::none;
+
+	if (current == 1U) {
+		if (key == "success") {
+			section_ = section::success;
+		}
+		else if (key == "errors") {
+			section_ = section::errors;
+		}
+		else if (key == "result") {
+			section_ = section::result;
+		}
+		else {
+			section_ = section::none;
+		}
+	}
+	else if (record_depth_ == current) {
+		if (key == "id") {
+			field_ = field::id;
+		}
+		else if (key == "name") {
+			field_ = field::name;
+		}
+		else if (key == "type") {
+			field_ = field::type;
+		}
+		else if (key == "content") {
+			field_ = field::content;
+		}
+		else if (key == "ttl") {
+			field_ = field::ttl;
+		}
+		else if (key == "proxied") {
+			field_ = field::proxied;
+		}
+	}
+	else if (error_depth_ == current) {
+		if (key == "code") {
+			field_ = field::error_code;
+		}
+		else if (key == "message") {
+			field_ = field::error_message;
+		}
+	}
+}
+
+inline void response_parser::on_string(const std::string_view value, const bool truncated) noexcept {
+	const std::size_t current {depth()};
+
+	if (record_depth_ == current) {
+		unsigned flag {0};
+		bool fits {true};
+		switch (field_) {
+		case field::id:
+			flag = record::id;
+			fits = copy(value, truncated, record_.id_value, sizeof record_.id_value, record_.id_length);
+			break;
+		case field::name:
+			flag = record::name;
+			fits = copy(value, truncated, record_.name_value, sizeof record_.name_value, record_.name_length);
+			break;
+		case field::type:
+			flag = record::type;
+			fits = copy(value, truncated, record_.type_value, sizeof record_.type_value, record_.type_length);
+			break;
+		case field::content:
+			flag = record::content;
+			fits = copy(value, truncated, record_.content_value, sizeof record_.content_value, record_.content_length);
+			break;
+		default:
+			break;
+		}
+		record_.found |= flag;
+		if (!fits) {
+			record_.overflown |= flag;
+		}
+	}
+	else if (error_depth_ == current && field_ == field::error_message && errors_ == 1U) {
+		// Error messages are only informative, so they can be cut
+		const std::size_t length {value.length() < error_message_capacity ? value.length() : error_message_capacity - 1U};
+		std::memcpy(error_message_, value.data(), length);
+		error_message_[length] = '\0';
+	}
+
+	field_ = field::none;
+}
+
+inline void response_parser::on_number(const std::string_view value) noexcept {
+	const std::size_t current {depth()};
+	const bool ttl {record_depth_ == current && field_ == field::ttl};
+	const bool error_code {error_depth_ == current && field_ == field::error_code && errors_ == 1U};
+	field_ = field::none;
+
+	// Numbers of the other fields, like the counts of result_info, can be
+	// of any size, and aren't read at all
+	if (!ttl && !error_code) {
+		return;
+	}
+
+	// Only integers are expected, and ones not fitting a long long aren't
+	constexpr long long max {std::numeric_limits<long long>::max()};
+	long long number {0};
+	bool negative {false};
+	bool integer {!value.empty()};
+	for (std::size_t i = 0; i < value.length() && integer; ++i) {
+		if (i == 0 && value[i] == '-') {
+			negative = true;
+		}
+		else if (value[i] >= '0' && value[i] <= '9' && number <= (max - (value[i] - '0')) / 10) {
+			number = number * 10 + (value[i] - '0');
+		}
+		else {
+			integer = false;
+		}
+	}
+	if (!integer) {
+		return;
+	}
+	if (negative) {
+		number = -number;
+	}
+
+	if (ttl) {
+		record_.ttl_value = number;
+		record_.found |= record::ttl;
+	}
+	else {
+		error_code_ = number;
+	}
+}
+
+inline void response_parser::on_bool(const bool value) noexcept {
+	const std::size_t current {depth()};
+
+	if (current == 1U && section_ == section::success) {
+		success_ = value;
+	}
+	else if (record_depth_ == current && field_ == field::proxied) {
+		record_.proxied_value = value;
+		record_.found |= record::proxied;
+	}
+
+	field_ = field::none;
+}
+
+} // namespace priv::json
@@ -0,0 +1,314 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * Reads the addresses assigned to the network interfaces over rtnetlink,
+ * so that the public address of the machine can be known without asking
+ * a remote server, when the machine has one, and waits for them to change.
+ */
+
+#pragma once
+
+#include <ddns/cloudflare-ddns.h>
+
+#include <chrono> /* std::chrono::steady_clock */
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::uint32_t */
+#include <cstring> /* std::memcpy, std::strlen */
+
+#ifdef __linux__
+#	include <arpa/inet.h> /* inet_ntop */
+#	include <cerrno> /* errno, EINTR, ENOBUFS */
+#	include <linux/netlink.h> /* sockaddr_nl, nlmsghdr, NLMSG_* */
+#	include <linux/rtnetlink.h> /* ifaddrmsg, rtattr, RTM_*, RTMGRP_*, IFA_* */
+#	include <poll.h> /* poll, pollfd */
+#	include <sys/socket.h> /* socket, bind, send, recv */
+#	include <unistd.h> /* close */
+#endif
+
+namespace priv::netlink {
+
+/*
+ * Whether an IPv4 address, in network byte order, can be reached from
+ * the Internet. Private, shared (CGNAT), loopback, link-local,
+ * documentation, benchmarking, multicast and reserved addresses can't.
+ */
+inline bool is_public_ipv4(const unsigned char* const address) noexcept {
+	const unsigned char a {address[0]};
+	const unsigned char b {address[1]};
+	const unsigned char c {address[2]};
+
+	return !(
+		a == 0 ||
+		a == 10 ||
+		(a == 100 && (b & 0xC0U) == 64) ||
+		a == 127 ||
+		(a == 169 && b == 254) ||
+		(a == 172 && (b & 0xF0U) == 16) ||
+		(a == 192 && b == 0 && (c == 0 || c == 2)) ||
+		(a == 192 && b == 88 && c == 99) ||
+		(a == 192 && b == 168) ||
+		(a == 198 && (b & 0xFEU) == 18) ||
+		(a == 198 && b == 51 && c == 100) ||
+		(a == 203 && b == 0 && c == 113) ||
+		a >= 224
+	);
+}
+
+/*
+ * Whether an IPv6 address can be reached from the Internet: only global
+ * unicast addresses (2000::/3) can, except for the documentation range
+ * and for the Teredo and 6to4 ones, which are derived from IPv4
+ * addresses and aren't worth publishing.
+ */
+inline bool is_public_ipv6(const unsigned char* const address) noexcept {
+	if ((address[0] & 0xE0U) != 0x20U) {
+		return false;
+	}
+	const bool teredo {address[0] == 0x20 && address[1] == 0x01 && address[2] == 0x00 && address[3] == 0x00};
+	const bool documentation {address[0] == 0x20 && address[1] == 0x01 && address[2] == 0x0D && address[3] == 0xB8};
+	const bool six_to_four {address[0] == 0x20 && address[1] == 0x02};
+	return !teredo && !documentation && !six_to_four;
+}
+
+#ifdef __linux__
+
+/*
+ * Addresses of family with these flags don't belong in a DNS record:
+ * temporary (privacy) addresses change every few hours, deprecated ones
+ * are being replaced, and tentative or duplicated ones can't be used yet.
+ * IFA_F_TEMPORARY has the value of IFA_F_SECONDARY, which marks the
+ * perfectly usable secondary addresses of an IPv4 subnet, so it only
+ * counts for IPv6.
+ */
+constexpr std::uint32_t unusable_flags(const int family) noexcept {
+	return (family == AF_INET6 ? IFA_F_TEMPORARY : 0U) | IFA_F_DEPRECATED | IFA_F_TENTATIVE | IFA_F_DADFAILED;
+}
+
+/*
+ * Opens a route netlink socket, subscribed to the multicast groups in the
+ * RTMGRP_* bit set groups. Returns -1 on failure.
+ */
+inline int open_socket(const std::uint32_t groups) noexcept {
+	const int fd {socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)};
+	if (fd == -1) {
+		return -1;
+	}
+
+	sockaddr_nl address {};
+	address.nl_family = AF_NETLINK;
+	address.nl_groups = groups;
+	if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof address) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+ * Copies to address the address of an RTM_NEWADDR or RTM_DELADDR message
+ * if it's a global, usable and public one of family, returning whether it
+ * is. address must have room for 16 bytes.
+ */
+inline bool public_address(const nlmsghdr* const message, const int family, unsigned char* const address) noexcept {
+	if (message->nlmsg_len < NLMSG_LENGTH(sizeof(ifaddrmsg))) {
+		return false;
+	}
+
+	const ifaddrmsg* const info {static_cast<const ifaddrmsg*>(NLMSG_DATA(message))};
+	if (info->ifa_family != family || info->ifa_scope != RT_SCOPE_UNIVERSE) {
+		return false;
+	}
+
+	std::uint32_t flags {info->ifa_flags};
+	const void* local {nullptr};
+	const void* peer {nullptr};
+
+	// IFA_RTA() and RTA_NEXT() cast away const
+	rtattr* attribute {IFA_RTA(const_cast<ifaddrmsg*>(info))};
+	int attributes_length {static_cast<int>(IFA_PAYLOAD(message))};
+	for (; RTA_OK(attribute, attributes_length); attribute = RTA_NEXT(attribute, attributes_length)) {
+		switch (attribute->rta_type) {
+		case IFA_LOCAL:
+			local = RTA_DATA(attribute);
+			break;
+		case IFA_ADDRESS:
+			peer = RTA_DATA(attribute);
+			break;
+		case IFA_FLAGS:
+			// The flags that don't fit in ifa_flags
+			std::memcpy(&flags, RTA_DATA(attribute), sizeof flags);
+			break;
+		default:
+			break;
+		}
+	}
+
+	if ((flags & unusable_flags(family)) != 0) {
+		return false;
+	}
+
+	// On point-to-point links IFA_ADDRESS is the address of the other end
+	const void* const found {local != nullptr ? local : peer};
+	if (found == nullptr) {
+		return false;
+	}
+
+	const std::size_t length {family == AF_INET6 ? 16U : 4U};
+	std::memcpy(address, found, length);
+
+	return family == AF_INET6 ? is_public_ipv6(address) : is_public_ipv4(address);
+}
+
+/*
+ * Writes in ip the first public address of family assigned to one of
+ * the network interfaces
+ */
+inline ddns_error get_public_address(const int family, const std::size_t ip_size, char* const ip) noexcept {
+	const int fd {open_socket(0)};
+	if (fd == -1) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	struct {
+		nlmsghdr header;
+		ifaddrmsg body;
+	} request {};
+	request.header.nlmsg_len = NLMSG_LENGTH(sizeof request.body);
+	request.header.nlmsg_type = RTM_GETADDR;
+	request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	request.header.nlmsg_seq = 1;
+	request.body.ifa_family = static_cast<unsigned char>(family);
+
+	if (send(fd, &request, request.header.nlmsg_len, 0) < 0) {
+		close(fd);
+		return DDNS_ERROR_GENERIC;
+	}
+
+	// The kernel sends the dump in messages of up to a page each
+	alignas(nlmsghdr) char buffer[8192];
+	unsigned char address[16];
+	bool found {false};
+	bool done {false};
+
+	while (!found && !done) {
+		const ssize_t received {recv(fd, buffer, sizeof buffer, 0)};
+		if (received <= 0) {
+			break;
+		}
+
+		unsigned int remaining {static_cast<unsigned int>(received)};
+		for (const nlmsghdr* message = reinterpret_cast<const nlmsghdr*>(buffer); NLMSG_OK(message, remaining); message = NLMSG_NEXT(message, remaining)) {
+			if (message->nlmsg_type == NLMSG_DONE || message->nlmsg_type == NLMSG_ERROR) {
+				done = true;
+				break;
+			}
+			if (message->nlmsg_type == RTM_NEWADDR && public_address(message, family, address)) {
+				found = true;
+				break;
+			}
+		}
+	}
+
+	close(fd);
+
+	if (!found) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	char text[DDNS_IP_ADDRESS_MAX_LENGTH];
+	if (inet_ntop(family, address, text, sizeof text) == nullptr) {
+		return DDNS_ERROR_GENERIC;
+	}
+
+	const std::size_t text_length {std::strlen(text)};
+	if (text_length >= ip_size) {
+		return DDNS_ERROR_USAGE;
+	}
+	std::memcpy(ip, text, text_length + 1U);
+
+	return DDNS_ERROR_OK;
+}
+
+/*
+ * Whether a message received from the RTMGRP_IPV4_IFADDR and
+ * RTMGRP_IPV6_IFADDR groups adds or removes a public address
+ */
+inline bool public_address_changed(const nlmsghdr* const message) noexcept {
+	if ((message->nlmsg_type != RTM_NEWADDR && message->nlmsg_type != RTM_DELADDR) || message->nlmsg_len < NLMSG_LENGTH(sizeof(ifaddrmsg))) {
+		return false;
+	}
+	const int family {static_cast<const ifaddrmsg*>(NLMSG_DATA(message))->ifa_family};
+	unsigned char address[16];
+	return public_address(message, family, address);
+}
+
+/*
+ * Waits on a socket opened with open_socket(RTMGRP_IPV4_IFADDR |
+ * RTMGRP_IPV6_IFADDR) until a public address is added or removed, or
+ * until timeout_ms milliseconds pass (forever if negative). Once something
+ * changes, it keeps waiting until debounce_ms milliseconds go by without
+ * any other change, so that a renumbering, which comes as a burst of
+ * messages, is reported only once. Interruptions by a signal, and
+ * wake_fd becoming readable unless it's negative, return early, without
+ * an error.
+ */
+inline ddns_error wait_for_change(const int fd, const int wake_fd, const int timeout_ms, const int debounce_ms, bool& changed) noexcept {
+	using clock = std::chrono::steady_clock;
+
+	changed = false;
+	clock::time_point deadline {clock::now() + std::chrono::milliseconds{timeout_ms}};
+	bool forever {timeout_ms < 0};
+
+	alignas(nlmsghdr) char buffer[8192];
+
+	while (true) {
+		int wait_ms {-1};
+		if (!forever) {
+			const auto left {std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count()};
+			wait_ms = left > 0 ? static_cast<int>(left) : 0;
+		}
+
+		// poll() ignores negative descriptors
+		pollfd poll_fds[2] {{fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+		const int ready {poll(poll_fds, 2, wait_ms)};
+		if (ready == 0 || (ready == -1 && errno == EINTR) || poll_fds[1].revents != 0) {
+			return DDNS_ERROR_OK;
+		}
+		if (ready == -1) {
+			return DDNS_ERROR_GENERIC;
+		}
+
+		bool relevant {false};
+		while (true) {
+			const ssize_t received {recv(fd, buffer, sizeof buffer, MSG_DONTWAIT)};
+			if (received == -1 && errno == ENOBUFS) {
+				// The kernel dropped some messages, which might have been
+				// the ones I care about
+				relevant = true;
+				continue;
+			}
+			if (received <= 0) {
+				break;
+			}
+			unsigned int remaining {static_cast<unsigned int>(received)};
+			for (const nlmsghdr* message = reinterpret_cast<const nlmsghdr*>(buffer); NLMSG_OK(message, remaining); message = NLMSG_NEXT(message, remaining)) {
+				relevant = relevant || public_address_changed(message);
+			}
+		}
+
+		if (relevant) {
+			changed = true;
+			deadline = clock::now() + std::chrono::milliseconds{debounce_ms};
+			forever = false;
+		}
+	}
+}
+
+#endif
+
+} // namespace priv::netlink
@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * Tells whether a name is a public suffix, like "com" or "co.uk", under
+ * which anyone can register a domain, so that it can't be a zone. The
+ * rules come from the ICANN section of the Public Suffix List, turned into
+ * a trie by psl_generator when the library is built.
+ */
+
+#pragma once
+
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::uint8_t, std::uint16_t */
+#include <string_view> /* std::string_view */
+
+namespace priv::psl {
+
+/*
+ * The rules of a node, which psl_generator sets
+ */
+constexpr std::uint8_t flag_rule {1U << 0U};
+// There's a "*.name" rule
+constexpr std::uint8_t flag_wildcard {1U << 1U};
+// There's a "!name" rule
+constexpr std::uint8_t flag_exception {1U << 2U};
+
+/*
+ * A node of the trie, for a label of a rule, starting from the rightmost
+ * one. The children of every node are contiguous and sorted by label.
+ */
+struct node {
+	// In labels
+	std::uint16_t label;
+	std::uint8_t label_length;
+	std::uint8_t flags;
+	// In nodes
+	std::uint16_t first_child;
+	std::uint16_t children_count;
+};
+
+} // namespace priv::psl
+
+// Defines priv::psl::labels and priv::psl::nodes, the first one being the
+// root of the trie
+#include "public_suffix_list.hpp"
+
+namespace priv::psl {
+
+constexpr char to_lower(const char c) noexcept {
+	return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+/*
+ * Compares label with the one of a node, ignoring the case of label
+ */
+constexpr int compare(const std::string_view label, const node& node) noexcept {
+	const std::size_t length {label.size() < node.label_length ? label.size() : node.label_length};
+	for (std::size_t i = 0; i < length; ++i) {
+		const unsigned char a {static_cast<unsigned char>(to_lower(label[i]))};
+		const unsigned char b {static_cast<unsigned char>(labels[node.label + i])};
+		if (a != b) {
+			return a < b ? -1 : 1;
+		}
+	}
+	if (label.size() == node.label_length) {
+		return 0;
+	}
+	return label.size() < node.label_length ? -1 : 1;
+}
+
+/*
+ * The child of parent for label, or nullptr if it has none
+ */
+constexpr const node* find_child(const node& parent, const std::string_view label) noexcept {
+	std::size_t low {parent.first_child};
+	std::size_t high {static_cast<std::size_t>(parent.first_child) + parent.children_count};
+	while (low < high) {
+		const std::size_t middle {low + (high - low) / 2U};
+		const int order {compare(label, nodes[middle])};
+		if (order == 0) {
+			return &nodes[middle];
+		}
+		if (order < 0) {
+			high = middle;
+		}
+		else {
+			low = middle + 1U;
+		}
+	}
+	return nullptr;
+}
+
+/*
+ * Whether name, like "example.co.uk" or "co.uk", is itself a public
+ * suffix. Top level domains always are, as the list has an implicit "*"
+ * rule.
+ */
+constexpr bool is_public_suffix(std::string_view name) noexcept {
+	if (!name.empty() && name.back() == '.') {
+		name.remove_suffix(1);
+	}
+	if (name.empty()) {
+		return false;
+	}
+
+	// Walk the trie from the rightmost label, stopping at the leftmost
+	// one, which is matched by an exact or an exception rule, or by a
+	// wildcard rule of its parent
+	const node* parent {&nodes[0]};
+	for (;;) {
+		const std::size_t dot {name.rfind('.')};
+		const std::string_view label {dot == std::string_view::npos ? name : name.substr(dot + 1U)};
+		const node* const child {find_child(*parent, label)};
+
+		if (dot == std::string_view::npos) {
+			if (child != nullptr && (child->flags & flag_exception) != 0) {
+				return false;
+			}
+			return parent == &nodes[0]
+				|| (parent->flags & flag_wildcard) != 0
+				|| (child != nullptr && (child->flags & flag_rule) != 0);
+		}
+
+		if (child == nullptr) {
+			return false;
+		}
+		parent = child;
+		name.remove_suffix(name.size() - dot);
+	}
+}
+
+} // namespace priv::psl
@@ -0,0 +1,222 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * Turns the ICANN section of the Public Suffix List into a trie of
+ * constexpr arrays, written to a header used by psl.hpp. It runs on the
+ * build machine.
+ *
+ * Usage: psl_generator OUTPUT [public_suffix_list.dat]
+ *
+ * Without a list the trie only has its root, and psl.hpp falls back to
+ * the implicit "*" rule, so that only top level domains are public
+ * suffixes.
+ */
+
+#include <algorithm> /* std::lower_bound */
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::uint8_t, std::uint16_t */
+#include <cstdio> /* std::fprintf, std::snprintf, stderr */
+#include <fstream> /* std::ifstream, std::ofstream */
+#include <map> /* std::map */
+#include <string> /* std::string, std::getline */
+#include <string_view> /* std::string_view */
+#include <utility> /* std::pair */
+#include <vector> /* std::vector */
+
+namespace {
+
+// Must match the ones in psl.hpp
+constexpr std::uint8_t flag_rule {1U << 0U};
+constexpr std::uint8_t flag_wildcard {1U << 1U};
+constexpr std::uint8_t flag_exception {1U << 2U};
+
+struct trie_node {
+	std::string label;
+	// Sorted by label, like psl.hpp searches them. std::vector is the
+	// container that can hold the still incomplete trie_node
+	std::vector<trie_node> children;
+	std::uint8_t flags {0};
+};
+
+/*
+ * The child of node with label, added if it isn't there
+ */
+trie_node& child(trie_node& node, const std::string_view label) {
+	const auto position {std::lower_bound(node.children.begin(), node.children.end(), label, [](const trie_node& child, const std::string_view label) {
+		return child.label < label;
+	})};
+	if (position != node.children.end() && position->label == label) {
+		return *position;
+	}
+	return *node.children.insert(position, trie_node{std::string{label}, {}, 0});
+}
+
+bool is_ascii(const std::string_view string) {
+	for (const char c : string) {
+		if (static_cast<unsigned char>(c) >= 0x80U) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Adds a rule like "co.uk", "*.ck" or "!www.ck", walking its labels from
+ * the rightmost one
+ */
+void add_rule(trie_node& root, std::string_view rule) {
+	std::uint8_t flag {flag_rule};
+	if (rule.front() == '!') {
+		flag = flag_exception;
+		rule.remove_prefix(1);
+	}
+	else if (rule.substr(0, 2) == "*.") {
+		// Wildcards are only allowed as the leftmost label, and they are
+		// stored in the node of the rest of the rule
+		flag = flag_wildcard;
+		rule.remove_prefix(2);
+	}
+
+	trie_node* node {&root};
+	while (!rule.empty()) {
+		const std::size_t dot {rule.rfind('.')};
+		const std::string_view label {dot == std::string_view::npos ? rule : rule.substr(dot + 1)};
+		node = &child(*node, label);
+		rule.remove_suffix(dot == std::string_view::npos ? rule.size() : rule.size() - dot);
+	}
+	node->flags |= flag;
+}
+
+bool read_rules(const char* const path, trie_node& root) {
+	std::ifstream file {path};
+	if (!file) {
+		std::fprintf(stderr, "psl_generator: unable to open %s\n", path);
+		return false;
+	}
+
+	// Private domains are left out: their owners could have them as a zone
+	bool icann {false};
+	for (std::string line; std::getline(file, line);) {
+		if (line.find("===BEGIN ICANN DOMAINS===") != std::string::npos) {
+			icann = true;
+		}
+		else if (line.find("===END ICANN DOMAINS===") != std::string::npos) {
+			icann = false;
+		}
+		if (!icann || line.empty() || line.compare(0, 2, "//") == 0) {
+			continue;
+		}
+
+		// A rule ends at the first whitespace
+		const std::string rule {line.substr(0, line.find_first_of(" \t\r"))};
+		// Cloudflare zone names use the ASCII form of internationalised
+		// names, which isn't in the list
+		if (rule.empty() || !is_ascii(rule)) {
+			continue;
+		}
+		add_rule(root, rule);
+	}
+
+	return true;
+}
+
+bool write_header(const char* const path, const trie_node& root) {
+	// Breadth-first, so that the children of every node are contiguous
+	std::vector<std::pair<std::string_view, const trie_node*>> order {{{}, &root}};
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		for (const trie_node& child : order[i].second->children) {
+			order.emplace_back(child.label, &child);
+		}
+	}
+
+	struct node_entry {
+		std::size_t label;
+		std::size_t label_length;
+		std::uint8_t flags;
+		std::size_t first_child;
+		std::size_t children_count;
+	};
+	std::vector<node_entry> nodes;
+
+	// Labels are stored once, no matter how many nodes use them
+	std::string labels;
+	std::map<std::string_view, std::size_t> label_offsets;
+
+	std::size_t first_child {1};
+	for (const auto& [label, node] : order) {
+		const auto [offset, inserted] = label_offsets.emplace(label, labels.size());
+		if (inserted) {
+			labels += label;
+		}
+		nodes.push_back({offset->second, label.size(), node->flags, first_child, node->children.size()});
+		first_child += node->children.size();
+	}
+
+	if (nodes.size() > UINT16_MAX || labels.size() > UINT16_MAX) {
+		std::fprintf(stderr, "psl_generator: the list is too big\n");
+		return false;
+	}
+
+	std::ofstream file {path, std::ios::trunc};
+	file <<
+		"/*\n"
+		" * Generated by psl_generator from the Public Suffix List, which is\n"
+		" * subject to the terms of the Mozilla Public License, v. 2.0.\n"
+		" * Do not edit.\n"
+		" */\n"
+		"\n"
+		"#pragma once\n"
+		"\n"
+		"namespace priv::psl {\n"
+		"\n"
+		"constexpr char labels[] {\n";
+
+	// Split in short literals, as some compilers limit their length
+	constexpr std::size_t line_length {96};
+	for (std::size_t i = 0; i < labels.size(); i += line_length) {
+		file << "\t\"" << labels.substr(i, line_length) << "\"\n";
+	}
+	if (labels.empty()) {
+		file << "\t\"\"\n";
+	}
+
+	file <<
+		"};\n"
+		"\n"
+		"constexpr node nodes[] {\n";
+
+	for (const node_entry& node : nodes) {
+		char line[64];
+		std::snprintf(line, sizeof line, "\t{%zu, %zu, %u, %zu, %zu},\n",
+			node.label, node.label_length, static_cast<unsigned>(node.flags), node.first_child, node.children_count
+		);
+		file << line;
+	}
+
+	file <<
+		"};\n"
+		"\n"
+		"} // namespace priv::psl\n";
+
+	return static_cast<bool>(file.flush());
+}
+
+} // namespace
+
+int main(const int argc, const char* const* const argv) {
+	if (argc != 2 && argc != 3) {
+		std::fprintf(stderr, "Usage: %s OUTPUT [public_suffix_list.dat]\n", argv[0]);
+		return 1;
+	}
+
+	trie_node root;
+	if (argc == 3 && !read_rules(argv[2], root)) {
+		return 1;
+	}
+
+	return write_header(argv[1], root) ? 0 : 1;
+}
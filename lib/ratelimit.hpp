@@ -0,0 +1,189 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * Paces the requests sent with each API token, so that a client checking
+ * many records stays under the rate limit of Cloudflare instead of being
+ * answered with 429 until it gives up. Every token gets a bucket, refilled
+ * at the rate allowed by Cloudflare, and a request is only sent once it can
+ * take one of its requests. The buckets start from Cloudflare's documented
+ * limit, 1200 requests every 5 minutes, and follow the RateLimit and
+ * RateLimit-Policy headers of the responses, which also account for the
+ * requests made with the same token by other programs:
+ *
+ *     RateLimit: "default";r=50;t=30
+ *     RateLimit-Policy: "default";q=1200;w=300
+ *
+ * where r is the number of requests left, t the seconds before the quota
+ * resets, q the quota and w the seconds of its window.
+ */
+
+#pragma once
+
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::int64_t, std::uint64_t */
+#include <string_view> /* std::string_view */
+
+namespace priv::ratelimit {
+
+constexpr long default_quota {1200};
+constexpr long default_window_s {300};
+// Clients rarely use more than a couple of tokens
+constexpr std::size_t max_buckets {8U};
+
+/*
+ * Identifies an API token without keeping a copy of it, with FNV-1a
+ */
+constexpr std::uint64_t key(const std::string_view api_token) noexcept {
+	std::uint64_t hash {0xcbf29ce484222325U};
+	for (const char c : api_token) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 0x100000001b3U;
+	}
+	return hash;
+}
+
+/*
+ * The integer value of the parameter named name of the first member of a
+ * structured field list, like the one of RateLimit, or -1 if it's missing
+ */
+constexpr long parameter(const std::string_view field, const char name) noexcept {
+	const std::string_view member {field.substr(0, field.find(','))};
+	for (std::size_t i = member.find(';'); i != std::string_view::npos; i = member.find(';', i + 1U)) {
+		std::size_t j {i + 1U};
+		while (j < member.length() && member[j] == ' ') {
+			++j;
+		}
+		if (j + 1U >= member.length() || member[j] != name || member[j + 1U] != '=') {
+			continue;
+		}
+
+		long value {0};
+		std::size_t digits {0};
+		for (j += 2U; j < member.length() && member[j] >= '0' && member[j] <= '9' && digits < 9U; ++j, ++digits) {
+			value = value * 10 + (member[j] - '0');
+		}
+		return digits != 0 ? value : -1;
+	}
+	return -1;
+}
+
+/*
+ * What a response said about the rate limit of its token, -1 meaning
+ * unknown
+ */
+struct limits {
+	long remaining {-1};
+	long reset_s {-1};
+	long quota {-1};
+	long window_s {-1};
+	// Answered with 429
+	bool throttled {false};
+};
+
+/*
+ * The requests an API token can still send. Counts are kept in
+ * thousandths of a request, so that a few milliseconds can refill a part
+ * of one.
+ */
+struct bucket {
+	std::uint64_t key {0};
+	std::int64_t capacity {default_quota * 1000};
+	std::int64_t available {default_quota * 1000};
+	// Per second
+	std::int64_t refill {default_quota * 1000 / default_window_s};
+	std::int64_t updated_ms {0};
+	// Nothing is sent before this, when the server says the quota is over
+	std::int64_t paused_until_ms {0};
+
+	void update(const std::int64_t now_ms) noexcept {
+		if (now_ms > updated_ms) {
+			available += (now_ms - updated_ms) * refill / 1000;
+			available = available < capacity ? available : capacity;
+		}
+		updated_ms = now_ms;
+	}
+};
+
+class limiter {
+public:
+	/*
+	 * Takes a request from the bucket of api_token, returning 0, or
+	 * returns how many milliseconds to wait before trying again
+	 */
+	long acquire(const std::string_view api_token, const std::int64_t now_ms) noexcept {
+		bucket& bucket {get(key(api_token), now_ms)};
+		if (now_ms < bucket.paused_until_ms) {
+			return static_cast<long>(bucket.paused_until_ms - now_ms);
+		}
+		if (bucket.available >= 1000) {
+			bucket.available -= 1000;
+			return 0;
+		}
+		const std::int64_t missing {1000 - bucket.available};
+		return static_cast<long>((missing * 1000 + bucket.refill - 1) / bucket.refill);
+	}
+
+	/*
+	 * Adapts the bucket of api_token to what a response said
+	 */
+	void observe(const std::string_view api_token, const std::int64_t now_ms, const limits& limits) noexcept {
+		bucket& bucket {get(key(api_token), now_ms)};
+
+		if (limits.quota > 0 && limits.window_s > 0) {
+			bucket.capacity = static_cast<std::int64_t>(limits.quota) * 1000;
+			const std::int64_t refill {bucket.capacity / limits.window_s};
+			bucket.refill = refill > 0 ? refill : 1;
+		}
+
+		// Other requests might be in flight, so the count can only go down
+		std::int64_t available {bucket.capacity};
+		if (limits.remaining >= 0) {
+			available = static_cast<std::int64_t>(limits.remaining) * 1000;
+		}
+		if (limits.throttled) {
+			available = 0;
+		}
+		bucket.available = available < bucket.available ? available : bucket.available;
+
+		if (bucket.available < 1000 && limits.reset_s > 0 && (limits.remaining == 0 || limits.throttled)) {
+			bucket.paused_until_ms = now_ms + static_cast<std::int64_t>(limits.reset_s) * 1000;
+		}
+	}
+
+	std::size_t size() const noexcept {
+		return size_;
+	}
+
+private:
+	/*
+	 * The bucket of key, replacing the least recently used one if there's
+	 * no room for a new one
+	 */
+	bucket& get(const std::uint64_t key, const std::int64_t now_ms) noexcept {
+		bucket* oldest {buckets_};
+		for (std::size_t i = 0; i < size_; ++i) {
+			if (buckets_[i].key == key) {
+				buckets_[i].update(now_ms);
+				return buckets_[i];
+			}
+			if (buckets_[i].updated_ms < oldest->updated_ms) {
+				oldest = &buckets_[i];
+			}
+		}
+
+		bucket& fresh {size_ < max_buckets ? buckets_[size_++] : *oldest};
+		fresh = bucket{};
+		fresh.key = key;
+		fresh.updated_ms = now_ms;
+		return fresh;
+	}
+
+	bucket buckets_[max_buckets];
+	std::size_t size_ {0};
+};
+
+} // namespace priv::ratelimit
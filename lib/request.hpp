@@ -0,0 +1,303 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * The URLs and bodies of the requests sent to Cloudflare's API, described
+ * as formats: lists of literals and of slots filled at run time, each of
+ * them with a bounded length. The size of the buffer a request is written
+ * into is then computed from its format at compile time, every slot is
+ * checked before anything is written, and the request is written in one
+ * straight pass, without checking the bounds again.
+ *
+ * Everything is constexpr, so that tests/request.cpp can prove that the
+ * buffers fit the longest possible requests.
+ */
+
+#pragma once
+
+#include <ddns/cloudflare-ddns.h>
+
+#include <cstddef> /* std::size_t */
+#include <limits> /* std::numeric_limits */
+#include <string_view> /* std::string_view */
+
+namespace priv::request {
+
+/*
+ * A plain loop, so that it can run in constant expressions; compilers turn
+ * it into a memcpy() call anyway
+ */
+constexpr char* copy(char* out, const std::string_view string) noexcept {
+	for (const char c : string) {
+		*out++ = c;
+	}
+	return out;
+}
+
+/*
+ * Text known at compile time
+ */
+template <const std::string_view& Text>
+struct literal {
+	static constexpr bool is_slot {false};
+	static constexpr std::size_t max_length {Text.length()};
+
+	static constexpr char* write(char* const out) noexcept {
+		return copy(out, Text);
+	}
+};
+
+/*
+ * A string of exactly Length chars, like an ID
+ */
+template <std::size_t Length>
+struct fixed {
+	static constexpr bool is_slot {true};
+	static constexpr std::size_t max_length {Length};
+
+	static constexpr bool valid(const std::string_view value) noexcept {
+		return value.length() == Length;
+	}
+
+	static constexpr char* write(char* const out, const std::string_view value) noexcept {
+		return copy(out, value);
+	}
+};
+
+/*
+ * A string of at most MaxLength chars
+ */
+template <std::size_t MaxLength>
+struct bounded {
+	static constexpr bool is_slot {true};
+	static constexpr std::size_t max_length {MaxLength};
+
+	static constexpr bool valid(const std::string_view value) noexcept {
+		return value.length() <= MaxLength;
+	}
+
+	static constexpr char* write(char* const out, const std::string_view value) noexcept {
+		return copy(out, value);
+	}
+};
+
+/*
+ * A number, in decimal
+ */
+struct number {
+	static constexpr bool is_slot {true};
+	static constexpr std::size_t max_length {std::numeric_limits<std::size_t>::digits10 + 1U};
+
+	static constexpr bool valid(std::size_t) noexcept {
+		return true;
+	}
+
+	static constexpr char* write(char* const out, std::size_t value) noexcept {
+		std::size_t length {0};
+		for (std::size_t rest = value; rest != 0 || length == 0; rest /= 10U) {
+			++length;
+		}
+		for (std::size_t i = length; i != 0; --i) {
+			out[i - 1U] = static_cast<char>('0' + value % 10U);
+			value /= 10U;
+		}
+		return out + length;
+	}
+};
+
+/*
+ * Checks and writes Parts, taking the value of each slot from values, in
+ * order
+ */
+template <typename... Parts>
+struct parts;
+
+template <>
+struct parts<> {
+	static constexpr bool valid() noexcept {
+		return true;
+	}
+
+	static constexpr char* write(char* const out) noexcept {
+		return out;
+	}
+};
+
+template <typename Part, typename... Rest>
+struct parts<Part, Rest...> {
+	template <typename... Values>
+	static constexpr bool valid(const Values&... values) noexcept {
+		if constexpr (Part::is_slot) {
+			return valid_slot(values...);
+		}
+		else {
+			return parts<Rest...>::valid(values...);
+		}
+	}
+
+	template <typename... Values>
+	static constexpr char* write(char* const out, const Values&... values) noexcept {
+		if constexpr (Part::is_slot) {
+			return write_slot(out, values...);
+		}
+		else {
+			return parts<Rest...>::write(Part::write(out), values...);
+		}
+	}
+
+private:
+	template <typename Value, typename... Values>
+	static constexpr bool valid_slot(const Value& value, const Values&... values) noexcept {
+		return Part::valid(value) && parts<Rest...>::valid(values...);
+	}
+
+	template <typename Value, typename... Values>
+	static constexpr char* write_slot(char* const out, const Value& value, const Values&... values) noexcept {
+		return parts<Rest...>::write(Part::write(out, value), values...);
+	}
+};
+
+/*
+ * The values of slots, taken as a string_view, so that the length of a C
+ * string is computed only once
+ */
+constexpr std::string_view slot_value(const std::string_view value) noexcept {
+	return value;
+}
+
+constexpr std::size_t slot_value(const std::size_t value) noexcept {
+	return value;
+}
+
+template <typename... Parts>
+struct format {
+	static constexpr std::size_t max_length {(Parts::max_length + ... + 0U)};
+	// +1 because of '\0'
+	static constexpr std::size_t size {max_length + 1U};
+	static constexpr std::size_t slots {(static_cast<std::size_t>(Parts::is_slot) + ... + 0U)};
+
+	/*
+	 * Whether values fit in the slots
+	 */
+	template <typename... Values>
+	static constexpr bool valid(const Values&... values) noexcept {
+		static_assert(sizeof...(Values) == slots);
+		return parts<Parts...>::valid(values...);
+	}
+
+	/*
+	 * Writes the request, without the terminating '\0', returning its end.
+	 * values must be valid.
+	 */
+	template <typename... Values>
+	static constexpr char* write(char* const out, const Values&... values) noexcept {
+		static_assert(sizeof...(Values) == slots);
+		return parts<Parts...>::write(out, values...);
+	}
+
+	/*
+	 * Writes the request in buffer, which must have room for size chars,
+	 * or returns DDNS_ERROR_USAGE if values don't fit in the slots
+	 */
+	template <typename... Values>
+	[[nodiscard]] static constexpr ddns_error make(char* const buffer, const Values&... values) noexcept {
+		return make_from(buffer, slot_value(values)...);
+	}
+
+private:
+	template <typename... Values>
+	static constexpr ddns_error make_from(char* const buffer, const Values&... values) noexcept {
+		if (!valid(values...)) {
+			return DDNS_ERROR_USAGE;
+		}
+		*write(buffer, values...) = '\0';
+		return DDNS_ERROR_OK;
+	}
+};
+
+/*
+ * Clients can talk to a different API server, so the URLs are built on
+ * top of the zones URL of the client, which has a bounded length
+ */
+constexpr std::string_view zones_path {"/zones/"};
+constexpr std::size_t zones_url_max_length {DDNS_BASE_URL_MAX_LENGTH + zones_path.length()};
+
+using zones_url = bounded<zones_url_max_length>;
+using zone_id = fixed<DDNS_ZONE_ID_LENGTH>;
+using record_id = fixed<DDNS_RECORD_ID_LENGTH>;
+using ip_address = bounded<DDNS_IP_ADDRESS_MAX_LENGTH>;
+
+constexpr std::string_view zones_query {"?per_page=1&name="};
+// -2 because this endpoint has a maximum record name length of 253
+constexpr std::size_t zone_name_max_length {DDNS_RECORD_NAME_MAX_LENGTH - 2U};
+
+/*
+ * GET, searches the zone with a name
+ */
+using zone_url = format<zones_url, literal<zones_query>, bounded<zone_name_max_length>>;
+
+constexpr std::string_view dns_records_query {"/dns_records?type=A,AAAA&name="};
+
+/*
+ * GET, the A and AAAA records with a name
+ */
+using get_record_url = format<zones_url, zone_id, literal<dns_records_query>, bounded<DDNS_RECORD_NAME_MAX_LENGTH>>;
+
+constexpr std::string_view list_records_query {"/dns_records?type=A,AAAA&per_page="};
+constexpr std::string_view list_records_page {"&page="};
+
+/*
+ * GET, a page of all the A and AAAA records of a zone
+ */
+using list_records_url = format<zones_url, zone_id, literal<list_records_query>, number, literal<list_records_page>, number>;
+
+constexpr std::string_view dns_records_path {"/dns_records/"};
+constexpr std::string_view update_body_start {R"({"content": ")"};
+constexpr std::string_view update_body_end {"\"}"};
+
+/*
+ * PATCH, sets the content of a record
+ */
+using update_record_url = format<zones_url, zone_id, literal<dns_records_path>, record_id>;
+using update_record_body = format<literal<update_body_start>, ip_address, literal<update_body_end>>;
+
+constexpr std::string_view dns_records_batch_path {"/dns_records/batch"};
+constexpr std::string_view batch_body_start {R"({"patches":[)"};
+constexpr std::string_view batch_patch_start {R"({"id":")"};
+constexpr std::string_view batch_patch_content {R"(","content":")"};
+constexpr std::string_view batch_patch_end {"\"}"};
+constexpr std::string_view batch_patch_separator {","};
+constexpr std::string_view batch_body_end {"]}"};
+
+/*
+ * POST, sets the content of up to DDNS_BATCH_MAX_RECORDS records. The
+ * body is made of a patch for every record, between batch_body_start and
+ * batch_body_end, separated by batch_patch_separator.
+ */
+using batch_update_url = format<zones_url, zone_id, literal<dns_records_batch_path>>;
+using batch_patch = format<literal<batch_patch_start>, record_id, literal<batch_patch_content>, ip_address, literal<batch_patch_end>>;
+
+// +1 because of '\0'
+constexpr std::size_t batch_update_body_size {
+	batch_body_start.length() +
+	DDNS_BATCH_MAX_RECORDS * batch_patch::max_length +
+	(DDNS_BATCH_MAX_RECORDS - 1U) * batch_patch_separator.length() +
+	batch_body_end.length() +
+	1U
+};
+
+constexpr std::string_view doh_query_start {"https://cloudflare-dns.com/dns-query?name="};
+constexpr std::string_view doh_query_type {"&type="};
+// The longest name DNS allows, without the trailing dot
+constexpr std::size_t host_max_length {253U};
+
+/*
+ * GET, the records of a type, like A or AAAA, of a host, from Cloudflare's
+ * DNS over HTTPS resolver, in its JSON format
+ */
+using doh_query_url = format<literal<doh_query_start>, bounded<host_max_length>, literal<doh_query_type>, bounded<4U>>;
+
+} // namespace priv::request
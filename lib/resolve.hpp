@@ -0,0 +1,535 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * The addresses of the few hosts a client talks to, like the API server,
+ * looked up with DNS over HTTPS and kept for as long as the TTL of the
+ * answers allows. They are handed to curl with CURLOPT_RESOLVE, so that
+ * requests made while they're valid don't wait for a DoH round trip, and
+ * they can be kept in a small text file, so that they survive between
+ * runs:
+ *
+ *     cloudflare-ddns resolve 1
+ *     api.cloudflare.com 443 1760707200 104.19.192.29,2606:4700::6813:c01d
+ *
+ * where every line holds a host, its port, when its addresses expire, in
+ * seconds since the epoch, and the addresses.
+ */
+
+#pragma once
+
+#include <ddns/cloudflare-ddns.h>
+#include "json.hpp"
+#include "request.hpp"
+
+#include <cstddef> /* std::size_t */
+#include <cstdint> /* std::int64_t */
+#include <cstdio> /* std::FILE, std::fopen, std::fclose, std::fgets, std::fputs, std::rename, std::remove */
+#include <cstring> /* std::memcpy */
+#include <string_view> /* std::string_view */
+
+namespace priv::resolve {
+
+constexpr std::size_t max_hosts {4U};
+constexpr std::size_t max_addresses {8U};
+// Longer TTLs are cut, so that a bad answer can't stick around for long
+constexpr std::int64_t max_ttl {86400};
+// Failed lookups aren't retried for this long, falling back to curl's DoH
+constexpr std::int64_t retry_delay {60};
+
+constexpr std::string_view file_header {"cloudflare-ddns resolve 1\n"};
+
+/*
+ * Whether host can be looked up and written in a CURLOPT_RESOLVE entry and
+ * in the file, which split it at colons, commas and spaces
+ */
+constexpr bool valid_host(const std::string_view host) noexcept {
+	if (host.empty() || host.length() > request::host_max_length) {
+		return false;
+	}
+	for (const char c : host) {
+		const bool valid {
+			(c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_'
+		};
+		if (!valid) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Whether host is an IPv4 address, which needs no lookup. IPv6 ones are
+ * between brackets in URLs, and are never valid hosts.
+ */
+constexpr bool is_ipv4(const std::string_view host) noexcept {
+	for (const char c : host) {
+		if ((c < '0' || c > '9') && c != '.') {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Whether address only has the characters of an IPv4 or an IPv6 address
+ */
+constexpr bool valid_address(const std::string_view address) noexcept {
+	if (address.empty() || address.length() >= DDNS_IP_ADDRESS_MAX_LENGTH) {
+		return false;
+	}
+	for (const char c : address) {
+		const bool valid {
+			(c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F') || c == '.' || c == ':'
+		};
+		if (!valid) {
+			return false;
+		}
+	}
+	return true;
+}
+
+struct endpoint {
+	std::string_view host;
+	unsigned port;
+};
+
+/*
+ * The host and the port of an https:// URL, or an empty host if there's
+ * nothing to look up, like when the URL holds an IP address
+ */
+constexpr endpoint url_endpoint(std::string_view url) noexcept {
+	constexpr std::string_view scheme {"https://"};
+	if (url.substr(0, scheme.length()) != scheme) {
+		return {};
+	}
+	url.remove_prefix(scheme.length());
+	url = url.substr(0, url.find_first_of("/?#"));
+
+	endpoint result {url, 443U};
+	if (const std::size_t colon = url.find(':'); colon != std::string_view::npos) {
+		result.host = url.substr(0, colon);
+		const std::string_view digits {url.substr(colon + 1U)};
+		if (digits.empty() || digits.length() > 5U) {
+			return {};
+		}
+		result.port = 0;
+		for (const char c : digits) {
+			if (c < '0' || c > '9') {
+				return {};
+			}
+			result.port = result.port * 10U + static_cast<unsigned>(c - '0');
+		}
+		if (result.port == 0 || result.port > 65535U) {
+			return {};
+		}
+	}
+
+	if (!valid_host(result.host) || is_ipv4(result.host)) {
+		return {};
+	}
+	return result;
+}
+
+struct entry {
+	char host[request::host_max_length + 1U];
+	std::size_t host_length;
+	unsigned port;
+	// Seconds since the epoch
+	std::int64_t expires_at;
+	// Lookups aren't tried again before this after failing
+	std::int64_t retry_at;
+	std::size_t addresses_count;
+	char addresses[max_addresses][DDNS_IP_ADDRESS_MAX_LENGTH];
+
+	std::string_view host_sv() const noexcept {
+		return {host, host_length};
+	}
+
+	bool fresh(const std::int64_t now) const noexcept {
+		return addresses_count != 0 && now < expires_at;
+	}
+
+	/*
+	 * Returns false if address is not valid, and ignores it if there
+	 * are already max_addresses
+	 */
+	bool add_address(const std::string_view address) noexcept {
+		if (!valid_address(address)) {
+			return false;
+		}
+		if (addresses_count < max_addresses) {
+			std::memcpy(addresses[addresses_count], address.data(), address.length());
+			addresses[addresses_count][address.length()] = '\0';
+			++addresses_count;
+		}
+		return true;
+	}
+};
+
+/*
+ * "+HOST:PORT:ADDRESS,ADDRESS", the longest CURLOPT_RESOLVE entry, with
+ * '\0' in place of the last comma
+ */
+constexpr std::size_t resolve_entry_size {
+	1U + request::host_max_length + 1U + 5U + 1U + max_addresses * DDNS_IP_ADDRESS_MAX_LENGTH
+};
+
+// A line of the file: an entry, its expiry date and the separators
+constexpr std::size_t line_size {resolve_entry_size + 32U};
+
+/*
+ * Writes the CURLOPT_RESOLVE entry of entry in out, which must have room
+ * for resolve_entry_size chars. Transient entries, starting with '+',
+ * leave curl's DNS cache like the ones it looked up itself.
+ */
+inline void write_resolve_entry(const entry& entry, const bool transient, char* out) noexcept {
+	if (transient) {
+		*out++ = '+';
+	}
+	out = request::copy(out, entry.host_sv());
+	*out++ = ':';
+	out = request::number::write(out, entry.port);
+	*out++ = ':';
+	for (std::size_t i = 0; i < entry.addresses_count; ++i) {
+		if (i != 0) {
+			*out++ = ',';
+		}
+		out = request::copy(out, entry.addresses[i]);
+	}
+	*out = '\0';
+}
+
+/*
+ * Reads the addresses and the TTL of an answer of Cloudflare's DoH
+ * resolver in the JSON format, adding the addresses to an entry:
+ *
+ *     {"Status": 0, ..., "Answer": [{"name": "...", "type": 1, "TTL": 300, "data": "192.0.2.1"}]}
+ *
+ * Only A and AAAA records count as addresses, but the TTL is the lowest
+ * of the whole answer, CNAME records included.
+ */
+class answer_parser : public json::tokenizer<answer_parser> {
+public:
+	explicit answer_parser(entry& destination) noexcept
+		: destination_ {destination} {
+		reset_tokenizer();
+	}
+
+	/*
+	 * Whether the answer was valid and its status NOERROR. Must be
+	 * called once the whole answer has been fed.
+	 */
+	bool success() const noexcept {
+		return complete() && status_ == 0 && valid_;
+	}
+
+	/*
+	 * The lowest TTL of the answer, or -1 if it has no records
+	 */
+	std::int64_t ttl() const noexcept {
+		return ttl_;
+	}
+
+	void on_object_start() noexcept {
+		// The records of Answer
+		if (answer_ && depth() == 3U && is_array(2U)) {
+			record_type_ = 0;
+			record_ttl_ = -1;
+			record_data_length_ = 0;
+			record_data_valid_ = false;
+		}
+		field_ = field::none;
+	}
+
+	void on_object_end() noexcept {
+		if (answer_ && depth() == 3U) {
+			if (record_ttl_ >= 0 && (ttl_ < 0 || record_ttl_ < ttl_)) {
+				ttl_ = record_ttl_;
+			}
+			if (record_type_ == type_a || record_type_ == type_aaaa) {
+				valid_ = record_data_valid_ && destination_.add_address({record_data_, record_data_length_}) && valid_;
+			}
+		}
+		field_ = field::none;
+	}
+
+	void on_array_start() noexcept {
+		field_ = field::none;
+	}
+
+	void on_array_end() noexcept {}
+
+	void on_key(const std::string_view key, const bool /*truncated*/) noexcept {
+		field_ = field::none;
+		if (depth() == 1U) {
+			answer_ = key == "Answer";
+			if (key == "Status") {
+				field_ = field::status;
+			}
+		}
+		else if (answer_ && depth() == 3U) {
+			if (key == "type") {
+				field_ = field::type;
+			}
+			else if (key == "TTL") {
+				field_ = field::ttl;
+			}
+			else if (key == "data") {
+				field_ = field::data;
+			}
+		}
+	}
+
+	void on_string(const std::string_view value, const bool truncated) noexcept {
+		if (field_ == field::data && answer_ && depth() == 3U) {
+			record_data_valid_ = !truncated && value.length() < sizeof record_data_;
+			if (record_data_valid_) {
+				std::memcpy(record_data_, value.data(), value.length());
+				record_data_length_ = value.length();
+			}
+		}
+		field_ = field::none;
+	}
+
+	void on_number(const std::string_view value) noexcept {
+		// Huge numbers are cut to max_ttl, which is bigger than any status
+		// or type; negative or fractional ones aren't expected
+		std::int64_t number {0};
+		for (const char c : value) {
+			if (c < '0' || c > '9') {
+				number = -1;
+				break;
+			}
+			number = number * 10 + (c - '0');
+			if (number > max_ttl) {
+				number = max_ttl;
+			}
+		}
+
+		if (field_ == field::status && depth() == 1U) {
+			status_ = number;
+		}
+		else if (answer_ && depth() == 3U) {
+			if (field_ == field::type) {
+				record_type_ = number;
+			}
+			else if (field_ == field::ttl) {
+				record_ttl_ = number;
+			}
+		}
+		field_ = field::none;
+	}
+
+	void on_bool(bool /*value*/) noexcept {
+		field_ = field::none;
+	}
+
+	void on_null() noexcept {
+		field_ = field::none;
+	}
+
+private:
+	static constexpr std::int64_t type_a {1};
+	static constexpr std::int64_t type_aaaa {28};
+
+	enum class field : unsigned char {
+		none,
+		status,
+		type,
+		ttl,
+		data
+	};
+
+	entry& destination_;
+	field field_ {field::none};
+	// Whether the key of the top level object being read is Answer
+	bool answer_ {false};
+	bool valid_ {true};
+	std::int64_t status_ {-1};
+	std::int64_t ttl_ {-1};
+	std::int64_t record_type_ {0};
+	std::int64_t record_ttl_ {-1};
+	bool record_data_valid_ {false};
+	std::size_t record_data_length_ {0};
+	char record_data_[DDNS_IP_ADDRESS_MAX_LENGTH];
+};
+
+/*
+ * The entries of a client, one for every host, each of them holding its
+ * port too. Once full, the entry expiring first makes room for new hosts.
+ */
+class cache {
+public:
+	entry* find(const endpoint& endpoint) noexcept {
+		for (std::size_t i = 0; i < size_; ++i) {
+			if (entries_[i].host_sv() == endpoint.host && entries_[i].port == endpoint.port) {
+				return &entries_[i];
+			}
+		}
+		return nullptr;
+	}
+
+	/*
+	 * The entry of endpoint, which must have a valid host, added without
+	 * addresses if it's not there yet
+	 */
+	entry& get(const endpoint& endpoint) noexcept {
+		if (entry* const found = find(endpoint)) {
+			return *found;
+		}
+
+		entry* destination {&entries_[0]};
+		if (size_ < max_hosts) {
+			destination = &entries_[size_++];
+		}
+		else {
+			for (std::size_t i = 1; i < max_hosts; ++i) {
+				if (entries_[i].expires_at < destination->expires_at) {
+					destination = &entries_[i];
+				}
+			}
+		}
+
+		std::memcpy(destination->host, endpoint.host.data(), endpoint.host.length());
+		destination->host[endpoint.host.length()] = '\0';
+		destination->host_length = endpoint.host.length();
+		destination->port = endpoint.port;
+		destination->expires_at = 0;
+		destination->retry_at = 0;
+		destination->addresses_count = 0;
+		return *destination;
+	}
+
+	std::size_t size() const noexcept {
+		return size_;
+	}
+
+	/*
+	 * Reads the entries still fresh at now from the file at path. A
+	 * missing or malformed file, or malformed lines, are skipped: the
+	 * cache is only an optimisation.
+	 */
+	void load(const char* const path, const std::int64_t now) noexcept {
+		std::FILE* const file {std::fopen(path, "r")};
+		if (file == nullptr) {
+			return;
+		}
+
+		char line[line_size];
+		if (std::fgets(line, sizeof line, file) != nullptr && std::string_view{line} == file_header) {
+			while (std::fgets(line, sizeof line, file) != nullptr) {
+				load_line(line, now);
+			}
+		}
+
+		std::fclose(file);
+	}
+
+	/*
+	 * Replaces the file at path with the fresh entries, writing them to
+	 * temporary_path first. Returns false on failure.
+	 */
+	bool save(const char* const path, const char* const temporary_path, const std::int64_t now) const noexcept {
+		std::FILE* const file {std::fopen(temporary_path, "w")};
+		if (file == nullptr) {
+			return false;
+		}
+
+		bool ok {std::fputs(file_header.data(), file) >= 0};
+		for (std::size_t i = 0; i < size_ && ok; ++i) {
+			const entry& entry {entries_[i]};
+			if (!entry.fresh(now)) {
+				continue;
+			}
+
+			char line[line_size];
+			char* out {request::copy(line, entry.host_sv())};
+			*out++ = ' ';
+			out = request::number::write(out, entry.port);
+			*out++ = ' ';
+			out = request::number::write(out, static_cast<std::size_t>(entry.expires_at));
+			*out++ = ' ';
+			for (std::size_t j = 0; j < entry.addresses_count; ++j) {
+				if (j != 0) {
+					*out++ = ',';
+				}
+				out = request::copy(out, entry.addresses[j]);
+			}
+			*out++ = '\n';
+			*out = '\0';
+			ok = std::fputs(line, file) >= 0;
+		}
+
+		ok = std::fclose(file) == 0 && ok;
+		// Readers either see the old file or the new one, never half of it
+		if (!ok || std::rename(temporary_path, path) != 0) {
+			std::remove(temporary_path);
+			return false;
+		}
+		return true;
+	}
+
+private:
+	/*
+	 * Splits the next field of line at separator
+	 */
+	static std::string_view next_field(std::string_view& line, const char separator) noexcept {
+		const std::size_t end {line.find(separator)};
+		const std::string_view field {line.substr(0, end)};
+		line.remove_prefix(end == std::string_view::npos ? line.length() : end + 1U);
+		return field;
+	}
+
+	static bool parse_number(const std::string_view digits, std::int64_t& number) noexcept {
+		if (digits.empty() || digits.length() > 18U) {
+			return false;
+		}
+		number = 0;
+		for (const char c : digits) {
+			if (c < '0' || c > '9') {
+				return false;
+			}
+			number = number * 10 + (c - '0');
+		}
+		return true;
+	}
+
+	void load_line(std::string_view line, const std::int64_t now) noexcept {
+		if (line.empty() || line.back() != '\n') {
+			return;
+		}
+		line.remove_suffix(1);
+
+		const std::string_view host {next_field(line, ' ')};
+		std::int64_t port {0};
+		std::int64_t expires_at {0};
+		// Entries expiring after max_ttl weren't written by save(), or were
+		// written before the clock went back, and aren't trusted
+		if (!valid_host(host) || !parse_number(next_field(line, ' '), port) || port == 0 || port > 65535
+			|| !parse_number(next_field(line, ' '), expires_at) || expires_at <= now || expires_at > now + max_ttl || line.empty()) {
+			return;
+		}
+
+		entry loaded;
+		loaded.addresses_count = 0;
+		while (!line.empty()) {
+			if (!loaded.add_address(next_field(line, ','))) {
+				return;
+			}
+		}
+
+		entry& destination {get({host, static_cast<unsigned>(port)})};
+		std::memcpy(destination.addresses, loaded.addresses, sizeof loaded.addresses);
+		destination.addresses_count = loaded.addresses_count;
+		destination.expires_at = expires_at;
+	}
+
+	entry entries_[max_hosts];
+	std::size_t size_ {0};
+};
+
+} // namespace priv::resolve
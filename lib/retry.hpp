@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: LGPL-3.0-or-later
+ */
+
+/*
+ * How long the requests of a client may take, and when they're sent again.
+ * Cloudflare answers 429 when the rate limit of a token is exceeded, and
+ * one of a few 5xx codes when something is temporarily wrong on its side:
+ * those requests are retried after an exponential backoff with full
+ * jitter, or after the delay asked with Retry-After, as long as the
+ * deadline of the client allows it.
+ */
+
+#pragma once
+
+#include <cstdint> /* std::int64_t, std::uint32_t */
+
+namespace priv::retry {
+
+// Counting the first one
+constexpr unsigned max_attempts {4U};
+constexpr long base_delay_ms {500};
+constexpr long max_delay_ms {8000};
+// Longer Retry-After values make the request fail right away
+constexpr long max_retry_after_s {60};
+
+constexpr long default_connect_timeout_ms {10000};
+constexpr long default_timeout_ms {30000};
+
+/*
+ * Whether a response with this HTTP status is worth sending again
+ */
+constexpr bool retryable(const long status) noexcept {
+	return status == 429 || status == 500 || status == 502 || status == 503 || status == 504;
+}
+
+/*
+ * The next number of a xorshift32 sequence, which only needs to spread
+ * the retries of different clients, starting from a non-zero state
+ */
+constexpr std::uint32_t next_random(std::uint32_t& state) noexcept {
+	state ^= state << 13U;
+	state ^= state >> 17U;
+	state ^= state << 5U;
+	return state;
+}
+
+/*
+ * How long to wait before the retry following attempt, counting from 0,
+ * given a random number and the Retry-After of the response, in seconds,
+ * or 0 if there was none. Returns -1 if the request shouldn't be retried.
+ */
+constexpr long delay_ms(const unsigned attempt, const long retry_after_s, const std::uint32_t random) noexcept {
+	if (attempt + 1U >= max_attempts || retry_after_s > max_retry_after_s) {
+		return -1;
+	}
+
+	long cap {base_delay_ms};
+	for (unsigned i = 0; i < attempt && cap < max_delay_ms; ++i) {
+		cap *= 2;
+	}
+	if (cap > max_delay_ms) {
+		cap = max_delay_ms;
+	}
+
+	const long delay {static_cast<long>(random % static_cast<std::uint32_t>(cap + 1))};
+	return retry_after_s * 1000 > delay ? retry_after_s * 1000 : delay;
+}
+
+/*
+ * The CURLOPT_TIMEOUT_MS of a request sent at now_ms, given the timeout of
+ * the requests, 0 meaning none, and the deadline of the client on the same
+ * clock, 0 meaning none. Returns -1 if the deadline has already passed.
+ */
+constexpr long request_timeout_ms(const long timeout_ms, const std::int64_t deadline_ms, const std::int64_t now_ms) noexcept {
+	if (deadline_ms == 0) {
+		return timeout_ms;
+	}
+	const std::int64_t remaining {deadline_ms - now_ms};
+	if (remaining <= 0) {
+		return -1;
+	}
+	return timeout_ms != 0 && timeout_ms < remaining ? timeout_ms : static_cast<long>(remaining);
+}
+
+} // namespace priv::retry
@@ -0,0 +1,272 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <poll.h>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+/*
+ * Counts the calls of an operation's callback, and keeps the last error
+ */
+struct outcome {
+	int calls {0};
+	ddns_error error {DDNS_ERROR_OK};
+};
+
+void record_outcome(const ddns_error error, void* const user) {
+	outcome& result {*static_cast<outcome*>(user)};
+	++result.calls;
+	result.error = error;
+}
+
+void run_polling(ddns_async* const async) {
+	const clock::time_point give_up {clock::now() + std::chrono::seconds{10}};
+	while (ddns_async_pending(async) != 0 && clock::now() < give_up) {
+		expect(eq(ddns_async_poll(async, 1000), DDNS_ERROR_OK));
+	}
+}
+
+/*
+ * A minimal event loop built on poll(2), driving an async through its
+ * socket and timer callbacks
+ */
+struct event_loop {
+	std::map<ddns_socket, int> sockets;
+	bool timer_set {false};
+	clock::time_point timer_at;
+	int timers {0};
+
+	static void watch(const ddns_socket socket, const int events, void* const user) {
+		event_loop& loop {*static_cast<event_loop*>(user)};
+		if (events == 0) {
+			loop.sockets.erase(socket);
+		}
+		else {
+			loop.sockets[socket] = events;
+		}
+	}
+
+	static void set_timer(const long timeout_ms, void* const user) {
+		event_loop& loop {*static_cast<event_loop*>(user)};
+		loop.timer_set = timeout_ms >= 0;
+		loop.timer_at = clock::now() + std::chrono::milliseconds{timeout_ms};
+		++loop.timers;
+	}
+
+	void run(ddns_async* const async) {
+		const clock::time_point give_up {clock::now() + std::chrono::seconds{10}};
+		while (ddns_async_pending(async) != 0 && clock::now() < give_up) {
+			std::vector<pollfd> fds;
+			for (const auto& [socket, events] : sockets) {
+				fds.push_back({socket, static_cast<short>(((events & DDNS_POLL_IN) != 0 ? POLLIN : 0) | ((events & DDNS_POLL_OUT) != 0 ? POLLOUT : 0)), 0});
+			}
+			int timeout_ms {1000};
+			if (timer_set) {
+				const auto left {std::chrono::duration_cast<std::chrono::milliseconds>(timer_at - clock::now()).count()};
+				timeout_ms = static_cast<int>(left > 0 ? (left < timeout_ms ? left : timeout_ms) : 0);
+			}
+
+			poll(fds.data(), fds.size(), timeout_ms);
+
+			for (const pollfd& fd : fds) {
+				if (fd.revents == 0) {
+					continue;
+				}
+				const int events {((fd.revents & POLLIN) != 0 ? DDNS_POLL_IN : 0) | ((fd.revents & POLLOUT) != 0 ? DDNS_POLL_OUT : 0) | ((fd.revents & (POLLERR | POLLHUP)) != 0 ? DDNS_POLL_ERROR : 0)};
+				expect(eq(ddns_async_socket_action(async, fd.fd, events), DDNS_ERROR_OK));
+			}
+			if (timer_set && clock::now() >= timer_at) {
+				timer_set = false;
+				expect(eq(ddns_async_socket_action(async, DDNS_SOCKET_TIMEOUT, 0), DDNS_ERROR_OK));
+			}
+		}
+	}
+};
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"async_poll"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+		ddns_async* async {nullptr};
+		expect(eq(ddns_async_create(client, &async), DDNS_ERROR_OK) >> fatal);
+
+		ddns_local_ip local_ip {false, 0, {}, DDNS_ERROR_GENERIC};
+		ddns_zone_search search {mock_cloudflare::api_token, mock_cloudflare::record_name, {}, DDNS_ERROR_GENERIC};
+		std::array<ddns_record, 2> records;
+		ddns_record_query query {mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records.size(), records.data(), 0, DDNS_ERROR_GENERIC};
+		ddns_record_update update {mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::a_record_id, "198.51.100.1", {}, DDNS_ERROR_GENERIC};
+
+		outcome local_ip_outcome;
+		outcome search_outcome;
+		outcome query_outcome;
+		outcome update_outcome;
+		expect(eq(ddns_async_get_local_ip(async, &local_ip, record_outcome, &local_ip_outcome), DDNS_ERROR_OK));
+		expect(eq(ddns_async_search_zone_id(async, &search, record_outcome, &search_outcome), DDNS_ERROR_OK));
+		expect(eq(ddns_async_get_records(async, &query, record_outcome, &query_outcome), DDNS_ERROR_OK));
+		expect(eq(ddns_async_update_record(async, &update, record_outcome, &update_outcome), DDNS_ERROR_OK));
+
+		// Nothing is done until the async is driven
+		expect(eq(ddns_async_pending(async), 4U));
+		expect(eq(query_outcome.calls, 0));
+
+		run_polling(async);
+		expect(eq(ddns_async_pending(async), 0U));
+
+		expect(eq(local_ip_outcome.calls, 1));
+		expect(eq(local_ip_outcome.error, DDNS_ERROR_OK));
+		expect(eq(std::string_view{local_ip.ip}, std::string_view{mock_cloudflare::local_ip}));
+
+		expect(eq(search_outcome.calls, 1));
+		expect(eq(search.error, DDNS_ERROR_OK));
+		expect(eq(std::string_view{search.zone_id}, std::string_view{mock_cloudflare::zone_id}));
+
+		expect(eq(query_outcome.calls, 1));
+		expect(eq(query.error, DDNS_ERROR_OK));
+		expect(eq(query.records_count, 2U));
+
+		expect(eq(update_outcome.calls, 1));
+		expect(eq(update.error, DDNS_ERROR_OK));
+		expect(eq(std::string_view{update.record_ip}, std::string_view{"198.51.100.1"}));
+		expect(eq(cloudflare.content(mock_cloudflare::a_record_id), std::string{"198.51.100.1"}));
+
+		// The zone was remembered, so searching it again sends nothing,
+		// but the callback still waits for the async to be driven
+		const std::size_t requests {server.requests().size()};
+		search = {mock_cloudflare::api_token, mock_cloudflare::record_name, {}, DDNS_ERROR_GENERIC};
+		search_outcome = {};
+		expect(eq(ddns_async_search_zone_id(async, &search, record_outcome, &search_outcome), DDNS_ERROR_OK));
+		expect(eq(search_outcome.calls, 0));
+		run_polling(async);
+		expect(eq(search_outcome.calls, 1));
+		expect(eq(std::string_view{search.zone_id}, std::string_view{mock_cloudflare::zone_id}));
+		expect(eq(server.requests().size(), requests));
+
+		ddns_async_destroy(async);
+		ddns_client_destroy(client);
+	};
+
+	"async_socket_action"_test = [] {
+		// The quota of the token is over for a second after the first
+		// request, so that the async has to set a timer to send the others
+		mock_cloudflare cloudflare;
+		std::atomic<int> requests {0};
+		const mock_server server {[&](const mock_request& request) {
+			mock_response response {cloudflare(request)};
+			if (++requests == 1) {
+				response.headers = "RateLimit: \"default\";r=0;t=1\r\nRateLimit-Policy: \"default\";q=1200;w=300\r\n";
+			}
+			return response;
+		}};
+		ddns_client* const client {make_client(server)};
+		ddns_async* async {nullptr};
+		expect(eq(ddns_async_create(client, &async), DDNS_ERROR_OK) >> fatal);
+		event_loop loop;
+		expect(eq(ddns_async_set_callbacks(async, event_loop::watch, event_loop::set_timer, &loop), DDNS_ERROR_OK));
+		expect(eq(ddns_async_poll(async, 0), DDNS_ERROR_USAGE));
+
+		// The second lookup is started by the callback of the first one
+		std::array<ddns_record, 2> records[2];
+		ddns_record_query queries[2] {
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records[0].size(), records[0].data(), 0, DDNS_ERROR_GENERIC},
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records[1].size(), records[1].data(), 0, DDNS_ERROR_GENERIC}
+		};
+		struct chain {
+			ddns_async* async;
+			ddns_record_query* next;
+			outcome first;
+			outcome second;
+		} chain {async, &queries[1], {}, {}};
+		const auto start_next = [](const ddns_error error, void* const user) {
+			struct chain& chain {*static_cast<struct chain*>(user)};
+			record_outcome(error, &chain.first);
+			expect(eq(ddns_async_get_records(chain.async, chain.next, record_outcome, &chain.second), DDNS_ERROR_OK));
+		};
+
+		const clock::time_point start {clock::now()};
+		expect(eq(ddns_async_get_records(async, &queries[0], start_next, &chain), DDNS_ERROR_OK));
+		expect(loop.timers > 0);
+		loop.run(async);
+
+		expect(eq(chain.first.calls, 1));
+		expect(eq(chain.second.calls, 1));
+		expect(eq(queries[0].records_count, 2U));
+		expect(eq(queries[1].records_count, 2U));
+		expect(clock::now() - start >= std::chrono::milliseconds{900});
+
+		ddns_async_destroy(async);
+		ddns_client_destroy(client);
+	};
+
+	"async_errors"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+		ddns_async* async {nullptr};
+		expect(eq(ddns_async_create(client, &async), DDNS_ERROR_OK) >> fatal);
+
+		expect(eq(ddns_async_set_callbacks(async, nullptr, nullptr, nullptr), DDNS_ERROR_USAGE));
+		expect(eq(ddns_async_socket_action(async, DDNS_SOCKET_TIMEOUT, 0), DDNS_ERROR_USAGE));
+		expect(eq(ddns_async_poll(async, -1), DDNS_ERROR_USAGE));
+		expect(eq(ddns_async_poll(async, 0), DDNS_ERROR_OK));
+
+		// Invalid entries are reported through the callback too
+		ddns_local_ip local_ip {false, -1, {}, DDNS_ERROR_OK};
+		ddns_zone_search search {mock_cloudflare::api_token, "", {}, DDNS_ERROR_OK};
+		std::array<ddns_record, 2> records;
+		ddns_record_query query {"wrong-token", mock_cloudflare::zone_id, mock_cloudflare::record_name, records.size(), records.data(), 0, DDNS_ERROR_OK};
+		outcome local_ip_outcome;
+		outcome search_outcome;
+		outcome query_outcome;
+		expect(eq(ddns_async_get_local_ip(async, &local_ip, record_outcome, &local_ip_outcome), DDNS_ERROR_OK));
+		expect(eq(ddns_async_search_zone_id(async, &search, record_outcome, &search_outcome), DDNS_ERROR_OK));
+		expect(eq(ddns_async_get_records(async, &query, record_outcome, &query_outcome), DDNS_ERROR_OK));
+		expect(eq(local_ip_outcome.calls, 0));
+		expect(eq(search_outcome.calls, 0));
+
+		run_polling(async);
+		expect(eq(local_ip_outcome.calls, 1));
+		expect(eq(local_ip_outcome.error, DDNS_ERROR_USAGE));
+		expect(eq(search_outcome.calls, 1));
+		expect(eq(search_outcome.error, DDNS_ERROR_GENERIC));
+		expect(eq(search.zone_id[0], '\0'));
+		expect(eq(query_outcome.calls, 1));
+		expect(neq(query.error, DDNS_ERROR_OK));
+
+		// Operations still running are abandoned
+		outcome abandoned;
+		query = {mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records.size(), records.data(), 0, DDNS_ERROR_OK};
+		expect(eq(ddns_async_get_records(async, &query, record_outcome, &abandoned), DDNS_ERROR_OK));
+		ddns_async_destroy(async);
+		expect(eq(abandoned.calls, 0));
+
+		// The client still works on its own
+		query = {mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records.size(), records.data(), 0, DDNS_ERROR_GENERIC};
+		expect(eq(ddns_client_get_records_multi(client, 1, &query), DDNS_ERROR_OK));
+
+		ddns_client_destroy(client);
+	};
+}
@@ -0,0 +1,203 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include <curl/curl.h>
+#include <array>
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	/**
+	 * Run the whole search/get/update flow with a single client, and
+	 * compare the results with the ones of the self contained functions
+	 */
+	"client"_test = [] {
+		ddns_client* client {nullptr};
+		expect(eq(ddns_client_create(&client), DDNS_ERROR_OK) >> fatal);
+
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(
+			ddns_client_search_zone_id(
+				client,
+				test_api_token,
+				test_record_name,
+				zone_id.size(), zone_id.data()
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(
+			std::string_view{zone_id.data()},
+			std::string_view{test_zone_id}
+		));
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ip;
+		expect(eq(ddns_client_get_local_ip(client, false, local_ip.size(), local_ip.data()), DDNS_ERROR_OK));
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> expected_local_ip;
+		expect(eq(ddns_get_local_ip(false, expected_local_ip.size(), expected_local_ip.data()), DDNS_ERROR_OK));
+		expect(eq(
+			std::string_view{local_ip.data()},
+			std::string_view{expected_local_ip.data()}
+		));
+
+		std::array<ddns_record, 4> records;
+		std::size_t records_count {0};
+		expect(eq(
+			ddns_client_get_records(
+				client,
+				test_api_token,
+				test_zone_id,
+				test_record_name,
+				records.size(), records.data(),
+				&records_count
+			),
+			DDNS_ERROR_OK
+		));
+		expect(ge(records_count, 1U) >> fatal);
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> record_ip;
+		std::array<char, DDNS_RECORD_ID_LENGTH + 1> record_id;
+		bool aaaa;
+		expect(eq(
+			ddns_client_get_record(
+				client,
+				test_api_token,
+				test_zone_id,
+				test_record_name,
+				record_ip.size(), record_ip.data(),
+				record_id.size(), record_id.data(),
+				&aaaa
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(
+			std::string_view{record_id.data()},
+			std::string_view{records[0].id}
+		));
+		expect(eq(
+			std::string_view{record_ip.data()},
+			std::string_view{records[0].content}
+		));
+		expect(eq(aaaa, records[0].aaaa));
+
+		expect(eq(
+			ddns_client_update_record(
+				client,
+				test_api_token,
+				test_zone_id,
+				record_id.data(),
+				local_ip.data(),
+				record_ip.size(), record_ip.data()
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(
+			std::string_view{local_ip.data()},
+			std::string_view{record_ip.data()}
+		));
+
+		// The handle must still work for GET requests after a PATCH one
+		expect(eq(
+			ddns_client_get_record(
+				client,
+				test_api_token,
+				test_zone_id,
+				test_record_name,
+				record_ip.size(), record_ip.data(),
+				record_id.size(), record_id.data(),
+				&aaaa
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(
+			std::string_view{local_ip.data()},
+			std::string_view{record_ip.data()}
+		));
+
+		ddns_client_destroy(client);
+	};
+
+	/**
+	 * Look up and update the same record more than once, concurrently
+	 */
+	"client_multi"_test = [] {
+		ddns_client* client {nullptr};
+		expect(eq(ddns_client_create(&client), DDNS_ERROR_OK) >> fatal);
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ip;
+		expect(eq(ddns_client_get_local_ip(client, false, local_ip.size(), local_ip.data()), DDNS_ERROR_OK));
+
+		std::array<std::array<ddns_record, 2>, 3> records;
+		std::array<ddns_record_query, 4> queries;
+		for (std::size_t i = 0; i < records.size(); ++i) {
+			queries[i] = {test_api_token, test_zone_id, test_record_name, records[i].size(), records[i].data(), 0, DDNS_ERROR_OK};
+		}
+		// An invalid query must not affect the other ones
+		queries.back() = {"invalid api token", test_zone_id, test_record_name, 0, nullptr, 0, DDNS_ERROR_OK};
+
+		expect(eq(ddns_client_get_records_multi(client, queries.size(), queries.data()), DDNS_ERROR_GENERIC));
+		for (std::size_t i = 0; i < records.size(); ++i) {
+			expect(eq(queries[i].error, DDNS_ERROR_OK));
+			expect(ge(queries[i].records_count, 1U));
+			expect(eq(
+				std::string_view{queries[i].records[0].id},
+				std::string_view{queries[0].records[0].id}
+			));
+		}
+		expect(eq(queries.back().error, DDNS_ERROR_USAGE));
+
+		std::array<ddns_record_update, 2> updates;
+		for (ddns_record_update& update : updates) {
+			update = {test_api_token, test_zone_id, records[0][0].id, local_ip.data(), {}, DDNS_ERROR_OK};
+		}
+
+		expect(eq(ddns_client_update_records_multi(client, updates.size(), updates.data()), DDNS_ERROR_OK));
+		for (const ddns_record_update& update : updates) {
+			expect(eq(update.error, DDNS_ERROR_OK));
+			expect(eq(
+				std::string_view{update.record_ip},
+				std::string_view{local_ip.data()}
+			));
+		}
+
+		ddns_client_destroy(client);
+	};
+
+	"client_bad_usage"_test = [] {
+		ddns_client* client {nullptr};
+		expect(eq(ddns_client_create(&client), DDNS_ERROR_OK) >> fatal);
+
+		std::array<ddns_record, 2> records;
+		std::size_t records_count {0};
+		expect(eq(
+			ddns_client_get_records(
+				client,
+				"invalid api token",
+				test_zone_id,
+				test_record_name,
+				records.size(), records.data(),
+				&records_count
+			),
+			DDNS_ERROR_USAGE
+		));
+
+		std::array<char, DDNS_ZONE_ID_LENGTH> too_small_zone_id;
+		expect(eq(
+			ddns_client_search_zone_id(
+				client,
+				test_api_token,
+				test_record_name,
+				too_small_zone_id.size(), too_small_zone_id.data()
+			),
+			DDNS_ERROR_USAGE
+		));
+
+		ddns_client_destroy(client);
+	};
+
+	curl_global_cleanup();
+}
@@ -9,5 +9,13 @@
 #include <boost/ut.hpp>
 #include <ddns/cloudflare-ddns.h>
 #include "credentials.hpp"
+#include <chrono>
 
 using namespace boost::ut;
+
+/*
+ * The milliseconds passed since start
+ */
+inline long elapsed_ms(const std::chrono::steady_clock::time_point start) {
+	return static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+struct parsed_record {
+	std::string id;
+	std::string name;
+	std::string type;
+	std::string content;
+	long long ttl;
+	bool proxied;
+	unsigned overflown;
+};
+
+void collect(void* const user, const priv::json::record& record) {
+	static_cast<std::vector<parsed_record>*>(user)->push_back({
+		std::string{record.id_sv()},
+		std::string{record.name_sv()},
+		std::string{record.type_sv()},
+		std::string{record.content_sv()},
+		record.ttl_value,
+		record.proxied_value,
+		record.overflown
+	});
+}
+
+/*
+ * Feeds response to parser chunk_size bytes at a time, like curl would
+ */
+bool parse(priv::json::response_parser& parser, const std::string_view response, const std::size_t chunk_size) {
+	for (std::size_t i = 0; i < response.size(); i += chunk_size) {
+		if (!parser.feed(response.data() + i, std::min(chunk_size, response.size() - i))) {
+			return false;
+		}
+	}
+	return parser.finish();
+}
+
+constexpr std::string_view listing {R"({
+	"result": [
+		{
+			"id": "372e67954025e0ba6aaa6d586b9e0b59",
+			"zone_id": "023e105f4ecef8ad9ca31a8372d0c353",
+			"zone_name": "example.com",
+			"name": "ddns.example.com",
+			"type": "A",
+			"content": "198.51.100.4",
+			"proxiable": true,
+			"proxied": false,
+			"ttl": 3600,
+			"settings": {"flatten_cname": false},
+			"meta": {"id": "not a record id", "content": "nor an address"},
+			"comment": "Escapes: \"\\ è 😀",
+			"tags": ["a", {"id": "neither"}]
+		},
+		{
+			"content": "2001:db8::4",
+			"type": "AAAA",
+			"name": "ddns.example.com",
+			"ttl": 1,
+			"proxied": true,
+			"id": "372e67954025e0ba6aaa6d586b9e0b60"
+		}
+	],
+	"success": true,
+	"errors": [],
+	"messages": [],
+	"result_info": {"page": 1, "per_page": 25, "count": 2, "total_count": 2}
+})"};
+
+} // namespace
+
+int main() {
+	"json_listing"_test = [] {
+		// Every chunk size, so that tokens get split everywhere
+		for (std::size_t chunk_size = 1; chunk_size <= listing.size(); chunk_size += chunk_size < 64 ? 1 : 97) {
+			std::vector<parsed_record> records;
+			priv::json::response_parser parser {collect, &records};
+
+			expect(eq(parse(parser, listing, chunk_size), true) >> fatal) << "chunk size" << chunk_size;
+			expect(parser.success());
+			expect(eq(parser.records(), 2U));
+			expect(eq(records.size(), 2U) >> fatal);
+
+			expect(eq(records[0].id, std::string{"372e67954025e0ba6aaa6d586b9e0b59"}));
+			expect(eq(records[0].name, std::string{"ddns.example.com"}));
+			expect(eq(records[0].type, std::string{"A"}));
+			expect(eq(records[0].content, std::string{"198.51.100.4"}));
+			expect(eq(records[0].ttl, 3600LL));
+			expect(!records[0].proxied);
+
+			expect(eq(records[1].id, std::string{"372e67954025e0ba6aaa6d586b9e0b60"}));
+			expect(eq(records[1].content, std::string{"2001:db8::4"}));
+			expect(eq(records[1].type, std::string{"AAAA"}));
+			expect(records[1].proxied);
+		}
+	};
+
+	"json_batch"_test = [] {
+		std::vector<parsed_record> records;
+		priv::json::response_parser parser {collect, &records};
+
+		const std::string_view response {
+			R"({"result":{"deletes":[],"patches":[)"
+			R"({"id":"00000000000000000000000000000001","type":"A","content":"192.0.2.1","meta":{}},)"
+			R"({"id":"00000000000000000000000000000002","type":"AAAA","content":"2001:db8::1"})"
+			R"(],"puts":[],"posts":[]},"success":true,"errors":[],"messages":[]})"
+		};
+		expect(eq(parse(parser, response, response.size()), true) >> fatal);
+		expect(parser.success());
+		expect(eq(records.size(), 3U) >> fatal);
+		expect(eq(records[0].content, std::string{"192.0.2.1"}));
+		expect(eq(records[1].content, std::string{"2001:db8::1"}));
+		// The result object itself, which has no fields of a record
+		expect(eq(records[2].id, std::string{}));
+	};
+
+	"json_errors"_test = [] {
+		priv::json::response_parser parser;
+
+		const std::string_view response {
+			R"({"result":null,"success":false,"errors":[{"code":9109,"message":"Invalid \"access\" token"},{"code":1,"message":"x"}],"messages":[]})"
+		};
+		expect(eq(parse(parser, response, 7), true) >> fatal);
+		expect(!parser.success());
+		expect(eq(parser.records(), 0U));
+		expect(eq(parser.errors(), 2U));
+		expect(eq(parser.error_code(), 9109LL));
+		expect(eq(std::string_view{parser.error_message()}, std::string_view{R"(Invalid "access" token)"}));
+	};
+
+	"json_overflow"_test = [] {
+		std::vector<parsed_record> records;
+		priv::json::response_parser parser {collect, &records};
+
+		const std::string long_content(1000, 'a');
+		const std::string response {R"({"success":true,"result":[{"id":"x","type":"TXT","content":")" + long_content + R"("}]})"};
+		expect(eq(parse(parser, response, 100), true) >> fatal);
+		expect(parser.success());
+		expect(eq(records.size(), 1U) >> fatal);
+		expect(eq(records[0].overflown, unsigned{priv::json::record::content}));
+		expect(eq(records[0].content, std::string{}));
+	};
+
+	"json_long_numbers"_test = [] {
+		std::vector<parsed_record> records;
+		priv::json::response_parser parser {collect, &records};
+
+		const std::string_view response {
+			R"({"success":false,"result_info":{"total_count":123456789012345678901234},"result":[{"id":"x","ttl":99999999999999999999}],)"
+			R"("errors":[{"code":-99999999999999999999,"message":"x"}]})"
+		};
+		expect(eq(parse(parser, response, 5), true) >> fatal);
+		expect(eq(records.size(), 1U) >> fatal);
+		// Numbers not fitting are left out, like ones that aren't integers
+		expect(eq(records[0].ttl, 0LL));
+		expect(eq(parser.errors(), 1U));
+		expect(eq(parser.error_code(), 0LL));
+	};
+
+	"json_malformed"_test = [] {
+		for (const std::string_view response : {
+			R"({"success":true,})",
+			R"({"success":tru})",
+			R"({"success" true})",
+			R"({"result":[1,2}})",
+			R"({"result":"\x"})",
+			R"({"success":true}})",
+			"{\"result\":\"\n\"}"
+		}) {
+			priv::json::response_parser parser;
+			expect(!parse(parser, response, 3)) << response;
+			expect(!parser.success());
+		}
+
+		// Cut short
+		priv::json::response_parser parser;
+		expect(parser.feed(listing.data(), listing.size() / 2));
+		expect(!parser.success());
+	};
+}
@@ -0,0 +1,157 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+/*
+ * A zone with records_count records. hostN.example.com has the A record 2N
+ * and the AAAA record 2N+1.
+ */
+void fill_zone(mock_cloudflare& cloudflare, const std::size_t records_count) {
+	cloudflare.clear_records();
+	for (std::size_t i = 0; i < records_count; ++i) {
+		const std::size_t host {i / 2};
+		const bool aaaa {i % 2 == 1};
+		char id[33];
+		char name[48];
+		char content[48];
+		std::snprintf(id, sizeof id, "%031zx%d", host, aaaa);
+		std::snprintf(name, sizeof name, "host%zu.example.com", host);
+		std::snprintf(content, sizeof content, "%s%zu", aaaa ? "2001:db8::" : "192.0.2.", host % 250);
+		cloudflare.add_record(id, name, aaaa, content);
+	}
+}
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"list_records"_test = [] {
+		mock_cloudflare cloudflare;
+		fill_zone(cloudflare, 59);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		ddns_zone_index* index {nullptr};
+		expect(eq(ddns_client_list_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, &index), DDNS_ERROR_OK) >> fatal);
+		expect(eq(ddns_zone_index_size(index), 59U));
+
+		const std::vector requests {server.requests()};
+		expect(eq(requests.size(), std::size_t{(59U + DDNS_RECORDS_PER_PAGE - 1U) / DDNS_RECORDS_PER_PAGE}));
+
+		std::array<ddns_record, 2> records;
+		std::size_t records_count {0};
+
+		expect(eq(ddns_zone_index_find(index, "host6.example.com", records.size(), records.data(), &records_count), DDNS_ERROR_OK));
+		expect(eq(records_count, 2U) >> fatal);
+		expect(records[0].aaaa != records[1].aaaa);
+		const ddns_record& a {records[0].aaaa ? records[1] : records[0]};
+		expect(eq(std::string_view{a.content}, std::string_view{"192.0.2.6"}));
+		expect(eq(std::string_view{a.id}, std::string_view{"00000000000000000000000000000060"}));
+
+		expect(eq(ddns_zone_index_find(index, "host29.example.com", records.size(), records.data(), &records_count), DDNS_ERROR_OK));
+		expect(eq(records_count, 1U) >> fatal);
+		expect(eq(std::string_view{records[0].content}, std::string_view{"192.0.2.29"}));
+
+		expect(eq(ddns_zone_index_find(index, "host30.example.com", records.size(), records.data(), &records_count), DDNS_ERROR_OK));
+		expect(eq(records_count, 0U));
+
+		// Only the number of records is written if there's no room
+		expect(eq(ddns_zone_index_find(index, "host0.example.com", 0, nullptr, &records_count), DDNS_ERROR_OK));
+		expect(eq(records_count, 2U));
+
+		ddns_zone_index_destroy(index);
+		ddns_client_destroy(client);
+	};
+
+	"list_records_full_pages"_test = [] {
+		// Exactly two full pages, so an empty one has to be fetched to know
+		// that the second was the last one
+		mock_cloudflare cloudflare;
+		fill_zone(cloudflare, DDNS_RECORDS_PER_PAGE * 2U);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		ddns_zone_index* index {nullptr};
+		expect(eq(ddns_client_list_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, &index), DDNS_ERROR_OK) >> fatal);
+		expect(eq(ddns_zone_index_size(index), std::size_t{DDNS_RECORDS_PER_PAGE * 2U}));
+		expect(eq(server.requests().size(), 3U));
+
+		ddns_zone_index_destroy(index);
+		ddns_client_destroy(client);
+	};
+
+	"list_records_large_page"_test = [] {
+		mock_cloudflare cloudflare;
+		fill_zone(cloudflare, 80);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		ddns_zone_index* index {nullptr};
+		expect(eq(ddns_client_list_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, &index), DDNS_ERROR_OK) >> fatal);
+		expect(eq(ddns_zone_index_size(index), 80U));
+
+		// The page is larger than what curl writes at once, and is kept whole
+		std::size_t response_size {0};
+		const std::string_view response {ddns_client_response(client, &response_size), response_size};
+		expect(gt(response.size(), std::size_t{CURL_MAX_WRITE_SIZE}));
+		expect(eq(response.substr(response.size() - 2), std::string_view{"}}"}));
+
+		ddns_zone_index_destroy(index);
+		ddns_client_destroy(client);
+	};
+
+	"list_records_empty_zone"_test = [] {
+		mock_cloudflare cloudflare;
+		fill_zone(cloudflare, 0);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		ddns_zone_index* index {nullptr};
+		expect(eq(ddns_client_list_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, &index), DDNS_ERROR_OK) >> fatal);
+		expect(eq(ddns_zone_index_size(index), 0U));
+
+		std::size_t records_count {1};
+		expect(eq(ddns_zone_index_find(index, "example.com", 0, nullptr, &records_count), DDNS_ERROR_OK));
+		expect(eq(records_count, 0U));
+
+		ddns_zone_index_destroy(index);
+		ddns_client_destroy(client);
+	};
+
+	"list_records_bad_usage"_test = [] {
+		const mock_server server {[](const mock_request&) {
+			return mock_cloudflare::failure(403, 10000, "Authentication error");
+		}};
+		ddns_client* const client {make_client(server)};
+
+		ddns_zone_index* index {nullptr};
+		expect(eq(ddns_client_list_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, &index), DDNS_ERROR_GENERIC));
+		expect(eq(ddns_client_list_records(client, "an invalid token", mock_cloudflare::zone_id, &index), DDNS_ERROR_USAGE));
+		expect(eq(ddns_client_list_records(client, mock_cloudflare::api_token, "an invalid zone id", &index), DDNS_ERROR_USAGE));
+		expect(eq(server.requests().size(), 1U));
+
+		CURL* curl {curl_easy_init()};
+		expect(eq(ddns_list_records_raw(mock_cloudflare::api_token, mock_cloudflare::zone_id, 0, &curl), DDNS_ERROR_USAGE));
+		curl_easy_cleanup(curl);
+
+		ddns_client_destroy(client);
+	};
+
+	curl_global_cleanup();
+}
@@ -0,0 +1,323 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/*
+ * The same flow of the client test, run against mock_cloudflare so that it
+ * needs neither an API token nor an Internet connection
+ */
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"mock_client"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(
+			ddns_client_search_zone_id(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::record_name,
+				zone_id.size(), zone_id.data()
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(
+			std::string_view{zone_id.data()},
+			std::string_view{mock_cloudflare::zone_id}
+		));
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ip;
+		expect(eq(ddns_client_get_local_ip(client, false, local_ip.size(), local_ip.data()), DDNS_ERROR_OK));
+		expect(eq(
+			std::string_view{local_ip.data()},
+			std::string_view{mock_cloudflare::local_ip}
+		));
+
+		std::array<ddns_local_ip, 1> local_ips {{{false, 0, {}, DDNS_ERROR_OK}}};
+		expect(eq(ddns_client_get_local_ips(client, local_ips.size(), local_ips.data()), DDNS_ERROR_OK));
+		expect(eq(
+			std::string_view{local_ips[0].ip},
+			std::string_view{mock_cloudflare::local_ip}
+		));
+
+		std::array<ddns_record, 4> records;
+		std::size_t records_count {0};
+		expect(eq(
+			ddns_client_get_records(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::zone_id,
+				mock_cloudflare::record_name,
+				records.size(), records.data(),
+				&records_count
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(records_count, 2U) >> fatal);
+		expect(eq(std::string_view{records[0].id}, std::string_view{mock_cloudflare::a_record_id}));
+		expect(eq(std::string_view{records[0].content}, std::string_view{mock_cloudflare::a_record_ip}));
+		expect(!records[0].aaaa);
+		expect(eq(std::string_view{records[1].content}, std::string_view{mock_cloudflare::aaaa_record_ip}));
+		expect(records[1].aaaa);
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> record_ip;
+		std::array<char, DDNS_RECORD_ID_LENGTH + 1> record_id;
+		bool aaaa {true};
+		expect(eq(
+			ddns_client_get_record(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::zone_id,
+				mock_cloudflare::record_name,
+				record_ip.size(), record_ip.data(),
+				record_id.size(), record_id.data(),
+				&aaaa
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(std::string_view{record_id.data()}, std::string_view{mock_cloudflare::a_record_id}));
+		expect(eq(std::string_view{record_ip.data()}, std::string_view{mock_cloudflare::a_record_ip}));
+		expect(!aaaa);
+
+		expect(eq(
+			ddns_client_update_record(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::zone_id,
+				record_id.data(),
+				local_ip.data(),
+				record_ip.size(), record_ip.data()
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(std::string_view{record_ip.data()}, std::string_view{local_ip.data()}));
+		expect(eq(cloudflare.content(mock_cloudflare::a_record_id), std::string{mock_cloudflare::local_ip}));
+
+		// The handle must still work for GET requests after a PATCH one
+		expect(eq(
+			ddns_client_get_record(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::zone_id,
+				mock_cloudflare::record_name,
+				record_ip.size(), record_ip.data(),
+				record_id.size(), record_id.data(),
+				&aaaa
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(std::string_view{record_ip.data()}, std::string_view{local_ip.data()}));
+
+		ddns_client_destroy(client);
+	};
+
+	"mock_client_multi"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		std::array<std::array<ddns_record, 2>, 2> records;
+		std::array<ddns_record_query, 3> queries {{
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records[0].size(), records[0].data(), 0, DDNS_ERROR_OK},
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, "missing.example.com", records[1].size(), records[1].data(), 0, DDNS_ERROR_OK},
+			// An invalid query must not affect the other ones
+			{"invalid api token", mock_cloudflare::zone_id, mock_cloudflare::record_name, 0, nullptr, 0, DDNS_ERROR_OK}
+		}};
+		expect(eq(ddns_client_get_records_multi(client, queries.size(), queries.data()), DDNS_ERROR_GENERIC));
+		expect(eq(queries[0].error, DDNS_ERROR_OK));
+		expect(eq(queries[0].records_count, 2U));
+		expect(eq(queries[1].error, DDNS_ERROR_OK));
+		expect(eq(queries[1].records_count, 0U));
+		expect(eq(queries[2].error, DDNS_ERROR_USAGE));
+
+		std::array<ddns_record_update, 2> updates {{
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::a_record_id, "198.51.100.1", {}, DDNS_ERROR_OK},
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::aaaa_record_id, "2001:db8::2", {}, DDNS_ERROR_OK}
+		}};
+		expect(eq(ddns_client_update_records_multi(client, updates.size(), updates.data()), DDNS_ERROR_OK));
+		for (const ddns_record_update& update : updates) {
+			expect(eq(update.error, DDNS_ERROR_OK));
+			expect(eq(cloudflare.content(update.record_id), std::string{update.new_ip}));
+			expect(eq(std::string_view{update.record_ip}, std::string_view{update.new_ip}));
+		}
+
+		ddns_client_destroy(client);
+	};
+
+	"mock_client_multi_duplicates"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		std::array<ddns_record, 1> few;
+		std::array<ddns_record, 2> all;
+		std::array<ddns_record_query, 2> queries {{
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, few.size(), few.data(), 0, DDNS_ERROR_OK},
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, all.size(), all.data(), 0, DDNS_ERROR_OK}
+		}};
+		expect(eq(ddns_client_get_records_multi(client, queries.size(), queries.data()), DDNS_ERROR_OK));
+		expect(eq(server.requests().size(), 1U));
+		for (const ddns_record_query& query : queries) {
+			expect(eq(query.error, DDNS_ERROR_OK));
+			expect(eq(query.records_count, 2U));
+		}
+		expect(eq(std::string_view{few[0].id}, std::string_view{all[0].id}));
+		expect(eq(std::string_view{few[0].content}, std::string_view{all[0].content}));
+		expect(all[0].aaaa != all[1].aaaa);
+
+		ddns_client_destroy(client);
+	};
+
+	/**
+	 * What Cloudflare answers when something is wrong must make the
+	 * functions fail, without the need of a broken account
+	 */
+	"mock_client_errors"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		// Well formed, but not the one of the account
+		constexpr const char* wrong_api_token {"wrong-api-token-wrong-api-token-wrong-ap"};
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(
+			ddns_client_search_zone_id(client, wrong_api_token, mock_cloudflare::record_name, zone_id.size(), zone_id.data()),
+			DDNS_ERROR_GENERIC
+		));
+		// No zone is a suffix of the name
+		expect(eq(
+			ddns_client_search_zone_id(client, mock_cloudflare::api_token, "ddns.example.org", zone_id.size(), zone_id.data()),
+			DDNS_ERROR_GENERIC
+		));
+
+		std::array<ddns_record, 2> records;
+		std::size_t records_count {0};
+		expect(eq(
+			ddns_client_get_records(
+				client,
+				mock_cloudflare::api_token,
+				"ffffffffffffffffffffffffffffffff",
+				mock_cloudflare::record_name,
+				records.size(), records.data(),
+				&records_count
+			),
+			DDNS_ERROR_GENERIC
+		));
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> record_ip;
+		std::array<char, DDNS_RECORD_ID_LENGTH + 1> record_id;
+		bool aaaa;
+		expect(eq(
+			ddns_client_get_record(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::zone_id,
+				"missing.example.com",
+				record_ip.size(), record_ip.data(),
+				record_id.size(), record_id.data(),
+				&aaaa
+			),
+			DDNS_ERROR_GENERIC
+		));
+
+		expect(eq(
+			ddns_client_update_record(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::zone_id,
+				"ffffffffffffffffffffffffffffffff",
+				"198.51.100.1",
+				record_ip.size(), record_ip.data()
+			),
+			DDNS_ERROR_GENERIC
+		));
+		expect(eq(
+			ddns_client_update_record(
+				client,
+				wrong_api_token,
+				mock_cloudflare::zone_id,
+				mock_cloudflare::a_record_id,
+				"198.51.100.1",
+				record_ip.size(), record_ip.data()
+			),
+			DDNS_ERROR_GENERIC
+		));
+		expect(eq(cloudflare.content(mock_cloudflare::a_record_id), std::string{mock_cloudflare::a_record_ip}));
+
+		// A batch is applied as a whole or not at all
+		std::array<ddns_record, 2> batch {{
+			{"", "198.51.100.1", false},
+			{"ffffffffffffffffffffffffffffffff", "198.51.100.2", false}
+		}};
+		std::snprintf(batch[0].id, sizeof batch[0].id, "%s", mock_cloudflare::a_record_id);
+		expect(eq(
+			ddns_client_update_records_batch(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, batch.size(), batch.data()),
+			DDNS_ERROR_GENERIC
+		));
+		expect(eq(cloudflare.content(mock_cloudflare::a_record_id), std::string{mock_cloudflare::a_record_ip}));
+
+		// The trace URL is bounded like the base URL
+		const std::string long_url {"https://127.0.0.1/" + std::string(DDNS_TRACE_URL_MAX_LENGTH, 'a')};
+		expect(eq(ddns_client_set_trace_url(client, long_url.c_str()), DDNS_ERROR_USAGE));
+		expect(eq(ddns_client_set_trace_url(client, ""), DDNS_ERROR_USAGE));
+		expect(eq(ddns_client_set_trace_url(client, (server.base_url() + "/missing").c_str()), DDNS_ERROR_OK));
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ip;
+		expect(eq(ddns_client_get_local_ip(client, false, local_ip.size(), local_ip.data()), DDNS_ERROR_GENERIC));
+
+		ddns_client_destroy(client);
+	};
+
+	"mock_client_large_responses"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		// Only the first records are written, but all of them are counted
+		std::array<ddns_record, 4> records;
+		std::size_t records_count {0};
+		expect(eq(
+			ddns_client_get_records(
+				client,
+				mock_cloudflare::api_token,
+				mock_cloudflare::zone_id,
+				mock_cloudflare::pool_name,
+				records.size(), records.data(),
+				&records_count
+			),
+			DDNS_ERROR_OK
+		));
+		expect(eq(records_count, mock_cloudflare::pool_size));
+		expect(eq(std::string_view{records[3].content}, std::string_view{"203.0.113.3"}));
+
+		std::size_t response_size {0};
+		const std::string_view response {ddns_client_response(client, &response_size), response_size};
+		expect(gt(response.size(), std::size_t{CURL_MAX_WRITE_SIZE}));
+
+		// The whole zone, over more than one page
+		ddns_zone_index* index {nullptr};
+		expect(eq(ddns_client_list_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, &index), DDNS_ERROR_OK) >> fatal);
+		expect(eq(ddns_zone_index_size(index), mock_cloudflare::pool_size + 2U));
+		expect(eq(ddns_zone_index_find(index, mock_cloudflare::pool_name, 0, nullptr, &records_count), DDNS_ERROR_OK));
+		expect(eq(records_count, mock_cloudflare::pool_size));
+		ddns_zone_index_destroy(index);
+
+		ddns_client_destroy(client);
+	};
+
+	curl_global_cleanup();
+}
@@ -0,0 +1,307 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "mock_cloudflare.hpp"
+
+#include <array> /* std::array */
+#include <cstdio> /* std::snprintf */
+#include <mutex> /* std::lock_guard */
+#include <string> /* std::string, std::stoul, std::to_string */
+#include <string_view> /* std::string_view */
+#include <utility> /* std::move, std::pair */
+#include <vector> /* std::vector */
+
+namespace {
+
+constexpr std::string_view zones_prefix {"/client/v4/zones/"};
+constexpr std::string_view zones_query {"?per_page=1&name="};
+constexpr std::string_view dns_records_query {"/dns_records?type=A,AAAA&name="};
+constexpr std::string_view list_query {"/dns_records?type=A,AAAA&per_page="};
+constexpr std::string_view page_query {"&page="};
+constexpr std::string_view batch_path {"/dns_records/batch"};
+constexpr std::string_view dns_records_path {"/dns_records/"};
+constexpr std::string_view trace_path {"/cdn-cgi/trace"};
+
+bool starts_with(const std::string_view string, const std::string_view prefix) {
+	return string.substr(0, prefix.size()) == prefix;
+}
+
+/*
+ * The string value following key in a JSON body, starting from position,
+ * which is moved past it
+ */
+std::string string_after(const std::string_view body, const std::string_view key, std::size_t& position) {
+	const std::size_t key_position {body.find(key, position)};
+	if (key_position == std::string_view::npos) {
+		position = std::string_view::npos;
+		return {};
+	}
+	const std::size_t begin {body.find('"', key_position + key.size()) + 1};
+	const std::size_t end {body.find('"', begin)};
+	position = end;
+	return std::string{body.substr(begin, end - begin)};
+}
+
+/*
+ * A record as Cloudflare describes it
+ */
+std::string describe(const std::string_view id, const std::string_view name, const bool aaaa, const std::string_view content) {
+	return
+		R"({"id":")" + std::string{id} + R"(","zone_id":")" + mock_cloudflare::zone_id
+		+ R"(","zone_name":")" + mock_cloudflare::zone_name + R"(","name":")" + std::string{name}
+		+ R"(","type":")" + (aaaa ? "AAAA" : "A") + R"(","content":")" + std::string{content}
+		+ R"(","proxiable":true,"proxied":false,"ttl":1,"settings":{},"meta":{},"comment":null,"tags":[],)"
+		R"("created_on":"2026-01-01T00:00:00.000000Z","modified_on":"2026-01-01T00:00:00.000000Z"})";
+}
+
+} // namespace
+
+mock_cloudflare::mock_cloudflare()
+	: api_tokens_ {api_token}
+	, zones_ {{zone_name, zone_id}} {
+	records_.push_back({a_record_id, record_name, false, a_record_ip});
+	records_.push_back({aaaa_record_id, record_name, true, aaaa_record_ip});
+	for (std::size_t i = 0; i < pool_size; ++i) {
+		char id[33];
+		char content[16];
+		std::snprintf(id, sizeof id, "%032zx", 0x1000U + i);
+		std::snprintf(content, sizeof content, "203.0.113.%zu", i % 250U);
+		records_.push_back({id, pool_name, false, content});
+	}
+}
+
+mock_response mock_cloudflare::operator()(const mock_request& request) {
+	const std::string_view target {request.target};
+
+	if (target == trace_path) {
+		if (request.method != "GET") {
+			return {405, ""};
+		}
+		return {200,
+			"fl=29f105\nh=one.one.one.one\nip=" + std::string{local_ip} + "\nts=1767225600.000\n"
+			"visit_scheme=https\nuag=curl\ncolo=MXP\nsliver=none\nhttp=http/1.1\nloc=IT\n"
+			"tls=TLSv1.3\nsni=plaintext\nwarp=off\ngateway=off\nrbi=off\nkex=X25519\n"
+		};
+	}
+
+	if (!starts_with(target, zones_prefix)) {
+		return failure(404, 7000, "No route for that URI");
+	}
+	if (!authorized(request.authorization)) {
+		return failure(403, 9109, "Invalid access token");
+	}
+
+	const std::string_view path {target.substr(zones_prefix.size())};
+	if (starts_with(path, zones_query)) {
+		return request.method == "GET" ? zones(path.substr(zones_query.size())) : failure(405, 10000, "Method not allowed");
+	}
+
+	if (!starts_with(path, zone_id)) {
+		return failure(404, 7003, "Could not route to /zones, perhaps your object identifier is invalid?");
+	}
+	const std::string_view zone_path {path.substr(std::string_view{zone_id}.size())};
+
+	if (request.method == "GET" && starts_with(zone_path, dns_records_query)) {
+		return dns_records(zone_path.substr(dns_records_query.size()));
+	}
+	if (request.method == "GET" && starts_with(zone_path, list_query)) {
+		return list(zone_path.substr(list_query.size()));
+	}
+	if (request.method == "POST" && zone_path == batch_path) {
+		return batch(request.body);
+	}
+	if (request.method == "PATCH" && starts_with(zone_path, dns_records_path)) {
+		return patch(zone_path.substr(dns_records_path.size()), request.body);
+	}
+	return failure(404, 7003, "Could not route");
+}
+
+void mock_cloudflare::add_api_token(const std::string_view token) {
+	const std::lock_guard lock {mutex_};
+	api_tokens_.emplace_back(token);
+}
+
+void mock_cloudflare::add_zone(const std::string_view name, const std::string_view id) {
+	const std::lock_guard lock {mutex_};
+	zones_.emplace_back(name, id);
+}
+
+void mock_cloudflare::clear_records() {
+	const std::lock_guard lock {mutex_};
+	records_.clear();
+}
+
+void mock_cloudflare::add_record(const std::string_view id, const std::string_view name, const bool aaaa, const std::string_view content) {
+	const std::lock_guard lock {mutex_};
+	records_.push_back({std::string{id}, std::string{name}, aaaa, std::string{content}});
+}
+
+std::string mock_cloudflare::content(const std::string_view record_id) const {
+	const std::lock_guard lock {mutex_};
+	for (const record& record : records_) {
+		if (record.id == record_id) {
+			return record.content;
+		}
+	}
+	return {};
+}
+
+mock_response mock_cloudflare::success(const std::string_view result) {
+	return {200, R"({"result":)" + std::string{result} + R"(,"success":true,"errors":[],"messages":[]})"};
+}
+
+mock_response mock_cloudflare::failure(const int status, const int code, const std::string_view message) {
+	return {status,
+		R"({"result":null,"success":false,"errors":[{"code":)" + std::to_string(code)
+		+ R"(,"message":")" + std::string{message} + R"("}],"messages":[]})"
+	};
+}
+
+bool mock_cloudflare::authorized(const std::string_view authorization) const {
+	const std::lock_guard lock {mutex_};
+	for (const std::string& token : api_tokens_) {
+		if (authorization == "Bearer " + token) {
+			return true;
+		}
+	}
+	return false;
+}
+
+mock_response mock_cloudflare::zones(const std::string_view query) const {
+	const std::lock_guard lock {mutex_};
+	for (const auto& [name, id] : zones_) {
+		if (query == name) {
+			return success(
+				R"([{"id":")" + id + R"(","name":")" + name + R"(","status":"active","paused":false,)"
+				R"("type":"full","development_mode":0,"name_servers":["ns1.example.net","ns2.example.net"]}])"
+			);
+		}
+	}
+	return success("[]");
+}
+
+mock_response mock_cloudflare::dns_records(const std::string_view query) const {
+	const std::lock_guard lock {mutex_};
+
+	std::string result {"["};
+	std::size_t count {0};
+	for (const record& record : records_) {
+		if (record.name != query) {
+			continue;
+		}
+		if (count++ != 0) {
+			result += ',';
+		}
+		result += describe(record.id, record.name, record.aaaa, record.content);
+	}
+	result += ']';
+
+	mock_response response {success(result)};
+	response.body.insert(response.body.size() - 1,
+		R"(,"result_info":{"page":1,"per_page":100,"count":)" + std::to_string(count)
+		+ R"(,"total_count":)" + std::to_string(count) + "}"
+	);
+	return response;
+}
+
+mock_response mock_cloudflare::list(const std::string_view query) const {
+	const std::size_t page_key {query.find(page_query)};
+	if (page_key == std::string_view::npos) {
+		return failure(400, 1004, "DNS Validation Error");
+	}
+	const std::size_t per_page {std::stoul(std::string{query.substr(0, page_key)})};
+	const std::size_t page {std::stoul(std::string{query.substr(page_key + page_query.size())})};
+	if (per_page == 0 || page == 0) {
+		return failure(400, 1004, "DNS Validation Error");
+	}
+
+	const std::lock_guard lock {mutex_};
+
+	std::string result {"["};
+	for (std::size_t i = (page - 1) * per_page; i < records_.size() && i < page * per_page; ++i) {
+		if (i != (page - 1) * per_page) {
+			result += ',';
+		}
+		result += describe(records_[i].id, records_[i].name, records_[i].aaaa, records_[i].content);
+	}
+	result += ']';
+
+	mock_response response {success(result)};
+	response.body.insert(response.body.size() - 1,
+		R"(,"result_info":{"page":)" + std::to_string(page) + R"(,"per_page":)" + std::to_string(per_page)
+		+ R"(,"total_count":)" + std::to_string(records_.size()) + "}"
+	);
+	return response;
+}
+
+mock_response mock_cloudflare::patch(const std::string_view record_id, const std::string_view body) {
+	std::size_t position {0};
+	const std::string content {string_after(body, R"("content":)", position)};
+	if (position == std::string_view::npos || content.empty()) {
+		return failure(400, 9021, "Invalid DNS record content");
+	}
+
+	const std::lock_guard lock {mutex_};
+	for (record& record : records_) {
+		if (record.id == record_id) {
+			record.content = content;
+			return success(describe(record.id, record.name, record.aaaa, record.content));
+		}
+	}
+	return failure(404, 81044, "Record does not exist.");
+}
+
+mock_response mock_cloudflare::batch(const std::string_view body) {
+	const std::lock_guard lock {mutex_};
+
+	// Cloudflare applies either all the patches or none of them
+	std::vector<std::pair<record*, std::string>> patches;
+	for (std::size_t position = 0; position != std::string_view::npos;) {
+		const std::string id {string_after(body, R"("id":)", position)};
+		if (position == std::string_view::npos) {
+			break;
+		}
+		std::string content {string_after(body, R"("content":)", position)};
+		if (position == std::string_view::npos) {
+			return failure(400, 9021, "Invalid DNS record content");
+		}
+
+		record* found {nullptr};
+		for (record& record : records_) {
+			if (record.id == id) {
+				found = &record;
+			}
+		}
+		if (found == nullptr) {
+			return failure(404, 81044, "Record does not exist.");
+		}
+		patches.emplace_back(found, std::move(content));
+	}
+
+	std::string result {R"({"deletes":[],"patches":[)"};
+	for (std::size_t i = 0; i < patches.size(); ++i) {
+		record& record {*patches[i].first};
+		record.content = std::move(patches[i].second);
+		if (i != 0) {
+			result += ',';
+		}
+		result += describe(record.id, record.name, record.aaaa, record.content);
+	}
+	result += R"(],"puts":[],"posts":[]})";
+	return success(result);
+}
+
+ddns_error search_zone(ddns_client* const client, const char* const api_token, const char* const record_name) {
+	std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+	return ddns_client_search_zone_id(client, api_token, record_name, zone_id.size(), zone_id.data());
+}
+
+ddns_error update_a_record(ddns_client* const client, const char* const api_token) {
+	ddns_record record {};
+	std::snprintf(record.id, sizeof record.id, "%s", mock_cloudflare::a_record_id);
+	std::snprintf(record.content, sizeof record.content, "%s", mock_cloudflare::local_ip);
+	return ddns_client_update_records_batch(client, api_token, mock_cloudflare::zone_id, 1, &record);
+}
@@ -0,0 +1,133 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+#include "mock_server.hpp"
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * The parts of Cloudflare's API used by the library, answered like
+ * Cloudflare does for a single zone, example.com, along with the
+ * /cdn-cgi/trace page used to find the local address. It is meant to be
+ * the handler of a mock_server, passed with std::ref(), so that tests can
+ * run without an API token nor an Internet connection:
+ *
+ *     mock_cloudflare cloudflare;
+ *     const mock_server server {std::ref(cloudflare)};
+ *
+ * The zone starts with an A and an AAAA record for record_name, and with
+ * pool_size A records for pool_name, which make the responses listing
+ * them larger than what curl writes at once. Updated records keep their
+ * new content, and requests made with a token other than api_token are
+ * refused unless the token is added with add_api_token(). Tests needing
+ * other zones or records can add them, and ones checking how the library
+ * handles failures can wrap it in a handler answering some requests with
+ * failure().
+ */
+class mock_cloudflare {
+public:
+	static constexpr const char* api_token {"mock-api-token-mock-api-token-mock-api-t"};
+	// Well formed, but refused unless added with add_api_token()
+	static constexpr const char* other_api_token {"othr-api-token-othr-api-token-othr-api-t"};
+	static constexpr const char* zone_id {"023e105f4ecef8ad9ca31a8372d0c353"};
+	static constexpr const char* zone_name {"example.com"};
+
+	static constexpr const char* record_name {"ddns.example.com"};
+	static constexpr const char* a_record_id {"372e67954025e0ba6aaa6d586b9e0b59"};
+	static constexpr const char* a_record_ip {"192.0.2.1"};
+	static constexpr const char* aaaa_record_id {"372e67954025e0ba6aaa6d586b9e0b60"};
+	static constexpr const char* aaaa_record_ip {"2001:db8::1"};
+
+	static constexpr const char* pool_name {"pool.example.com"};
+	static constexpr std::size_t pool_size {150U};
+
+	// The address answered by /cdn-cgi/trace
+	static constexpr const char* local_ip {"198.51.100.4"};
+
+	mock_cloudflare();
+
+	mock_cloudflare(const mock_cloudflare&) = delete;
+	mock_cloudflare& operator=(const mock_cloudflare&) = delete;
+
+	mock_response operator()(const mock_request& request);
+
+	/*
+	 * Accepts the requests made with token too, as if it belonged to
+	 * another account with access to the zone
+	 */
+	void add_api_token(std::string_view token);
+
+	/*
+	 * Lets zone searches find the zone name with the ID id. Its records
+	 * can't be looked up, only the ones of zone_id can.
+	 */
+	void add_zone(std::string_view name, std::string_view id);
+
+	/*
+	 * Removes all the records of the zone, including the initial ones
+	 */
+	void clear_records();
+
+	/*
+	 * Adds a record to the zone, after the ones it already has
+	 */
+	void add_record(std::string_view id, std::string_view name, bool aaaa, std::string_view content);
+
+	/*
+	 * The current content of the record with this ID, or an empty string
+	 * if there's none
+	 */
+	std::string content(std::string_view record_id) const;
+
+	/*
+	 * A successful response of Cloudflare's API, with result as its
+	 * result
+	 */
+	static mock_response success(std::string_view result);
+
+	/*
+	 * A failed response of Cloudflare's API, with a single error
+	 */
+	static mock_response failure(int status, int code, std::string_view message);
+
+private:
+	struct record {
+		std::string id;
+		std::string name;
+		bool aaaa;
+		std::string content;
+	};
+
+	bool authorized(std::string_view authorization) const;
+	mock_response zones(std::string_view query) const;
+	mock_response dns_records(std::string_view query) const;
+	mock_response list(std::string_view query) const;
+	mock_response patch(std::string_view record_id, std::string_view body);
+	mock_response batch(std::string_view body);
+
+	mutable std::mutex mutex_;
+	std::vector<std::string> api_tokens_;
+	// Pairs of names and IDs
+	std::vector<std::pair<std::string, std::string>> zones_;
+	std::vector<record> records_;
+};
+
+/*
+ * Searches the zone of record_name with client, for the tests that only
+ * care about whether it's found and about the requests sent
+ */
+ddns_error search_zone(ddns_client* client, const char* api_token = mock_cloudflare::api_token, const char* record_name = mock_cloudflare::record_name);
+
+/*
+ * Points the A record of mock_cloudflare::record_name to
+ * mock_cloudflare::local_ip, with a single batch request
+ */
+ddns_error update_a_record(ddns_client* client, const char* api_token = mock_cloudflare::api_token);
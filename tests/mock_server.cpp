@@ -0,0 +1,348 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "mock_server.hpp"
+
+#include <csignal> /* std::signal, SIGPIPE, SIG_IGN */
+#include <cstdio> /* std::fopen, std::fclose */
+#include <ctime> /* std::time */
+#include <filesystem> /* std::filesystem::temp_directory_path, std::filesystem::remove */
+#include <stdexcept> /* std::runtime_error */
+#include <string> /* std::string, std::stoul, std::to_string */
+#include <string_view> /* std::string_view */
+#include <system_error> /* std::error_code */
+#include <thread> /* std::thread */
+#include <utility> /* std::move, std::pair */
+#include <vector> /* std::vector */
+
+#include <arpa/inet.h> /* htonl, htons, ntohs */
+#include <netinet/in.h> /* sockaddr_in, INADDR_LOOPBACK, IPPROTO_TCP */
+#include <netinet/tcp.h> /* TCP_NODELAY */
+#include <poll.h> /* poll, pollfd, POLLIN */
+#include <sys/socket.h> /* socket, bind, listen, accept, setsockopt, getsockname */
+#include <unistd.h> /* close */
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+
+namespace {
+
+/*
+ * How often the serving threads check whether they should stop
+ */
+constexpr int poll_timeout_ms {100};
+
+[[noreturn]] void fail(const char* const what) {
+	throw std::runtime_error{std::string{"mock_server: "} + what};
+}
+
+EVP_PKEY* generate_key() {
+	EVP_PKEY_CTX* const context {EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr)};
+	EVP_PKEY* key {nullptr};
+	const bool ok {
+		context != nullptr &&
+		EVP_PKEY_keygen_init(context) == 1 &&
+		EVP_PKEY_CTX_set_ec_paramgen_curve_nid(context, NID_X9_62_prime256v1) == 1 &&
+		EVP_PKEY_keygen(context, &key) == 1
+	};
+	EVP_PKEY_CTX_free(context);
+	if (!ok) {
+		fail("unable to generate the key");
+	}
+	return key;
+}
+
+/*
+ * Self-signed certificate for 127.0.0.1, which is also its own CA
+ */
+X509* generate_certificate(EVP_PKEY* const key) {
+	X509* const certificate {X509_new()};
+	if (certificate == nullptr) {
+		fail("unable to create the certificate");
+	}
+
+	X509_set_version(certificate, 2);
+	ASN1_INTEGER_set(X509_get_serialNumber(certificate), static_cast<long>(std::time(nullptr)));
+	X509_gmtime_adj(X509_getm_notBefore(certificate), -60);
+	X509_gmtime_adj(X509_getm_notAfter(certificate), 24L * 60L * 60L);
+	X509_set_pubkey(certificate, key);
+
+	X509_NAME* const name {X509_get_subject_name(certificate)};
+	X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("127.0.0.1"), -1, -1, 0);
+	X509_set_issuer_name(certificate, name);
+
+	X509V3_CTX extension_context;
+	X509V3_set_ctx_nodb(&extension_context);
+	X509V3_set_ctx(&extension_context, certificate, certificate, nullptr, nullptr, 0);
+
+	bool ok {true};
+	for (const auto& [nid, value] : {
+		std::pair{NID_basic_constraints, "critical,CA:TRUE"},
+		std::pair{NID_subject_alt_name, "IP:127.0.0.1"}
+	}) {
+		X509_EXTENSION* const extension {X509V3_EXT_conf_nid(nullptr, &extension_context, nid, value)};
+		ok = ok && extension != nullptr && X509_add_ext(certificate, extension, -1) == 1;
+		X509_EXTENSION_free(extension);
+	}
+
+	if (!ok || X509_sign(certificate, key, EVP_sha256()) == 0) {
+		X509_free(certificate);
+		fail("unable to sign the certificate");
+	}
+	return certificate;
+}
+
+/*
+ * Whether header is a header line named name, which must be lowercase,
+ * in which case its value is written in value
+ */
+bool header_value(const std::string_view header, const std::string_view name, std::string_view& value) {
+	if (header.size() <= name.size() || header[name.size()] != ':') {
+		return false;
+	}
+	for (std::size_t i = 0; i < name.size(); ++i) {
+		const char c {header[i]};
+		if ((c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c) != name[i]) {
+			return false;
+		}
+	}
+	value = header.substr(name.size() + 1);
+	while (!value.empty() && value.front() == ' ') {
+		value.remove_prefix(1);
+	}
+	return true;
+}
+
+/*
+ * Returns the length of the request at the start of buffer, or 0 if it
+ * isn't complete yet
+ */
+std::size_t parse_request(const std::string& buffer, mock_request& request) {
+	const std::size_t headers_end {buffer.find("\r\n\r\n")};
+	if (headers_end == std::string::npos) {
+		return 0;
+	}
+
+	const std::string_view head {buffer.data(), headers_end};
+	const std::size_t method_end {head.find(' ')};
+	const std::size_t target_end {head.find(' ', method_end + 1)};
+	if (method_end == std::string_view::npos || target_end == std::string_view::npos) {
+		fail("malformed request line");
+	}
+
+	std::size_t content_length {0};
+	std::string_view authorization;
+	for (std::size_t line = head.find("\r\n"); line != std::string_view::npos; line = head.find("\r\n", line + 2)) {
+		const std::string_view header {head.substr(line + 2, head.find("\r\n", line + 2) - (line + 2))};
+		std::string_view value;
+		if (header_value(header, "content-length", value)) {
+			content_length = std::stoul(std::string{value});
+		}
+		else if (header_value(header, "authorization", value)) {
+			authorization = value;
+		}
+	}
+
+	const std::size_t request_length {headers_end + 4 + content_length};
+	if (buffer.size() < request_length) {
+		return 0;
+	}
+
+	request.method = head.substr(0, method_end);
+	request.target = head.substr(method_end + 1, target_end - method_end - 1);
+	request.authorization = authorization;
+	request.body = buffer.substr(headers_end + 4, content_length);
+	return request_length;
+}
+
+} // namespace
+
+mock_server::mock_server(handler_type handler)
+	: handler_{std::move(handler)} {
+	// Answering a client that gave up must not kill the test
+	std::signal(SIGPIPE, SIG_IGN);
+
+	EVP_PKEY* const key {generate_key()};
+	X509* const certificate {generate_certificate(key)};
+
+	context_ = SSL_CTX_new(TLS_server_method());
+	const bool context_ok {
+		context_ != nullptr &&
+		SSL_CTX_use_certificate(context_, certificate) == 1 &&
+		SSL_CTX_use_PrivateKey(context_, key) == 1
+	};
+
+	listener_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	const int reuse {1};
+	setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+
+	sockaddr_in address {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	socklen_t address_length {sizeof address};
+
+	const bool socket_ok {
+		listener_ != -1 &&
+		bind(listener_, reinterpret_cast<const sockaddr*>(&address), sizeof address) == 0 &&
+		listen(listener_, 16) == 0 &&
+		getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &address_length) == 0
+	};
+
+	const std::string port {std::to_string(ntohs(address.sin_port))};
+	base_url_ = "https://127.0.0.1:" + port + "/client/v4";
+	trace_url_ = "https://127.0.0.1:" + port + "/cdn-cgi/trace";
+	ca_file_ = (std::filesystem::temp_directory_path() / ("cloudflare-ddns-mock-" + port + ".pem")).string();
+
+	bool ca_file_ok {false};
+	if (socket_ok) {
+		if (std::FILE* const ca_file = std::fopen(ca_file_.c_str(), "w")) {
+			ca_file_ok = PEM_write_X509(ca_file, certificate) == 1;
+			ca_file_ok = std::fclose(ca_file) == 0 && ca_file_ok;
+		}
+	}
+
+	X509_free(certificate);
+	EVP_PKEY_free(key);
+
+	if (!context_ok || !socket_ok || !ca_file_ok) {
+		SSL_CTX_free(context_);
+		if (listener_ != -1) {
+			close(listener_);
+		}
+		fail("unable to set up the server");
+	}
+
+	thread_ = std::thread{&mock_server::serve, this};
+}
+
+mock_server::~mock_server() {
+	stopping_ = true;
+	thread_.join();
+	close(listener_);
+	SSL_CTX_free(context_);
+	std::error_code error;
+	std::filesystem::remove(ca_file_, error);
+}
+
+std::vector<mock_request> mock_server::requests() const {
+	const std::lock_guard lock {requests_mutex_};
+	return requests_;
+}
+
+void mock_server::serve() {
+	std::vector<std::thread> connections;
+
+	while (!stopping_) {
+		pollfd listener {listener_, POLLIN, 0};
+		if (poll(&listener, 1, poll_timeout_ms) <= 0) {
+			continue;
+		}
+
+		const int connection {accept4(listener_, nullptr, nullptr, SOCK_CLOEXEC)};
+		if (connection == -1) {
+			continue;
+		}
+		// Responses are written in pieces, and Nagle's algorithm would
+		// hold back the last one until the client's delayed ACK
+		const int no_delay {1};
+		setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof no_delay);
+
+		// Every connection gets its own thread, so that concurrent
+		// transfers are served concurrently too
+		connections.emplace_back([this, connection] {
+			SSL* const ssl {SSL_new(context_)};
+			if (ssl != nullptr && SSL_set_fd(ssl, connection) == 1 && SSL_accept(ssl) == 1) {
+				++connections_;
+				try {
+					serve_connection(ssl, connection);
+				}
+				catch (const std::exception&) {
+					// Malformed request, the client will see the connection
+					// getting closed
+				}
+				SSL_shutdown(ssl);
+			}
+			SSL_free(ssl);
+			close(connection);
+		});
+	}
+
+	for (std::thread& connection : connections) {
+		connection.join();
+	}
+}
+
+void mock_server::serve_connection(ssl_st* const ssl, const int connection) {
+	std::string buffer;
+
+	while (!stopping_) {
+		mock_request request;
+		if (const std::size_t request_length = parse_request(buffer, request); request_length != 0) {
+			buffer.erase(0, request_length);
+
+			{
+				const std::lock_guard lock {requests_mutex_};
+				requests_.push_back(request);
+			}
+
+			const mock_response response {handler_(request)};
+			const std::string message {
+				"HTTP/1.1 " + std::to_string(response.status) + " Mock\r\n"
+				"Content-Type: application/json\r\n"
+				"Content-Length: " + std::to_string(response.body.size()) + "\r\n"
+				+ response.headers +
+				"\r\n" + response.body
+			};
+			if (SSL_write(ssl, message.data(), static_cast<int>(message.size())) <= 0) {
+				return;
+			}
+			continue;
+		}
+
+		if (SSL_pending(ssl) == 0) {
+			pollfd fds {connection, POLLIN, 0};
+			if (poll(&fds, 1, poll_timeout_ms) <= 0) {
+				continue;
+			}
+			if ((fds.revents & POLLIN) == 0) {
+				return;
+			}
+		}
+
+		char chunk[4096];
+		const int read {SSL_read(ssl, chunk, sizeof chunk)};
+		if (read <= 0) {
+			return;
+		}
+		buffer.append(chunk, static_cast<std::size_t>(read));
+	}
+}
+
+ddns_client* make_client(const char* const base_url, const char* const trace_url, const char* const ca_file) noexcept {
+	ddns_client* client {nullptr};
+	if (ddns_client_create(&client) != DDNS_ERROR_OK) {
+		return nullptr;
+	}
+	if (ddns_client_set_base_url(client, base_url) != DDNS_ERROR_OK
+		|| ddns_client_set_trace_url(client, trace_url) != DDNS_ERROR_OK
+		|| ddns_client_set_ca_file(client, ca_file) != DDNS_ERROR_OK) {
+		ddns_client_destroy(client);
+		return nullptr;
+	}
+	return client;
+}
+
+ddns_client* make_client(const mock_server& server) {
+	ddns_client* const client {make_client(server.base_url().c_str(), server.trace_url().c_str(), server.ca_file().c_str())};
+	if (client == nullptr) {
+		fail("unable to set up the client");
+	}
+	return client;
+}
@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ddns/cloudflare-ddns.h>
+
+struct ssl_ctx_st;
+struct ssl_st;
+
+struct mock_request {
+	std::string method;
+	std::string target;
+	// The value of the Authorization header, if any
+	std::string authorization;
+	std::string body;
+};
+
+struct mock_response {
+	int status {200};
+	std::string body;
+	// Extra header lines, each ending with "\r\n"
+	std::string headers {};
+};
+
+/*
+ * A minimal HTTPS server listening on 127.0.0.1, used to test the library
+ * without talking to Cloudflare. It uses a freshly generated self-signed
+ * certificate, written to ca_file() so that clients can trust it, and
+ * answers every HTTP/1.1 request with the handler from background
+ * threads, one per connection. The handler must then be safe to call
+ * concurrently.
+ */
+class mock_server {
+public:
+	using handler_type = std::function<mock_response(const mock_request&)>;
+
+	explicit mock_server(handler_type handler);
+	~mock_server();
+
+	mock_server(const mock_server&) = delete;
+	mock_server& operator=(const mock_server&) = delete;
+
+	/*
+	 * The URL to pass to ddns_client_set_base_url()
+	 */
+	const std::string& base_url() const noexcept {
+		return base_url_;
+	}
+
+	/*
+	 * The URL to pass to ddns_client_set_trace_url()
+	 */
+	const std::string& trace_url() const noexcept {
+		return trace_url_;
+	}
+
+	/*
+	 * The path to pass to ddns_client_set_ca_file()
+	 */
+	const std::string& ca_file() const noexcept {
+		return ca_file_;
+	}
+
+	/*
+	 * All the requests received so far
+	 */
+	std::vector<mock_request> requests() const;
+
+	/*
+	 * The number of TLS connections accepted so far
+	 */
+	std::size_t connections() const noexcept {
+		return connections_;
+	}
+
+private:
+	void serve();
+	void serve_connection(ssl_st* ssl, int connection);
+
+	handler_type handler_;
+	ssl_ctx_st* context_ {nullptr};
+	int listener_ {-1};
+	std::string base_url_;
+	std::string trace_url_;
+	std::string ca_file_;
+
+	mutable std::mutex requests_mutex_;
+	std::vector<mock_request> requests_;
+
+	std::atomic<std::size_t> connections_ {0};
+	std::atomic<bool> stopping_ {false};
+	std::thread thread_;
+};
+
+/*
+ * A client sending its requests to the server at base_url and trace_url,
+ * and trusting the certificates in ca_file, or nullptr if it can't be set
+ * up. It must be destroyed with ddns_client_destroy().
+ */
+ddns_client* make_client(const char* base_url, const char* trace_url, const char* ca_file) noexcept;
+
+/*
+ * A client sending all its requests to server. Throws std::runtime_error
+ * if it can't be set up.
+ */
+ddns_client* make_client(const mock_server& server);
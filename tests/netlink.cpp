@@ -0,0 +1,208 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "netlink.hpp"
+#include <array>
+#include <cstring>
+#include <string_view>
+
+#ifdef __linux__
+#	include <arpa/inet.h>
+#	include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef __linux__
+
+/*
+ * An RTM_NEWADDR message like the ones of an RTM_GETADDR dump, or of
+ * another type, with IFA_ADDRESS, and IFA_LOCAL if local isn't null
+ */
+struct address_message {
+	alignas(nlmsghdr) unsigned char buffer[256] {};
+
+	address_message(const int family, const unsigned char scope, const std::uint32_t flags, const char* const address, const char* const local = nullptr, const unsigned short type = RTM_NEWADDR) {
+		nlmsghdr* const header {reinterpret_cast<nlmsghdr*>(buffer)};
+		header->nlmsg_type = type;
+		header->nlmsg_len = NLMSG_LENGTH(sizeof(ifaddrmsg));
+
+		ifaddrmsg* const info {static_cast<ifaddrmsg*>(NLMSG_DATA(header))};
+		info->ifa_family = static_cast<unsigned char>(family);
+		info->ifa_scope = scope;
+
+		append(IFA_ADDRESS, address);
+		if (local != nullptr) {
+			append(IFA_LOCAL, local);
+		}
+		append_flags(flags);
+	}
+
+	const nlmsghdr* header() const {
+		return reinterpret_cast<const nlmsghdr*>(buffer);
+	}
+
+private:
+	rtattr* next_attribute(const unsigned short type, const std::size_t length) {
+		nlmsghdr* const header {reinterpret_cast<nlmsghdr*>(buffer)};
+		rtattr* const attribute {reinterpret_cast<rtattr*>(buffer + NLMSG_ALIGN(header->nlmsg_len))};
+		attribute->rta_type = type;
+		attribute->rta_len = static_cast<unsigned short>(RTA_LENGTH(length));
+		header->nlmsg_len = NLMSG_ALIGN(header->nlmsg_len) + RTA_ALIGN(attribute->rta_len);
+		return attribute;
+	}
+
+	void append(const unsigned short type, const char* const address) {
+		const int family {static_cast<ifaddrmsg*>(NLMSG_DATA(reinterpret_cast<nlmsghdr*>(buffer)))->ifa_family};
+		rtattr* const attribute {next_attribute(type, family == AF_INET6 ? 16U : 4U)};
+		inet_pton(family, address, RTA_DATA(attribute));
+	}
+
+	void append_flags(const std::uint32_t flags) {
+		rtattr* const attribute {next_attribute(IFA_FLAGS, sizeof flags)};
+		std::memcpy(RTA_DATA(attribute), &flags, sizeof flags);
+	}
+};
+
+#endif
+
+bool public_ipv4(const std::array<unsigned char, 4> address) {
+	return priv::netlink::is_public_ipv4(address.data());
+}
+
+bool public_ipv6(const std::array<unsigned char, 16> address) {
+	return priv::netlink::is_public_ipv6(address.data());
+}
+
+} // namespace
+
+int main() {
+	"netlink_public_ipv4"_test = [] {
+		expect(public_ipv4({1, 1, 1, 1}));
+		expect(public_ipv4({149, 20, 4, 15}));
+		expect(public_ipv4({100, 63, 0, 1}));
+		expect(public_ipv4({172, 32, 0, 1}));
+		expect(public_ipv4({198, 20, 0, 1}));
+
+		expect(!public_ipv4({0, 0, 0, 0}));
+		expect(!public_ipv4({10, 1, 2, 3}));
+		expect(!public_ipv4({100, 64, 0, 1}));
+		expect(!public_ipv4({100, 127, 255, 254}));
+		expect(!public_ipv4({127, 0, 0, 1}));
+		expect(!public_ipv4({169, 254, 1, 1}));
+		expect(!public_ipv4({172, 16, 0, 1}));
+		expect(!public_ipv4({172, 31, 255, 255}));
+		expect(!public_ipv4({192, 0, 2, 1}));
+		expect(!public_ipv4({192, 168, 1, 1}));
+		expect(!public_ipv4({198, 18, 0, 1}));
+		expect(!public_ipv4({198, 51, 100, 4}));
+		expect(!public_ipv4({203, 0, 113, 1}));
+		expect(!public_ipv4({224, 0, 0, 1}));
+		expect(!public_ipv4({255, 255, 255, 255}));
+	};
+
+	"netlink_public_ipv6"_test = [] {
+		expect(public_ipv6({0x26, 0x06, 0x47, 0x00, 0x47, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0x11, 0x11}));
+		expect(public_ipv6({0x20, 0x01, 0x04, 0x70, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+
+		// ::1, fd00::1, fe80::1, ff02::1
+		expect(!public_ipv6({0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+		expect(!public_ipv6({0xFD, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+		expect(!public_ipv6({0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+		expect(!public_ipv6({0xFF, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+		// Documentation, Teredo and 6to4
+		expect(!public_ipv6({0x20, 0x01, 0x0D, 0xB8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+		expect(!public_ipv6({0x20, 0x01, 0x00, 0x00, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+		expect(!public_ipv6({0x20, 0x02, 0xC0, 0x00, 0x02, 0x01, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1}));
+	};
+
+#ifdef __linux__
+	"netlink_public_address"_test = [] {
+		unsigned char address[16];
+
+		expect(priv::netlink::public_address(address_message{AF_INET, RT_SCOPE_UNIVERSE, 0, "149.20.4.15"}.header(), AF_INET, address));
+		expect(eq(address[0], 149) && eq(address[3], 15));
+
+		expect(priv::netlink::public_address(address_message{AF_INET6, RT_SCOPE_UNIVERSE, IFA_F_PERMANENT, "2606:4700:4700::1111"}.header(), AF_INET6, address));
+		expect(eq(address[0], 0x26) && eq(address[15], 0x11));
+
+		// Wrong family, private address, link scope
+		expect(!priv::netlink::public_address(address_message{AF_INET, RT_SCOPE_UNIVERSE, 0, "149.20.4.15"}.header(), AF_INET6, address));
+		expect(!priv::netlink::public_address(address_message{AF_INET, RT_SCOPE_UNIVERSE, 0, "192.168.1.2"}.header(), AF_INET, address));
+		expect(!priv::netlink::public_address(address_message{AF_INET6, RT_SCOPE_LINK, 0, "2606:4700:4700::1111"}.header(), AF_INET6, address));
+
+		// Privacy extensions and addresses still going through DAD
+		expect(!priv::netlink::public_address(address_message{AF_INET6, RT_SCOPE_UNIVERSE, IFA_F_TEMPORARY, "2606:4700:4700::1111"}.header(), AF_INET6, address));
+		expect(!priv::netlink::public_address(address_message{AF_INET6, RT_SCOPE_UNIVERSE, IFA_F_TENTATIVE, "2606:4700:4700::1111"}.header(), AF_INET6, address));
+		expect(!priv::netlink::public_address(address_message{AF_INET6, RT_SCOPE_UNIVERSE, IFA_F_DEPRECATED, "2606:4700:4700::1111"}.header(), AF_INET6, address));
+
+		// The secondary addresses of an IPv4 subnet share their flag with
+		// the temporary IPv6 ones
+		expect(priv::netlink::public_address(address_message{AF_INET, RT_SCOPE_UNIVERSE, IFA_F_SECONDARY, "149.20.4.15"}.header(), AF_INET, address));
+
+		// On point-to-point links IFA_ADDRESS is the other end
+		expect(priv::netlink::public_address(address_message{AF_INET, RT_SCOPE_UNIVERSE, 0, "10.0.0.1", "149.20.4.15"}.header(), AF_INET, address));
+		expect(eq(address[0], 149));
+	};
+
+	"netlink_public_address_changed"_test = [] {
+		expect(priv::netlink::public_address_changed(address_message{AF_INET, RT_SCOPE_UNIVERSE, 0, "149.20.4.15"}.header()));
+		expect(priv::netlink::public_address_changed(address_message{AF_INET6, RT_SCOPE_UNIVERSE, 0, "2606:4700:4700::1111", nullptr, RTM_DELADDR}.header()));
+
+		expect(!priv::netlink::public_address_changed(address_message{AF_INET, RT_SCOPE_UNIVERSE, 0, "10.0.0.2", nullptr, RTM_DELADDR}.header()));
+		expect(!priv::netlink::public_address_changed(address_message{AF_INET6, RT_SCOPE_UNIVERSE, IFA_F_TEMPORARY, "2606:4700:4700::1111"}.header()));
+		expect(!priv::netlink::public_address_changed(address_message{AF_INET, RT_SCOPE_UNIVERSE, 0, "149.20.4.15", nullptr, RTM_NEWLINK}.header()));
+	};
+#endif
+
+	"netlink_address_watch"_test = [] {
+		ddns_address_watch* watch {nullptr};
+		if (ddns_address_watch_create(&watch) != DDNS_ERROR_OK) {
+			// Not supported here
+			expect(watch == nullptr);
+			return;
+		}
+
+		// Nothing is expected to change on the machine running the test
+		bool changed {true};
+		expect(eq(ddns_address_watch_wait(watch, 50, 10, &changed), DDNS_ERROR_OK));
+		expect(!changed);
+
+#ifdef __linux__
+		// Written to before waiting, like a signal handler would, so the wait
+		// without a timeout must end anyway
+		int wake[2];
+		expect(eq(pipe(wake), 0) >> fatal);
+		expect(eq(write(wake[1], "x", 1), 1));
+		expect(eq(ddns_address_watch_set_wake_fd(watch, wake[0]), DDNS_ERROR_OK));
+		changed = true;
+		expect(eq(ddns_address_watch_wait(watch, -1, 10, &changed), DDNS_ERROR_OK));
+		expect(!changed);
+		expect(eq(ddns_address_watch_set_wake_fd(watch, -1), DDNS_ERROR_OK));
+		close(wake[0]);
+		close(wake[1]);
+#endif
+
+		ddns_address_watch_destroy(watch);
+		ddns_address_watch_destroy(nullptr);
+	};
+
+	"netlink_get_interface_ip"_test = [] {
+		// Whether there's a public address depends on the machine running
+		// the test, but when there's one it must be a valid one
+		for (const bool ipv6 : {false, true}) {
+			char ip[DDNS_IP_ADDRESS_MAX_LENGTH];
+			const ddns_error error {ddns_get_interface_ip(ipv6, sizeof ip, ip)};
+			expect(error == DDNS_ERROR_OK || error == DDNS_ERROR_GENERIC);
+			if (error == DDNS_ERROR_OK) {
+				expect(eq(std::string_view{ip}.find(':') != std::string_view::npos, ipv6));
+				char small[2];
+				expect(eq(ddns_get_interface_ip(ipv6, sizeof small, small), DDNS_ERROR_USAGE));
+			}
+		}
+	};
+}
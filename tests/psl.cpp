@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "psl.hpp"
+
+using priv::psl::is_public_suffix;
+
+// Evaluated at compile time too
+static_assert(is_public_suffix("com"));
+static_assert(!is_public_suffix("example.com"));
+
+int main() {
+	"psl_top_level_domains"_test = [] {
+		expect(is_public_suffix("com"));
+		expect(is_public_suffix("it"));
+		expect(is_public_suffix("COM"));
+		expect(is_public_suffix("com."));
+		// The implicit "*" rule
+		expect(is_public_suffix("not-a-real-tld"));
+
+		expect(!is_public_suffix(""));
+		expect(!is_public_suffix("."));
+		expect(!is_public_suffix("example.com"));
+		expect(!is_public_suffix("pappacoda.it"));
+		expect(!is_public_suffix("ddns.andrea.pappacoda.it"));
+	};
+
+	// The rest depends on the list the library was built with
+	if (priv::psl::nodes[0].children_count == 0) {
+		return 0;
+	}
+
+	"psl_multiple_labels"_test = [] {
+		expect(is_public_suffix("co.uk"));
+		expect(is_public_suffix("Co.UK"));
+		expect(is_public_suffix("com.au"));
+		expect(!is_public_suffix("example.co.uk"));
+		expect(!is_public_suffix("www.example.co.uk"));
+		expect(!is_public_suffix("notarule.uk"));
+	};
+
+	"psl_wildcards"_test = [] {
+		// *.ck and !www.ck
+		expect(is_public_suffix("ck"));
+		expect(is_public_suffix("anything.ck"));
+		expect(!is_public_suffix("www.ck"));
+		expect(!is_public_suffix("example.anything.ck"));
+
+		// *.kawasaki.jp and !city.kawasaki.jp, without kawasaki.jp itself
+		expect(!is_public_suffix("kawasaki.jp"));
+		expect(is_public_suffix("example.kawasaki.jp"));
+		expect(!is_public_suffix("city.kawasaki.jp"));
+		expect(!is_public_suffix("www.city.kawasaki.jp"));
+	};
+
+	"psl_private_domains"_test = [] {
+		// Only the ICANN section is used
+		expect(!is_public_suffix("github.io"));
+		expect(!is_public_suffix("blogspot.com"));
+	};
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+namespace {
+
+/*
+ * mock_cloudflare with a second account, and with a.example.com,
+ * b.example.com and c.example.com having an A record each
+ */
+void set_up(mock_cloudflare& cloudflare) {
+	cloudflare.add_api_token(mock_cloudflare::other_api_token);
+	cloudflare.add_record("00000000000000000000000000000a01", "a.example.com", false, "192.0.2.10");
+	cloudflare.add_record("00000000000000000000000000000b01", "b.example.com", false, "192.0.2.11");
+	cloudflare.add_record("00000000000000000000000000000c01", "c.example.com", false, "192.0.2.12");
+}
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"rate_limit_headers"_test = [] {
+		// The quota of the token is over for a second after the first
+		// request
+		std::atomic<int> requests {0};
+		mock_cloudflare cloudflare;
+		set_up(cloudflare);
+		const mock_server server {[&](const mock_request& request) {
+			mock_response response {cloudflare(request)};
+			if (++requests == 1) {
+				response.headers = "RateLimit: \"default\";r=0;t=1\r\nRateLimit-Policy: \"default\";q=1200;w=300\r\n";
+			}
+			return response;
+		}};
+		ddns_client* const client {make_client(server)};
+
+		expect(eq(update_a_record(client, mock_cloudflare::api_token), DDNS_ERROR_OK));
+
+		// Other tokens don't have to wait
+		auto start {std::chrono::steady_clock::now()};
+		expect(eq(update_a_record(client, mock_cloudflare::other_api_token), DDNS_ERROR_OK));
+		expect(elapsed_ms(start) < 1000);
+
+		// Concurrent requests wait as well
+		std::array<ddns_record, 2> records[3];
+		std::array<ddns_record_query, 3> queries {{
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, "a.example.com", records[0].size(), records[0].data(), 0, DDNS_ERROR_GENERIC},
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, "b.example.com", records[1].size(), records[1].data(), 0, DDNS_ERROR_GENERIC},
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, "c.example.com", records[2].size(), records[2].data(), 0, DDNS_ERROR_GENERIC}
+		}};
+		expect(eq(ddns_client_get_records_multi(client, queries.size(), queries.data()), DDNS_ERROR_OK));
+		for (const ddns_record_query& query : queries) {
+			expect(eq(query.records_count, 1U));
+		}
+		expect(elapsed_ms(start) >= 900);
+
+		// Unless the deadline doesn't leave time for it
+		requests = 0;
+		expect(eq(update_a_record(client, mock_cloudflare::api_token), DDNS_ERROR_OK));
+		expect(eq(ddns_client_set_deadline(client, 500), DDNS_ERROR_OK));
+		start = std::chrono::steady_clock::now();
+		expect(eq(update_a_record(client, mock_cloudflare::api_token), DDNS_ERROR_GENERIC));
+		expect(eq(search_zone(client, mock_cloudflare::api_token, "example.com"), DDNS_ERROR_GENERIC));
+		expect(elapsed_ms(start) < 500);
+
+		ddns_client_destroy(client);
+	};
+
+	"rate_limit_zone_answers"_test = [] {
+		mock_cloudflare cloudflare;
+		set_up(cloudflare);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		expect(eq(search_zone(client, mock_cloudflare::api_token, "a.example.com"), DDNS_ERROR_OK));
+		expect(eq(server.requests().size(), 2U));
+
+		// example.com was already searched
+		expect(eq(search_zone(client, mock_cloudflare::api_token, "b.example.com"), DDNS_ERROR_OK));
+		expect(eq(search_zone(client, mock_cloudflare::api_token, "a.example.com"), DDNS_ERROR_OK));
+		expect(eq(server.requests().size(), 3U));
+
+		// But not with this token, which could see other zones
+		expect(eq(search_zone(client, mock_cloudflare::other_api_token, "a.example.com"), DDNS_ERROR_OK));
+		expect(eq(server.requests().size(), 5U));
+
+		ddns_client_destroy(client);
+	};
+}
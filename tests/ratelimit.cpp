@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "ratelimit.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+namespace ratelimit = priv::ratelimit;
+
+static_assert(ratelimit::key("token") == ratelimit::key("token"));
+static_assert(ratelimit::key("token") != ratelimit::key("other token"));
+
+static_assert(ratelimit::parameter(R"("default";r=50;t=30)", 'r') == 50);
+static_assert(ratelimit::parameter(R"("default";r=50;t=30)", 't') == 30);
+static_assert(ratelimit::parameter(R"("default"; q=1200; w=300)", 'w') == 300);
+// Only the first policy counts
+static_assert(ratelimit::parameter(R"("default";r=50;t=30, "burst";r=1;t=1)", 'r') == 50);
+static_assert(ratelimit::parameter(R"("default";t=30, "burst";r=1;t=1)", 'r') == -1);
+static_assert(ratelimit::parameter(R"("default";r=;t=30)", 'r') == -1);
+static_assert(ratelimit::parameter(R"("default";rr=5)", 'r') == -1);
+static_assert(ratelimit::parameter("", 'r') == -1);
+
+} // namespace
+
+int main() {
+	"ratelimit_burst"_test = [] {
+		ratelimit::limiter limiter;
+		for (long i = 0; i < ratelimit::default_quota; ++i) {
+			expect(eq(limiter.acquire("token", 0), 0L) >> fatal);
+		}
+		// 4 requests every second
+		expect(eq(limiter.acquire("token", 0), 250L));
+		expect(eq(limiter.acquire("token", 100), 150L));
+		expect(eq(limiter.acquire("token", 250), 0L));
+		expect(eq(limiter.acquire("token", 250), 250L));
+
+		// Other tokens have their own bucket
+		expect(eq(limiter.acquire("other token", 250), 0L));
+		expect(eq(limiter.size(), 2U));
+	};
+
+	"ratelimit_headers"_test = [] {
+		ratelimit::limiter limiter;
+
+		ratelimit::limits policy;
+		policy.remaining = 2;
+		policy.reset_s = 10;
+		policy.quota = 10;
+		policy.window_s = 10;
+		limiter.observe("token", 0, policy);
+		expect(eq(limiter.acquire("token", 0), 0L));
+		expect(eq(limiter.acquire("token", 0), 0L));
+		// One request every second
+		expect(eq(limiter.acquire("token", 0), 1000L));
+
+		// Nothing until the quota resets
+		ratelimit::limits exhausted;
+		exhausted.remaining = 0;
+		exhausted.reset_s = 30;
+		limiter.observe("token", 1000, exhausted);
+		expect(eq(limiter.acquire("token", 1000), 30000L));
+		expect(eq(limiter.acquire("token", 31000), 0L));
+
+		// A 429 empties the bucket even without the headers
+		ratelimit::limits throttled;
+		throttled.throttled = true;
+		limiter.observe("other token", 0, throttled);
+		expect(limiter.acquire("other token", 0) > 0L);
+	};
+
+	"ratelimit_buckets"_test = [] {
+		ratelimit::limiter limiter;
+		for (std::size_t i = 0; i < ratelimit::max_buckets; ++i) {
+			expect(eq(limiter.acquire("token " + std::to_string(i), static_cast<std::int64_t>(i) + 1), 0L));
+		}
+		expect(eq(limiter.size(), ratelimit::max_buckets));
+
+		// The least recently used one makes room for the new one
+		expect(eq(limiter.acquire("new token", 100), 0L));
+		expect(eq(limiter.size(), ratelimit::max_buckets));
+	};
+}
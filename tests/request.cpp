@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "request.hpp"
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace {
+
+namespace request = priv::request;
+
+/*
+ * A string of Length chars, as long as the longest value of a slot
+ */
+template <std::size_t Length>
+struct filled {
+	std::array<char, Length> chars {};
+
+	constexpr explicit filled(const char c) {
+		for (char& i : chars) {
+			i = c;
+		}
+	}
+
+	constexpr operator std::string_view() const {
+		return {chars.data(), Length};
+	}
+};
+
+constexpr filled<request::zones_url_max_length> longest_zones_url {'u'};
+constexpr filled<DDNS_ZONE_ID_LENGTH> zone_id {'z'};
+constexpr filled<DDNS_RECORD_ID_LENGTH> record_id {'r'};
+constexpr filled<DDNS_RECORD_NAME_MAX_LENGTH> longest_record_name {'n'};
+constexpr filled<request::zone_name_max_length> longest_zone_name {'n'};
+constexpr filled<DDNS_IP_ADDRESS_MAX_LENGTH> longest_ip {'1'};
+
+/*
+ * Writes a request in a buffer of exactly Format::size chars, returning
+ * its length, or 0 if the values don't fit. Writing past the end of the
+ * buffer isn't allowed in a constant expression, so if this compiles the
+ * buffer is big enough.
+ */
+template <typename Format, typename... Values>
+constexpr std::size_t written_length(const Values&... values) {
+	std::array<char, Format::size> buffer {};
+	if (Format::make(buffer.data(), std::string_view{values}...) != DDNS_ERROR_OK) {
+		return 0;
+	}
+	return std::string_view{buffer.data()}.length();
+}
+
+template <typename Format, typename... Values>
+std::string written(const Values&... values) {
+	std::array<char, Format::size> buffer {};
+	expect(eq(Format::make(buffer.data(), values...), DDNS_ERROR_OK) >> fatal);
+	return buffer.data();
+}
+
+// The longest requests fill their buffers exactly
+static_assert(written_length<request::zone_url>(longest_zones_url, longest_zone_name) == request::zone_url::max_length);
+static_assert(written_length<request::get_record_url>(longest_zones_url, zone_id, longest_record_name) == request::get_record_url::max_length);
+static_assert(written_length<request::update_record_url>(longest_zones_url, zone_id, record_id) == request::update_record_url::max_length);
+static_assert(written_length<request::update_record_body>(longest_ip) == request::update_record_body::max_length);
+static_assert(written_length<request::batch_update_url>(longest_zones_url, zone_id) == request::batch_update_url::max_length);
+static_assert(written_length<request::batch_patch>(record_id, longest_ip) == request::batch_patch::max_length);
+static_assert(written_length<request::doh_query_url>(filled<request::host_max_length>{'h'}, "AAAA") == request::doh_query_url::max_length);
+
+// Slots can't hold longer values, and fixed ones shorter ones either
+static_assert(written_length<request::zone_url>(longest_zones_url, filled<request::zone_name_max_length + 1U>{'n'}) == 0);
+static_assert(written_length<request::get_record_url>(longest_zones_url, zone_id, filled<DDNS_RECORD_NAME_MAX_LENGTH + 1U>{'n'}) == 0);
+static_assert(written_length<request::get_record_url>(filled<request::zones_url_max_length + 1U>{'u'}, zone_id, longest_record_name) == 0);
+static_assert(written_length<request::update_record_url>(longest_zones_url, filled<DDNS_ZONE_ID_LENGTH - 1U>{'z'}, record_id) == 0);
+static_assert(written_length<request::update_record_url>(longest_zones_url, zone_id, filled<DDNS_RECORD_ID_LENGTH + 1U>{'r'}) == 0);
+static_assert(written_length<request::update_record_body>(filled<DDNS_IP_ADDRESS_MAX_LENGTH + 1U>{'1'}) == 0);
+
+// Numbers are never too long, even the biggest one
+constexpr std::size_t longest_list_records_url {[] {
+	std::array<char, request::list_records_url::size> buffer {};
+	if (request::list_records_url::make(buffer.data(), std::string_view{longest_zones_url}, std::string_view{zone_id}, static_cast<std::size_t>(-1), static_cast<std::size_t>(-1)) != DDNS_ERROR_OK) {
+		return std::size_t{0};
+	}
+	return std::string_view{buffer.data()}.length();
+}()};
+static_assert(longest_list_records_url == request::list_records_url::max_length);
+
+// A batch of DDNS_BATCH_MAX_RECORDS of the longest patches fills its
+// buffer exactly
+constexpr std::size_t longest_batch_update_body {[] {
+	std::array<char, request::batch_update_body_size> buffer {};
+	char* end {request::copy(buffer.data(), request::batch_body_start)};
+	for (std::size_t i = 0; i < DDNS_BATCH_MAX_RECORDS; ++i) {
+		if (i != 0) {
+			end = request::copy(end, request::batch_patch_separator);
+		}
+		end = request::batch_patch::write(end, std::string_view{record_id}, std::string_view{longest_ip});
+	}
+	end = request::copy(end, request::batch_body_end);
+	*end = '\0';
+	return std::string_view{buffer.data()}.length();
+}()};
+static_assert(longest_batch_update_body == request::batch_update_body_size - 1U);
+
+} // namespace
+
+int main() {
+	"request_urls"_test = [] {
+		constexpr std::string_view zones_url {"https://api.cloudflare.com/client/v4/zones/"};
+		constexpr std::string_view zone {"023e105f4ecef8ad9ca31a8372d0c353"};
+		constexpr std::string_view record {"372e67954025e0ba6aaa6d586b9e0b59"};
+
+		expect(eq(written<request::zone_url>(zones_url, "example.com"), std::string{
+			"https://api.cloudflare.com/client/v4/zones/?per_page=1&name=example.com"
+		}));
+		expect(eq(written<request::get_record_url>(zones_url, zone, "ddns.example.com"), std::string{
+			"https://api.cloudflare.com/client/v4/zones/023e105f4ecef8ad9ca31a8372d0c353/dns_records?type=A,AAAA&name=ddns.example.com"
+		}));
+		expect(eq(written<request::list_records_url>(zones_url, zone, std::size_t{100}, std::size_t{0}), std::string{
+			"https://api.cloudflare.com/client/v4/zones/023e105f4ecef8ad9ca31a8372d0c353/dns_records?type=A,AAAA&per_page=100&page=0"
+		}));
+		expect(eq(written<request::update_record_url>(zones_url, zone, record), std::string{
+			"https://api.cloudflare.com/client/v4/zones/023e105f4ecef8ad9ca31a8372d0c353/dns_records/372e67954025e0ba6aaa6d586b9e0b59"
+		}));
+		expect(eq(written<request::batch_update_url>(zones_url, zone), std::string{
+			"https://api.cloudflare.com/client/v4/zones/023e105f4ecef8ad9ca31a8372d0c353/dns_records/batch"
+		}));
+		expect(eq(written<request::doh_query_url>("api.cloudflare.com", "AAAA"), std::string{
+			"https://cloudflare-dns.com/dns-query?name=api.cloudflare.com&type=AAAA"
+		}));
+	};
+
+	"request_bodies"_test = [] {
+		expect(eq(written<request::update_record_body>("2001:db8::1"), std::string{R"({"content": "2001:db8::1"})"}));
+		expect(eq(written<request::batch_patch>("372e67954025e0ba6aaa6d586b9e0b59", "192.0.2.1"), std::string{
+			R"({"id":"372e67954025e0ba6aaa6d586b9e0b59","content":"192.0.2.1"})"
+		}));
+	};
+
+	"request_numbers"_test = [] {
+		const auto number = [](const std::size_t value) {
+			char buffer[request::number::max_length];
+			return std::string(buffer, request::number::write(buffer, value));
+		};
+		expect(eq(number(0), std::string{"0"}));
+		expect(eq(number(7), std::string{"7"}));
+		expect(eq(number(100), std::string{"100"}));
+		expect(eq(number(static_cast<std::size_t>(-1)), std::to_string(static_cast<std::size_t>(-1))));
+	};
+}
@@ -0,0 +1,127 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace {
+
+ddns_client* make_client(const mock_server& server, std::vector<ddns_stats>& reports) {
+	ddns_client* const client {::make_client(server)};
+	ddns_client_set_stats_callback(client, [](const ddns_stats* const stats, void* const user) {
+		static_cast<std::vector<ddns_stats>*>(user)->push_back(*stats);
+	}, &reports);
+	return client;
+}
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"request_stats"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		std::vector<ddns_stats> reports;
+		ddns_client* const client {make_client(server, reports)};
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> local_ip;
+		expect(eq(ddns_client_get_local_ip(client, false, local_ip.size(), local_ip.data()), DDNS_ERROR_OK));
+		expect(eq(reports.size(), 1U) >> fatal);
+		const ddns_stats& trace {reports[0]};
+		expect(eq(trace.endpoint, DDNS_ENDPOINT_TRACE));
+		expect(eq(trace.status, 200L));
+		expect(eq(trace.attempts, 1U));
+		// The first request has to connect
+		expect(!trace.reused_connection);
+		expect(gt(trace.appconnect_us, 0L));
+		expect(trace.connect_us <= trace.appconnect_us && trace.appconnect_us <= trace.starttransfer_us && trace.starttransfer_us <= trace.total_us);
+		expect(trace.total_us <= trace.elapsed_us);
+		expect(gt(trace.bytes_sent, 0U));
+		// The headers count as well
+		std::size_t response_size {0};
+		(void) ddns_client_response(client, &response_size);
+		expect(gt(trace.bytes_received, response_size));
+
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(ddns_client_search_zone_id(client, mock_cloudflare::api_token, mock_cloudflare::record_name, zone_id.size(), zone_id.data()), DDNS_ERROR_OK));
+		std::array<ddns_record, 2> records;
+		std::size_t records_count {0};
+		expect(eq(ddns_client_get_records(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records.size(), records.data(), &records_count), DDNS_ERROR_OK));
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> record_ip;
+		expect(eq(ddns_client_update_record(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::a_record_id, "198.51.100.1", record_ip.size(), record_ip.data()), DDNS_ERROR_OK));
+		ddns_record record {};
+		std::snprintf(record.id, sizeof record.id, "%s", mock_cloudflare::aaaa_record_id);
+		std::snprintf(record.content, sizeof record.content, "2001:db8::2");
+		expect(eq(ddns_client_update_records_batch(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, 1, &record), DDNS_ERROR_OK));
+
+		// Every request is reported, the concurrent ones too
+		const std::vector requests {server.requests()};
+		expect(eq(reports.size(), requests.size()) >> fatal);
+		std::array<std::size_t, DDNS_ENDPOINT_DOH + 1> endpoints {};
+		for (const ddns_stats& stats : reports) {
+			++endpoints[stats.endpoint];
+		}
+		expect(eq(endpoints[DDNS_ENDPOINT_TRACE], 1U));
+		expect(ge(endpoints[DDNS_ENDPOINT_ZONES], 1U));
+		expect(eq(endpoints[DDNS_ENDPOINT_DNS_RECORDS], 1U));
+		expect(eq(endpoints[DDNS_ENDPOINT_UPDATE], 1U));
+		expect(eq(endpoints[DDNS_ENDPOINT_BATCH], 1U));
+		// Nothing is looked up with DoH for an IP address
+		expect(eq(endpoints[DDNS_ENDPOINT_DOH], 0U));
+
+		const ddns_stats& update {reports[reports.size() - 2]};
+		expect(eq(update.endpoint, DDNS_ENDPOINT_UPDATE));
+		expect(update.reused_connection);
+		expect(eq(update.status, 200L));
+
+		// No more reports without a callback
+		ddns_client_set_stats_callback(client, nullptr, nullptr);
+		expect(eq(ddns_client_get_local_ip(client, false, local_ip.size(), local_ip.data()), DDNS_ERROR_OK));
+		expect(eq(reports.size(), requests.size()));
+
+		ddns_client_destroy(client);
+	};
+
+	"request_stats_retries"_test = [] {
+		mock_cloudflare cloudflare;
+		std::atomic<int> requests {0};
+		const mock_server server {[&](const mock_request& request) {
+			if (++requests % 2 == 1) {
+				return mock_response {503, R"({"success":false,"errors":[{"code":503,"message":"Service Unavailable"}]})", "Retry-After: 0\r\n"};
+			}
+			return cloudflare(request);
+		}};
+		std::vector<ddns_stats> reports;
+		ddns_client* const client {make_client(server, reports)};
+
+		std::array<char, DDNS_IP_ADDRESS_MAX_LENGTH> record_ip;
+		expect(eq(ddns_client_update_record(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::a_record_id, "198.51.100.1", record_ip.size(), record_ip.data()), DDNS_ERROR_OK));
+		expect(eq(reports.size(), 1U) >> fatal);
+		expect(eq(reports[0].attempts, 2U));
+		expect(eq(reports[0].status, 200L));
+
+		std::array<ddns_record_update, 1> updates {{
+			{mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::aaaa_record_id, "2001:db8::2", {}, DDNS_ERROR_OK}
+		}};
+		expect(eq(ddns_client_update_records_multi(client, updates.size(), updates.data()), DDNS_ERROR_OK));
+		expect(eq(reports.size(), 2U) >> fatal);
+		expect(eq(reports[1].endpoint, DDNS_ENDPOINT_UPDATE));
+		expect(eq(reports[1].attempts, 2U));
+		expect(ge(reports[1].elapsed_us, reports[1].total_us));
+
+		ddns_client_destroy(client);
+	};
+
+	curl_global_cleanup();
+}
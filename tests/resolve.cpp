@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "resolve.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+namespace resolve = priv::resolve;
+
+constexpr bool same_endpoint(const resolve::endpoint endpoint, const std::string_view host, const unsigned port) {
+	return endpoint.host == host && endpoint.port == port;
+}
+
+static_assert(same_endpoint(resolve::url_endpoint("https://api.cloudflare.com/client/v4/zones/"), "api.cloudflare.com", 443U));
+static_assert(same_endpoint(resolve::url_endpoint("https://one.one.one.one/cdn-cgi/trace"), "one.one.one.one", 443U));
+static_assert(same_endpoint(resolve::url_endpoint("https://api.example.com:8443"), "api.example.com", 8443U));
+static_assert(same_endpoint(resolve::url_endpoint("https://api.example.com?name=x"), "api.example.com", 443U));
+// Nothing to look up
+static_assert(resolve::url_endpoint("https://127.0.0.1:8443/client/v4/zones/").host.empty());
+static_assert(resolve::url_endpoint("https://[::1]/client/v4/zones/").host.empty());
+static_assert(resolve::url_endpoint("http://api.cloudflare.com/").host.empty());
+static_assert(resolve::url_endpoint("https://user@api.cloudflare.com/").host.empty());
+static_assert(resolve::url_endpoint("https://api.cloudflare.com:0/").host.empty());
+static_assert(resolve::url_endpoint("https://api.cloudflare.com:65536/").host.empty());
+static_assert(resolve::url_endpoint("https://api.cloudflare.com:/").host.empty());
+
+resolve::entry make_entry(const std::string_view host, const unsigned port) {
+	resolve::cache cache;
+	return cache.get({host, port});
+}
+
+bool parse(resolve::answer_parser& parser, const std::string_view answer) {
+	return parser.feed(answer.data(), answer.size()) && parser.finish();
+}
+
+std::string resolve_entry(const resolve::entry& entry, const bool transient) {
+	char line[resolve::resolve_entry_size];
+	resolve::write_resolve_entry(entry, transient, line);
+	return line;
+}
+
+} // namespace
+
+int main() {
+	"resolve_answer"_test = [] {
+		resolve::entry entry {make_entry("api.cloudflare.com", 443U)};
+		resolve::answer_parser parser {entry};
+		expect(parse(parser, R"({
+			"Status": 0, "TC": false, "RD": true, "RA": true, "AD": true, "CD": false,
+			"Question": [{"name": "api.cloudflare.com", "type": 1}],
+			"Answer": [
+				{"name": "api.cloudflare.com", "type": 5, "TTL": 120, "data": "api.cloudflare.com.cdn.cloudflare.net."},
+				{"name": "api.cloudflare.com.cdn.cloudflare.net.", "type": 1, "TTL": 300, "data": "104.19.192.29"},
+				{"name": "api.cloudflare.com.cdn.cloudflare.net.", "type": 1, "TTL": 280, "data": "104.19.193.29"}
+			]
+		})"));
+		expect(parser.success());
+		expect(eq(parser.ttl(), std::int64_t{120}));
+		expect(eq(entry.addresses_count, 2U) >> fatal);
+		expect(eq(std::string_view{entry.addresses[0]}, std::string_view{"104.19.192.29"}));
+		expect(eq(std::string_view{entry.addresses[1]}, std::string_view{"104.19.193.29"}));
+
+		resolve::answer_parser aaaa_parser {entry};
+		expect(parse(aaaa_parser, R"({"Status":0,"Answer":[{"name":"api.cloudflare.com","type":28,"TTL":86401,"data":"2606:4700::6813:c01d"}]})"));
+		expect(aaaa_parser.success());
+		// Cut to max_ttl
+		expect(eq(aaaa_parser.ttl(), resolve::max_ttl));
+		expect(eq(entry.addresses_count, 3U) >> fatal);
+		expect(eq(std::string_view{entry.addresses[2]}, std::string_view{"2606:4700::6813:c01d"}));
+	};
+
+	"resolve_answer_failures"_test = [] {
+		resolve::entry entry {make_entry("api.cloudflare.com", 443U)};
+
+		// No such host
+		resolve::answer_parser nxdomain {entry};
+		expect(parse(nxdomain, R"({"Status":3,"Question":[{"name":"api.cloudflare.com","type":1}]})"));
+		expect(!nxdomain.success());
+
+		// No A records, which is fine
+		resolve::answer_parser empty {entry};
+		expect(parse(empty, R"({"Status":0,"Question":[{"name":"api.cloudflare.com","type":28}]})"));
+		expect(empty.success());
+		expect(eq(empty.ttl(), std::int64_t{-1}));
+
+		// Addresses that can't be handed to curl
+		resolve::answer_parser bad_address {entry};
+		expect(parse(bad_address, R"({"Status":0,"Answer":[{"type":1,"TTL":300,"data":"104.19.192.29,127.0.0.1"}]})"));
+		expect(!bad_address.success());
+
+		resolve::answer_parser truncated {entry};
+		expect(!truncated.feed("{\"Status\":0,\"Answer\":[", 22U) || !truncated.finish());
+		expect(!truncated.success());
+
+		expect(eq(entry.addresses_count, 0U));
+	};
+
+	"resolve_entries"_test = [] {
+		resolve::entry entry {make_entry("api.cloudflare.com", 443U)};
+		expect(entry.add_address("104.19.192.29"));
+		expect(entry.add_address("2606:4700::6813:c01d"));
+		expect(!entry.add_address("not an address"));
+
+		expect(eq(resolve_entry(entry, false), std::string{"api.cloudflare.com:443:104.19.192.29,2606:4700::6813:c01d"}));
+		expect(eq(resolve_entry(entry, true), std::string{"+api.cloudflare.com:443:104.19.192.29,2606:4700::6813:c01d"}));
+
+		entry.expires_at = 1000;
+		expect(entry.fresh(999));
+		expect(!entry.fresh(1000));
+	};
+
+	"resolve_longest_entry"_test = [] {
+		resolve::entry entry {make_entry(std::string(priv::request::host_max_length, 'h'), 65535U)};
+		const std::string longest_address(DDNS_IP_ADDRESS_MAX_LENGTH - 1U, 'f');
+		for (std::size_t i = 0; i < resolve::max_addresses + 1U; ++i) {
+			expect(entry.add_address(longest_address));
+		}
+		expect(eq(entry.addresses_count, resolve::max_addresses));
+		expect(eq(resolve_entry(entry, true).length() + 1U, resolve::resolve_entry_size));
+	};
+
+	"resolve_cache"_test = [] {
+		resolve::cache cache;
+		for (unsigned i = 0; i < resolve::max_hosts; ++i) {
+			resolve::entry& entry {cache.get({"example.com", 1000U + i})};
+			entry.expires_at = 100 + i;
+		}
+		expect(eq(cache.size(), resolve::max_hosts));
+		expect(cache.find({"example.com", 1000U}) != nullptr);
+		expect(cache.find({"example.org", 1000U}) == nullptr);
+
+		// Replaces the one expiring first
+		cache.get({"example.org", 443U});
+		expect(eq(cache.size(), resolve::max_hosts));
+		expect(cache.find({"example.com", 1000U}) == nullptr);
+		expect(cache.find({"example.com", 1001U}) != nullptr);
+		expect(cache.find({"example.org", 443U}) != nullptr);
+	};
+
+	"resolve_file"_test = [] {
+		const std::filesystem::path path {std::filesystem::temp_directory_path() / "cloudflare-ddns-test-resolve.cache"};
+		const std::string temporary_path {path.string() + ".tmp"};
+
+		resolve::cache cache;
+		resolve::entry& api {cache.get({"api.cloudflare.com", 443U})};
+		expect(api.add_address("104.19.192.29"));
+		expect(api.add_address("2606:4700::6813:c01d"));
+		api.expires_at = 2000;
+		resolve::entry& expired {cache.get({"one.one.one.one", 443U})};
+		expect(expired.add_address("1.1.1.1"));
+		expired.expires_at = 1000;
+		expect(eq(cache.save(path.c_str(), temporary_path.c_str(), 1500), true) >> fatal);
+		expect(!std::filesystem::exists(temporary_path));
+
+		resolve::cache loaded;
+		loaded.load(path.c_str(), 1500);
+		expect(eq(loaded.size(), 1U) >> fatal);
+		const resolve::entry* const found {loaded.find({"api.cloudflare.com", 443U})};
+		expect(eq(found != nullptr, true) >> fatal);
+		expect(eq(found->expires_at, std::int64_t{2000}));
+		expect(eq(resolve_entry(*found, false), resolve_entry(api, false)));
+
+		// Entries expired by the time the file is read are skipped
+		resolve::cache later;
+		later.load(path.c_str(), 2000);
+		expect(eq(later.size(), 0U));
+
+		// And so are the ones expiring after max_ttl, which save() can't write
+		{
+			std::ofstream file {path, std::ios::trunc};
+			file << resolve::file_header
+				<< "api.cloudflare.com 443 " << 1500 + resolve::max_ttl + 1 << " 104.19.192.29\n"
+				<< "one.one.one.one 443 " << 1500 + resolve::max_ttl << " 1.1.1.1\n";
+		}
+		resolve::cache far_future;
+		far_future.load(path.c_str(), 1500);
+		expect(eq(far_future.size(), 1U) >> fatal);
+		expect(far_future.find({"one.one.one.one", 443U}) != nullptr);
+
+		// And so are malformed lines, and files written by other versions
+		{
+			std::ofstream file {path, std::ios::trunc};
+			file << resolve::file_header
+				<< "api.cloudflare.com 443 2000 104.19.192.29,not-an-address\n"
+				<< "api.cloudflare.com:443 443 2000 104.19.192.29\n"
+				<< "api.cloudflare.com 0 2000 104.19.192.29\n"
+				<< "api.cloudflare.com 443 2000\n"
+				<< "one.one.one.one 443 2000 1.1.1.1,1.0.0.1\n"
+				<< "api.cloudflare.com 443 2000 104.19.192.29";
+		}
+		resolve::cache malformed;
+		malformed.load(path.c_str(), 1500);
+		expect(eq(malformed.size(), 1U) >> fatal);
+		expect(eq(malformed.find({"one.one.one.one", 443U})->addresses_count, 2U));
+
+		{
+			std::ofstream file {path, std::ios::trunc};
+			file << "cloudflare-ddns resolve 0\n" << "one.one.one.one 443 2000 1.1.1.1\n";
+		}
+		resolve::cache other_version;
+		other_version.load(path.c_str(), 1500);
+		expect(eq(other_version.size(), 0U));
+
+		std::filesystem::remove(path);
+
+		resolve::cache missing;
+		missing.load(path.c_str(), 1500);
+		expect(eq(missing.size(), 0U));
+	};
+}
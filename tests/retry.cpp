@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "retry.hpp"
+#include <cstdint>
+
+namespace {
+
+namespace retry = priv::retry;
+
+static_assert(retry::retryable(429));
+static_assert(retry::retryable(503));
+static_assert(!retry::retryable(200));
+static_assert(!retry::retryable(400));
+// Sending it again won't make it implemented
+static_assert(!retry::retryable(501));
+
+// The attempts after the last one, and servers asking to wait too long
+static_assert(retry::delay_ms(retry::max_attempts - 1U, 0, 1000U) == -1);
+static_assert(retry::delay_ms(0, retry::max_retry_after_s + 1, 1000U) == -1);
+static_assert(retry::delay_ms(0, 2, 1000U) == 2000);
+
+static_assert(retry::request_timeout_ms(30000, 0, 500) == 30000);
+static_assert(retry::request_timeout_ms(30000, 1500, 500) == 1000);
+static_assert(retry::request_timeout_ms(100, 1500, 500) == 100);
+static_assert(retry::request_timeout_ms(0, 1500, 500) == 1000);
+static_assert(retry::request_timeout_ms(30000, 1500, 1500) == -1);
+
+} // namespace
+
+int main() {
+	"retry_backoff"_test = [] {
+		std::uint32_t state {1U};
+		for (unsigned attempt = 0; attempt + 1U < retry::max_attempts; ++attempt) {
+			long cap {retry::base_delay_ms};
+			for (unsigned i = 0; i < attempt; ++i) {
+				cap *= 2;
+			}
+			cap = cap < retry::max_delay_ms ? cap : retry::max_delay_ms;
+
+			bool spread {false};
+			const long first {retry::delay_ms(attempt, 0, retry::next_random(state))};
+			for (int i = 0; i < 100; ++i) {
+				const long delay {retry::delay_ms(attempt, 0, retry::next_random(state))};
+				expect(delay >= 0 && delay <= cap) << "attempt" << attempt << "delay" << delay;
+				spread = spread || delay != first;
+			}
+			expect(spread);
+		}
+	};
+
+	"retry_random"_test = [] {
+		std::uint32_t state {1U};
+		const std::uint32_t first {retry::next_random(state)};
+		bool zero {false};
+		bool repeated {false};
+		for (int i = 0; i < 1000; ++i) {
+			const std::uint32_t random {retry::next_random(state)};
+			zero = zero || random == 0;
+			repeated = repeated || random == first;
+		}
+		expect(!zero);
+		expect(!repeated);
+	};
+}
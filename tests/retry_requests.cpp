@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+const mock_response unavailable {mock_cloudflare::failure(503, 503, "Service Unavailable")};
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"retry_server_errors"_test = [] {
+		// Every request fails twice, both the concurrent ones of the search
+		// and the single one of the update
+		std::atomic<int> failed_searches {0};
+		std::atomic<int> failed_updates {0};
+		mock_cloudflare cloudflare;
+		const mock_server server {[&](const mock_request& request) {
+			const bool failing {request.method == "POST" ? ++failed_updates <= 2 : ++failed_searches <= 4};
+			return failing ? unavailable : cloudflare(request);
+		}};
+		ddns_client* const client {make_client(server)};
+
+		expect(eq(search_zone(client), DDNS_ERROR_OK));
+		// Two candidates, each sent until the failures run out
+		expect(eq(server.requests().size(), 6U));
+
+		expect(eq(update_a_record(client), DDNS_ERROR_OK));
+		expect(eq(server.requests().size(), 9U));
+
+		ddns_client_destroy(client);
+	};
+
+	"retry_after"_test = [] {
+		std::atomic<int> requests {0};
+		mock_cloudflare cloudflare;
+		const mock_server server {[&](const mock_request& request) {
+			if (++requests == 1) {
+				mock_response limited {mock_cloudflare::failure(429, 10000, "Rate limited")};
+				limited.headers = "Retry-After: 1\r\n";
+				return limited;
+			}
+			return cloudflare(request);
+		}};
+		ddns_client* const client {make_client(server)};
+
+		const auto start {std::chrono::steady_clock::now()};
+		expect(eq(update_a_record(client), DDNS_ERROR_OK));
+		expect(elapsed_ms(start) >= 1000);
+		expect(eq(server.requests().size(), 2U));
+
+		ddns_client_destroy(client);
+	};
+
+	"retry_gives_up"_test = [] {
+		const mock_server server {[](const mock_request&) {
+			return unavailable;
+		}};
+		ddns_client* const client {make_client(server)};
+
+		expect(eq(update_a_record(client), DDNS_ERROR_GENERIC));
+		expect(eq(server.requests().size(), 4U));
+
+		// Nor waits longer than the server is willing to accept
+		const mock_server slow_down {[](const mock_request&) {
+			return mock_response {429, "", "Retry-After: 3600\r\n"};
+		}};
+		ddns_client* const patient {make_client(slow_down)};
+		expect(eq(update_a_record(patient), DDNS_ERROR_GENERIC));
+		expect(eq(slow_down.requests().size(), 1U));
+
+		ddns_client_destroy(patient);
+		ddns_client_destroy(client);
+	};
+
+	"retry_deadline"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {[&](const mock_request& request) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+			return cloudflare(request);
+		}};
+		ddns_client* const client {make_client(server)};
+
+		expect(eq(ddns_client_set_deadline(client, -1), DDNS_ERROR_USAGE));
+		expect(eq(ddns_client_set_timeouts(client, 1000, -1), DDNS_ERROR_USAGE));
+
+		expect(eq(ddns_client_set_deadline(client, 500), DDNS_ERROR_OK));
+		auto start {std::chrono::steady_clock::now()};
+		expect(eq(search_zone(client), DDNS_ERROR_GENERIC));
+		expect(eq(update_a_record(client), DDNS_ERROR_GENERIC));
+		expect(elapsed_ms(start) < 1000);
+
+		// The timeout of each request applies without a deadline too
+		expect(eq(ddns_client_set_deadline(client, 0), DDNS_ERROR_OK));
+		expect(eq(ddns_client_set_timeouts(client, 1000, 500), DDNS_ERROR_OK));
+		start = std::chrono::steady_clock::now();
+		expect(eq(update_a_record(client), DDNS_ERROR_GENERIC));
+		expect(elapsed_ms(start) < 1000);
+
+		expect(eq(ddns_client_set_timeouts(client, 1000, 0), DDNS_ERROR_OK));
+		expect(eq(update_a_record(client), DDNS_ERROR_OK));
+
+		ddns_client_destroy(client);
+	};
+}
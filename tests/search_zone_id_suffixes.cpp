@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr const char* sub_zone_id {"9a7806061c88ada191ed06f989cc3dac"};
+
+std::vector<std::string> searched_names(const mock_server& server) {
+	std::vector<std::string> names;
+	for (const mock_request& request : server.requests()) {
+		names.push_back(request.target.substr(request.target.find("&name=") + 6));
+	}
+	// The requests are concurrent, so they can arrive in any order
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"search_zone_id_suffixes"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(ddns_client_search_zone_id(client, mock_cloudflare::api_token, "ddns.example.com", zone_id.size(), zone_id.data()), DDNS_ERROR_OK));
+		expect(eq(std::string_view{zone_id.data()}, std::string_view{mock_cloudflare::zone_id}));
+
+		expect(eq(searched_names(server), std::vector<std::string>{"ddns.example.com", "example.com"}));
+
+		ddns_client_destroy(client);
+	};
+
+	"search_zone_id_delegated"_test = [] {
+		mock_cloudflare cloudflare;
+		cloudflare.add_zone("sub.example.com", sub_zone_id);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		// Both sub.example.com and example.com match, but the record
+		// belongs to the delegated zone
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(ddns_client_search_zone_id(client, mock_cloudflare::api_token, "ddns.sub.example.com", zone_id.size(), zone_id.data()), DDNS_ERROR_OK));
+		expect(eq(std::string_view{zone_id.data()}, std::string_view{sub_zone_id}));
+
+		expect(eq(searched_names(server), std::vector<std::string>{"ddns.sub.example.com", "example.com", "sub.example.com"}));
+
+		ddns_client_destroy(client);
+	};
+
+	"search_zone_id_not_found"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(ddns_client_search_zone_id(client, mock_cloudflare::api_token, "ddns.example.org", zone_id.size(), zone_id.data()), DDNS_ERROR_GENERIC));
+		expect(eq(ddns_client_search_zone_id(client, mock_cloudflare::api_token, "localhost", zone_id.size(), zone_id.data()), DDNS_ERROR_GENERIC));
+
+		// No request is sent for names without a dot
+		expect(eq(server.requests().size(), 2U));
+
+		ddns_client_destroy(client);
+	};
+
+	"search_zone_id_failure"_test = [] {
+		// The search of sub.example.com fails, so it's unknown whether the
+		// record belongs to it or to example.com
+		mock_cloudflare cloudflare;
+		cloudflare.add_zone("sub.example.com", sub_zone_id);
+		const mock_server server {[&](const mock_request& request) {
+			if (request.target.find("name=sub.example.com") != std::string::npos) {
+				return mock_cloudflare::failure(500, 1000, "Internal Server Error");
+			}
+			return cloudflare(request);
+		}};
+		ddns_client* const client {make_client(server)};
+
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(ddns_client_search_zone_id(client, mock_cloudflare::api_token, "ddns.sub.example.com", zone_id.size(), zone_id.data()), DDNS_ERROR_GENERIC));
+
+		ddns_client_destroy(client);
+	};
+
+	"search_zone_id_suffixes_bad_usage"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(ddns_client_search_zone_id(client, "an invalid token", "ddns.example.com", zone_id.size(), zone_id.data()), DDNS_ERROR_USAGE));
+		expect(eq(ddns_client_search_zone_id(client, mock_cloudflare::api_token, "ddns.example.com", DDNS_ZONE_ID_LENGTH, zone_id.data()), DDNS_ERROR_USAGE));
+
+		expect(eq(server.requests().size(), 0U));
+
+		ddns_client_destroy(client);
+	};
+
+	curl_global_cleanup();
+}
@@ -0,0 +1,96 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <array>
+#include <cstddef>
+#include <functional>
+
+namespace {
+
+ddns_client* make_client(const mock_server& server, ddns_share* const share) {
+	ddns_client* const client {::make_client(server)};
+	ddns_client_set_share(client, share);
+	return client;
+}
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"share_connections"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_share* share {nullptr};
+		expect(eq(ddns_share_create(&share), DDNS_ERROR_OK) >> fatal);
+
+		ddns_client* const first {make_client(server, share)};
+		ddns_client* const second {make_client(server, share)};
+
+		expect(eq(search_zone(first, mock_cloudflare::api_token, mock_cloudflare::zone_name), DDNS_ERROR_OK));
+		expect(eq(server.connections(), 1U));
+
+		// The second client reuses the connection of the first one
+		expect(eq(search_zone(second, mock_cloudflare::api_token, mock_cloudflare::zone_name), DDNS_ERROR_OK));
+		expect(eq(server.connections(), 1U));
+
+		// Until it goes back to its own. example.com was already searched,
+		// so only the new name is sent.
+		ddns_client_set_share(second, nullptr);
+		expect(eq(search_zone(second, mock_cloudflare::api_token, "www.example.com"), DDNS_ERROR_OK));
+		expect(eq(server.connections(), 2U));
+
+		ddns_client_destroy(first);
+		ddns_client_destroy(second);
+		ddns_share_destroy(share);
+	};
+
+	"share_unshared_clients"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+
+		ddns_client* const first {make_client(server, nullptr)};
+		ddns_client* const second {make_client(server, nullptr)};
+
+		expect(eq(search_zone(first, mock_cloudflare::api_token, mock_cloudflare::zone_name), DDNS_ERROR_OK));
+		expect(eq(search_zone(second, mock_cloudflare::api_token, mock_cloudflare::zone_name), DDNS_ERROR_OK));
+		expect(eq(server.connections(), 2U));
+
+		ddns_client_destroy(first);
+		ddns_client_destroy(second);
+	};
+
+	"share_concurrent_transfers"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_share* share {nullptr};
+		expect(eq(ddns_share_create(&share), DDNS_ERROR_OK) >> fatal);
+
+		ddns_client* const first {make_client(server, share)};
+		ddns_client* const second {make_client(server, share)};
+
+		// Searched concurrently, each on its own connection
+		std::array<char, DDNS_ZONE_ID_LENGTH + 1> zone_id;
+		expect(eq(ddns_client_search_zone_id(first, mock_cloudflare::api_token, "a.b.example.com", zone_id.size(), zone_id.data()), DDNS_ERROR_OK));
+		const std::size_t connections {server.connections()};
+		expect(ge(connections, 1U));
+
+		// Which are then left to the other clients
+		expect(eq(search_zone(second, mock_cloudflare::api_token, mock_cloudflare::zone_name), DDNS_ERROR_OK));
+		expect(eq(server.connections(), connections));
+
+		ddns_client_destroy(first);
+		ddns_client_destroy(second);
+		ddns_share_destroy(share);
+		ddns_share_destroy(nullptr);
+	};
+
+	curl_global_cleanup();
+}
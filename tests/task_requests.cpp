@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <ddns/task.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// The calls to operator new made by this thread, by the library too, but
+// not by the threads of the mock server
+thread_local std::size_t allocations {0};
+
+/*
+ * What the executable does for each record: find its zone, look it up and
+ * update it if its address changed
+ */
+ddns::task<void> reconcile(ddns::executor& executor, const char* const record_name, const bool aaaa, const char* const ip, std::size_t& updates) {
+	const ddns::result<ddns::zone_id> zone {co_await ddns::search_zone_id(executor, mock_cloudflare::api_token, record_name)};
+	if (!zone) {
+		co_return zone.error();
+	}
+
+	const ddns::result<ddns_record> record {co_await ddns::get_record(executor, mock_cloudflare::api_token, zone->data(), record_name, aaaa)};
+	if (!record) {
+		co_return record.error();
+	}
+	if (std::string_view{record->content} == ip) {
+		co_return DDNS_ERROR_OK;
+	}
+
+	const ddns::result<void> updated {co_await ddns::update_record(executor, mock_cloudflare::api_token, zone->data(), record->id, ip)};
+	if (updated) {
+		++updates;
+	}
+	co_return updated.error();
+}
+
+/*
+ * Both records of the name, concurrently, the A one with the local address
+ */
+ddns::task<void> reconcile_all(ddns::executor& executor, const char* const aaaa_ip, std::size_t& updates) {
+	const ddns::result<ddns::ip_address> local_ip {co_await ddns::get_local_ip(executor, false)};
+	if (!local_ip) {
+		co_return local_ip.error();
+	}
+
+	ddns::task<void> a {reconcile(executor, mock_cloudflare::record_name, false, local_ip->data(), updates)};
+	ddns::task<void> aaaa {reconcile(executor, mock_cloudflare::record_name, true, aaaa_ip, updates)};
+	co_await ddns::when_all(a, aaaa);
+
+	co_return a.get() ? aaaa.get().error() : a.get().error();
+}
+
+ddns::task<std::size_t> count_records(ddns::executor& executor, const std::size_t lookups) {
+	std::array<ddns_record, 2> records[8];
+	ddns::task<std::size_t> tasks[8];
+	for (std::size_t i = 0; i < lookups; ++i) {
+		tasks[i] = ddns::get_records(executor, mock_cloudflare::api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, records[i].size(), records[i].data());
+	}
+	co_await ddns::when_all(tasks, lookups);
+
+	std::size_t count {0};
+	for (std::size_t i = 0; i < lookups; ++i) {
+		if (!tasks[i].get()) {
+			co_return tasks[i].get().error();
+		}
+		count += *tasks[i].get();
+	}
+	co_return count;
+}
+
+} // namespace
+
+void* operator new(const std::size_t size) {
+	++allocations;
+	if (void* const memory = std::malloc(size != 0 ? size : 1)) {
+		return memory;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+	++allocations;
+	return std::malloc(size != 0 ? size : 1);
+}
+
+void operator delete(void* const memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* const memory, std::size_t) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* const memory, const std::nothrow_t&) noexcept {
+	std::free(memory);
+}
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"task_reconcile"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+		{
+			ddns::executor executor {client};
+			expect(eq(executor.error(), DDNS_ERROR_OK) >> fatal);
+
+			std::size_t updates {0};
+			expect(eq(executor.run(reconcile_all(executor, "2001:db8::2", updates)).error(), DDNS_ERROR_OK));
+			expect(eq(updates, 2U));
+			expect(eq(cloudflare.content(mock_cloudflare::a_record_id), std::string{mock_cloudflare::local_ip}));
+			expect(eq(cloudflare.content(mock_cloudflare::aaaa_record_id), std::string{"2001:db8::2"}));
+
+			// Once warm, the same flow allocates nothing
+			updates = 0;
+			const std::size_t before {allocations};
+			const ddns::result<void> again {executor.run(reconcile_all(executor, "2001:db8::3", updates))};
+			const std::size_t allocated {allocations - before};
+			expect(eq(again.error(), DDNS_ERROR_OK));
+			expect(eq(updates, 1U));
+			expect(eq(allocated, 0U));
+		}
+		ddns_client_destroy(client);
+	};
+
+	"task_when_all"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+		{
+			ddns::executor executor {client};
+			const ddns::result<std::size_t> count {executor.run(count_records(executor, 8))};
+			expect(eq(count.error(), DDNS_ERROR_OK));
+			expect(eq(*count, 16U));
+
+			// Nothing to wait for
+			expect(eq(*executor.run(count_records(executor, 0)), 0U));
+		}
+		ddns_client_destroy(client);
+	};
+
+	"task_errors"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+		{
+			ddns::executor executor {client};
+
+			expect(eq(executor.run(ddns::search_zone_id(executor, mock_cloudflare::api_token, "ddns.example.org")).error(), DDNS_ERROR_GENERIC));
+			expect(eq(executor.run(ddns::get_record(executor, mock_cloudflare::other_api_token, mock_cloudflare::zone_id, mock_cloudflare::record_name, false)).error(), DDNS_ERROR_GENERIC));
+			expect(eq(executor.run(ddns::get_local_ip(executor, false, -1)).error(), DDNS_ERROR_USAGE));
+			expect(eq(executor.run(ddns::update_record(executor, mock_cloudflare::api_token, mock_cloudflare::zone_id, "bad", "192.0.2.9")).error(), DDNS_ERROR_USAGE));
+		}
+		ddns_client_destroy(client);
+	};
+}
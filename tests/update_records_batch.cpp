@@ -0,0 +1,158 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Andrea Pappacoda
+ *
+ * SPDX-License-Identifier: AGPL-3.0-or-later
+ */
+
+#include "common.hpp"
+#include "mock_cloudflare.hpp"
+#include "mock_server.hpp"
+#include <curl/curl.h>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+const std::string batch_target {"/client/v4/zones/" + std::string{mock_cloudflare::zone_id} + "/dns_records/batch"};
+
+ddns_record make_record(const std::size_t index, const char* const content) {
+	ddns_record record {};
+	std::snprintf(record.id, sizeof record.id, "%032zx", index);
+	std::snprintf(record.content, sizeof record.content, "%s", content);
+	return record;
+}
+
+/*
+ * Adds records to the zone of cloudflare, AAAA ones if their content is an
+ * IPv6 address, so that they can be patched
+ */
+void add_records(mock_cloudflare& cloudflare, const std::vector<ddns_record>& records) {
+	for (const ddns_record& record : records) {
+		cloudflare.add_record(record.id, mock_cloudflare::record_name, std::strchr(record.content, ':') != nullptr, "192.0.2.255");
+	}
+}
+
+std::size_t count(const std::string_view string, const std::string_view pattern) {
+	std::size_t occurrences {0};
+	for (std::size_t i = string.find(pattern); i != std::string_view::npos; i = string.find(pattern, i + 1)) {
+		++occurrences;
+	}
+	return occurrences;
+}
+
+} // namespace
+
+int main() {
+	curl_global_init(CURL_GLOBAL_DEFAULT);
+
+	"update_records_batch"_test = [] {
+		std::vector records {
+			make_record(1, "1.2.3.4"),
+			make_record(2, "2001:db8::1"),
+			make_record(3, "5.6.7.8")
+		};
+		mock_cloudflare cloudflare;
+		add_records(cloudflare, records);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		expect(eq(ddns_client_update_records_batch(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, records.size(), records.data()), DDNS_ERROR_OK));
+
+		const std::vector requests {server.requests()};
+		expect(eq(requests.size(), 1U) >> fatal);
+		expect(eq(requests[0].method, std::string{"POST"}));
+		expect(eq(requests[0].target, batch_target));
+		expect(eq(requests[0].body, std::string{
+			R"({"patches":[)"
+			R"({"id":"00000000000000000000000000000001","content":"1.2.3.4"},)"
+			R"({"id":"00000000000000000000000000000002","content":"2001:db8::1"},)"
+			R"({"id":"00000000000000000000000000000003","content":"5.6.7.8"})"
+			R"(]})"
+		}));
+
+		expect(eq(std::string_view{records[0].content}, std::string_view{"1.2.3.4"}));
+		expect(!records[0].aaaa);
+		expect(eq(std::string_view{records[1].content}, std::string_view{"2001:db8::1"}));
+		expect(records[1].aaaa);
+		expect(!records[2].aaaa);
+
+		ddns_client_destroy(client);
+	};
+
+	"update_records_batch_chunks"_test = [] {
+		std::vector<ddns_record> records;
+		for (std::size_t i = 0; i < DDNS_BATCH_MAX_RECORDS + 4U; ++i) {
+			records.push_back(make_record(i, "192.0.2.1"));
+		}
+		mock_cloudflare cloudflare;
+		add_records(cloudflare, records);
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		expect(eq(ddns_client_update_records_batch(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, records.size(), records.data()), DDNS_ERROR_OK));
+
+		const std::vector requests {server.requests()};
+		expect(eq(requests.size(), 2U) >> fatal);
+		expect(eq(count(requests[0].body, R"("id")"), std::size_t{DDNS_BATCH_MAX_RECORDS}));
+		expect(eq(count(requests[1].body, R"("id")"), 4U));
+		expect(eq(count(requests[1].body, make_record(DDNS_BATCH_MAX_RECORDS, "").id), 1U));
+
+		ddns_client_destroy(client);
+	};
+
+	"update_records_batch_failure"_test = [] {
+		const mock_server server {[](const mock_request&) {
+			return mock_cloudflare::failure(400, 1004, "DNS Validation Error");
+		}};
+		ddns_client* const client {make_client(server)};
+
+		std::vector<ddns_record> records;
+		for (std::size_t i = 0; i < DDNS_BATCH_MAX_RECORDS + 1U; ++i) {
+			records.push_back(make_record(i, "192.0.2.1"));
+		}
+
+		expect(eq(ddns_client_update_records_batch(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, records.size(), records.data()), DDNS_ERROR_GENERIC));
+		// The second batch must not be sent once the first one fails
+		expect(eq(server.requests().size(), 1U));
+
+		ddns_client_destroy(client);
+	};
+
+	"update_records_batch_bad_usage"_test = [] {
+		mock_cloudflare cloudflare;
+		const mock_server server {std::ref(cloudflare)};
+		ddns_client* const client {make_client(server)};
+
+		std::array records {make_record(1, "1.2.3.4"), make_record(2, "5.6.7.8")};
+
+		expect(eq(ddns_client_update_records_batch(client, "an invalid token", mock_cloudflare::zone_id, records.size(), records.data()), DDNS_ERROR_USAGE));
+		expect(eq(ddns_client_update_records_batch(client, mock_cloudflare::api_token, "an invalid zone id", records.size(), records.data()), DDNS_ERROR_USAGE));
+
+		// No batch is sent if any record is invalid, not even the valid ones
+		records[1].id[5] = '\0';
+		expect(eq(ddns_client_update_records_batch(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, records.size(), records.data()), DDNS_ERROR_USAGE));
+		records[1] = make_record(2, "5.6.7.8");
+		std::memset(records[1].content, 'a', sizeof records[1].content);
+		expect(eq(ddns_client_update_records_batch(client, mock_cloudflare::api_token, mock_cloudflare::zone_id, records.size(), records.data()), DDNS_ERROR_USAGE));
+
+		expect(eq(server.requests().size(), 0U));
+
+		CURL* curl {curl_easy_init()};
+		expect(eq(ddns_update_records_batch_raw(mock_cloudflare::api_token, mock_cloudflare::zone_id, 0, records.data(), &curl), DDNS_ERROR_USAGE));
+		std::vector<ddns_record> too_many(DDNS_BATCH_MAX_RECORDS + 1U, make_record(1, "1.2.3.4"));
+		expect(eq(ddns_update_records_batch_raw(mock_cloudflare::api_token, mock_cloudflare::zone_id, too_many.size(), too_many.data(), &curl), DDNS_ERROR_USAGE));
+		curl_easy_cleanup(curl);
+
+		const std::string long_url(DDNS_BASE_URL_MAX_LENGTH + 1U, 'a');
+		expect(eq(ddns_client_set_base_url(client, long_url.c_str()), DDNS_ERROR_USAGE));
+
+		ddns_client_destroy(client);
+	};
+
+	curl_global_cleanup();
+}